@@ -16,55 +16,23 @@
 #define DEG2RAD (3.14159265 / 180.0)
 #define RAD2DEG (180.0 / 3.14159265)
 
-layout(std140) uniform GeometryBuffer
-{
-    float4x4 model;
-    float4x4 view;
-    float4x4 projection;
-    float3 cameraPos;
-    float elapsedTime;
-};
-
-layout(std140) uniform MaterialBuffer
-{
-    float3 ambient;
-    float3 diffuse;
-    float3 specular;
-    float3 emissionColour;
-	float glintFactor;
-    float roughness;
-    float metallic;
-    float emissionIntensity;
-};
+// Uniform blocks shared with the CPU (GeometryBuffer, MaterialBuffer, LightsBuffer, ParticleBuffer, UpscaleBuffer).
+// The asset manager replaces this line with the declarations generated from RENDER_UNIFORM_BLOCKS in uniform_blocks.hpp
+#inject
 
 // equiv for CPU enum values
 #define LIGHT_TYPE_DIRECTIONAL 0
 #define LIGHT_TYPE_POINT 1
 #define LIGHT_TYPE_SPOT 2
 
-struct LightData
-{
-    // These 4 floats would be aligned into a float4, meaning a single light occupies 16 bytes
-    uint type;
-    float intensity;
-    float innerRadius; // For spot lights (radians)
-    float outerRadius; // For spot lights (radians)
-
-    // Ignored for dir lights
-    float3 position;
-    float3 direction;
-
-    // RGB colour
-    float3 colour;
-};
-
-layout(std140) uniform LightsBuffer
+// Mesh normals are octahedral encoded into two snorm16s, see render::quantiseMeshVertices
+vec3 decodeOctahedralNormal(vec2 encoded)
 {
-    // Support up to 4 real-time lights
-    LightData light0;
-    LightData light1;
-    LightData light2;
-    LightData light3;
-};
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    // Lower hemisphere, folded over the diagonals
+    float t = max(-n.z, 0.0);
+    n.xy -= vec2(n.x >= 0.0 ? t : -t, n.y >= 0.0 ? t : -t);
+    return normalize(n);
+}
 
 #endif // COMMON_H
\ No newline at end of file
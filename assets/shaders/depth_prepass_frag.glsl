@@ -0,0 +1,5 @@
+// Depth only. Colour writes are masked off by the pipeline state
+
+void main()
+{
+}
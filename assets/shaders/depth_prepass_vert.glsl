@@ -0,0 +1,11 @@
+layout(location = 0) in vec3 iPosition;
+
+#include "common.glsl"
+
+// Must match the forward pass bit for bit, otherwise the equal depth test in the main pass rejects fragments
+invariant gl_Position;
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(iPosition, 1.0);
+}
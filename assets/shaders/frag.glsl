@@ -1,10 +1,23 @@
 precision mediump float;
 
+// Material variants. The asset manager compiles this file with MATERIAL_VARIANT and one define per feature the material
+// uses, see render::getMaterialVariantDefines. Features left out read as the white fallback texture or zero would, without
+// the fetch or the maths. Compiled on its own, every feature is on
+#ifndef MATERIAL_VARIANT
+#define HAS_DIFFUSE_TEX
+#define HAS_META_TEX
+#define HAS_EMISSION
+#define HAS_EMISSION_TEX
+#define HAS_MATCAP_TEX
+#define HAS_BRDF_LUT_TEX
+#define HAS_GLINT
+#define LIGHT_COUNT 4
+#endif
+
 #include "common.glsl"
 #include "lighting.glsl"
+#include "oit.glsl"
 
-// gl_FragColor is deprecated in GLSL 4.4+
-layout(location = 0) out vec4 fragColor;
 layout(binding = 0) uniform sampler2D diffuseTex;
 layout(binding = 1) uniform sampler2D metaTex;
 layout(binding = 2) uniform sampler2D emissionTex;
@@ -54,7 +67,9 @@ vec3 computeLighting(LightData lightData, in vec3 albedo, vec3 normal, float per
 }
 
 vec4 sampleMatcap(vec3 normal, float roughness) {
-
+#ifndef HAS_MATCAP_TEX
+    return vec4(1.0, 1.0, 1.0, 1.0);
+#else
     // specular IBL
     const float k_MAX_REFLECTION_LOD = log2(256); // log2(matcapResolution)
     float specularLevel = clamp(roughness * k_MAX_REFLECTION_LOD, 0.0, k_MAX_REFLECTION_LOD);
@@ -62,6 +77,7 @@ vec4 sampleMatcap(vec3 normal, float roughness) {
     const float k_MATCAP_BORDER = 0.43;
     highp vec2 matcapUv = normal.xy * k_MATCAP_BORDER + vec2(0.5, 0.5);
     return textureLod(matcapTex, vec2(matcapUv.x, matcapUv.y), specularLevel);
+#endif
 }
 
 // ibl contribution
@@ -79,11 +95,15 @@ vec3 computeIBL(vec3 albedo, vec3 normal, float roughness, inout vec3 specular)
     vec4 irradiance = sampleMatcap(n, 0.9);
     vec3 ambient    = (kD * irradiance.rgb);
 
+#ifdef HAS_BRDF_LUT_TEX
     // Read brdf texture from disk
     vec4 brdf = textureLod(brdfLutTex, vec2(NdotV, roughness), 0);
     // undo sRGB to read linear tex
     brdf.x = pow(brdf.x, 1 / 2.2);
     brdf.y = pow(brdf.y, 1 / 2.2);
+#else
+    vec4 brdf = vec4(1.0, 1.0, 1.0, 1.0);
+#endif
 
     vec4 iblSpecular = sampleMatcap(r, roughness);
     specular = iblSpecular.rgb * (kS * brdf.x + brdf.y);
@@ -109,9 +129,16 @@ float genGlint(vec2 uv) {
 
 void main()
 {
+#ifdef HAS_DIFFUSE_TEX
     vec4 albedo = vec4(texture(diffuseTex, uv).rgb, 1.0f) * vec4(diffuse, 1.0);
+#else
+    vec4 albedo = vec4(diffuse, 1.0);
+#endif
+#ifdef HAS_META_TEX
     vec4 meta = pow(vec4(texture(metaTex, uv).rgb, 1.0f), vec4(1.0/2.2)); // read metaTex and convert to linear
-    vec4 emissionTexCol = texture(emissionTex, uv);
+#else
+    vec4 meta = vec4(1.0, 1.0, 1.0, 1.0);
+#endif
     float metal = meta.r * metallic;
     float roughness = meta.g * roughness;
     float perceptualRoughness = clamp(roughness, 0.01f, 0.99f);
@@ -119,21 +146,36 @@ void main()
     vec3 iblSpecular;
     vec3 iblDiffuse = computeIBL(albedo.rgb, normal, perceptualRoughness, iblSpecular);
 
-    vec3 light0Contribution = computeLighting(light0, albedo.rgb, normal, perceptualRoughness);
-    vec3 light1Contribution = computeLighting(light1, albedo.rgb, normal, perceptualRoughness);
-    vec3 light2Contribution = computeLighting(light2, albedo.rgb, normal, perceptualRoughness);
-    vec3 light3Contribution = computeLighting(light3, albedo.rgb, normal, perceptualRoughness);
-
+    vec3 finalColor = iblDiffuse.rgb * albedo.rgb +
+        ambient.rgb * iblSpecular;
+
+    // Unused light slots are zeroed and contribute nothing, so variants stop at the scene's light count
+#if LIGHT_COUNT > 0
+    finalColor += computeLighting(light[0], albedo.rgb, normal, perceptualRoughness);
+#endif
+#if LIGHT_COUNT > 1
+    finalColor += computeLighting(light[1], albedo.rgb, normal, perceptualRoughness);
+#endif
+#if LIGHT_COUNT > 2
+    finalColor += computeLighting(light[2], albedo.rgb, normal, perceptualRoughness);
+#endif
+#if LIGHT_COUNT > 3
+    finalColor += computeLighting(light[3], albedo.rgb, normal, perceptualRoughness);
+#endif
+
+#ifdef HAS_GLINT
     float glintFac = genGlint(uv) * glintFactor;
-    vec3 glint = vec3(glintFac, glintFac, glintFac);
+    finalColor += vec3(glintFac, glintFac, glintFac);
+#endif
 
-    vec3 finalColor = iblDiffuse.rgb * albedo.rgb +
-        ambient.rgb * iblSpecular +
-        light0Contribution +
-        light1Contribution +
-        light2Contribution +
-        light3Contribution + glint +
-        emissionTexCol.rgb * emissionColour * emissionIntensity;
-
-    fragColor = vec4(finalColor.rgb, albedo.a);
+#ifdef HAS_EMISSION
+#ifdef HAS_EMISSION_TEX
+    vec4 emissionTexCol = texture(emissionTex, uv);
+#else
+    vec4 emissionTexCol = vec4(1.0, 1.0, 1.0, 1.0);
+#endif
+    finalColor += emissionTexCol.rgb * emissionColour * emissionIntensity;
+#endif
+
+    writeFragment(finalColor.rgb * albedo.a, albedo.a, length(cameraPos - worldPos));
 }
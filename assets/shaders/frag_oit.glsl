@@ -0,0 +1,3 @@
+// Forward shader writing into the weighted blended OIT targets
+#define WEIGHTED_BLENDED_OIT
+#include "frag.glsl"
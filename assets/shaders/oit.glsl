@@ -0,0 +1,33 @@
+#ifndef OIT_H
+#define OIT_H
+
+// Colour output for forward shaded surfaces. Shaders that define WEIGHTED_BLENDED_OIT before including this file write into the
+// weighted blended OIT targets instead of the backbuffer, see SceneRenderer::drawWeightedBlendedTransparency
+#ifdef WEIGHTED_BLENDED_OIT
+
+// rgb accumulates weighted premultiplied colour, alpha is blended down into the revealage (product of 1 - alpha)
+layout(location = 0) out vec4 oitAccumulation;
+// Sum of the weights, to normalise the accumulated colour
+layout(location = 1) out vec4 oitWeight;
+
+void writeFragment(vec3 premultipliedColour, float alpha, float viewDistance)
+{
+    // Depth weight from McGuire and Bavoil 2013, nearer surfaces dominate. Clamped to stay inside half float range
+    float weight = alpha * clamp(10.0 / (1e-5 + pow(viewDistance / 5.0, 2.0) + pow(viewDistance / 200.0, 6.0)), 1e-2, 3e3);
+    oitAccumulation = vec4(premultipliedColour * weight, alpha);
+    oitWeight = vec4(alpha * weight, 0.0, 0.0, 0.0);
+}
+
+#else
+
+// gl_FragColor is deprecated in GLSL 4.4+
+layout(location = 0) out vec4 fragColor;
+
+void writeFragment(vec3 premultipliedColour, float alpha, float viewDistance)
+{
+    fragColor = vec4(premultipliedColour, alpha);
+}
+
+#endif
+
+#endif // OIT_H
@@ -0,0 +1,23 @@
+precision mediump float;
+
+// gl_FragColor is deprecated in GLSL 4.4+
+layout(location = 0) out vec4 fragColor;
+layout(binding = 0) uniform sampler2D accumulationTex;
+layout(binding = 1) uniform sampler2D weightTex;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec4 accumulation = texelFetch(accumulationTex, texel, 0);
+    float revealage = accumulation.a;
+    if (revealage >= 1.0) {
+        // Nothing transparent covers this pixel
+        discard;
+    }
+
+    float weightSum = texelFetch(weightTex, texel, 0).r;
+    vec3 averageColour = accumulation.rgb / max(weightSum, 1e-5);
+
+    // Alpha blended over the opaque scene, so the background shows through by the revealage
+    fragColor = vec4(averageColour, 1.0 - revealage);
+}
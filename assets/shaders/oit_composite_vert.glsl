@@ -0,0 +1,7 @@
+layout(location = 0) in vec3 iPosition;
+
+// Fullscreen quad, already in clip space
+void main()
+{
+    gl_Position = vec4(iPosition.xy, 0.0, 1.0);
+}
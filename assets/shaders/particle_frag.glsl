@@ -3,9 +3,8 @@ precision mediump float;
 #define DO_PARTICLES
 #include "common.glsl"
 #include "lighting.glsl"
+#include "oit.glsl"
 
-// gl_FragColor is deprecated in GLSL 4.4+
-layout(location = 0) out vec4 fragColor;
 layout(binding = 0) uniform sampler2D diffuseTex;
 
 // normal and pos are in world-space
@@ -24,5 +23,5 @@ void main()
     colourBlend.rgb *= colourBlend.a; // premultiplied alpha
 
     vec4 albedo = vec4(texture(diffuseTex, uv).rgb, 1.0f) * vec4(diffuse, 1.0) * colourBlend;
-    fragColor = vec4(albedo.rgb, albedo.a);
+    writeFragment(albedo.rgb, albedo.a, length(cameraPos - worldPos));
 }
\ No newline at end of file
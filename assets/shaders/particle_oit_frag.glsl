@@ -0,0 +1,3 @@
+// Particle shader writing into the weighted blended OIT targets
+#define WEIGHTED_BLENDED_OIT
+#include "particle_frag.glsl"
@@ -1,28 +1,9 @@
 layout(location = 0) in vec3 iPosition;
-layout(location = 1) in vec3 iNormal;
+layout(location = 1) in vec2 iNormal; // Octahedral encoded
 layout(location = 2) in vec2 iUv;
 
 #include "common.glsl"
 
-struct ParticleData
-{
-    vec3 position;
-    vec3 velocity;
-    vec4 colourBegin;
-    vec4 colourEnd;
-
-    // packed as float4
-    float sizeBegin;
-    float sizeEnd;
-    float life;
-    float particleTextureCount; // technically worse as its per particle, but these 4 bytes would've been padding anyway
-};
-
-layout(std140) uniform ParticleBuffer
-{
-    ParticleData particles[800];
-};
-
 out vec3 worldPos;
 out vec3 normal;
 out vec3 uvLife;
@@ -86,7 +67,7 @@ void main()
     gl_Position = projection * view * model * vec4(particlePos, 1.0);
     gl_Position = billboard(vec4(particlePos, 1.0));
     worldPos = (model * vec4(particlePos, 1.0)).xyz;
-    normal = (view * model * vec4(iNormal, 0.0)).xyz;
+    normal = (view * model * vec4(decodeOctahedralNormal(iNormal), 0.0)).xyz;
     
     // UVs
     int particleTextureIndex = int(mod(gl_InstanceID, int(particles[gl_InstanceID].particleTextureCount)));
@@ -0,0 +1,13 @@
+precision mediump float;
+
+#include "common.glsl"
+
+// gl_FragColor is deprecated in GLSL 4.4+
+layout(location = 0) out vec4 fragColor;
+layout(binding = 0) uniform sampler2D sceneTex;
+
+void main()
+{
+    vec2 uv = min(gl_FragCoord.xy * fragCoordScale_uvMax.xy, fragCoordScale_uvMax.zw);
+    fragColor = vec4(texture(sceneTex, uv).rgb, 1.0);
+}
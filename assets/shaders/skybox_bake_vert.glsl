@@ -0,0 +1,13 @@
+layout(location = 0) in vec3 iPosition;
+
+#include "common.glsl"
+
+out vec3 eyeDir;
+
+void main()
+{
+    // Renders a single cube map face with a fullscreen quad. Instead of a camera the view matrix holds the face's basis,
+    // its rows are the world space directions of the face's x and y axes, followed by the face's normal
+    gl_Position = vec4(iPosition.xy, 0.0, 1.0);
+    eyeDir = (view * vec4(iPosition.xy, 1.0, 0.0)).xyz;
+}
@@ -0,0 +1,14 @@
+precision mediump float;
+
+#include "common.glsl"
+
+// gl_FragColor is deprecated in GLSL 4.4+
+layout(location = 0) out vec4 fragColor;
+layout(binding = 0) uniform samplerCube skyCube;
+
+in vec3 eyeDir;
+
+void main()
+{
+    fragColor = vec4(texture(skyCube, eyeDir).rgb, 1.0);
+}
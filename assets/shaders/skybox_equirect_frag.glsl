@@ -0,0 +1,20 @@
+precision mediump float;
+
+#include "common.glsl"
+
+// gl_FragColor is deprecated in GLSL 4.4+
+layout(location = 0) out vec4 fragColor;
+layout(binding = 0) uniform sampler2D skyTex;
+
+in vec3 eyeDir;
+
+#define PI 3.14159265
+
+void main()
+{
+    // Converts an equirectangular HDRI into a cube map face
+    vec3 direction = normalize(eyeDir);
+    vec2 uv = vec2(atan(direction.z, direction.x) / (2.0 * PI) + 0.5, asin(clamp(direction.y, -1.0, 1.0)) / PI + 0.5);
+    // Sample the top mip explicitly, the derivatives are discontinuous where atan wraps around
+    fragColor = vec4(textureLod(skyTex, uv, 0.0).rgb, 1.0);
+}
@@ -1,5 +1,5 @@
 layout(location = 0) in vec3 iPosition;
-layout(location = 1) in vec3 iNormal;
+layout(location = 1) in vec2 iNormal; // Octahedral encoded
 layout(location = 2) in vec2 iUv;
 
 #include "common.glsl"
@@ -8,7 +8,7 @@ layout(binding = 0) uniform sampler2D brickTex;
 
 in vec3 eyeDir;
 
-#define SUN_DIR normalize(light0.direction)
+#define SUN_DIR normalize(light[0].direction)
 
 // Star Nest by Pablo Roman Andrioli
 // License: MIT
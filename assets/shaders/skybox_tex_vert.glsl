@@ -1,5 +1,5 @@
 layout(location = 0) in vec3 iPosition;
-layout(location = 1) in vec3 iNormal;
+layout(location = 1) in vec2 iNormal; // Octahedral encoded
 layout(location = 2) in vec2 iUv;
 
 #include "common.glsl"
@@ -11,6 +11,6 @@ void main()
 {
     vec4 pos = projection * view * model * vec4(iPosition, 1.0);
     gl_Position = vec4(pos.xy, 0.0, pos.w);
-    normal = iNormal.xyz;
+    normal = decodeOctahedralNormal(iNormal);
     uv = iUv.xy;
 }
\ No newline at end of file
@@ -5,16 +5,9 @@ layout(location = 0) out vec4 fragColor;
 layout(binding = 0) uniform sampler2D msdfTex;
 
 in vec2 uv;
-
-layout(std140) uniform TextBuffer
-{
-    mat4 model;
-    mat4 view;
-    mat4 projection;
-    vec4 colourForeground;
-    vec4 colourOutline;
-    float outlineWidth;
-};
+flat in vec4 colourForeground;
+flat in vec4 colourOutline;
+flat in float outlineWidth;
 
 float screenPxRange() {
     // given a 32x32 distance field with a pixel range of 2 and a render resolution of 72x72
@@ -1,21 +1,29 @@
-layout(location = 0) in vec2 iPosition;
-layout(location = 1) in vec2 iUv;
+// One instance per glyph, already in clip space. The quad's corners are picked from gl_VertexID, so there's no per-vertex data
+layout(location = 0) in vec4 iOriginAxisX; // xy => centre, zw => half width axis
+layout(location = 1) in vec3 iAxisYOutline; // xy => half height axis, z => outline width
+layout(location = 2) in vec4 iUvRect; // left, bottom, right, top
+layout(location = 3) in vec4 iColourForeground;
+layout(location = 4) in vec4 iColourOutline;
 
 out vec2 uv;
+flat out vec4 colourForeground;
+flat out vec4 colourOutline;
+flat out float outlineWidth;
 
-layout(std140) uniform TextBuffer
-{
-    mat4 model;
-    mat4 view;
-    mat4 projection;
-    vec4 colourForeground;
-    vec4 colourOutline;
-    float outlineWidth;
-};
+// (left, bottom), (left, top), (right, bottom), (right, bottom), (left, top), (right, top)
+const vec2 k_quadCorners[6] = vec2[6](
+    vec2(-1.0, -1.0), vec2(-1.0, 1.0), vec2(1.0, -1.0),
+    vec2(1.0, -1.0), vec2(-1.0, 1.0), vec2(1.0, 1.0)
+);
 
 void main()
 {
-    vec4 pos = projection * model * vec4(iPosition, 0.0, 1.0);
-    gl_Position = vec4(pos.xy, 0.0, pos.w);
-    uv = iUv.xy;
-}
\ No newline at end of file
+    vec2 corner = k_quadCorners[gl_VertexID % 6];
+    vec2 pos = iOriginAxisX.xy + corner.x * iOriginAxisX.zw + corner.y * iAxisYOutline.xy;
+    gl_Position = vec4(pos, 0.0, 1.0);
+    uv = mix(iUvRect.xy, iUvRect.zw, corner * 0.5 + 0.5);
+
+    colourForeground = iColourForeground;
+    colourOutline = iColourOutline;
+    outlineWidth = iAxisYOutline.z;
+}
@@ -0,0 +1,16 @@
+precision mediump float;
+
+// gl_FragColor is deprecated in GLSL 4.4+
+layout(location = 0) out vec4 fragColor;
+layout(binding = 0) uniform sampler2D canvasTex;
+
+void main()
+{
+    // The canvas matches the backbuffer 1:1 and is already premultiplied
+    vec4 canvasColour = texelFetch(canvasTex, ivec2(gl_FragCoord.xy), 0);
+    if (canvasColour.a <= 0.0) {
+        // Nothing drawn on the canvas here
+        discard;
+    }
+    fragColor = canvasColour;
+}
@@ -5,17 +5,7 @@ layout(location = 0) out vec4 fragColor;
 layout(binding = 0) uniform sampler2D uiTex;
 
 in vec2 uv;
-
-layout(std140) uniform UiBuffer
-{
-    mat4 model;
-    mat4 view;
-    mat4 projection;
-    vec4 textureTint;
-    vec2 size;
-    vec2 offset;
-    vec4 screenSize; // xy => screenSize width height, zw = 1/ width 1/height
-};
+flat in vec4 textureTint;
 
 void main()
 {
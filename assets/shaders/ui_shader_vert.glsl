@@ -1,29 +1,25 @@
 precision mediump float;
 
-layout(location = 0) in vec3 iPosition;
-layout(location = 2) in vec2 iUv;
+// One instance per sprite, already in clip space. The quad's corners are picked from gl_VertexID, so there's no per-vertex data
+layout(location = 0) in vec4 iOriginAxisX; // xy => centre, zw => half width axis
+layout(location = 1) in vec2 iAxisY; // half height axis
+layout(location = 2) in vec4 iUvRect; // left, bottom, right, top
+layout(location = 3) in vec4 iTint;
 
 out vec2 uv;
+flat out vec4 textureTint;
 
-layout(std140) uniform UiBuffer
-{
-    mat4 model;
-    mat4 view;
-    mat4 projection;
-    vec4 textureTint;
-    vec2 size;
-    vec2 offset;
-    vec4 screenSize; // xy => screenSize width height, zw = 1/ width 1/height
-};
+// (left, bottom), (left, top), (right, bottom), (right, bottom), (left, top), (right, top)
+const vec2 k_quadCorners[6] = vec2[6](
+    vec2(-1.0, -1.0), vec2(-1.0, 1.0), vec2(1.0, -1.0),
+    vec2(1.0, -1.0), vec2(-1.0, 1.0), vec2(1.0, 1.0)
+);
 
 void main()
 {
-    // in pos is 2x2 px, centered around 0,0
-    // take in pos and scale it such that we are sizeX x sizeY pixels in size at the end
-    // projection takes 
-    vec2 newPos = iPosition.xy;
-    newPos.xy = newPos.xy * size.xy * 0.5f + vec2(offset.x, -offset.y); // flip offset y because OpenGL
-    vec4 pos = projection * model * vec4(newPos, 0.0, 1.0);
-    gl_Position = vec4(pos.xy, 0.0, pos.w);
-    uv = vec2(1.0f - iUv.x, iUv.y);
-}
\ No newline at end of file
+    vec2 corner = k_quadCorners[gl_VertexID % 6];
+    vec2 pos = iOriginAxisX.xy + corner.x * iOriginAxisX.zw + corner.y * iAxisY;
+    gl_Position = vec4(pos, 0.0, 1.0);
+    uv = mix(iUvRect.xy, iUvRect.zw, corner * 0.5 + 0.5);
+    textureTint = iTint;
+}
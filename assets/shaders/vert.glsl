@@ -1,5 +1,5 @@
 layout(location = 0) in vec3 iPosition;
-layout(location = 1) in vec3 iNormal;
+layout(location = 1) in vec2 iNormal; // Octahedral encoded
 layout(location = 2) in vec2 iUv;
 
 #include "common.glsl"
@@ -8,10 +8,13 @@ out vec3 worldPos;
 out vec3 normal;
 out vec2 uv;
 
+// Shared with depth_prepass_vert.glsl, so both passes produce identical depth
+invariant gl_Position;
+
 void main()
 {
     gl_Position = projection * view * model * vec4(iPosition, 1.0);
     worldPos = (model * vec4(iPosition, 1.0)).xyz;
-    normal = (view * model * vec4(iNormal, 0.0)).xyz;
+    normal = (view * model * vec4(decodeOctahedralNormal(iNormal), 0.0)).xyz;
     uv = iUv.xy;
 }
\ No newline at end of file
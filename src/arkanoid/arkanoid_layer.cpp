@@ -3,6 +3,8 @@
 #include "arkanoid/logic/level_handler.hpp"
 
 #include <imgui.h>
+#include <fmt/format.h>
+#include "imgui_extensions.hpp"
 
 #include "b2debug/debug_draw.hpp"
 
@@ -70,12 +72,23 @@ void ArkanoidLayer::update(double timeElapsed, double deltaTime) {
 
     // ` toggles ImGUI
     // ` + P toggles physics debugging
+    // ` + B toggles the rendering benchmark scene
     if (engine::input::InputManager::getInstance()->keyReleased(engine::input::Keycode::Tilde)) {
         m_doDrawDebugUi = !m_doDrawDebugUi;
     }
     if (engine::input::InputManager::getInstance()->keyDown(engine::input::Keycode::Tilde) && engine::input::InputManager::getInstance()->keyReleased(engine::input::Keycode::P)) {
         m_doDrawDebugPhysics = !m_doDrawDebugPhysics;
     }
+#if _DEBUG
+    if (engine::input::InputManager::getInstance()->keyDown(engine::input::Keycode::Tilde) && engine::input::InputManager::getInstance()->keyReleased(engine::input::Keycode::B)) {
+        if (m_activeScene == &benchmarkScene) {
+            setActiveScene(m_sceneBeforeBenchmark != nullptr ? *m_sceneBeforeBenchmark : menuScene);
+        } else {
+            m_sceneBeforeBenchmark = m_activeScene;
+            setActiveScene(benchmarkScene);
+        }
+    }
+#endif
 
     m_sceneUpdater.update(*m_activeScene, deltaTime);
 
@@ -133,6 +146,42 @@ void ArkanoidLayer::imguiDraw() {
         m_sceneUpdater.drawDebugInspector(*m_activeScene, &m_selectedUiHierarchyElement);
         ImGui::End();
 
+        ImGui::Begin("Renderer");
+        {
+            const char* depthPrepassModeNames[] = { "Disabled", "Enabled", "Automatic" };
+            ImGui::ComboboxEx("Depth Pre-pass", (int*)&m_activeScene->renderingParams.depthPrepass, depthPrepassModeNames, IM_ARRAYSIZE(depthPrepassModeNames));
+            ImGui::Text(fmt::format("Pre-pass active: {}", m_sceneRenderer.isDepthPrepassActive() ? "yes" : "no").c_str());
+            // Without a pre-pass every covered layer runs the full PBR shader, with it each pixel is shaded once
+            ImGui::Text(fmt::format("Estimated opaque depth complexity: {:.2f}", m_sceneRenderer.getEstimatedDepthComplexity()).c_str());
+
+            ImGui::Checkbox("Hi-Z occlusion culling", &m_sceneRenderer.getOcclusionCuller().enabled);
+            ImGui::Text(fmt::format("Hi-Z culled {} / {} tests", m_sceneRenderer.getOcclusionCuller().getCulledCount(), m_sceneRenderer.getOcclusionCuller().getTestedCount()).c_str());
+
+            const render::DynamicResolutionController& dynamicResolution = engine::App::getInstance()->getDynamicResolution();
+            ImGui::Text(fmt::format("Resolution scale: {:.0f}% ({:.2f} ms / {:.2f} ms budget)", dynamicResolution.getScale() * 100.0f,
+                dynamicResolution.getSmoothedFrameTime() * 1000.0, dynamicResolution.getDesc().targetFrameTime * 1000.0).c_str());
+        }
+        ImGui::End();
+
+        ImGui::Begin("Frame Pacing");
+        {
+            engine::FramePacer& framePacer = engine::App::getInstance()->getFramePacer();
+            const char* framePacingModeNames[] = { "Vsync", "Limited", "Adaptive" };
+            int framePacingMode = static_cast<int>(framePacer.getMode());
+            ImGui::ComboboxEx("Mode", &framePacingMode, framePacingModeNames, IM_ARRAYSIZE(framePacingModeNames));
+            if (framePacingMode != static_cast<int>(framePacer.getMode())) {
+                framePacer.setMode(static_cast<engine::FramePacingMode>(framePacingMode));
+            }
+
+            engine::FramePacingStats stats = framePacer.computeStats();
+            ImGui::Text(fmt::format("Vsync: {}", stats.vsyncActive ? "on" : "off").c_str());
+            ImGui::Text(fmt::format("Frame interval: {:.2f} ms (target {:.2f} ms)", stats.averageInterval * 1000.0, stats.targetInterval * 1000.0).c_str());
+            ImGui::Text(fmt::format("Predicted frame cost: {:.2f} ms", stats.predictedCost * 1000.0).c_str());
+            ImGui::Text(fmt::format("Jitter p50 / p95 / p99: {:.3f} / {:.3f} / {:.3f} ms", stats.jitterP50 * 1000.0, stats.jitterP95 * 1000.0, stats.jitterP99 * 1000.0).c_str());
+            ImGui::Text(fmt::format("Missed frames: {} / {}", stats.missedFrames, stats.sampleCount).c_str());
+        }
+        ImGui::End();
+
         if (m_doDrawDebugPhysics) {
             
             ImGui::Begin("Physics");
@@ -153,7 +202,7 @@ void ArkanoidLayer::imguiDraw() {
             ImGui::Checkbox("Friction", &g_draw.m_debugDraw.drawFrictionImpulses);
             ImGui::End();
 
-            getDevice()->debugMarkerPush("b2debug");
+            GPU_MARKER_PUSH(getDevice(), "b2debug");
             // HACK
             LevelHandler* comp = (LevelHandler*)((m_activeScene->findNamedEntity("GameManager"))->findComponent(render::ComponentType::UserBehaviour));
             // m_sceneUpdater.drawPhysicsDebug(*m_activeScene);
@@ -165,7 +214,7 @@ void ArkanoidLayer::imguiDraw() {
             b2World_Draw(comp->getWorldId(), &g_draw.m_debugDraw);
             g_draw.Flush();
 
-            getDevice()->debugMarkerPop();
+            GPU_MARKER_POP(getDevice());
         }
     }
 #endif
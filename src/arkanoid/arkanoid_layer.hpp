@@ -33,6 +33,8 @@ public:
     // Ideally these would be serialised and we would just load from disk but for the purposes of the assignment this should suffice
     render::Scene menuScene;
     render::Scene gameScene;
+    // Rendering stress test, not reachable from the game itself. ` + B toggles it in debug builds
+    render::Scene benchmarkScene;
 
 private:
     bool windowResized(const engine::events::WindowResizeEvent& event);
@@ -42,6 +44,7 @@ private:
     void initScenes();
     void initMenuScene(render::Scene& outScene);
     void initGameScene(render::Scene& outScene);
+    void initBenchmarkScene(render::Scene& outScene);
 
     // Loads gpu resources into memory
     void loadGpuResources();
@@ -51,13 +54,20 @@ private:
     // Scene management
     // The currently active scene
     render::Scene* m_activeScene = nullptr;
+    // Scene to return to when leaving the benchmark
+    render::Scene* m_sceneBeforeBenchmark = nullptr;
 
     // Gpu handles
     gpu::IShader* m_shaderModernOpaque = nullptr;
-    gpu::IShader* m_shaderModernTransparent = nullptr;
     gpu::IShader* m_shaderClassic = nullptr;
     gpu::IShader* m_shaderParticle = nullptr;
 
+    // Particles are double sided and don't hide each other
+    static constexpr gpu::GraphicsState k_particleGraphicsState = {
+        .depthWrite = false,
+        .faceCullingMode = gpu::FaceCullMode::Never,
+    };
+
     gpu::BlendStateHandle m_ballParticleBlendState;
 
     // Scene handlers
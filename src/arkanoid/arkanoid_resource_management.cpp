@@ -9,60 +9,33 @@ void ArkanoidLayer::initScenes() {
 
     initMenuScene(menuScene);
     initGameScene(gameScene);
+
+#if _DEBUG
+    // Only reachable through the debug toggle, release builds don't need its entities in memory
+    benchmarkScene.layer = this;
+    initBenchmarkScene(benchmarkScene);
+#endif
 }
 
 void ArkanoidLayer::loadGpuResources() {
 
-    // Load shader for materials
+    // Load shader for materials. Transparent materials use the same shader, their blending comes from the draw order
+    // Their uniform blocks are bound by the scene renderer, see SceneRenderer::registerUniformBlocks
     m_shaderModernOpaque = getAssetManager()->fetchShader({
-        .graphicsState = {
-            // opaque rendering
-        },
         .vertShader = "vert.glsl",
         .fragShader = "frag.glsl",
         .debugName = "ModernOpaque"
         });
-    getDevice()->setBufferBinding(m_shaderModernOpaque, "GeometryBuffer", 0);
-    getDevice()->setBufferBinding(m_shaderModernOpaque, "MaterialBuffer", 1);
-    getDevice()->setBufferBinding(m_shaderModernOpaque, "LightsBuffer", 2);
-
-    m_shaderModernTransparent = getAssetManager()->fetchShader({
-        .graphicsState = {
-            // transparent rendering
-            // @TODO:
-        },
-        .vertShader = "vert.glsl",
-        .fragShader = "frag.glsl",
-        .debugName = "ModernAlphaBlend"
-        });
-    getDevice()->setBufferBinding(m_shaderModernTransparent, "GeometryBuffer", 0);
-    getDevice()->setBufferBinding(m_shaderModernTransparent, "MaterialBuffer", 1);
-    getDevice()->setBufferBinding(m_shaderModernTransparent, "LightsBuffer", 2);
 
     m_shaderClassic = getAssetManager()->fetchShader({
-        .graphicsState = {
-            // opaque rendering
-        },
         .vertShader = "classic_vert.glsl",
         .fragShader = "classic_frag.glsl",
         .debugName = "Classic"
         });
-    getDevice()->setBufferBinding(m_shaderClassic, "GeometryBuffer", 0);
-    getDevice()->setBufferBinding(m_shaderClassic, "MaterialBuffer", 1);
-    getDevice()->setBufferBinding(m_shaderClassic, "LightsBuffer", 2);
 
     m_shaderParticle = getAssetManager()->fetchShader({
-        .graphicsState = {
-            // opaque rendering
-            .depthWrite = false,
-            .faceCullingMode = gpu::FaceCullMode::Never,
-        },
         .vertShader = "particle_vert.glsl",
         .fragShader = "particle_frag.glsl",
         .debugName = "Particles"
         });
-    getDevice()->setBufferBinding(m_shaderParticle, "GeometryBuffer", 0);
-    getDevice()->setBufferBinding(m_shaderParticle, "MaterialBuffer", 1);
-    getDevice()->setBufferBinding(m_shaderParticle, "LightsBuffer", 2);
-    getDevice()->setBufferBinding(m_shaderParticle, "ParticleBuffer", 3);
 }
\ No newline at end of file
@@ -61,14 +61,14 @@ void Brick::updateBrick(BrickType type) {
     switch (type) {
     case BrickType::Regular:
     {
-        m_renderer->material = m_regularBrickMaterial;
+        m_renderer->setMaterial(m_regularBrickMaterial);
         m_totalHealth = 1;
         break;
     }
     case BrickType::Strong:
     {
         // strong bricks may require anywhere from 3 to 6 hits to break
-        m_renderer->material = m_strongBrickMaterial;
+        m_renderer->setMaterial(m_strongBrickMaterial);
         m_totalHealth = engine::RandomNumberGenerator::getRangedInt(3, 6);
 
         // 10% chance of powerup
@@ -79,7 +79,7 @@ void Brick::updateBrick(BrickType type) {
     }
     case BrickType::Indestructable:
     {
-        m_renderer->material = m_indestructableBrickMaterial;
+        m_renderer->setMaterial(m_indestructableBrickMaterial);
         m_totalHealth = k_HEALTH_INDESTRUCTABLE;
         break;
     }
@@ -406,12 +406,7 @@ void LevelHandler::killPowerup(render::Entity* powerup, b2BodyId powerupBody) {
     b2DestroyBody(powerupBody);
 
     // find powerup in the scene graph and delete it
-    auto iterEntity = std::find_if(powerup->parent->children.begin(), powerup->parent->children.end(), [&](const std::shared_ptr<render::Entity>& child) {
-        return child.get() == powerup;
-    });
-    if (iterEntity != powerup->parent->children.end()) {
-        powerup->parent->children.erase(iterEntity);
-    }
+    powerup->parent->remove(powerup);
 
     // find powerup collider and also remove it
     auto iterBody = std::find_if(m_powerupsPhysics.begin(), m_powerupsPhysics.end(), [&](const b2BodyId& physBody) {
@@ -551,8 +546,8 @@ void LevelHandler::update(float deltaTime) {
 
     // defer some stuff to first frame
     if (!firstFrame) {
-        m_gameoverUiRoot->enabled = false;
-        m_victoryUiRoot->enabled = false;
+        m_gameoverUiRoot->setEnabled(false);
+        m_victoryUiRoot->setEnabled(false);
         firstFrame = true;
     }
 
@@ -699,7 +694,7 @@ void LevelHandler::update(float deltaTime) {
 
                 if (!brickComponent->shouldExistInScene()) {
                     // disable bricks
-                    brick->enabled = false;
+                    brick->setEnabled(false);
                     b2Body_Disable(brickId);
 
                     if (brickComponent->shouldSpawnPowerup()) {
@@ -820,10 +815,19 @@ void LevelHandler::update(float deltaTime) {
         setLevel(m_level + 1);
     }
 
-    // Update UI state
-    m_livesUi->text = fmt::format("Lives {}", m_lives);
-    m_levelsUi->text = fmt::format("Level {}", (m_level + 1));
-    m_scoresUi->text = fmt::format("Score {}", m_score);
+    // Update UI state. Only reformat on change, the text renderer re-lays out any text that changes
+    if (m_displayedLives != m_lives) {
+        m_livesUi->text = fmt::format("Lives {}", m_lives);
+        m_displayedLives = m_lives;
+    }
+    if (m_displayedLevel != m_level) {
+        m_levelsUi->text = fmt::format("Level {}", (m_level + 1));
+        m_displayedLevel = m_level;
+    }
+    if (m_displayedScore != m_score) {
+        m_scoresUi->text = fmt::format("Score {}", m_score);
+        m_displayedScore = m_score;
+    }
     break;
 
     if (m_score != m_oldScore) {
@@ -861,10 +865,10 @@ void LevelHandler::update(float deltaTime) {
                         m_leaderboard.addEntry(m_userNameBuffer, m_score);
                         m_leaderboard.save(m_leaderboardFilePath);
                         m_isUsernameAccepted = true;
-                        m_gameoverUsernameTooltip->enabled = false;
-                        m_victoryUsernameTooltip->enabled = false;
-                        m_victoryUsernameInput->enabled = false;
-                        m_gameoverUsernameInput->enabled = false;
+                        m_gameoverUsernameTooltip->setEnabled(false);
+                        m_victoryUsernameTooltip->setEnabled(false);
+                        m_victoryUsernameInput->setEnabled(false);
+                        m_gameoverUsernameInput->setEnabled(false);
 
                         std::string leaderboardStr = "";
                         for (int i = 0; i < m_leaderboard.size(); i++) {
@@ -882,8 +886,8 @@ void LevelHandler::update(float deltaTime) {
             m_victoryUsernameInput->text = m_userNameBuffer;
             m_gameoverUsernameInput->text = m_userNameBuffer;
 
-            m_gameoverLeaderboard->enabled = m_isUsernameAccepted;
-            m_victoryLeaderboard->enabled = m_isUsernameAccepted;
+            m_gameoverLeaderboard->setEnabled(m_isUsernameAccepted);
+            m_victoryLeaderboard->setEnabled(m_isUsernameAccepted);
 
         }
         
@@ -932,7 +936,7 @@ void LevelHandler::setLevelLayout(LevelBrickLayoutShape shape) {
         for (auto brickEntity : m_bricksEntityRoot->children) {
             auto pBrickComponent = (Brick*)(brickEntity.get()->findComponent(render::ComponentType::UserBehaviour));
 
-            pBrickComponent->getEntity()->enabled = true;
+            pBrickComponent->getEntity()->setEnabled(true);
             b2Body_Enable(pBrickComponent->getBrickId());
         }
         break;
@@ -955,10 +959,10 @@ void LevelHandler::setLevelLayout(LevelBrickLayoutShape shape) {
             }
 
             if (shouldEnable) {
-                pBrickComponent->getEntity()->enabled = true;
+                pBrickComponent->getEntity()->setEnabled(true);
                 b2Body_Enable(pBrickComponent->getBrickId());
             } else {
-                pBrickComponent->getEntity()->enabled = false;
+                pBrickComponent->getEntity()->setEnabled(false);
                 b2Body_Disable(pBrickComponent->getBrickId());
             }
         }
@@ -974,10 +978,10 @@ void LevelHandler::setLevelLayout(LevelBrickLayoutShape shape) {
             int distanceFromCenter = std::abs(pBrickComponent->getPosX() - (columns / 2));
 
             if (distanceFromCenter <= allowableDistance) {
-                pBrickComponent->getEntity()->enabled = true;
+                pBrickComponent->getEntity()->setEnabled(true);
                 b2Body_Enable(pBrickComponent->getBrickId());
             } else {
-                pBrickComponent->getEntity()->enabled = false;
+                pBrickComponent->getEntity()->setEnabled(false);
                 b2Body_Disable(pBrickComponent->getBrickId());
             }
         }
@@ -1004,11 +1008,11 @@ void LevelHandler::setLevelLayout(LevelBrickLayoutShape shape) {
             }
 
             if (shouldEnable) {
-                pBrickComponent->getEntity()->enabled = true;
+                pBrickComponent->getEntity()->setEnabled(true);
                 b2Body_Enable(pBrickComponent->getBrickId());
             }
             else {
-                pBrickComponent->getEntity()->enabled = false;
+                pBrickComponent->getEntity()->setEnabled(false);
                 b2Body_Disable(pBrickComponent->getBrickId());
             }
         }
@@ -1021,10 +1025,10 @@ void LevelHandler::setLevelLayout(LevelBrickLayoutShape shape) {
             auto pBrickComponent = (Brick*)(brickEntity.get()->findComponent(render::ComponentType::UserBehaviour));
 
             if (pBrickComponent->getPosX() != 2 && pBrickComponent->getPosX() != 7) {
-                pBrickComponent->getEntity()->enabled = true;
+                pBrickComponent->getEntity()->setEnabled(true);
                 b2Body_Enable(pBrickComponent->getBrickId());
             } else {
-                pBrickComponent->getEntity()->enabled = false;
+                pBrickComponent->getEntity()->setEnabled(false);
                 b2Body_Disable(pBrickComponent->getBrickId());
             }
         }
@@ -1070,7 +1074,7 @@ void LevelHandler::setLevel(uint32_t levelId) {
 
     for (auto brickEntity : shuffledBricks) {
         auto pBrickComponent = (Brick*)(brickEntity.get()->findComponent(render::ComponentType::UserBehaviour));
-        if (!pBrickComponent->getEntity()->enabled)
+        if (!pBrickComponent->getEntity()->isEnabled())
             continue;
 
         // Determine brick type
@@ -1095,15 +1099,15 @@ void LevelHandler::setLevel(uint32_t levelId) {
 
     // @TODO: Toggle pinball stuff and enemies etc
     if (currentParams.enablePinballFlippers) {
-        m_flipperLeftEntity->enabled = true;
-        m_flipperRightEntity->enabled = true;
+        m_flipperLeftEntity->setEnabled(true);
+        m_flipperRightEntity->setEnabled(true);
         b2Body_Enable(m_flipperLeftBody.pivot);
         b2Body_Enable(m_flipperLeftBody.body);
         b2Body_Enable(m_flipperRightBody.pivot);
         b2Body_Enable(m_flipperRightBody.body);
     } else {
-        m_flipperLeftEntity->enabled = false;
-        m_flipperRightEntity->enabled = false;
+        m_flipperLeftEntity->setEnabled(false);
+        m_flipperRightEntity->setEnabled(false);
         b2Body_Disable(m_flipperLeftBody.pivot);
         b2Body_Disable(m_flipperLeftBody.body);
         b2Body_Disable(m_flipperRightBody.pivot);
@@ -1111,15 +1115,15 @@ void LevelHandler::setLevel(uint32_t levelId) {
     }
 
     if (currentParams.enableBumpers) {
-        m_bumperEntity->enabled = true;
+        m_bumperEntity->setEnabled(true);
         b2Body_Enable(m_bumperBody);
     } else {
-        m_bumperEntity->enabled = false;
+        m_bumperEntity->setEnabled(false);
         b2Body_Disable(m_bumperBody);
     }
 
     // clearp powerups
-    m_powerupsContainerEntity->children.clear();
+    m_powerupsContainerEntity->clearChildren();
     m_powerupsPhysics.clear();
 
     // reset camera rotation
@@ -1130,17 +1134,17 @@ void LevelHandler::setGameOver() {
     memset(m_userNameBuffer, 0, sizeof(m_userNameBuffer));
     m_usernameBufferPointer = 0;
     m_isUsernameAccepted = false;
-    m_gameoverUiRoot->enabled = true;
-    m_gameoverUsernameTooltip->enabled = true;
-    m_victoryUiRoot->enabled = false;
-    m_victoryUsernameTooltip->enabled = false;
-    m_gameoverLeaderboard->enabled = false;
-    m_victoryLeaderboard->enabled = false;
-    m_victoryUsernameInput->enabled = true;
-    m_gameoverUsernameInput->enabled = true;
-    m_livesUi->getEntity()->enabled = false;
-    m_levelsUi->getEntity()->enabled = false;
-    m_scoresUi->getEntity()->enabled = false;
+    m_gameoverUiRoot->setEnabled(true);
+    m_gameoverUsernameTooltip->setEnabled(true);
+    m_victoryUiRoot->setEnabled(false);
+    m_victoryUsernameTooltip->setEnabled(false);
+    m_gameoverLeaderboard->setEnabled(false);
+    m_victoryLeaderboard->setEnabled(false);
+    m_victoryUsernameInput->setEnabled(true);
+    m_gameoverUsernameInput->setEnabled(true);
+    m_livesUi->getEntity()->setEnabled(false);
+    m_levelsUi->getEntity()->setEnabled(false);
+    m_scoresUi->getEntity()->setEnabled(false);
     m_gameState = GameState::GameOver;
 }
 
@@ -1148,17 +1152,17 @@ void LevelHandler::setWin() {
     memset(m_userNameBuffer, 0, sizeof(m_userNameBuffer));
     m_usernameBufferPointer = 0;
     m_isUsernameAccepted = false;
-    m_gameoverUiRoot->enabled = false;
-    m_gameoverUsernameTooltip->enabled = false;
-    m_victoryUiRoot->enabled = true;
-    m_victoryUsernameTooltip->enabled = true;
-    m_gameoverLeaderboard->enabled = false;
-    m_victoryLeaderboard->enabled = false;
-    m_victoryUsernameInput->enabled = true;
-    m_gameoverUsernameInput->enabled = true;
-    m_livesUi->getEntity()->enabled = false;
-    m_levelsUi->getEntity()->enabled = false;
-    m_scoresUi->getEntity()->enabled = false;
+    m_gameoverUiRoot->setEnabled(false);
+    m_gameoverUsernameTooltip->setEnabled(false);
+    m_victoryUiRoot->setEnabled(true);
+    m_victoryUsernameTooltip->setEnabled(true);
+    m_gameoverLeaderboard->setEnabled(false);
+    m_victoryLeaderboard->setEnabled(false);
+    m_victoryUsernameInput->setEnabled(true);
+    m_gameoverUsernameInput->setEnabled(true);
+    m_livesUi->getEntity()->setEnabled(false);
+    m_levelsUi->getEntity()->setEnabled(false);
+    m_scoresUi->getEntity()->setEnabled(false);
     m_gameState = GameState::Victory;
 }
 
@@ -1166,17 +1170,17 @@ void LevelHandler::restart() {
     memset(m_userNameBuffer, 0, sizeof(m_userNameBuffer));
     m_usernameBufferPointer = 0;
     m_isUsernameAccepted = false;
-    m_gameoverUiRoot->enabled = false;
-    m_gameoverUsernameTooltip->enabled = false;
-    m_victoryUiRoot->enabled = false;
-    m_victoryUsernameTooltip->enabled = false;
-    m_gameoverLeaderboard->enabled = false;
-    m_victoryLeaderboard->enabled = false;
-    m_victoryUsernameInput->enabled = true;
-    m_gameoverUsernameInput->enabled = true;
-    m_livesUi->getEntity()->enabled = true;
-    m_levelsUi->getEntity()->enabled = true;
-    m_scoresUi->getEntity()->enabled = true;
+    m_gameoverUiRoot->setEnabled(false);
+    m_gameoverUsernameTooltip->setEnabled(false);
+    m_victoryUiRoot->setEnabled(false);
+    m_victoryUsernameTooltip->setEnabled(false);
+    m_gameoverLeaderboard->setEnabled(false);
+    m_victoryLeaderboard->setEnabled(false);
+    m_victoryUsernameInput->setEnabled(true);
+    m_gameoverUsernameInput->setEnabled(true);
+    m_livesUi->getEntity()->setEnabled(true);
+    m_levelsUi->getEntity()->setEnabled(true);
+    m_scoresUi->getEntity()->setEnabled(true);
     m_gameState = GameState::Gameplay;
     m_score = 0;
     setLevel(0);
@@ -181,6 +181,10 @@ private:
     int32_t m_oldScore = 0;
     int32_t m_bricksToProgressToNextLevel = 10*4;
     uint32_t m_level = 0;
+    // Values currently shown by the HUD text, so it's only reformatted when they change
+    int32_t m_displayedLives = -1;
+    int32_t m_displayedScore = -1;
+    uint32_t m_displayedLevel = UINT32_MAX;
 
     float m_currentBallSpeed = 0;
     float m_normalBallSpeed = 0;
@@ -0,0 +1,66 @@
+#include "arkanoid/arkanoid_layer.hpp"
+#include "engine/renderer/scene_composer.hpp"
+
+#include <fmt/format.h>
+
+// Overdraw stress test. Stacks layers of Suzannes straight down the camera's view axis so every pixel is covered by several
+// opaque surfaces, which is the worst case for the PBR fragment shader and the best case for the depth pre-pass.
+void ArkanoidLayer::initBenchmarkScene(render::Scene& outScene) {
+
+    constexpr uint32_t k_COLUMNS = 12;
+    constexpr uint32_t k_ROWS = 7;
+    constexpr uint32_t k_LAYERS = 8;
+    constexpr float k_spacing = 3.6f;
+    constexpr float k_layerSpacing = 4.0f;
+
+    using namespace ::render;
+
+    // Metadata
+    outScene.sceneName = "Benchmark";
+    outScene.lightingParams.skybox = {
+        .type = render::SkyboxType::Procedural,
+    };
+    outScene.renderingParams.depthPrepass = DepthPrepassMode::Automatic;
+
+    outScene.push_back(
+        EntityBuilder().withName("Camera")
+        .withPosition({ 0,0,30 })
+        .withCamera({
+            .infiniteFar = true
+            })
+        .withChild(
+            EntityBuilder().withName("Light")
+            .withLight({
+                .colour = {1,1,1}
+                })
+        )
+    );
+
+    Mesh suzanne = getAssetManager()->fetchMesh("test.obj");
+    for (uint32_t layer = 0; layer < k_LAYERS; layer++) {
+        for (uint32_t row = 0; row < k_ROWS; row++) {
+            for (uint32_t column = 0; column < k_COLUMNS; column++) {
+                // Offset every other layer by half a cell so the layers don't line up perfectly behind each other
+                float offset = (layer % 2) * k_spacing * 0.5f;
+                outScene.push_back(
+                    EntityBuilder().withName(fmt::format("Suzanne_{}_{}_{}", layer, row, column))
+                    .withPosition({
+                        (column - (k_COLUMNS - 1) * 0.5f) * k_spacing + offset,
+                        (row - (k_ROWS - 1) * 0.5f) * k_spacing + offset,
+                        -(float)layer * k_layerSpacing })
+                    .withMeshRenderer({
+                        .mesh = suzanne,
+                        .material = {
+                            .shader = m_shaderModernOpaque,
+                            .name = "Suzanne",
+                            .ambient = hlslpp::float3(0.0352941176f, 0.0745098039f, 0.1215686275f),
+                            .diffuse = hlslpp::float3(0.2f + 0.1f * layer, 0.5f, 1.0f - 0.1f * layer),
+                            .roughness = 0.4f,
+                            .diffuseTex = getAssetManager()->fetchTexture("brick_wall.png")
+                        }
+                        })
+                );
+            }
+        }
+    }
+}
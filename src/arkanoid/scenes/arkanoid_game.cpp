@@ -177,6 +177,7 @@ void ArkanoidLayer::initGameScene(render::Scene& outScene) {
         .withParticleSystem({
             .material = {
                 .shader = m_shaderParticle,
+                .graphicsState = k_particleGraphicsState,
                 .diffuse = {1,1,1},
                 .diffuseTex = getAssetManager()->fetchTexture("particle_texture.png"),
                 .brdfLutTex = getAssetManager()->fetchTexture("dfg.hdr"),
@@ -236,6 +237,7 @@ void ArkanoidLayer::initGameScene(render::Scene& outScene) {
         .withParticleSystem({
             .material = {
                 .shader = m_shaderParticle,
+                .graphicsState = k_particleGraphicsState,
                 .diffuse = {1,1,1},
                 .diffuseTex = getAssetManager()->fetchTexture("particles/dirt_particles.png"),
                 .brdfLutTex = getAssetManager()->fetchTexture("dfg.hdr"),
@@ -351,7 +353,7 @@ void ArkanoidLayer::initGameScene(render::Scene& outScene) {
 
     outScene.push_back(
         EntityBuilder().withName("UICanvas")
-        .withUiCanvas()
+        .withUiCanvas(true, /* cacheRendering */ true)
         .withChild(
             EntityBuilder().withName("LivesUI")
             .withUiText({
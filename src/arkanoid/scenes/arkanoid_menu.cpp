@@ -52,7 +52,7 @@ void ArkanoidLayer::initMenuScene(render::Scene& outScene) {
 
     outScene.push_back(
         EntityBuilder().withName("UICanvas")
-        .withUiCanvas()
+        .withUiCanvas(true, /* cacheRendering */ true)
         .withChild(
             EntityBuilder().withName("Logo")
             .withUiText({
@@ -2,10 +2,11 @@
 #include "engine/log.hpp"
 #include "engine/core.hpp"
 #include "engine/gpu/device_manager.hpp"
+#include "engine/gpu/null/nulldevice.hpp"
+#include "engine/gpu/software/softwaredevice.hpp"
 #include "engine/events/application_event.hpp"
 
 #include <chrono>
-#include <thread>
 #include <algorithm>
 
 namespace engine {
@@ -22,16 +23,36 @@ namespace engine {
 		// init seed
 		RandomNumberGenerator::init();
 
-		m_maxFrameRate = desc.maxFramerate;
-		m_maxFrameTime = 1.0 / desc.maxFramerate;
+		if (desc.softwareRendering) {
+			desc.headless = true;
+		}
+		if (desc.headless) {
+			// Nothing to sync to, run as fast as maxFramerate allows
+			desc.window.headless = true;
+			desc.framePacing = FramePacingMode::Limited;
+		}
+		m_appProps = desc;
+
+		m_dynamicResolution.init(desc.dynamicResolution);
 
 		m_inputManager = new input::InputManager;
 		m_inputManager->init();
 		m_window = std::make_unique<Window>(desc.window, desc.openglMajor, desc.openglMinor);
 		m_window->createNativeWindow();
+		m_framePacer.init(desc.framePacing, desc.maxFramerate, m_window.get());
 
-		m_graphicsDeviceManager = gpu::DeviceManager::create();
+		gpu::GraphicsApi api = gpu::GraphicsApi::OpenGL;
+		if (desc.softwareRendering) {
+			api = gpu::GraphicsApi::Software;
+		} else if (desc.headless) {
+			api = gpu::GraphicsApi::Null;
+		}
+		m_graphicsDeviceManager = gpu::DeviceManager::create(api, desc.capturePath);
 		m_graphicsDevice = m_graphicsDeviceManager->getDevice();
+		if (api == gpu::GraphicsApi::Software) {
+			// No window to draw into, the backbuffer stands in for it
+			static_cast<gpu::software::SoftwareDevice*>(m_graphicsDeviceManager->getBackendDevice())->resizeBackbuffer(desc.window.width, desc.window.height);
+		}
 
 		// Set initial viewport to the window size
 		gpu::Rect viewport = {
@@ -63,9 +84,19 @@ namespace engine {
 		auto lastTime = std::chrono::high_resolution_clock::now();
 		double timeElapsed = 0.0;
 		double physicsAccumulator = 0.0;
-		double sleepTime = 0.0;
+		uint32_t frameCount = 0;
+		double totalCpuFrameTime = 0.0;
+		double maxCpuFrameTime = 0.0;
 
 		while (!m_window->shouldCloseWindow() && m_isRunning) {
+			if (m_appProps.frameLimit != 0 && frameCount >= m_appProps.frameLimit) {
+				break;
+			}
+			frameCount++;
+
+			// Wait for the latest point the frame can start and still make its present, then sample input right away
+			m_framePacer.waitForNextFrame();
+			m_window->pollEvents();
 
 			// @NOTE: deltaTime is 0 for the first frame of the app's lifetime
 			auto currentTime = std::chrono::high_resolution_clock::now();
@@ -84,14 +115,11 @@ namespace engine {
 				timeElapsed += k_FIXED_DELTA_TIME;
 			}
 
-			if (m_maxFrameTime > 0) {
-				sleepTime += m_maxFrameTime - frameTime;
-				sleepTime = std::max(sleepTime, 0.0);
-				std::this_thread::sleep_for(std::chrono::nanoseconds((long long)(1000000000 * sleepTime)));
-			}
-
 			// don't issue draw calls while minimised
 			if (!m_minimised) {
+#if ENGINE_GPU_TIMINGS
+				m_graphicsDevice->beginProfilingFrame();
+#endif
 				// draw events
 				for (engine::ILayer* layer : m_layerStack) {
 					layer->render(frameTime);
@@ -103,13 +131,56 @@ namespace engine {
 					layer->imguiDraw();
 				}
 				m_imguiLayer->end();
+#if ENGINE_GPU_TIMINGS
+				m_graphicsDevice->endProfilingFrame();
+#endif
 
 				// Present
 				m_graphicsDevice->present();
+
+				// The first GPU timing always covers the whole frame
+				const std::vector<gpu::GpuScopeTiming>& gpuTimings = m_graphicsDevice->getProfilingResults();
+				double gpuFrameTime = gpuTimings.empty() ? 0.0 : gpuTimings[0].milliseconds * 0.001;
+				// Time spent producing the frame, leaving out the pacer's wait and the wait for vsync in windowPresent
+				double cpuFrameTime = m_framePacer.endFrameWork(gpuFrameTime);
+				m_dynamicResolution.update(cpuFrameTime, gpuFrameTime);
+				totalCpuFrameTime += cpuFrameTime;
+				maxCpuFrameTime = std::max(maxCpuFrameTime, cpuFrameTime);
+
 				m_window->windowPresent();
+				m_framePacer.framePresented();
+			} else {
+				m_framePacer.skipFrame();
 			}
 
 		}
+
+		if (m_appProps.headless && frameCount > 0) {
+			// Summary for CI, the device counted the work of the last frame
+			LOG_INFO("Headless run finished after {} frames. CPU frame time: {:.3f} ms average, {:.3f} ms max",
+				frameCount, totalCpuFrameTime * 1000.0 / frameCount, maxCpuFrameTime * 1000.0);
+			if (m_graphicsDeviceManager->getApi() == gpu::GraphicsApi::Software) {
+				gpu::software::SoftwareDevice* softwareDevice = static_cast<gpu::software::SoftwareDevice*>(m_graphicsDeviceManager->getBackendDevice());
+				const gpu::software::SoftwareFrameStats& frameStats = softwareDevice->getLastFrameStats();
+				LOG_INFO("Last frame: {} draws ({} skipped, no software shader), {} clears, {:.3f} ms rasterizing on {} threads",
+					frameStats.drawCalls, frameStats.skippedDrawCalls, frameStats.clears, frameStats.rasterMilliseconds, softwareDevice->getThreadCount());
+				LOG_INFO("Last frame: {} vertices shaded, {} triangles submitted, {} rejected, {} clipped, {} binned, {} fragments shaded, {} discarded",
+					frameStats.raster.verticesShaded, frameStats.raster.trianglesSubmitted, frameStats.raster.trianglesRejected, frameStats.raster.trianglesClipped,
+					frameStats.raster.trianglesBinned, frameStats.raster.fragmentsShaded, frameStats.raster.fragmentsDiscarded);
+				if (!m_appProps.screenshotPath.empty()) {
+					softwareDevice->writeBackbufferImage(m_appProps.screenshotPath);
+				}
+			} else {
+				const gpu::null::NullDevice* nullDevice = static_cast<const gpu::null::NullDevice*>(m_graphicsDeviceManager->getBackendDevice());
+				const gpu::null::NullFrameStats& frameStats = nullDevice->getLastFrameStats();
+				LOG_INFO("Last frame: {} draws ({} indexed), {} triangles, {} pipeline changes ({} shader, {} blend state), {} texture binds, {} framebuffer binds, {} bytes uploaded",
+					frameStats.drawCalls, frameStats.indexedDrawCalls, frameStats.triangles, frameStats.pipelineChanges, frameStats.shaderChanges, frameStats.blendStateChanges,
+					frameStats.textureBinds, frameStats.framebufferBinds, frameStats.bytesWritten);
+				if (nullDevice->getValidationErrorCount() > 0) {
+					LOG_ERROR("Null device reported {} validation errors", nullDevice->getValidationErrorCount());
+				}
+			}
+		}
 		m_window->close();
 	}
 
@@ -15,6 +15,8 @@
 #include "engine/managers/asset_manager.hpp"
 #include "engine/input/input_manager.hpp"
 #include "engine/log.hpp"
+#include "engine/renderer/dynamic_resolution.hpp"
+#include "engine/frame_pacer.hpp"
 
 struct AppDesc {
 	// Window props
@@ -23,7 +25,24 @@ struct AppDesc {
 	int32_t openglMajor = 3;
 	int32_t openglMinor = 3;
 
+	// How frames are paced against the display. maxFramerate only applies to FramePacingMode::Limited, 0 leaves it uncapped
+	engine::FramePacingMode framePacing = engine::FramePacingMode::Vsync;
 	double maxFramerate = 60.0f;
+
+	// Dynamic resolution. The 3D scene is rendered offscreen at a fraction of the window size, picked to keep frames within
+	// the target frame time, then upscaled to the backbuffer. UI always renders at native resolution
+	render::DynamicResolutionDesc dynamicResolution = {};
+
+	// Runs without a window or GPU, rendering through the null device. Frames are paced with FramePacingMode::Limited
+	bool headless = false;
+	// Headless, but rendered through the software device instead of the null device
+	bool softwareRendering = false;
+	// Software rendering only, writes the last frame to this PPM image when the app stops. Empty disables it
+	std::string screenshotPath = "";
+	// Stops the app after this many frames, 0 runs until the window is closed. Headless apps can't be closed any other way
+	uint32_t frameLimit = 0;
+	// Records every device call of the session into this file, for replaying with the CaptureReplay tool. Empty disables it
+	std::string capturePath = "";
 };
 
 namespace engine {
@@ -71,6 +90,8 @@ namespace engine {
 		[[nodiscard]] inline gpu::DeviceManager* getDeviceManager() { return m_graphicsDeviceManager; };
 		[[nodiscard]] inline ImguiLayer* getImguiLayer() { return m_imguiLayer; };
 		[[nodiscard]] inline managers::AssetManager* getAssetManager() { return m_assetManager; };
+		[[nodiscard]] inline render::DynamicResolutionController& getDynamicResolution() { return m_dynamicResolution; };
+		[[nodiscard]] inline FramePacer& getFramePacer() { return m_framePacer; };
 
 		[[nodiscard]] inline static App* getInstance() { return s_instance; };
 		
@@ -94,8 +115,8 @@ namespace engine {
 		bool m_isRunning = false;
 		bool m_minimised = false;
 
-		double m_maxFrameRate = 0;
-		double m_maxFrameTime = 0;
+		FramePacer m_framePacer;
+		render::DynamicResolutionController m_dynamicResolution;
 
 		static App* s_instance;
 	};
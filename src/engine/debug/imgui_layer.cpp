@@ -28,6 +28,14 @@ namespace engine {
         // Setup Dear ImGui style
         ImGui::StyleColorsDark();
 
+        if (engine::App::getInstance()->getWindow()->isHeadless()) {
+            // No platform or renderer to bind to. The font atlas still has to be built, usually the renderer does it
+            unsigned char* pixels = nullptr;
+            int width = 0, height = 0;
+            io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+            return;
+        }
+
         GLFWwindow* glfwWindow = reinterpret_cast<GLFWwindow*>(engine::App::getInstance()->getWindow()->getHandle());
 
         // Setup Platform/Renderer bindings
@@ -36,6 +44,10 @@ namespace engine {
     }
 
     void ImguiLayer::detach() {
+        if (engine::App::getInstance()->getWindow()->isHeadless()) {
+            ImGui::DestroyContext();
+            return;
+        }
         ImGui_ImplOpenGL3_Shutdown();
         ImGui_ImplGlfw_Shutdown();
         ImGui::DestroyContext();
@@ -51,8 +63,16 @@ namespace engine {
 
     void ImguiLayer::begin() {
         // Start the Dear ImGui frame
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
+        if (engine::App::getInstance()->getWindow()->isHeadless()) {
+            // Normally set by the GLFW backend
+            ImGui::GetIO().DisplaySize = ImVec2(
+                (float) engine::App::getInstance()->getWindow()->getWidth(),
+                (float) engine::App::getInstance()->getWindow()->getHeight()
+            );
+        } else {
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+        }
         ImGui::NewFrame();
     }
 
@@ -67,7 +87,36 @@ namespace engine {
 
         // Rendering
         ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        if (!engine::App::getInstance()->getWindow()->isHeadless()) {
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+    }
+
+    void ImguiLayer::imguiDraw() {
+#if ENGINE_GPU_TIMINGS
+        if (!m_showGpuTimings) {
+            return;
+        }
+
+        // Read back a few frames late, see gpu::k_gpuProfilerLatency
+        const std::vector<gpu::GpuScopeTiming>& timings = getDevice()->getProfilingResults();
+        ImGui::Begin("GPU Timings");
+        if (ImGui::BeginTable("GpuTimingsTable", 2, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders)) {
+            ImGui::TableSetupColumn("Pass");
+            ImGui::TableSetupColumn("GPU ms");
+            ImGui::TableHeadersRow();
+            for (const gpu::GpuScopeTiming& timing : timings) {
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                // Indent nested scopes under their parent
+                ImGui::Text("%*s%s", static_cast<int>(timing.depth * 2), "", timing.name);
+                ImGui::TableSetColumnIndex(1);
+                ImGui::Text("%.3f", timing.milliseconds);
+            }
+            ImGui::EndTable();
+        }
+        ImGui::End();
+#endif
     }
 
     uint32_t ImguiLayer::getActiveWidgetId() const {
@@ -13,15 +13,22 @@ namespace engine {
         virtual void attach() override;
         virtual void detach() override;
         virtual void event(events::Event& event) override;
+        virtual void imguiDraw() override;
 
         void begin();
         void end();
 
         void blockEvents(bool block) { m_eventsBlocked = block; }
+        void showGpuTimings(bool show) { m_showGpuTimings = show; }
 
         uint32_t getActiveWidgetId() const;
 
     private:
         bool m_eventsBlocked = true;
+#if _DEBUG
+        bool m_showGpuTimings = true;
+#else
+        bool m_showGpuTimings = false;
+#endif
     };
 }
\ No newline at end of file
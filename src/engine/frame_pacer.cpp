@@ -0,0 +1,201 @@
+#include "frame_pacer.hpp"
+#include "engine/core.hpp"
+#include "engine/window.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace engine {
+
+    static inline double toSeconds(FramePacer::Clock::duration duration) {
+        return std::chrono::duration<double>(duration).count();
+    }
+
+    static inline FramePacer::Clock::duration fromSeconds(double seconds) {
+        return std::chrono::duration_cast<FramePacer::Clock::duration>(std::chrono::duration<double>(seconds));
+    }
+
+    void FramePacer::init(FramePacingMode mode, double maxFramerate, Window* pWindow) {
+        ASSERT(pWindow != nullptr);
+        ASSERT(mode < FramePacingMode::Count);
+
+        m_pWindow = pWindow;
+        m_maxFrameTime = maxFramerate > 0.0 ? 1.0 / maxFramerate : 0.0;
+        double refreshRate = pWindow->getRefreshRate();
+        m_refreshInterval = refreshRate > 0.0 ? 1.0 / refreshRate : 1.0 / 60.0;
+        m_adaptiveSwapSupported = pWindow->supportsAdaptiveVsync();
+
+        setMode(mode);
+    }
+
+    void FramePacer::setMode(FramePacingMode mode) {
+        ASSERT(mode < FramePacingMode::Count);
+
+        m_mode = mode;
+        m_vsyncActive = mode != FramePacingMode::Limited;
+        applySwapInterval();
+
+        // The old cadence means nothing in the new mode
+        m_hasDeadline = false;
+        m_hasPresented = false;
+        m_intervalCount = 0;
+        m_intervalCursor = 0;
+    }
+
+    void FramePacer::applySwapInterval() {
+        switch (m_mode) {
+        case FramePacingMode::Vsync:
+            m_pWindow->setSwapInterval(1);
+            break;
+        case FramePacingMode::Limited:
+            m_pWindow->setSwapInterval(0);
+            break;
+        case FramePacingMode::Adaptive:
+            m_pWindow->setSwapInterval(m_adaptiveSwapSupported ? -1 : (m_vsyncActive ? 1 : 0));
+            break;
+        }
+    }
+
+    double FramePacer::getTargetInterval() const {
+        return m_mode == FramePacingMode::Limited ? m_maxFrameTime : m_refreshInterval;
+    }
+
+    void FramePacer::waitForNextFrame() {
+        if (m_hasDeadline) {
+            // Start as late as possible so the input sampled at the start of the frame is as fresh as it can be.
+            // If the predicted cost no longer fits, the target is already behind us and the frame starts immediately
+            waitUntil(m_nextDeadline - fromSeconds(m_predictedCost + k_framePacingSafetyMargin));
+        }
+        m_frameStart = Clock::now();
+    }
+
+    double FramePacer::endFrameWork(double gpuFrameTime) {
+        double cpuFrameTime = toSeconds(Clock::now() - m_frameStart);
+
+        // Predict the next frame's cost from a smoothed average plus twice the smoothed deviation, so a frame which
+        // runs a little long still makes its present
+        double cost = std::max(cpuFrameTime, gpuFrameTime);
+        if (m_averageCost <= 0.0) {
+            m_averageCost = cost;
+            m_costDeviation = 0.0;
+        } else {
+            double deviation = std::abs(cost - m_averageCost);
+            m_averageCost += (cost - m_averageCost) * k_framePacingCostSmoothing;
+            m_costDeviation += (deviation - m_costDeviation) * k_framePacingCostSmoothing;
+        }
+        m_predictedCost = m_averageCost + 2.0 * m_costDeviation;
+
+        // Without driver support, emulate adaptive vsync. Waiting for vblank on a frame which already missed it halves
+        // the frame rate, tearing costs less
+        if (m_mode == FramePacingMode::Adaptive && !m_adaptiveSwapSupported) {
+            if (m_vsyncActive && m_predictedCost > m_refreshInterval * k_adaptiveVsyncOffThreshold) {
+                m_vsyncActive = false;
+                applySwapInterval();
+            } else if (!m_vsyncActive && m_predictedCost < m_refreshInterval * k_adaptiveVsyncOnThreshold) {
+                m_vsyncActive = true;
+                applySwapInterval();
+            }
+        }
+
+        return cpuFrameTime;
+    }
+
+    void FramePacer::framePresented() {
+        Clock::time_point now = Clock::now();
+        if (m_hasPresented) {
+            m_intervals[m_intervalCursor] = toSeconds(now - m_lastPresent);
+            m_intervalCursor = (m_intervalCursor + 1) % k_framePacingHistory;
+            m_intervalCount = std::min(m_intervalCount + 1, k_framePacingHistory);
+        }
+        m_lastPresent = now;
+        m_hasPresented = true;
+
+        double interval = getTargetInterval();
+        if (m_mode == FramePacingMode::Limited) {
+            if (interval <= 0.0) {
+                // Uncapped
+                m_hasDeadline = false;
+                return;
+            }
+            // Step from the previous deadline rather than from now, so sleep overshoot doesn't slowly lower the frame rate.
+            // Once more than a frame behind, restart the cadence instead of rushing frames out to catch up
+            m_nextDeadline = m_hasDeadline ? m_nextDeadline + fromSeconds(interval) : now + fromSeconds(interval);
+            if (m_nextDeadline < now) {
+                m_nextDeadline = now + fromSeconds(interval);
+            }
+            m_hasDeadline = true;
+        } else {
+            // The swap returns at vblank, the next one is a refresh away. Tearing frames present as soon as they are done
+            m_nextDeadline = now + fromSeconds(interval);
+            m_hasDeadline = m_vsyncActive;
+        }
+    }
+
+    void FramePacer::skipFrame() {
+        // Nothing is presented, but keep the loop from spinning at full speed
+        m_nextDeadline = Clock::now() + fromSeconds(std::max(getTargetInterval(), m_refreshInterval) + m_predictedCost + k_framePacingSafetyMargin);
+        m_hasDeadline = true;
+        m_hasPresented = false;
+    }
+
+    void FramePacer::waitUntil(Clock::time_point target) {
+        while (true) {
+            Clock::time_point now = Clock::now();
+            if (now >= target) {
+                return;
+            }
+
+            double remaining = toSeconds(target - now);
+            if (remaining > m_spinThreshold) {
+                // Sleep wakes up late by up to the scheduler's granularity, so leave the last stretch to spin
+                double requested = remaining - m_spinThreshold;
+                std::this_thread::sleep_for(fromSeconds(requested));
+                double overshoot = toSeconds(Clock::now() - now) - requested;
+                // Follow the worst recent overshoot, decaying slowly once sleeps become more accurate
+                m_spinThreshold = std::clamp(std::max(overshoot * 1.5, m_spinThreshold * 0.99), k_framePacingMinSpin, k_framePacingMaxSpin);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    FramePacingStats FramePacer::computeStats() const {
+        FramePacingStats stats = {
+            .targetInterval = getTargetInterval(),
+            .predictedCost = m_predictedCost,
+            .sampleCount = m_intervalCount,
+            .vsyncActive = m_vsyncActive,
+        };
+        if (m_intervalCount == 0) {
+            return stats;
+        }
+
+        double total = 0.0;
+        for (uint32_t i = 0; i < m_intervalCount; i++) {
+            total += m_intervals[i];
+        }
+        stats.averageInterval = total / m_intervalCount;
+
+        // Uncapped frames have no target, measure jitter against the average instead
+        double reference = stats.targetInterval > 0.0 ? stats.targetInterval : stats.averageInterval;
+        double jitter[k_framePacingHistory];
+        for (uint32_t i = 0; i < m_intervalCount; i++) {
+            jitter[i] = std::abs(m_intervals[i] - reference);
+            if (m_intervals[i] > reference * 1.5) {
+                stats.missedFrames++;
+            }
+        }
+
+        auto percentile = [&](double fraction) {
+            uint32_t index = std::min(m_intervalCount - 1, static_cast<uint32_t>(fraction * (m_intervalCount - 1) + 0.5));
+            std::nth_element(jitter, jitter + index, jitter + m_intervalCount);
+            return jitter[index];
+        };
+        stats.jitterP50 = percentile(0.50);
+        stats.jitterP95 = percentile(0.95);
+        stats.jitterP99 = percentile(0.99);
+
+        return stats;
+    }
+}
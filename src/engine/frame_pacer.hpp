@@ -0,0 +1,106 @@
+#pragma once
+
+#include <inttypes.h>
+#include <chrono>
+
+namespace engine {
+
+    class Window;
+
+    enum class FramePacingMode : uint8_t {
+        // Swap interval 1, the display paces frames. maxFramerate is ignored
+        Vsync,
+        // Swap interval 0, frames are paced to maxFramerate with a hybrid sleep and spin wait
+        Limited,
+        // Vsync while frames fit in a refresh, tearing instead of dropping to half the refresh rate when they don't.
+        // Uses the driver's adaptive swap interval when available, otherwise toggles vsync from the predicted frame cost
+        Adaptive,
+        Count,
+    };
+
+    // Frame intervals kept for the pacing statistics
+    constexpr uint32_t k_framePacingHistory = 256;
+    // Slack left between the predicted end of a frame and its deadline
+    constexpr double k_framePacingSafetyMargin = 0.001;
+    // Bounds on how long before a deadline the pacer stops sleeping and spins instead
+    constexpr double k_framePacingMinSpin = 0.0005;
+    constexpr double k_framePacingMaxSpin = 0.004;
+    // Weight of the newest sample in the frame cost prediction
+    constexpr double k_framePacingCostSmoothing = 0.1;
+    // Adaptive mode without driver support turns vsync off once the predicted cost passes the first fraction of a refresh,
+    // and back on once it drops under the second
+    constexpr double k_adaptiveVsyncOffThreshold = 0.95;
+    constexpr double k_adaptiveVsyncOnThreshold = 0.8;
+
+    struct FramePacingStats {
+        // Interval the pacer is aiming for between presents, in seconds
+        double targetInterval = 0.0;
+        double averageInterval = 0.0;
+        double predictedCost = 0.0;
+        // Percentiles of how far present intervals were from the target, in seconds
+        double jitterP50 = 0.0;
+        double jitterP95 = 0.0;
+        double jitterP99 = 0.0;
+        // Frames in the history which took over 1.5x the target interval
+        uint32_t missedFrames = 0;
+        uint32_t sampleCount = 0;
+        bool vsyncActive = false;
+    };
+
+    // Decides when each frame starts. Frames start as late as the predicted frame cost allows while still making the next
+    // present, so input is sampled as close to the display as possible. Waits are skipped entirely when running behind
+    class FramePacer {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        void init(FramePacingMode mode, double maxFramerate, Window* pWindow);
+        void setMode(FramePacingMode mode);
+
+        // Blocks until the next frame should start
+        void waitForNextFrame();
+        // Marks the end of the frame's CPU work, right before presenting. Returns the CPU time the frame took.
+        // gpuFrameTime is optional, when known it takes part in the cost prediction
+        double endFrameWork(double gpuFrameTime = 0.0);
+        // Marks the frame as presented, after the buffer swap returns
+        void framePresented();
+        // Called instead of endFrameWork and framePresented when nothing was drawn, e.g. while minimised
+        void skipFrame();
+
+        [[nodiscard]] inline FramePacingMode getMode() const { return m_mode; }
+        [[nodiscard]] inline double getPredictedCost() const { return m_predictedCost; }
+        // Sorts a copy of the history, call when displaying the stats rather than every frame
+        [[nodiscard]] FramePacingStats computeStats() const;
+
+    private:
+        // Interval between presents the current mode is aiming for
+        double getTargetInterval() const;
+        // Sleeps while the target is far away, then spins for the last stretch the OS scheduler can't hit reliably
+        void waitUntil(Clock::time_point target);
+        void applySwapInterval();
+
+        FramePacingMode m_mode = FramePacingMode::Vsync;
+        Window* m_pWindow = nullptr;
+        double m_maxFrameTime = 0.0;
+        double m_refreshInterval = 1.0 / 60.0;
+        bool m_adaptiveSwapSupported = false;
+        bool m_vsyncActive = true;
+
+        Clock::time_point m_frameStart = {};
+        Clock::time_point m_lastPresent = {};
+        // When the next present is due. Invalid when presenting as fast as possible
+        Clock::time_point m_nextDeadline = {};
+        bool m_hasDeadline = false;
+        // False until a frame was presented, or after a skipped frame, so the next interval isn't recorded
+        bool m_hasPresented = false;
+
+        double m_averageCost = 0.0;
+        double m_costDeviation = 0.0;
+        double m_predictedCost = 0.0;
+        // Margin kept for spinning, grows with how far the OS overshoots sleeps
+        double m_spinThreshold = 0.002;
+
+        double m_intervals[k_framePacingHistory] = {};
+        uint32_t m_intervalCount = 0;
+        uint32_t m_intervalCursor = 0;
+    };
+}
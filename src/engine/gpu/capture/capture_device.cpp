@@ -0,0 +1,398 @@
+#include "capture_device.hpp"
+#include "engine/core.hpp"
+#include "engine/log.hpp"
+
+#include <cstring>
+
+namespace gpu::capture {
+
+	CaptureDevice::CaptureDevice(DeviceHandle device, const std::string& path) : m_device(device) {
+		ASSERT(m_device != nullptr);
+
+		m_file = fopen(path.c_str(), "wb");
+		if (m_file == nullptr) {
+			LOG_ERROR("Failed to open capture file \"{}\", device calls won't be captured", path);
+			return;
+		}
+		CaptureHeader header = {};
+		fwrite(&header, sizeof(header), 1, m_file);
+		LOG_INFO("Capturing device calls to \"{}\"", path);
+	}
+
+	CaptureDevice::~CaptureDevice() {
+		if (m_file != nullptr) {
+			flush();
+			fclose(m_file);
+			LOG_INFO("Captured {} frames", m_capturedFrames);
+		}
+	}
+
+	uint32_t CaptureDevice::registerObject(const void* object) {
+		uint32_t id = m_nextObjectId++;
+		m_objectIds[object] = id;
+		return id;
+	}
+
+	uint32_t CaptureDevice::getObjectId(const void* object) {
+		if (object == nullptr) {
+			return 0;
+		}
+		auto it = m_objectIds.find(object);
+		return it != m_objectIds.end() ? it->second : 0;
+	}
+
+	void CaptureDevice::flush() {
+		if (m_file != nullptr && !m_writer.getData().empty()) {
+			fwrite(m_writer.getData().data(), 1, m_writer.getData().size(), m_file);
+			fflush(m_file);
+		}
+		m_writer.clear();
+	}
+
+	void CaptureDevice::setViewport(const Rect viewportRect) {
+		writeCommand(CaptureCommand::SetViewport);
+		m_writer.write(viewportRect);
+		m_device->setViewport(viewportRect);
+	}
+
+	void CaptureDevice::setScissor(bool enabled, const Rect scissorRect) {
+		writeCommand(CaptureCommand::SetScissor);
+		m_writer.write(enabled);
+		m_writer.write(scissorRect);
+		m_device->setScissor(enabled, scissorRect);
+	}
+
+	InputLayoutHandle CaptureDevice::createInputLayout(const VertexAttributeDesc* desc, uint32_t attributeCount) {
+		InputLayoutHandle inputLayout = m_device->createInputLayout(desc, attributeCount);
+		writeCommand(CaptureCommand::CreateInputLayout);
+		m_writer.write(registerObject(inputLayout.Get()));
+		m_writer.write(attributeCount);
+		for (uint32_t i = 0; i < attributeCount; i++) {
+			serialize(m_writer, desc[i]);
+		}
+		return inputLayout;
+	}
+
+	ShaderHandle CaptureDevice::makeShader(const ShaderDesc shaderDesc) {
+		ShaderHandle shader = m_device->makeShader(shaderDesc);
+		writeCommand(CaptureCommand::MakeShader);
+		m_writer.write(registerObject(shader.Get()));
+		serialize(m_writer, shaderDesc);
+		return shader;
+	}
+
+	PipelineHandle CaptureDevice::makePipeline(const PipelineDesc pipelineDesc) {
+		PipelineHandle pipeline = m_device->makePipeline(pipelineDesc);
+		writeCommand(CaptureCommand::MakePipeline);
+		m_writer.write(registerObject(pipeline.Get()));
+		m_writer.write(getObjectId(pipelineDesc.shader));
+		m_writer.write(getObjectId(pipelineDesc.inputLayout));
+		m_writer.write(pipelineDesc.graphicsState);
+		m_writer.write(getObjectId(pipelineDesc.blendState));
+		return pipeline;
+	}
+
+	std::string CaptureDevice::getShaderBinaryTag() const {
+		return m_device->getShaderBinaryTag();
+	}
+
+	bool CaptureDevice::getShaderBinary(IShader* shader, ShaderBinary& outBinary) {
+		return m_device->getShaderBinary(shader, outBinary);
+	}
+
+	//
+	// Buffers
+	//
+
+	BufferHandle CaptureDevice::makeBuffer(const BufferDesc bufferDesc) {
+		BufferHandle buffer = m_device->makeBuffer(bufferDesc);
+		writeCommand(CaptureCommand::MakeBuffer);
+		m_writer.write(registerObject(buffer.Get()));
+		serialize(m_writer, bufferDesc);
+		return buffer;
+	}
+
+	void CaptureDevice::writeBuffer(IBuffer* handle, size_t size, const void* data) {
+		writeCommand(CaptureCommand::WriteBuffer);
+		m_writer.write(getObjectId(handle));
+		m_writer.write<uint64_t>(size);
+		m_writer.writeBlob(data, size);
+		m_device->writeBuffer(handle, size, data);
+	}
+
+	void CaptureDevice::mapBuffer(IBuffer* buffer, uint32_t offset, size_t length, MapAccessFlags accessFlags, void** mappedDataPtr) {
+		writeCommand(CaptureCommand::MapBuffer);
+		m_writer.write(getObjectId(buffer));
+		m_writer.write(offset);
+		m_writer.write<uint64_t>(length);
+		m_writer.write(accessFlags);
+		if ((accessFlags & MapAccessFlags::Read) != 0) {
+			m_device->mapBuffer(buffer, offset, length, accessFlags, mappedDataPtr);
+			return;
+		}
+
+		// Reading back through a write mapping is undefined (and slow on write-combined memory), so the caller writes
+		// into a shadow copy instead. It is recorded and copied into the real mapping on unmap
+		void* deviceData = nullptr;
+		m_device->mapBuffer(buffer, offset, length, accessFlags, &deviceData);
+		if (deviceData == nullptr) {
+			*mappedDataPtr = nullptr;
+			return;
+		}
+		ActiveMapping mapping = { .deviceData = deviceData };
+		if (!m_freeShadows.empty()) {
+			mapping.shadow = std::move(m_freeShadows.back());
+			m_freeShadows.pop_back();
+		}
+		mapping.shadow.assign(length, 0);
+		*mappedDataPtr = mapping.shadow.data();
+		m_activeMappings[buffer] = std::move(mapping);
+	}
+
+	void CaptureDevice::unmapBuffer(IBuffer* buffer) {
+		writeCommand(CaptureCommand::UnmapBuffer);
+		m_writer.write(getObjectId(buffer));
+		auto it = m_activeMappings.find(buffer);
+		if (it == m_activeMappings.end()) {
+			m_writer.writeBlob(nullptr, 0);
+			m_device->unmapBuffer(buffer);
+			return;
+		}
+		std::vector<uint8_t>& shadow = it->second.shadow;
+		m_writer.writeBlob(shadow.data(), shadow.size());
+		memcpy(it->second.deviceData, shadow.data(), shadow.size());
+		m_device->unmapBuffer(buffer);
+		m_freeShadows.push_back(std::move(shadow));
+		m_activeMappings.erase(it);
+	}
+
+	void CaptureDevice::bindBuffer(IBuffer* buffer) {
+		writeCommand(CaptureCommand::BindBuffer);
+		m_writer.write(getObjectId(buffer));
+		m_device->bindBuffer(buffer);
+	}
+
+	void CaptureDevice::unbindBuffer(IBuffer* buffer) {
+		writeCommand(CaptureCommand::UnbindBuffer);
+		m_writer.write(getObjectId(buffer));
+		m_device->unbindBuffer(buffer);
+	}
+
+	void CaptureDevice::setConstantBuffer(IBuffer* buffer, uint32_t bindIndex) {
+		writeCommand(CaptureCommand::SetConstantBuffer);
+		m_writer.write(getObjectId(buffer));
+		m_writer.write(bindIndex);
+		m_device->setConstantBuffer(buffer, bindIndex);
+	}
+
+	void CaptureDevice::unbindConstantBuffer(IBuffer* buffer, uint32_t bindIndex) {
+		writeCommand(CaptureCommand::UnbindConstantBuffer);
+		m_writer.write(getObjectId(buffer));
+		m_writer.write(bindIndex);
+		m_device->unbindConstantBuffer(buffer, bindIndex);
+	}
+
+	void CaptureDevice::setBufferBinding(IShader* shader, const std::string& name, uint32_t bindIndex) {
+		writeCommand(CaptureCommand::SetBufferBinding);
+		m_writer.write(getObjectId(shader));
+		m_writer.writeString(name);
+		m_writer.write(bindIndex);
+		m_device->setBufferBinding(shader, name, bindIndex);
+	}
+
+	void CaptureDevice::registerUniformBlock(const UniformBlockDesc& desc) {
+		writeCommand(CaptureCommand::RegisterUniformBlock);
+		serialize(m_writer, desc);
+		m_device->registerUniformBlock(desc);
+	}
+
+	//
+	// Draws
+	//
+
+	void CaptureDevice::draw(DrawCallState drawCallState, size_t triangleCount, size_t offset, size_t instances, size_t firstInstance) {
+		writeCommand(CaptureCommand::Draw);
+		m_writer.write(getObjectId(drawCallState.vertexBufer));
+		m_writer.write(getObjectId(drawCallState.pipeline));
+		m_writer.write(drawCallState.primitiveType);
+		m_writer.write<uint64_t>(triangleCount);
+		m_writer.write<uint64_t>(offset);
+		m_writer.write<uint64_t>(instances);
+		m_writer.write<uint64_t>(firstInstance);
+		m_device->draw(drawCallState, triangleCount, offset, instances, firstInstance);
+	}
+
+	void CaptureDevice::drawIndexed(DrawCallState drawCallState, size_t triangleCount, size_t offset, size_t instances, size_t firstInstance) {
+		writeCommand(CaptureCommand::DrawIndexed);
+		m_writer.write(getObjectId(drawCallState.vertexBufer));
+		m_writer.write(getObjectId(drawCallState.indexBuffer));
+		m_writer.write(getObjectId(drawCallState.pipeline));
+		m_writer.write(drawCallState.primitiveType);
+		m_writer.write<uint64_t>(triangleCount);
+		m_writer.write<uint64_t>(offset);
+		m_writer.write<uint64_t>(instances);
+		m_writer.write<uint64_t>(firstInstance);
+		m_device->drawIndexed(drawCallState, triangleCount, offset, instances, firstInstance);
+	}
+
+	void CaptureDevice::clearColor(Color color, float depth) {
+		writeCommand(CaptureCommand::ClearColor);
+		m_writer.write(color);
+		m_writer.write(depth);
+		m_device->clearColor(color, depth);
+	}
+
+	void CaptureDevice::present() {
+		writeCommand(CaptureCommand::Present);
+		m_device->present();
+		m_capturedFrames++;
+		flush();
+	}
+
+	//
+	// Blend state
+	//
+
+	BlendStateHandle CaptureDevice::makeBlendState(const BlendStateDesc blendStateDesc) {
+		BlendStateHandle blendState = m_device->makeBlendState(blendStateDesc);
+		writeCommand(CaptureCommand::MakeBlendState);
+		m_writer.write(registerObject(blendState.Get()));
+		m_writer.write(blendStateDesc);
+		return blendState;
+	}
+
+	//
+	// Textures
+	//
+
+	TextureHandle CaptureDevice::makeTexture(TextureDesc desc, void* textureData) {
+		TextureHandle texture = m_device->makeTexture(desc, textureData);
+		writeCommand(CaptureCommand::MakeTexture);
+		m_writer.write(registerObject(texture.Get()));
+		serialize(m_writer, desc);
+		// RGBA8, every face back to back for cube maps
+		size_t faceCount = desc.type == TextureType::TextureCubeMap ? k_CUBEMAP_FACE_COUNT : 1;
+		m_writer.writeBlob(textureData, static_cast<size_t>(desc.width) * desc.height * 4 * faceCount);
+		return texture;
+	}
+
+	TextureSamplerHandle CaptureDevice::makeTextureSampler(TextureSamplerDesc desc) {
+		TextureSamplerHandle sampler = m_device->makeTextureSampler(desc);
+		writeCommand(CaptureCommand::MakeTextureSampler);
+		m_writer.write(registerObject(sampler.Get()));
+		serialize(m_writer, desc);
+		return sampler;
+	}
+
+	void CaptureDevice::bindTexture(ITexture* texture, ITextureSampler* sampler, uint32_t index) {
+		writeCommand(CaptureCommand::BindTexture);
+		m_writer.write(getObjectId(texture));
+		m_writer.write(getObjectId(sampler));
+		m_writer.write(index);
+		m_device->bindTexture(texture, sampler, index);
+	}
+
+	void CaptureDevice::bindTexture(IFramebuffer* texture, ITextureSampler* sampler, uint32_t index, uint32_t attachment) {
+		writeCommand(CaptureCommand::BindFramebufferTexture);
+		m_writer.write(getObjectId(texture));
+		m_writer.write(getObjectId(sampler));
+		m_writer.write(index);
+		m_writer.write(attachment);
+		m_device->bindTexture(texture, sampler, index, attachment);
+	}
+
+	//
+	// Framebuffers
+	//
+
+	FramebufferHandle CaptureDevice::makeFramebuffer(FramebufferDesc desc) {
+		FramebufferHandle framebuffer = m_device->makeFramebuffer(desc);
+		writeCommand(CaptureCommand::MakeFramebuffer);
+		m_writer.write(registerObject(framebuffer.Get()));
+		serialize(m_writer, desc);
+		return framebuffer;
+	}
+
+	void CaptureDevice::bindFramebuffer(IFramebuffer* texture, uint32_t cubeFace) {
+		writeCommand(CaptureCommand::BindFramebuffer);
+		m_writer.write(getObjectId(texture));
+		m_writer.write(cubeFace);
+		m_device->bindFramebuffer(texture, cubeFace);
+	}
+
+	void CaptureDevice::blitFramebuffer(IFramebuffer* textureSrc, IFramebuffer* textureDst) {
+		writeCommand(CaptureCommand::BlitFramebuffer);
+		m_writer.write(getObjectId(textureSrc));
+		m_writer.write(getObjectId(textureDst));
+		m_device->blitFramebuffer(textureSrc, textureDst);
+	}
+
+	void CaptureDevice::blitFramebufferDepth(IFramebuffer* textureSrc, IFramebuffer* textureDst) {
+		writeCommand(CaptureCommand::BlitFramebufferDepth);
+		m_writer.write(getObjectId(textureSrc));
+		m_writer.write(getObjectId(textureDst));
+		m_device->blitFramebufferDepth(textureSrc, textureDst);
+	}
+
+	void CaptureDevice::clearColorAttachment(uint32_t attachment, Color color) {
+		writeCommand(CaptureCommand::ClearColorAttachment);
+		m_writer.write(attachment);
+		m_writer.write(color);
+		m_device->clearColorAttachment(attachment, color);
+	}
+
+	void CaptureDevice::readDepthBuffer(IBuffer* buffer, const Rect rect) {
+		writeCommand(CaptureCommand::ReadDepthBuffer);
+		m_writer.write(getObjectId(buffer));
+		m_writer.write(rect);
+		m_device->readDepthBuffer(buffer, rect);
+	}
+
+	void CaptureDevice::setDepthOverride(bool enabled, CompareFunc depthFunc, bool depthWrite) {
+		writeCommand(CaptureCommand::SetDepthOverride);
+		m_writer.write(enabled);
+		m_writer.write(depthFunc);
+		m_writer.write(depthWrite);
+		m_device->setDepthOverride(enabled, depthFunc, depthWrite);
+	}
+
+	//
+	// Debugging
+	//
+
+	void CaptureDevice::debugMarkerPush(const std::string& title) {
+		writeCommand(CaptureCommand::DebugMarkerPush);
+		m_writer.writeString(title);
+		m_device->debugMarkerPush(title);
+	}
+
+	void CaptureDevice::debugMarkerPop() {
+		writeCommand(CaptureCommand::DebugMarkerPop);
+		m_device->debugMarkerPop();
+	}
+
+	void CaptureDevice::beginProfilingFrame() {
+		writeCommand(CaptureCommand::BeginProfilingFrame);
+		m_device->beginProfilingFrame();
+	}
+
+	void CaptureDevice::endProfilingFrame() {
+		writeCommand(CaptureCommand::EndProfilingFrame);
+		m_device->endProfilingFrame();
+	}
+
+	void CaptureDevice::profileScopePush(const char* name) {
+		writeCommand(CaptureCommand::ProfileScopePush);
+		m_writer.writeString(name);
+		m_device->profileScopePush(name);
+	}
+
+	void CaptureDevice::profileScopePop() {
+		writeCommand(CaptureCommand::ProfileScopePop);
+		m_device->profileScopePop();
+	}
+
+	const std::vector<GpuScopeTiming>& CaptureDevice::getProfilingResults() const {
+		return m_device->getProfilingResults();
+	}
+}
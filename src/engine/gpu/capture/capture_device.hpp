@@ -0,0 +1,100 @@
+#pragma once
+
+#include "engine/gpu/idevice.hpp"
+#include "capture_format.hpp"
+
+#include <cstdio>
+#include <unordered_map>
+#include <vector>
+
+namespace gpu::capture {
+
+	// Records every call into a capture file, then forwards it to the wrapped device. Objects are the wrapped device's own,
+	// so code can't tell it is being captured. The capture covers the whole session and is flushed to disk on every present.
+	// Calls made around the device (e.g. by the ImGui renderer backend) aren't captured
+	class CaptureDevice : public ::gpu::IDevice {
+	public:
+		CaptureDevice(DeviceHandle device, const std::string& path);
+		~CaptureDevice() override;
+
+		void setViewport(const Rect viewportRect) override;
+		void setScissor(bool enabled, const Rect scissorRect = {}) override;
+		InputLayoutHandle createInputLayout(const VertexAttributeDesc* desc, uint32_t attributeCount) override;
+		ShaderHandle makeShader(const ShaderDesc shaderDesc) override;
+		PipelineHandle makePipeline(const PipelineDesc pipelineDesc) override;
+		// Forwarded untouched. Captures always record the source, replays may run on another driver
+		std::string getShaderBinaryTag() const override;
+		bool getShaderBinary(IShader* shader, ShaderBinary& outBinary) override;
+
+		BufferHandle makeBuffer(const BufferDesc bufferDesc) override;
+		void writeBuffer(IBuffer* handle, size_t size, const void* data) override;
+		void mapBuffer(IBuffer* buffer, uint32_t offset, size_t length, MapAccessFlags accessFlags, void** mappedDataPtr) override;
+		void unmapBuffer(IBuffer* buffer) override;
+		void bindBuffer(IBuffer* buffer) override;
+		void unbindBuffer(IBuffer* buffer) override;
+		void setConstantBuffer(IBuffer* buffer, uint32_t bindIndex) override;
+		void unbindConstantBuffer(IBuffer* buffer, uint32_t bindIndex) override;
+		void setBufferBinding(IShader* shader, const std::string& name, uint32_t bindIndex) override;
+		void registerUniformBlock(const UniformBlockDesc& desc) override;
+
+		void draw(DrawCallState drawCallState, size_t triangleCount, size_t offset = 0, size_t instances = 1, size_t firstInstance = 0) override;
+		void drawIndexed(DrawCallState drawCallState, size_t triangleCount, size_t offset = 0, size_t instances = 1, size_t firstInstance = 0) override;
+
+		void clearColor(Color color, float depth) override;
+		void present() override;
+
+		// Blend state
+		BlendStateHandle makeBlendState(const BlendStateDesc blendStateDesc) override;
+
+		// Textures
+		TextureHandle makeTexture(TextureDesc desc, void* textureData) override;
+		TextureSamplerHandle makeTextureSampler(TextureSamplerDesc desc) override;
+		void bindTexture(ITexture* texture, ITextureSampler* sampler, uint32_t index = 0) override;
+		void bindTexture(IFramebuffer* texture, ITextureSampler* sampler, uint32_t index = 0, uint32_t attachment = 0) override;
+
+		FramebufferHandle makeFramebuffer(FramebufferDesc desc) override;
+		void bindFramebuffer(IFramebuffer* texture, uint32_t cubeFace = 0) override;
+		void blitFramebuffer(IFramebuffer* textureSrc, IFramebuffer* textureDst) override;
+		void blitFramebufferDepth(IFramebuffer* textureSrc, IFramebuffer* textureDst) override;
+		void clearColorAttachment(uint32_t attachment, Color color) override;
+		void readDepthBuffer(IBuffer* buffer, const Rect rect) override;
+
+		void setDepthOverride(bool enabled, CompareFunc depthFunc = CompareFunc::Equal, bool depthWrite = false) override;
+
+		void debugMarkerPush(const std::string& title) override;
+		void debugMarkerPop() override;
+
+		void beginProfilingFrame() override;
+		void endProfilingFrame() override;
+		void profileScopePush(const char* name) override;
+		void profileScopePop() override;
+		[[nodiscard]] const std::vector<GpuScopeTiming>& getProfilingResults() const override;
+
+		[[nodiscard]] inline IDevice* getWrappedDevice() const { return m_device; }
+
+	private:
+		// A write mapping handed out as a shadow copy. deviceData is the wrapped device's mapping
+		struct ActiveMapping {
+			void* deviceData = nullptr;
+			std::vector<uint8_t> shadow;
+		};
+
+		// Hands out the next id. An address reused by a new object simply takes the new id
+		uint32_t registerObject(const void* object);
+		// 0 for null and for objects made before the capture started
+		uint32_t getObjectId(const void* object);
+		inline void writeCommand(CaptureCommand command) { m_writer.write(command); }
+		void flush();
+
+		DeviceHandle m_device;
+		FILE* m_file = nullptr;
+		CaptureWriter m_writer;
+
+		std::unordered_map<const void*, uint32_t> m_objectIds;
+		uint32_t m_nextObjectId = 1;
+		std::unordered_map<const IBuffer*, ActiveMapping> m_activeMappings;
+		// Shadow allocations from past mappings, reused so per-frame maps don't allocate
+		std::vector<std::vector<uint8_t>> m_freeShadows;
+		uint64_t m_capturedFrames = 0;
+	};
+}
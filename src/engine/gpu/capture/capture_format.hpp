@@ -0,0 +1,311 @@
+#pragma once
+
+#include <inttypes.h>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <type_traits>
+
+#include "engine/gpu/idevice.hpp"
+
+// Binary layout of device captures. A capture is the header followed by commands until the end of the file, each one a
+// CaptureCommand byte and its arguments. Objects are referred to by ids handed out in creation order, 0 is null.
+// Values are stored in native byte order, captures are only meant to be replayed on the machine type they were made on
+namespace gpu::capture {
+
+	constexpr uint32_t k_captureMagic = 0x50414347; // 'GCAP'
+	constexpr uint32_t k_captureVersion = 4;
+
+	struct CaptureHeader {
+		uint32_t magic = k_captureMagic;
+		uint32_t version = k_captureVersion;
+	};
+
+	// One per IDevice call
+	enum class CaptureCommand : uint8_t {
+		SetViewport,
+		SetScissor,
+		CreateInputLayout,
+		MakeShader,
+		MakePipeline,
+		MakeBuffer,
+		WriteBuffer,
+		MapBuffer,
+		// Carries the bytes written through the mapping, if it was mapped for writing
+		UnmapBuffer,
+		BindBuffer,
+		UnbindBuffer,
+		SetConstantBuffer,
+		UnbindConstantBuffer,
+		SetBufferBinding,
+		RegisterUniformBlock,
+		Draw,
+		DrawIndexed,
+		ClearColor,
+		// Ends a frame
+		Present,
+		MakeBlendState,
+		MakeTexture,
+		MakeTextureSampler,
+		BindTexture,
+		BindFramebufferTexture,
+		MakeFramebuffer,
+		BindFramebuffer,
+		BlitFramebuffer,
+		BlitFramebufferDepth,
+		ClearColorAttachment,
+		ReadDepthBuffer,
+		SetDepthOverride,
+		DebugMarkerPush,
+		DebugMarkerPop,
+		BeginProfilingFrame,
+		EndProfilingFrame,
+		ProfileScopePush,
+		ProfileScopePop,
+		Count,
+	};
+
+	class CaptureWriter {
+	public:
+		template<typename T>
+		inline void write(const T& value) {
+			static_assert(std::is_trivially_copyable_v<T>);
+			writeBytes(&value, sizeof(T));
+		}
+
+		inline void writeBytes(const void* data, size_t size) {
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+			m_data.insert(m_data.end(), bytes, bytes + size);
+		}
+
+		inline void writeString(const std::string& string) {
+			write<uint32_t>(static_cast<uint32_t>(string.size()));
+			writeBytes(string.data(), string.size());
+		}
+
+		// Size prefixed, data may be null to record a zero length blob
+		inline void writeBlob(const void* data, size_t size) {
+			size = data != nullptr ? size : 0;
+			write<uint64_t>(size);
+			writeBytes(data, size);
+		}
+
+		[[nodiscard]] inline const std::vector<uint8_t>& getData() const { return m_data; }
+		inline void clear() { m_data.clear(); }
+
+	private:
+		std::vector<uint8_t> m_data;
+	};
+
+	// Reads past the end return zeroed values and set the overflow flag instead of faulting
+	class CaptureReader {
+	public:
+		CaptureReader(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+
+		template<typename T>
+		inline T read() {
+			static_assert(std::is_trivially_copyable_v<T>);
+			T value = {};
+			readBytes(&value, sizeof(T));
+			return value;
+		}
+
+		inline void readBytes(void* out, size_t size) {
+			if (size > m_size - m_cursor) {
+				m_overflow = true;
+				memset(out, 0, size);
+				m_cursor = m_size;
+				return;
+			}
+			memcpy(out, m_data + m_cursor, size);
+			m_cursor += size;
+		}
+
+		inline std::string readString() {
+			uint32_t length = read<uint32_t>();
+			if (length > m_size - m_cursor) {
+				m_overflow = true;
+				m_cursor = m_size;
+				return {};
+			}
+			std::string string(reinterpret_cast<const char*>(m_data + m_cursor), length);
+			m_cursor += length;
+			return string;
+		}
+
+		// Points into the capture, empty blobs return nullptr
+		inline const uint8_t* readBlob(size_t& size) {
+			size = static_cast<size_t>(read<uint64_t>());
+			if (size > m_size - m_cursor) {
+				m_overflow = true;
+				m_cursor = m_size;
+				size = 0;
+			}
+			if (size == 0) {
+				return nullptr;
+			}
+			const uint8_t* blob = m_data + m_cursor;
+			m_cursor += size;
+			return blob;
+		}
+
+		[[nodiscard]] inline bool isAtEnd() const { return m_cursor >= m_size; }
+		[[nodiscard]] inline bool hasOverflowed() const { return m_overflow; }
+
+	private:
+		const uint8_t* m_data = nullptr;
+		size_t m_size = 0;
+		size_t m_cursor = 0;
+		bool m_overflow = false;
+	};
+
+	//
+	// Descriptors. Structs holding strings or vectors are written field by field, the rest as they are laid out in memory
+	//
+
+	inline void serialize(CaptureWriter& writer, const VertexAttributeDesc& desc) {
+		writer.writeString(desc.name);
+		writer.write(desc.format);
+		writer.write(desc.arraySize);
+		writer.write(desc.bufferIndex);
+		writer.write<uint64_t>(desc.offset);
+		writer.write(desc.elementStride);
+		writer.write(desc.instanceStepRate);
+	}
+
+	inline void deserialize(CaptureReader& reader, VertexAttributeDesc& desc) {
+		desc.name = reader.readString();
+		desc.format = reader.read<GpuFormat>();
+		desc.arraySize = reader.read<uint32_t>();
+		desc.bufferIndex = reader.read<uint32_t>();
+		desc.offset = static_cast<size_t>(reader.read<uint64_t>());
+		desc.elementStride = reader.read<uint32_t>();
+		desc.instanceStepRate = reader.read<uint32_t>();
+	}
+
+	// Sources are written with their null terminator, so the deserialized desc can point straight into the capture. The
+	// program binary isn't written, it only loads on the driver that made it
+	inline void serialize(CaptureWriter& writer, const ShaderDesc& desc) {
+		const char* vertexSource = reinterpret_cast<const char*>(desc.VS.byteCode);
+		const char* pixelSource = reinterpret_cast<const char*>(desc.PS.byteCode);
+		writer.writeBlob(vertexSource, vertexSource != nullptr ? strlen(vertexSource) + 1 : 0);
+		writer.writeString(desc.VS.entryFunc);
+		writer.writeString(desc.VS.sourceName);
+		writer.writeBlob(pixelSource, pixelSource != nullptr ? strlen(pixelSource) + 1 : 0);
+		writer.writeString(desc.PS.entryFunc);
+		writer.writeString(desc.PS.sourceName);
+		writer.writeString(desc.debugName);
+	}
+
+	inline void deserialize(CaptureReader& reader, ShaderDesc& desc) {
+		size_t size = 0;
+		desc.VS.byteCode = const_cast<uint8_t*>(reader.readBlob(size));
+		desc.VS.entryFunc = reader.readString();
+		desc.VS.sourceName = reader.readString();
+		desc.PS.byteCode = const_cast<uint8_t*>(reader.readBlob(size));
+		desc.PS.entryFunc = reader.readString();
+		desc.PS.sourceName = reader.readString();
+		desc.debugName = reader.readString();
+	}
+
+	inline void serialize(CaptureWriter& writer, const UniformBlockDesc& desc) {
+		writer.writeString(desc.name);
+		writer.write(desc.bindIndex);
+		writer.write(desc.size);
+		writer.write(static_cast<uint32_t>(desc.members.size()));
+		for (const ShaderUniformMember& member : desc.members) {
+			writer.writeString(member.name);
+			writer.write(member.offset);
+		}
+	}
+
+	inline void deserialize(CaptureReader& reader, UniformBlockDesc& desc) {
+		desc.name = reader.readString();
+		desc.bindIndex = reader.read<uint32_t>();
+		desc.size = reader.read<uint32_t>();
+		desc.members.resize(reader.read<uint32_t>());
+		for (ShaderUniformMember& member : desc.members) {
+			member.name = reader.readString();
+			member.offset = reader.read<uint32_t>();
+		}
+	}
+
+	inline void serialize(CaptureWriter& writer, const BufferDesc& desc) {
+		writer.write(desc.type);
+		writer.write(desc.usage);
+		writer.write(desc.format);
+		writer.writeString(desc.debugName);
+	}
+
+	inline void deserialize(CaptureReader& reader, BufferDesc& desc) {
+		desc.type = reader.read<BufferType>();
+		desc.usage = reader.read<Usage>();
+		desc.format = reader.read<GpuFormat>();
+		desc.debugName = reader.readString();
+	}
+
+	inline void serialize(CaptureWriter& writer, const TextureDesc& desc) {
+		writer.write(desc.width);
+		writer.write(desc.height);
+		writer.write(desc.generateMipmaps);
+		writer.write(desc.type);
+		writer.writeString(desc.debugName);
+	}
+
+	inline void deserialize(CaptureReader& reader, TextureDesc& desc) {
+		desc.width = reader.read<uint32_t>();
+		desc.height = reader.read<uint32_t>();
+		desc.generateMipmaps = reader.read<bool>();
+		desc.type = reader.read<TextureType>();
+		desc.debugName = reader.readString();
+	}
+
+	inline void serialize(CaptureWriter& writer, const TextureSamplerDesc& desc) {
+		writer.write(desc.minFilter);
+		writer.write(desc.magFilter);
+		writer.write(desc.mipFilter);
+		writer.write(desc.wrapX);
+		writer.write(desc.wrapY);
+		writer.write(desc.wrapZ);
+		writer.write(desc.lodBias);
+		writer.write(desc.anisotropy);
+		writer.writeString(desc.debugName);
+	}
+
+	inline void deserialize(CaptureReader& reader, TextureSamplerDesc& desc) {
+		desc.minFilter = reader.read<SamplingMode>();
+		desc.magFilter = reader.read<SamplingMode>();
+		desc.mipFilter = reader.read<SamplingMode>();
+		desc.wrapX = reader.read<TextureWrap>();
+		desc.wrapY = reader.read<TextureWrap>();
+		desc.wrapZ = reader.read<TextureWrap>();
+		desc.lodBias = reader.read<float>();
+		desc.anisotropy = reader.read<float>();
+		desc.debugName = reader.readString();
+	}
+
+	inline void serialize(CaptureWriter& writer, const FramebufferDesc& desc) {
+		writer.write(desc.colorDesc);
+		writer.write(desc.depthStencilDesc);
+		writer.write(desc.hasDepth);
+		writer.write<uint32_t>(static_cast<uint32_t>(desc.additionalColorFormats.size()));
+		for (TextureFormat format : desc.additionalColorFormats) {
+			writer.write(format);
+		}
+		writer.write(desc.cubeMap);
+		writer.writeString(desc.debugName);
+	}
+
+	inline void deserialize(CaptureReader& reader, FramebufferDesc& desc) {
+		desc.colorDesc = reader.read<FramebufferAttachmentDesc>();
+		desc.depthStencilDesc = reader.read<FramebufferAttachmentDesc>();
+		desc.hasDepth = reader.read<bool>();
+		uint32_t additionalColorCount = reader.read<uint32_t>();
+		desc.additionalColorFormats.clear();
+		for (uint32_t i = 0; i < additionalColorCount && !reader.hasOverflowed(); i++) {
+			desc.additionalColorFormats.push_back(reader.read<TextureFormat>());
+		}
+		desc.cubeMap = reader.read<bool>();
+		desc.debugName = reader.readString();
+	}
+}
@@ -0,0 +1,383 @@
+#include "capture_replayer.hpp"
+#include "engine/core.hpp"
+#include "engine/log.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace gpu::capture {
+
+	bool CaptureReplayer::load(const std::string& path) {
+		FILE* file = fopen(path.c_str(), "rb");
+		if (file == nullptr) {
+			LOG_ERROR("Failed to open capture \"{}\"", path);
+			return false;
+		}
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+
+		CaptureHeader header = {};
+		if (size < static_cast<long>(sizeof(header)) || fread(&header, sizeof(header), 1, file) != 1 || header.magic != k_captureMagic) {
+			LOG_ERROR("\"{}\" isn't a device capture", path);
+			fclose(file);
+			return false;
+		}
+		if (header.version != k_captureVersion) {
+			LOG_ERROR("Capture \"{}\" is version {}, expected {}", path, header.version, k_captureVersion);
+			fclose(file);
+			return false;
+		}
+
+		m_capture.resize(size - sizeof(header));
+		size_t read = fread(m_capture.data(), 1, m_capture.size(), file);
+		fclose(file);
+		m_capture.resize(read);
+		return true;
+	}
+
+	bool CaptureReplayer::replay(IDevice* pDevice, const std::function<void()>& onFramePresented) {
+		ASSERT(pDevice != nullptr);
+		m_frameTimings.clear();
+		m_pendingMappings.clear();
+		m_drawCount = 0;
+
+		CaptureReader reader(m_capture.data(), m_capture.size());
+		ReplayFrameTiming frameTiming = {};
+		auto frameStart = std::chrono::high_resolution_clock::now();
+		bool success = true;
+
+		while (!reader.isAtEnd()) {
+			CaptureCommand command = reader.read<CaptureCommand>();
+			if (!executeCommand(reader, command, pDevice)) {
+				LOG_ERROR("Unknown command {} in frame {}, stopping the replay", (uint32_t)command, frameTiming.frame);
+				success = false;
+				break;
+			}
+			if (reader.hasOverflowed()) {
+				// The app was killed mid-frame, the partial frame is dropped
+				LOG_WARNING("Capture ends partway through frame {}", frameTiming.frame);
+				break;
+			}
+			frameTiming.commandCount++;
+
+			if (command == CaptureCommand::Present) {
+				if (onFramePresented) {
+					onFramePresented();
+				}
+				auto frameEnd = std::chrono::high_resolution_clock::now();
+				frameTiming.milliseconds = std::chrono::duration<double, std::milli>(frameEnd - frameStart).count();
+				frameTiming.drawCount = m_drawCount;
+				m_frameTimings.push_back(frameTiming);
+
+				frameTiming = { .frame = frameTiming.frame + 1 };
+				m_drawCount = 0;
+				frameStart = frameEnd;
+			}
+		}
+
+		releaseObjects();
+		return success;
+	}
+
+	void CaptureReplayer::releaseObjects() {
+		// Pipelines first, they refer to the shaders, input layouts and blend states
+		m_pipelines.clear();
+		m_inputLayouts.clear();
+		m_shaders.clear();
+		m_buffers.clear();
+		m_blendStates.clear();
+		m_textures.clear();
+		m_textureSamplers.clear();
+		m_framebuffers.clear();
+	}
+
+	bool CaptureReplayer::executeCommand(CaptureReader& reader, CaptureCommand command, IDevice* pDevice) {
+		switch (command) {
+		case CaptureCommand::SetViewport: {
+			Rect viewport = reader.read<Rect>();
+			pDevice->setViewport(viewport);
+			break;
+		}
+		case CaptureCommand::SetScissor: {
+			bool enabled = reader.read<bool>();
+			Rect scissor = reader.read<Rect>();
+			pDevice->setScissor(enabled, scissor);
+			break;
+		}
+		case CaptureCommand::CreateInputLayout: {
+			uint32_t id = reader.read<uint32_t>();
+			uint32_t attributeCount = reader.read<uint32_t>();
+			std::vector<VertexAttributeDesc> attributes;
+			for (uint32_t i = 0; i < attributeCount && !reader.hasOverflowed(); i++) {
+				deserialize(reader, attributes.emplace_back());
+			}
+			if (!reader.hasOverflowed()) {
+				store(m_inputLayouts, id, pDevice->createInputLayout(attributes.data(), attributeCount));
+			}
+			break;
+		}
+		case CaptureCommand::MakeShader: {
+			uint32_t id = reader.read<uint32_t>();
+			ShaderDesc desc;
+			deserialize(reader, desc);
+			if (!reader.hasOverflowed()) {
+				store(m_shaders, id, pDevice->makeShader(desc));
+			}
+			break;
+		}
+		case CaptureCommand::MakePipeline: {
+			uint32_t id = reader.read<uint32_t>();
+			PipelineDesc desc;
+			desc.shader = lookup(m_shaders, reader.read<uint32_t>());
+			desc.inputLayout = lookup(m_inputLayouts, reader.read<uint32_t>());
+			desc.graphicsState = reader.read<GraphicsState>();
+			desc.blendState = lookup(m_blendStates, reader.read<uint32_t>());
+			if (!reader.hasOverflowed()) {
+				store(m_pipelines, id, pDevice->makePipeline(desc));
+			}
+			break;
+		}
+		case CaptureCommand::MakeBuffer: {
+			uint32_t id = reader.read<uint32_t>();
+			BufferDesc desc;
+			deserialize(reader, desc);
+			if (!reader.hasOverflowed()) {
+				store(m_buffers, id, pDevice->makeBuffer(desc));
+			}
+			break;
+		}
+		case CaptureCommand::WriteBuffer: {
+			IBuffer* buffer = lookup(m_buffers, reader.read<uint32_t>());
+			size_t size = static_cast<size_t>(reader.read<uint64_t>());
+			size_t dataSize = 0;
+			const uint8_t* data = reader.readBlob(dataSize);
+			if (!reader.hasOverflowed()) {
+				pDevice->writeBuffer(buffer, size, data);
+			}
+			break;
+		}
+		case CaptureCommand::MapBuffer: {
+			IBuffer* buffer = lookup(m_buffers, reader.read<uint32_t>());
+			uint32_t offset = reader.read<uint32_t>();
+			size_t length = static_cast<size_t>(reader.read<uint64_t>());
+			MapAccessFlags accessFlags = reader.read<MapAccessFlags>();
+			if (reader.hasOverflowed()) {
+				break;
+			}
+			// The mapping itself is redone at unmap, where the written bytes are known. Mapping for reading is replayed
+			// here so readbacks still wait on the GPU like they did in the app
+			if ((accessFlags & MapAccessFlags::Read) != 0) {
+				void* mapped = nullptr;
+				pDevice->mapBuffer(buffer, offset, length, accessFlags, &mapped);
+				if (mapped != nullptr) {
+					pDevice->unmapBuffer(buffer);
+				}
+			} else {
+				void* mapped = nullptr;
+				pDevice->mapBuffer(buffer, offset, length, accessFlags, &mapped);
+				m_pendingMappings[buffer] = mapped;
+			}
+			break;
+		}
+		case CaptureCommand::UnmapBuffer: {
+			IBuffer* buffer = lookup(m_buffers, reader.read<uint32_t>());
+			size_t size = 0;
+			const uint8_t* data = reader.readBlob(size);
+			if (reader.hasOverflowed()) {
+				break;
+			}
+			auto it = m_pendingMappings.find(buffer);
+			if (it != m_pendingMappings.end()) {
+				if (it->second != nullptr) {
+					if (data != nullptr) {
+						memcpy(it->second, data, size);
+					}
+					pDevice->unmapBuffer(buffer);
+				}
+				m_pendingMappings.erase(it);
+			}
+			break;
+		}
+		case CaptureCommand::BindBuffer:
+			pDevice->bindBuffer(lookup(m_buffers, reader.read<uint32_t>()));
+			break;
+		case CaptureCommand::UnbindBuffer:
+			pDevice->unbindBuffer(lookup(m_buffers, reader.read<uint32_t>()));
+			break;
+		case CaptureCommand::SetConstantBuffer: {
+			IBuffer* buffer = lookup(m_buffers, reader.read<uint32_t>());
+			uint32_t bindIndex = reader.read<uint32_t>();
+			pDevice->setConstantBuffer(buffer, bindIndex);
+			break;
+		}
+		case CaptureCommand::UnbindConstantBuffer: {
+			IBuffer* buffer = lookup(m_buffers, reader.read<uint32_t>());
+			uint32_t bindIndex = reader.read<uint32_t>();
+			pDevice->unbindConstantBuffer(buffer, bindIndex);
+			break;
+		}
+		case CaptureCommand::SetBufferBinding: {
+			IShader* shader = lookup(m_shaders, reader.read<uint32_t>());
+			std::string name = reader.readString();
+			uint32_t bindIndex = reader.read<uint32_t>();
+			pDevice->setBufferBinding(shader, name, bindIndex);
+			break;
+		}
+		case CaptureCommand::RegisterUniformBlock: {
+			UniformBlockDesc desc;
+			deserialize(reader, desc);
+			pDevice->registerUniformBlock(desc);
+			break;
+		}
+		case CaptureCommand::Draw:
+		case CaptureCommand::DrawIndexed: {
+			DrawCallState drawCallState;
+			drawCallState.vertexBufer = lookup(m_buffers, reader.read<uint32_t>());
+			if (command == CaptureCommand::DrawIndexed) {
+				drawCallState.indexBuffer = lookup(m_buffers, reader.read<uint32_t>());
+			}
+			drawCallState.pipeline = lookup(m_pipelines, reader.read<uint32_t>());
+			drawCallState.primitiveType = reader.read<PrimitiveType>();
+			size_t triangleCount = static_cast<size_t>(reader.read<uint64_t>());
+			size_t offset = static_cast<size_t>(reader.read<uint64_t>());
+			size_t instances = static_cast<size_t>(reader.read<uint64_t>());
+			size_t firstInstance = static_cast<size_t>(reader.read<uint64_t>());
+			if (reader.hasOverflowed()) {
+				break;
+			}
+			if (command == CaptureCommand::DrawIndexed) {
+				pDevice->drawIndexed(drawCallState, triangleCount, offset, instances, firstInstance);
+			} else {
+				pDevice->draw(drawCallState, triangleCount, offset, instances, firstInstance);
+			}
+			m_drawCount++;
+			break;
+		}
+		case CaptureCommand::ClearColor: {
+			Color color = reader.read<Color>();
+			float depth = reader.read<float>();
+			pDevice->clearColor(color, depth);
+			break;
+		}
+		case CaptureCommand::Present:
+			pDevice->present();
+			break;
+		case CaptureCommand::MakeBlendState: {
+			uint32_t id = reader.read<uint32_t>();
+			BlendStateDesc desc = reader.read<BlendStateDesc>();
+			if (!reader.hasOverflowed()) {
+				store(m_blendStates, id, pDevice->makeBlendState(desc));
+			}
+			break;
+		}
+		case CaptureCommand::MakeTexture: {
+			uint32_t id = reader.read<uint32_t>();
+			TextureDesc desc;
+			deserialize(reader, desc);
+			size_t size = 0;
+			const uint8_t* data = reader.readBlob(size);
+			if (!reader.hasOverflowed()) {
+				store(m_textures, id, pDevice->makeTexture(desc, const_cast<uint8_t*>(data)));
+			}
+			break;
+		}
+		case CaptureCommand::MakeTextureSampler: {
+			uint32_t id = reader.read<uint32_t>();
+			TextureSamplerDesc desc;
+			deserialize(reader, desc);
+			if (!reader.hasOverflowed()) {
+				store(m_textureSamplers, id, pDevice->makeTextureSampler(desc));
+			}
+			break;
+		}
+		case CaptureCommand::BindTexture: {
+			ITexture* texture = lookup(m_textures, reader.read<uint32_t>());
+			ITextureSampler* sampler = lookup(m_textureSamplers, reader.read<uint32_t>());
+			uint32_t index = reader.read<uint32_t>();
+			pDevice->bindTexture(texture, sampler, index);
+			break;
+		}
+		case CaptureCommand::BindFramebufferTexture: {
+			IFramebuffer* framebuffer = lookup(m_framebuffers, reader.read<uint32_t>());
+			ITextureSampler* sampler = lookup(m_textureSamplers, reader.read<uint32_t>());
+			uint32_t index = reader.read<uint32_t>();
+			uint32_t attachment = reader.read<uint32_t>();
+			pDevice->bindTexture(framebuffer, sampler, index, attachment);
+			break;
+		}
+		case CaptureCommand::MakeFramebuffer: {
+			uint32_t id = reader.read<uint32_t>();
+			FramebufferDesc desc;
+			deserialize(reader, desc);
+			if (!reader.hasOverflowed()) {
+				store(m_framebuffers, id, pDevice->makeFramebuffer(desc));
+			}
+			break;
+		}
+		case CaptureCommand::BindFramebuffer: {
+			IFramebuffer* framebuffer = lookup(m_framebuffers, reader.read<uint32_t>());
+			uint32_t cubeFace = reader.read<uint32_t>();
+			pDevice->bindFramebuffer(framebuffer, cubeFace);
+			break;
+		}
+		case CaptureCommand::BlitFramebuffer:
+		case CaptureCommand::BlitFramebufferDepth: {
+			IFramebuffer* source = lookup(m_framebuffers, reader.read<uint32_t>());
+			IFramebuffer* destination = lookup(m_framebuffers, reader.read<uint32_t>());
+			if (command == CaptureCommand::BlitFramebuffer) {
+				pDevice->blitFramebuffer(source, destination);
+			} else {
+				pDevice->blitFramebufferDepth(source, destination);
+			}
+			break;
+		}
+		case CaptureCommand::ClearColorAttachment: {
+			uint32_t attachment = reader.read<uint32_t>();
+			Color color = reader.read<Color>();
+			pDevice->clearColorAttachment(attachment, color);
+			break;
+		}
+		case CaptureCommand::ReadDepthBuffer: {
+			IBuffer* buffer = lookup(m_buffers, reader.read<uint32_t>());
+			Rect rect = reader.read<Rect>();
+			pDevice->readDepthBuffer(buffer, rect);
+			break;
+		}
+		case CaptureCommand::SetDepthOverride: {
+			bool enabled = reader.read<bool>();
+			CompareFunc depthFunc = reader.read<CompareFunc>();
+			bool depthWrite = reader.read<bool>();
+			pDevice->setDepthOverride(enabled, depthFunc, depthWrite);
+			break;
+		}
+		case CaptureCommand::DebugMarkerPush:
+			pDevice->debugMarkerPush(reader.readString());
+			break;
+		case CaptureCommand::DebugMarkerPop:
+			pDevice->debugMarkerPop();
+			break;
+		case CaptureCommand::BeginProfilingFrame:
+			pDevice->beginProfilingFrame();
+			break;
+		case CaptureCommand::EndProfilingFrame:
+			pDevice->endProfilingFrame();
+			break;
+		case CaptureCommand::ProfileScopePush: {
+			std::string name = reader.readString();
+			// Scopes reuse a handful of names, only keep one copy of each
+			auto it = std::find(m_profileScopeNames.begin(), m_profileScopeNames.end(), name);
+			const std::string& storedName = it != m_profileScopeNames.end() ? *it : m_profileScopeNames.emplace_back(std::move(name));
+			pDevice->profileScopePush(storedName.c_str());
+			break;
+		}
+		case CaptureCommand::ProfileScopePop:
+			pDevice->profileScopePop();
+			break;
+		default:
+			return false;
+		}
+		return true;
+	}
+}
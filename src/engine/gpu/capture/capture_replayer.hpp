@@ -0,0 +1,69 @@
+#pragma once
+
+#include "engine/gpu/idevice.hpp"
+#include "capture_format.hpp"
+
+#include <deque>
+#include <functional>
+#include <unordered_map>
+
+namespace gpu::capture {
+
+	struct ReplayFrameTiming {
+		// Index of the frame in the capture
+		uint32_t frame = 0;
+		uint32_t commandCount = 0;
+		uint32_t drawCount = 0;
+		// CPU time spent issuing the frame's calls, including present and the onFramePresented callback
+		double milliseconds = 0.0;
+	};
+
+	// Re-issues a capture made by CaptureDevice against any device. The whole capture is kept in memory so reading it
+	// doesn't show up in the timings
+	class CaptureReplayer {
+	public:
+		// Returns false if the file is missing or isn't a capture of a supported version
+		bool load(const std::string& path);
+
+		// Replays every command in order. onFramePresented runs after every present, e.g. to swap the window.
+		// Returns false if the capture turned out to be truncated or corrupt, timings of the frames replayed so far are kept
+		bool replay(IDevice* pDevice, const std::function<void()>& onFramePresented = nullptr);
+
+		[[nodiscard]] inline const std::vector<ReplayFrameTiming>& getFrameTimings() const { return m_frameTimings; }
+
+	private:
+		template<typename T>
+		static T* lookup(std::vector<engine::RefCounter<T>>& objects, uint32_t id) {
+			return id < objects.size() ? objects[id].Get() : nullptr;
+		}
+		template<typename T>
+		static void store(std::vector<engine::RefCounter<T>>& objects, uint32_t id, engine::RefCounter<T> object) {
+			if (id >= objects.size()) {
+				objects.resize(id + 1);
+			}
+			objects[id] = std::move(object);
+		}
+
+		// Executes a single command, returns false on an unknown command
+		bool executeCommand(CaptureReader& reader, CaptureCommand command, IDevice* pDevice);
+		void releaseObjects();
+
+		std::vector<uint8_t> m_capture;
+		std::vector<ReplayFrameTiming> m_frameTimings;
+
+		// Replayed objects, indexed by capture id
+		std::vector<InputLayoutHandle> m_inputLayouts;
+		std::vector<ShaderHandle> m_shaders;
+		std::vector<PipelineHandle> m_pipelines;
+		std::vector<BufferHandle> m_buffers;
+		std::vector<BlendStateHandle> m_blendStates;
+		std::vector<TextureHandle> m_textures;
+		std::vector<TextureSamplerHandle> m_textureSamplers;
+		std::vector<FramebufferHandle> m_framebuffers;
+		// Buffers mapped for writing, waiting for their contents at unmap
+		std::unordered_map<IBuffer*, void*> m_pendingMappings;
+		// Profiling scope names must outlive the device's readback, deque keeps them in place as it grows
+		std::deque<std::string> m_profileScopeNames;
+		uint32_t m_drawCount = 0;
+	};
+}
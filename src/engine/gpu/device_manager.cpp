@@ -1,17 +1,41 @@
 #include "device_manager.hpp"
 
+#include "engine/core.hpp"
 #include "gl/gldevice.hpp"
+#include "null/nulldevice.hpp"
+#include "software/softwaredevice.hpp"
+#include "capture/capture_device.hpp"
 
 namespace gpu {
-    DeviceManager* DeviceManager::create() {
+    DeviceManager* DeviceManager::create(GraphicsApi api, const std::string& capturePath) {
         DeviceManager* deviceManager = new DeviceManager();
+        deviceManager->m_api = api;
+        deviceManager->m_capturePath = capturePath;
         deviceManager->createDevice();
         return deviceManager;
     }
 
     bool DeviceManager::createDevice() {
-        IDevice* device = new gl::GlDevice();
+        IDevice* device = nullptr;
+        switch (m_api) {
+        case GraphicsApi::OpenGL:
+            device = new gl::GlDevice();
+            break;
+        case GraphicsApi::Null:
+            device = new null::NullDevice();
+            break;
+        case GraphicsApi::Software:
+            device = new software::SoftwareDevice();
+            break;
+        default:
+            ASSERT(false);
+            return false;
+        }
+        m_backendDevice = device;
         m_device = DeviceHandle::Create(device);
+        if (!m_capturePath.empty()) {
+            m_device = DeviceHandle::Create(new capture::CaptureDevice(m_device, m_capturePath));
+        }
         return true;
     }
-}
\ No newline at end of file
+}
@@ -6,11 +6,24 @@
 #include "idevice.hpp"
 
 namespace gpu {
+	enum class GraphicsApi : uint8_t {
+		OpenGL,
+		// Renders nothing, validates and counts calls instead. Needs no window or GPU
+		Null,
+		// Renders on the CPU with a multithreaded rasterizer into an in-memory backbuffer. Needs no window or GPU
+		Software,
+		Count,
+	};
+
 	class DeviceManager {
 	public:
-		static DeviceManager* create();
+		// A non-empty capturePath records every device call of the session into that file, see CaptureDevice
+		static DeviceManager* create(GraphicsApi api = GraphicsApi::OpenGL, const std::string& capturePath = "");
 
 		[[nodiscard]] IDevice* getDevice() const { return m_device; };
+		// The device of the selected api, underneath the capture device when capturing
+		[[nodiscard]] IDevice* getBackendDevice() const { return m_backendDevice; };
+		[[nodiscard]] GraphicsApi getApi() const { return m_api; };
 
 	private:
 		bool createDevice();
@@ -18,5 +31,8 @@ namespace gpu {
 	private:
 
 		DeviceHandle m_device;
+		IDevice* m_backendDevice = nullptr;
+		GraphicsApi m_api = GraphicsApi::OpenGL;
+		std::string m_capturePath;
 	};
-}
\ No newline at end of file
+}
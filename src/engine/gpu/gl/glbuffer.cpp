@@ -39,7 +39,8 @@ namespace gpu::gl {
     void GlDevice::writeBuffer(IBuffer* handle, size_t size, const void* data) {
         ASSERT(handle != nullptr);
         ASSERT(size > 0);
-        if (handle->getDesc().type != BufferType::ConstantBuffer) {
+        // Constant buffers and readback targets may be allocated without initial data
+        if (handle->getDesc().type != BufferType::ConstantBuffer && handle->getDesc().type != BufferType::PixelReadTarget) {
             ASSERT(data != nullptr);
         }
         bindBuffer(handle);
@@ -67,11 +68,20 @@ namespace gpu::gl {
         ASSERT(!name.empty());
         ASSERT(bindIndex < m_maxUniformBufferBindings);
 
-        uint32_t uniformBlockIndex = glGetUniformBlockIndex(shader->getNativeObject(), name.c_str());
-        GL_CHECK(;);
-        ASSERT(uniformBlockIndex != GL_INVALID_INDEX);
-        ASSERT(uniformBlockIndex != GL_INVALID_OPERATION);
-        GL_CHECK(glUniformBlockBinding(shader->getNativeObject(), uniformBlockIndex, bindIndex));
+        // Still compiling, applied once the program links
+        const ShaderStatus status = shader->pollStatus();
+        if (status == ShaderStatus::Compiling) {
+            static_cast<GlShader*>(shader)->m_pendingBlockBindings.emplace_back(name, bindIndex);
+            return;
+        }
+        if (status == ShaderStatus::Failed) {
+            return;
+        }
+
+        // Looked up in the reflection, the compiler may also have stripped the block if nothing reads it
+        if (!static_cast<GlShader*>(shader)->setBlockBinding(name, bindIndex)) {
+            LOG_WARN("[GL]: Shader \"{}\" has no active uniform block {}", shader->getDesc().debugName, name);
+        }
     }
 
     GlInputLayout::GlInputLayout() {}
@@ -14,16 +14,165 @@ namespace gpu::gl {
 
 	GlShader::~GlShader() {
 		ASSERT(m_pointer != 0);
-		ASSERT(m_pixelShaderPtr != 0);
-		ASSERT(m_vertexShaderPtr != 0);
 		glDeleteProgram(m_pointer);
-		glDeleteShader(m_pixelShaderPtr);
-		glDeleteShader(m_vertexShaderPtr);
+		// Programs loaded from a binary have no shader objects
+		if (m_pixelShaderPtr != 0) {
+			glDeleteShader(m_pixelShaderPtr);
+		}
+		if (m_vertexShaderPtr != 0) {
+			glDeleteShader(m_vertexShaderPtr);
+		}
 		m_pointer = 0;
 		m_pixelShaderPtr = 0;
 		m_vertexShaderPtr = 0;
 	}
 
+	ShaderStatus GlShader::pollStatus() {
+		if (m_status != ShaderStatus::Compiling) {
+			return m_status;
+		}
+		if (m_canPollCompletion) {
+			GLint completed = GL_FALSE;
+			GL_CHECK(glGetProgramiv(m_pointer, GL_COMPLETION_STATUS_KHR, &completed));
+			if (!completed) {
+				return m_status;
+			}
+		}
+		return finishCompile();
+	}
+
+	ShaderStatus GlShader::finishCompile() {
+		int  success = 0;
+		char infoLog[4096] = {};
+
+		glGetShaderiv(m_vertexShaderPtr, GL_COMPILE_STATUS, &success);
+		if (!success)
+		{
+			glGetShaderInfoLog(m_vertexShaderPtr, sizeof(infoLog), NULL, infoLog);
+			LOG_FATAL("[GL]: Failed to compile vertex shader {}. Got:\n{}", m_shaderDesc.VS.sourceName, infoLog);
+			m_status = ShaderStatus::Failed;
+			return m_status;
+		}
+
+		glGetShaderiv(m_pixelShaderPtr, GL_COMPILE_STATUS, &success);
+		if (!success)
+		{
+			glGetShaderInfoLog(m_pixelShaderPtr, sizeof(infoLog), NULL, infoLog);
+			LOG_FATAL("[GL]: Failed to compile pixel shader {}. Got:\n{}", m_shaderDesc.PS.sourceName, infoLog);
+			m_status = ShaderStatus::Failed;
+			return m_status;
+		}
+
+		glGetProgramiv(m_pointer, GL_LINK_STATUS, &success);
+		if (!success)
+		{
+			glGetProgramInfoLog(m_pointer, sizeof(infoLog), NULL, infoLog);
+			LOG_FATAL("[GL]: Failed to link shader {}. Got:\n{}", m_shaderDesc.debugName, infoLog);
+			m_status = ShaderStatus::Failed;
+			return m_status;
+		}
+
+		m_status = ShaderStatus::Ready;
+		reflect();
+		for (const auto& [blockName, bindIndex] : m_pendingBlockBindings) {
+			setBlockBinding(blockName, bindIndex);
+		}
+		m_pendingBlockBindings.clear();
+		return m_status;
+	}
+
+	static bool isGlSamplerType(GLenum type) {
+		switch (type) {
+		case GL_SAMPLER_1D:
+		case GL_SAMPLER_2D:
+		case GL_SAMPLER_3D:
+		case GL_SAMPLER_CUBE:
+		case GL_SAMPLER_1D_SHADOW:
+		case GL_SAMPLER_2D_SHADOW:
+		case GL_SAMPLER_CUBE_SHADOW:
+		case GL_SAMPLER_1D_ARRAY:
+		case GL_SAMPLER_2D_ARRAY:
+		case GL_SAMPLER_2D_ARRAY_SHADOW:
+		case GL_SAMPLER_2D_MULTISAMPLE:
+		case GL_SAMPLER_BUFFER:
+		case GL_INT_SAMPLER_2D:
+		case GL_UNSIGNED_INT_SAMPLER_2D:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	void GlShader::reflect() {
+		m_reflection = {};
+		char name[256] = {};
+
+		GLint blockCount = 0;
+		GL_CHECK(glGetProgramiv(m_pointer, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount));
+		m_reflection.uniformBlocks.resize(blockCount);
+		for (GLint i = 0; i < blockCount; i++) {
+			ShaderUniformBlock& block = m_reflection.uniformBlocks[i];
+			GLint binding = 0;
+			GLint size = 0;
+			GLint memberCount = 0;
+			GL_CHECK(glGetActiveUniformBlockName(m_pointer, i, sizeof(name), nullptr, name));
+			GL_CHECK(glGetActiveUniformBlockiv(m_pointer, i, GL_UNIFORM_BLOCK_BINDING, &binding));
+			GL_CHECK(glGetActiveUniformBlockiv(m_pointer, i, GL_UNIFORM_BLOCK_DATA_SIZE, &size));
+			GL_CHECK(glGetActiveUniformBlockiv(m_pointer, i, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &memberCount));
+			block.name = name;
+			block.index = i;
+			block.binding = binding;
+			block.size = size;
+
+			if (memberCount > 0) {
+				std::vector<GLint> memberIndices(memberCount);
+				std::vector<GLint> memberOffsets(memberCount);
+				GL_CHECK(glGetActiveUniformBlockiv(m_pointer, i, GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES, memberIndices.data()));
+				GL_CHECK(glGetActiveUniformsiv(m_pointer, memberCount, reinterpret_cast<const GLuint*>(memberIndices.data()), GL_UNIFORM_OFFSET, memberOffsets.data()));
+				block.members.resize(memberCount);
+				for (GLint member = 0; member < memberCount; member++) {
+					GL_CHECK(glGetActiveUniformName(m_pointer, memberIndices[member], sizeof(name), nullptr, name));
+					block.members[member].name = name;
+					block.members[member].offset = memberOffsets[member];
+				}
+			}
+		}
+
+		// Samplers are the uniforms outside of any block with a sampler type. Their unit comes from layout(binding)
+		GLint uniformCount = 0;
+		GL_CHECK(glGetProgramiv(m_pointer, GL_ACTIVE_UNIFORMS, &uniformCount));
+		for (GLint i = 0; i < uniformCount; i++) {
+			const GLuint uniformIndex = i;
+			GLint blockIndex = -1;
+			GLint type = 0;
+			GL_CHECK(glGetActiveUniformsiv(m_pointer, 1, &uniformIndex, GL_UNIFORM_BLOCK_INDEX, &blockIndex));
+			GL_CHECK(glGetActiveUniformsiv(m_pointer, 1, &uniformIndex, GL_UNIFORM_TYPE, &type));
+			if (blockIndex != -1 || !isGlSamplerType(type)) {
+				continue;
+			}
+
+			GLint unit = 0;
+			GL_CHECK(glGetActiveUniformName(m_pointer, uniformIndex, sizeof(name), nullptr, name));
+			const GLint location = glGetUniformLocation(m_pointer, name);
+			GL_CHECK(;);
+			GL_CHECK(glGetUniformiv(m_pointer, location, &unit));
+			m_reflection.samplers.push_back({ .name = name, .binding = static_cast<uint32_t>(unit) });
+		}
+	}
+
+	bool GlShader::setBlockBinding(const std::string& blockName, uint32_t bindIndex) {
+		for (ShaderUniformBlock& block : m_reflection.uniformBlocks) {
+			if (block.name == blockName) {
+				if (block.binding != bindIndex) {
+					GL_CHECK(glUniformBlockBinding(m_pointer, block.index, bindIndex));
+					block.binding = bindIndex;
+				}
+				return true;
+			}
+		}
+		return false;
+	}
+
 	GlDevice::GlDevice() {
 		LOG_INFO("OpenGL Version: {}", std::string((char*)glGetString(GL_VERSION)));
 		LOG_INFO("GLSL Version: {}", std::string((char*)glGetString(GL_SHADING_LANGUAGE_VERSION)));
@@ -60,30 +209,112 @@ namespace gpu::gl {
 		GL_CHECK(glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &m_maxUniformBufferBlockSize));
 		GL_CHECK(glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &m_maxCombinedTextureImageUnits));
 		GL_CHECK(glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &m_maxTextureMaxAnisotropyExt));
+
+		// Let the driver compile shaders on its own threads, 0xFFFFFFFF leaves the thread count up to it
+		if (isExtensionAvailable("GL_KHR_parallel_shader_compile")) {
+			GL_CHECK(glMaxShaderCompilerThreadsKHR(0xFFFFFFFF));
+			m_parallelShaderCompile = true;
+		}
+
+		// Program binaries, some drivers expose the extension with no formats which means they can't save any
+		if (isExtensionAvailable("GL_ARB_get_program_binary")) {
+			GLint numFormats = 0;
+			GL_CHECK(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats));
+			if (numFormats > 0) {
+				m_programBinaryFormats.resize(numFormats);
+				GL_CHECK(glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, m_programBinaryFormats.data()));
+				// Binaries are only valid for the exact driver build that made them
+				m_shaderBinaryTag = fmt::format("{}|{}|{}",
+					(const char*)glGetString(GL_VENDOR), (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION));
+			}
+		}
 		
 		// Enable MSAA
 		GL_CHECK(glEnable(GL_MULTISAMPLE));
 		GL_CHECK(glDisable(GL_BLEND));
+
+		// Filter across cube map face edges, otherwise the seams show up in skyboxes
+		GL_CHECK(glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS));
 	}
 
 	GlDevice::~GlDevice() {
-
+		for (ProfileFrame& frame : m_profileFrames) {
+			if (!frame.queries.empty()) {
+				glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+			}
+		}
 	}
 
 	const bool GlDevice::isExtensionAvailable(const std::string& extensionName) const {
 		return (std::find(m_openGlExtensions.begin(), m_openGlExtensions.end(), extensionName)) != m_openGlExtensions.end();
 	}
 
+	std::string GlDevice::getShaderBinaryTag() const {
+		return m_shaderBinaryTag;
+	}
+
+	bool GlDevice::getShaderBinary(IShader* shader, ShaderBinary& outBinary) {
+		ASSERT(shader != nullptr);
+		if (m_shaderBinaryTag.empty()) {
+			return false;
+		}
+
+		const GLuint program = shader->getNativeObject();
+		GLint binaryLength = 0;
+		GL_CHECK(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength));
+		if (binaryLength <= 0) {
+			return false;
+		}
+
+		GLenum format = 0;
+		GLsizei writtenLength = 0;
+		outBinary.data.resize(binaryLength);
+		GL_CHECK(glGetProgramBinary(program, binaryLength, &writtenLength, &format, outBinary.data.data()));
+		outBinary.data.resize(writtenLength);
+		outBinary.format = format;
+		return writtenLength > 0;
+	}
+
+	uint32_t GlDevice::loadProgramBinary(const ShaderBinary& binary) {
+		if (m_shaderBinaryTag.empty() || binary.data.empty() ||
+			std::find(m_programBinaryFormats.begin(), m_programBinaryFormats.end(), static_cast<int32_t>(binary.format)) == m_programBinaryFormats.end()) {
+			return 0;
+		}
+
+		GLuint program = glCreateProgram();
+		GL_CHECK(;);
+		GL_CHECK(glProgramBinary(program, binary.format, binary.data.data(), static_cast<GLsizei>(binary.data.size())));
+
+		// A driver update or different GPU rejects the binary here, which isn't an error
+		GLint success = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		if (!success) {
+			glDeleteProgram(program);
+			return 0;
+		}
+		return program;
+	}
+
 	void GlDevice::setViewport(const Rect viewportRect) {
 		GL_CHECK(glViewport(viewportRect.left, viewportRect.top, viewportRect.getWidth(), viewportRect.getHeight()));
 	}
 
+	void GlDevice::setScissor(bool enabled, const Rect scissorRect) {
+		if (enabled) {
+			GL_CHECK(glEnable(GL_SCISSOR_TEST));
+			GL_CHECK(glScissor(scissorRect.left, scissorRect.top, scissorRect.getWidth(), scissorRect.getHeight()));
+		} else {
+			GL_CHECK(glDisable(GL_SCISSOR_TEST));
+		}
+	}
+
 	InputLayoutHandle GlDevice::createInputLayout(const VertexAttributeDesc* desc, uint32_t attributeCount) {
 
 		// Create native data
 		GLuint vertexArray = 0;
 		GL_CHECK(glGenVertexArrays(1, &vertexArray));
 		GL_CHECK(glBindVertexArray(vertexArray));
+		m_appliedState.vertexArray = vertexArray;
 		for (uint32_t i = 0; i < attributeCount; i++) {
 
 			ASSERT(desc[i].format != GpuFormat::Unknown);
@@ -98,13 +329,14 @@ namespace gpu::gl {
 				(void*) desc[i].offset));
 
 			GL_CHECK(glEnableVertexAttribArray(desc[i].bufferIndex));
+			GL_CHECK(glVertexAttribDivisor(desc[i].bufferIndex, desc[i].instanceStepRate));
 		}
 
 		// Copy attributes
 		GlInputLayout* inputLayout = new GlInputLayout();
 		inputLayout->attributes.resize(attributeCount);
 		for (uint32_t i = 0; i < attributeCount; i++) {
-			inputLayout->attributes[0] = desc[0];
+			inputLayout->attributes[i] = desc[i];
 		}
 		inputLayout->m_pointer = vertexArray;
 
@@ -120,48 +352,55 @@ namespace gpu::gl {
 		ASSERT(shaderDesc.PS.byteCode != nullptr);
 		ASSERT(shaderDesc.PS.byteCode[0] != 0);
 
-		GLuint vertexShader = 0;
-		GLuint pixelShader = 0;
-		GLuint shaderProgram = 0;
+		// The binary is only borrowed for this call, don't keep a pointer to it around
+		ShaderDesc storedDesc = shaderDesc;
+		storedDesc.binary = nullptr;
 
-		int  success = 0;
-		char infoLog[4096] = {};
+		if (shaderDesc.binary != nullptr) {
+			const GLuint binaryProgram = loadProgramBinary(*shaderDesc.binary);
+			if (binaryProgram != 0) {
+				GL_CHECK(glUseProgram(binaryProgram));
+				m_appliedState.program = binaryProgram;
+
+#if _DEBUG
+				if (!shaderDesc.debugName.empty()) {
+					GL_CHECK(glObjectLabel(GL_PROGRAM, binaryProgram, -1, shaderDesc.debugName.c_str()));
+				}
+#endif
+
+				GlShader* shader = new GlShader(storedDesc);
+				shader->m_pointer = binaryProgram;
+				shader->m_status = ShaderStatus::Ready;
+				shader->reflect();
+				return ShaderHandle::Create(shader);
+			}
+			LOG_WARN("[GL]: Shader binary for \"{}\" was rejected by the driver, compiling from source.", shaderDesc.debugName);
+		}
 
 		// We prepend a common "global" header into every shader before passing them into the shader compiler.
 		// Also we resolve #include pragma directives, so that we can better modularise the code.
 		// This is done in the asset manager however, which isn't ideal
 
-		vertexShader = glCreateShader(GL_VERTEX_SHADER);
+		// Everything is submitted before any status is read back, reading it would wait for the compiler. With
+		// GL_KHR_parallel_shader_compile the driver compiles and links on its own threads meanwhile
+		GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
 		GL_CHECK(;);
 		GL_CHECK(glShaderSource(vertexShader, 1, (const GLchar**)&shaderDesc.VS.byteCode, NULL));
 		GL_CHECK(glCompileShader(vertexShader));
-		glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-		if (!success)
-		{
-			glGetShaderInfoLog(vertexShader, sizeof(infoLog), NULL, infoLog);
-			LOG_FATAL("[GL]: Failed to compile vertex shader. Got:\n{0}", infoLog);
-
-			return ShaderHandle::Create(nullptr);
-		}
 
-		pixelShader = glCreateShader(GL_FRAGMENT_SHADER);
+		GLuint pixelShader = glCreateShader(GL_FRAGMENT_SHADER);
 		GL_CHECK(;);
 		GL_CHECK(glShaderSource(pixelShader, 1, (const GLchar**)&shaderDesc.PS.byteCode, NULL));
 		GL_CHECK(glCompileShader(pixelShader));
-		glGetShaderiv(pixelShader, GL_COMPILE_STATUS, &success);
-		if (!success)
-		{
-			glGetShaderInfoLog(pixelShader, sizeof(infoLog), NULL, infoLog);
-			LOG_FATAL("[GL]: Failed to compile pixel shader. Got:\n{0}", infoLog);
 
-			return ShaderHandle::Create(nullptr);
-		}
-
-		shaderProgram = glCreateProgram();
+		GLuint shaderProgram = glCreateProgram();
 		GL_CHECK(glAttachShader(shaderProgram, vertexShader));
 		GL_CHECK(glAttachShader(shaderProgram, pixelShader));
+		if (!m_shaderBinaryTag.empty()) {
+			// Lets getShaderBinary read the program back afterwards
+			GL_CHECK(glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+		}
 		GL_CHECK(glLinkProgram(shaderProgram));
-		GL_CHECK(glUseProgram(shaderProgram));
 
 #if _DEBUG
 		if (!shaderDesc.debugName.empty()) {
@@ -171,10 +410,22 @@ namespace gpu::gl {
 		}
 #endif
 
-		GlShader* shader = new GlShader(shaderDesc);
+		GlShader* shader = new GlShader(storedDesc);
 		shader->m_pointer = shaderProgram;
 		shader->m_vertexShaderPtr = vertexShader;
 		shader->m_pixelShaderPtr = pixelShader;
+		shader->m_canPollCompletion = m_parallelShaderCompile;
+
+		if (shaderDesc.async) {
+			return ShaderHandle::Create(shader);
+		}
+
+		if (shader->finishCompile() == ShaderStatus::Failed) {
+			delete shader;
+			return ShaderHandle::Create(nullptr);
+		}
+		GL_CHECK(glUseProgram(shaderProgram));
+		m_appliedState.program = shaderProgram;
 
 		return ShaderHandle::Create(shader);
 	}
@@ -200,116 +451,250 @@ namespace gpu::gl {
 		return BufferHandle::Create(buffer);
 	}
 
-	void GlDevice::bindShader(IShader* shader) {
-		ASSERT(shader != nullptr);
+	PipelineHandle GlDevice::makePipeline(const PipelineDesc pipelineDesc) {
+		ASSERT(pipelineDesc.shader != nullptr);
+		ASSERT(pipelineDesc.inputLayout != nullptr);
 
-		// shader program
-		GL_CHECK(glUseProgram(shader->getNativeObject()));
+		// State is applied when a draw binds the pipeline, GL has no object for it
+		GlPipeline* pipeline = new GlPipeline(pipelineDesc);
+		return PipelineHandle::Create(pipeline);
+	}
 
-		// culling mode
-		switch (shader->getDesc().graphicsState.faceCullingMode) {
-			case gpu::FaceCullMode::Never:
-			{
-				GL_CHECK(glDisable(GL_CULL_FACE));
-				break;
+	void GlDevice::registerUniformBlock(const UniformBlockDesc& desc) {
+		ASSERT(!desc.name.empty());
+		ASSERT(desc.bindIndex < static_cast<uint32_t>(m_maxUniformBufferBindings));
+		m_uniformBlocks[desc.name] = desc;
+		m_uniformBlocksRevision++;
+	}
+
+	void GlDevice::applyUniformBlocks(GlShader* shader) {
+		shader->m_uniformBlocksRevision = m_uniformBlocksRevision;
+		for (const ShaderUniformBlock& block : shader->m_reflection.uniformBlocks) {
+			auto registered = m_uniformBlocks.find(block.name);
+			if (registered == m_uniformBlocks.end()) {
+				continue;
 			}
-			case gpu::FaceCullMode::Back:
-			{
-				GL_CHECK(glEnable(GL_CULL_FACE));
-				GL_CHECK(glCullFace(GL_BACK));
-				break;
+			const UniformBlockDesc& desc = registered->second;
+			shader->setBlockBinding(block.name, desc.bindIndex);
+
+#if _DEBUG
+			// std140 rules don't always match how the C++ struct packs, so catch any drift before it shows up as garbage
+			if (desc.size != 0 && block.size > desc.size) {
+				LOG_ERROR("[GL]: Uniform block {} is {} bytes in shader \"{}\", but its C++ struct is only {} bytes",
+					block.name, block.size, shader->m_shaderDesc.debugName, desc.size);
 			}
-			case gpu::FaceCullMode::Front:
-			{
-				GL_CHECK(glEnable(GL_CULL_FACE));
-				GL_CHECK(glCullFace(GL_FRONT));
-				break;
+			for (const ShaderUniformMember& member : desc.members) {
+				for (const ShaderUniformMember& reflected : block.members) {
+					if (reflected.name == member.name && reflected.offset != member.offset) {
+						LOG_ERROR("[GL]: {}.{} is at offset {} in shader \"{}\", but at {} in its C++ struct",
+							block.name, member.name, reflected.offset, shader->m_shaderDesc.debugName, member.offset);
+					}
+				}
 			}
-			case gpu::FaceCullMode::Both:
-			{
-				GL_CHECK(glEnable(GL_CULL_FACE));
-				GL_CHECK(glCullFace(GL_FRONT_AND_BACK));
-				break;
+#endif
+		}
+	}
+
+	void GlDevice::bindPipeline(IPipeline* pipeline) {
+		ASSERT(pipeline != nullptr);
+		const PipelineDesc& desc = pipeline->getDesc();
+		const GraphicsState& state = desc.graphicsState;
+		const bool applyAll = !m_appliedStateValid;
+		m_appliedStateValid = true;
+
+		// Programs made before a block was registered get it bound here
+		GlShader* shader = static_cast<GlShader*>(desc.shader);
+		if (shader->m_status == ShaderStatus::Compiling) {
+			// glUseProgram would wait for the driver anyway
+			shader->finishCompile();
+		}
+		if (shader->m_uniformBlocksRevision != m_uniformBlocksRevision) {
+			applyUniformBlocks(shader);
+		}
+
+		// shader program
+		if (applyAll || m_appliedState.program != desc.shader->getNativeObject()) {
+			GL_CHECK(glUseProgram(desc.shader->getNativeObject()));
+			m_appliedState.program = desc.shader->getNativeObject();
+		}
+
+		// associated vertex layout
+		if (applyAll || m_appliedState.vertexArray != desc.inputLayout->getNativeObject()) {
+			GL_CHECK(glBindVertexArray(desc.inputLayout->getNativeObject()));
+			m_appliedState.vertexArray = desc.inputLayout->getNativeObject();
+		}
+
+		// culling mode
+		if (applyAll || m_appliedState.faceCullingMode != state.faceCullingMode) {
+			switch (state.faceCullingMode) {
+				case gpu::FaceCullMode::Never:
+				{
+					GL_CHECK(glDisable(GL_CULL_FACE));
+					break;
+				}
+				case gpu::FaceCullMode::Back:
+				{
+					GL_CHECK(glEnable(GL_CULL_FACE));
+					GL_CHECK(glCullFace(GL_BACK));
+					break;
+				}
+				case gpu::FaceCullMode::Front:
+				{
+					GL_CHECK(glEnable(GL_CULL_FACE));
+					GL_CHECK(glCullFace(GL_FRONT));
+					break;
+				}
+				case gpu::FaceCullMode::Both:
+				{
+					GL_CHECK(glEnable(GL_CULL_FACE));
+					GL_CHECK(glCullFace(GL_FRONT_AND_BACK));
+					break;
+				}
 			}
+			m_appliedState.faceCullingMode = state.faceCullingMode;
 		}
 
 		// winding order
-		GL_CHECK(glFrontFace(shader->getDesc().graphicsState.faceWindingOrder == gpu::WindingOrder::Clockwise ? GL_CW : GL_CCW));
+		if (applyAll || m_appliedState.faceWindingOrder != state.faceWindingOrder) {
+			GL_CHECK(glFrontFace(state.faceWindingOrder == gpu::WindingOrder::Clockwise ? GL_CW : GL_CCW));
+			m_appliedState.faceWindingOrder = state.faceWindingOrder;
+		}
 
 		// depth state
-		if (shader->getDesc().graphicsState.depthTest) {
-			GL_CHECK(glEnable(GL_DEPTH_TEST));
-		} else {
-			GL_CHECK(glDisable(GL_DEPTH_TEST));
+		if (applyAll || m_appliedState.depthTest != state.depthTest) {
+			if (state.depthTest) {
+				GL_CHECK(glEnable(GL_DEPTH_TEST));
+			} else {
+				GL_CHECK(glDisable(GL_DEPTH_TEST));
+			}
+			m_appliedState.depthTest = state.depthTest;
+		}
+		const bool depthWrite = m_depthOverrideEnabled ? m_depthOverrideWrite : state.depthWrite;
+		const CompareFunc depthFunc = m_depthOverrideEnabled ? m_depthOverrideFunc : state.depthState;
+		if (applyAll || m_appliedState.depthWrite != depthWrite) {
+			GL_CHECK(glDepthMask(depthWrite ? GL_TRUE : GL_FALSE));
+			m_appliedState.depthWrite = depthWrite;
+		}
+		if (applyAll || m_appliedState.depthFunc != depthFunc) {
+			GL_CHECK(glDepthFunc(getGlDepthFunc(depthFunc).glEnum));
+			m_appliedState.depthFunc = depthFunc;
+		}
+
+		// colour writes
+		if (applyAll || m_appliedState.colorWrite != state.colorWrite) {
+			GLboolean colorWrite = state.colorWrite ? GL_TRUE : GL_FALSE;
+			GL_CHECK(glColorMask(colorWrite, colorWrite, colorWrite, colorWrite));
+			m_appliedState.colorWrite = state.colorWrite;
+		}
+
+		// blending, the factors are left alone while blending is disabled
+		const BlendStateDesc blendDesc = desc.blendState != nullptr ? desc.blendState->getDesc() : BlendStateDesc{};
+		if (applyAll || m_appliedState.blendState.blendEnable != blendDesc.blendEnable) {
+			if (blendDesc.blendEnable) {
+				GL_CHECK(glEnable(GL_BLEND));
+			} else {
+				GL_CHECK(glDisable(GL_BLEND));
+			}
+			m_appliedState.blendState.blendEnable = blendDesc.blendEnable;
+		}
+		if (blendDesc.blendEnable && (applyAll || m_appliedState.blendState != blendDesc)) {
+			// Blend factors
+			GLenum srcRGB = getGlBlendFactor(blendDesc.srcFactor).glEnum;
+			GLenum srcAlpha = getGlBlendFactor(blendDesc.srcFactorAlpha).glEnum;
+			GLenum dstRGB = getGlBlendFactor(blendDesc.dstFactor).glEnum;
+			GLenum dstAlpha = getGlBlendFactor(blendDesc.dstFactorAlpha).glEnum;
+			GL_CHECK(glBlendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha));
+
+			GLenum eqnRGB = getGlBlendOp(blendDesc.blendOp).glEnum;
+			GLenum eqnAlpha = getGlBlendOp(blendDesc.blendOpAlpha).glEnum;
+			GL_CHECK(glBlendEquationSeparate(eqnRGB, eqnAlpha));
+			m_appliedState.blendState = blendDesc;
 		}
-		GL_CHECK(glDepthMask(shader->getDesc().graphicsState.depthWrite == true ? GL_TRUE : GL_FALSE));
-		GL_CHECK(glDepthFunc(getGlDepthFunc(shader->getDesc().graphicsState.depthState).glEnum));
 	}
 
-	void GlDevice::draw(DrawCallState drawCallState, size_t triangleCount, size_t offset, size_t instances) {
+	void GlDevice::setDepthOverride(bool enabled, CompareFunc depthFunc, bool depthWrite) {
+		m_depthOverrideEnabled = enabled;
+		m_depthOverrideFunc = depthFunc;
+		m_depthOverrideWrite = depthWrite;
+	}
+
+	// GL 3.3 has no base instance draws, emulate it by moving the instanced attributes' pointers.
+	// The vertex layout and its vertex buffer must be bound
+	static void setInstanceAttributeOffset(const IInputLayout* vertexLayout, size_t firstInstance) {
+		for (const VertexAttributeDesc& attribute : vertexLayout->attributes) {
+			if (attribute.instanceStepRate == 0) {
+				continue;
+			}
+			auto formatData = gpu::gl::getGlFormat(attribute.format);
+			size_t instanceOffset = (firstInstance / attribute.instanceStepRate) * attribute.elementStride;
+			GL_CHECK(glVertexAttribPointer(
+				attribute.bufferIndex,
+				static_cast<GLint>(formatData.size),
+				formatData.glType,
+				formatData.glNormalised,
+				attribute.elementStride,
+				(void*) (attribute.offset + instanceOffset)));
+		}
+	}
+
+	void GlDevice::draw(DrawCallState drawCallState, size_t triangleCount, size_t offset, size_t instances, size_t firstInstance) {
 		ASSERT(drawCallState.vertexBufer != nullptr);
 		ASSERT(drawCallState.indexBuffer == nullptr);
-		ASSERT(drawCallState.shader != nullptr);
-		ASSERT(drawCallState.vertexLayout != nullptr);
+		ASSERT(drawCallState.pipeline != nullptr);
 		ASSERT(triangleCount > 0);
 		ASSERT(drawCallState.primitiveType != PrimitiveType::Count);
 		if (instances == 0) {
 			return;
 		}
 
-		// associated vertex layout
-		GL_CHECK(glBindVertexArray(drawCallState.vertexLayout->getNativeObject()));
-
-		// Bind shader
-		bindShader(drawCallState.shader);
+		// Bind shader, vertex layout and fixed function state
+		bindPipeline(drawCallState.pipeline);
 
 		// Bind vertex buffer
 		bindBuffer(drawCallState.vertexBufer);
 		// Unbind index buffer
 		GL_CHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
 
-		// Set BlendState
-		if (drawCallState.blendState != nullptr) {
-			bindBlendState(drawCallState.blendState);
-		}
-
 		auto primitiveType = getGlPrimitiveType(drawCallState.primitiveType);
 
 		// Issue draw call
+		if (firstInstance != 0) {
+			setInstanceAttributeOffset(drawCallState.pipeline->getDesc().inputLayout, firstInstance);
+		}
 		GL_CHECK(glDrawArraysInstanced(primitiveType.glType, static_cast<GLint>(offset), static_cast<GLsizei>(triangleCount) * 3U /* OpenGL expects number of vertices here, not tris */, instances));
+		if (firstInstance != 0) {
+			setInstanceAttributeOffset(drawCallState.pipeline->getDesc().inputLayout, 0);
+		}
 	}
-	void GlDevice::drawIndexed(DrawCallState drawCallState, size_t triangleCount, size_t offset, size_t instances) {
+	void GlDevice::drawIndexed(DrawCallState drawCallState, size_t triangleCount, size_t offset, size_t instances, size_t firstInstance) {
 		ASSERT(drawCallState.vertexBufer != nullptr);
 		ASSERT(drawCallState.indexBuffer != nullptr);
-		ASSERT(drawCallState.shader != nullptr);
-		ASSERT(drawCallState.vertexLayout != nullptr);
+		ASSERT(drawCallState.pipeline != nullptr);
 		ASSERT(triangleCount > 0);
 		ASSERT(drawCallState.primitiveType != PrimitiveType::Count);
 		if (instances == 0) {
 			return;
 		}
 
-		// associated vertex layout
-		GL_CHECK(glBindVertexArray(drawCallState.vertexLayout->getNativeObject()));
-
-		// Bind shader
-		bindShader(drawCallState.shader);
+		// Bind shader, vertex layout and fixed function state
+		bindPipeline(drawCallState.pipeline);
 
 		// Bind vertex buffer
 		bindBuffer(drawCallState.vertexBufer);
 		// Bind index buffer
 		bindBuffer(drawCallState.indexBuffer);
 
-		// Set BlendState
-		if (drawCallState.blendState != nullptr) {
-			bindBlendState(drawCallState.blendState);
-		}
-
 		auto primitiveType = getGlPrimitiveType(drawCallState.primitiveType);
 		auto indexFormat = getGlFormat(drawCallState.indexBuffer->getDesc().format);
 
 		// Issue draw call
+		if (firstInstance != 0) {
+			setInstanceAttributeOffset(drawCallState.pipeline->getDesc().inputLayout, firstInstance);
+		}
 		GL_CHECK(glDrawElementsInstanced(primitiveType.glType, static_cast<GLsizei>(triangleCount) * 3U /* OpenGL expects number of indices here, not tris */, indexFormat.glType, reinterpret_cast<void*>(offset), instances));
+		if (firstInstance != 0) {
+			setInstanceAttributeOffset(drawCallState.pipeline->getDesc().inputLayout, 0);
+		}
 	}
 
 	void GlDevice::clearColor(Color color, float depth) {
@@ -322,8 +707,11 @@ namespace gpu::gl {
 			GL_CHECK(glClearDepth(depth));
 			m_depth = depth;
 		}
-		// clear colour and depth buffer
+		// clear colour and depth buffer. Write masks also apply to glClear, so restore them in case a depth only pipeline was last bound
 		GL_CHECK(glDepthMask(GL_TRUE));
+		GL_CHECK(glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE));
+		m_appliedState.depthWrite = true;
+		m_appliedState.colorWrite = true;
 		GL_CHECK(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
 	}
 
@@ -337,27 +725,6 @@ namespace gpu::gl {
 		return BlendStateHandle::Create(blendState);
 	}
 
-	void GlDevice::bindBlendState(IBlendState* blendState) {
-		ASSERT(blendState != nullptr);
-		gpu::BlendStateDesc desc = blendState->getDesc();
-
-		if (desc.blendEnable) {
-			GL_CHECK(glEnable(GL_BLEND));
-			// Blend factors
-			GLenum srcRGB = getGlBlendFactor(desc.srcFactor).glEnum;
-			GLenum srcAlpha = getGlBlendFactor(desc.srcFactorAlpha).glEnum;
-			GLenum dstRGB = getGlBlendFactor(desc.dstFactor).glEnum;
-			GLenum dstAlpha = getGlBlendFactor(desc.dstFactorAlpha).glEnum;
-			GL_CHECK(glBlendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha));
-
-			GLenum eqnRGB = getGlBlendOp(desc.blendOp).glEnum;
-			GLenum eqnAlpha = getGlBlendOp(desc.blendOpAlpha).glEnum;
-			GL_CHECK(glBlendEquationSeparate(eqnRGB, eqnAlpha));
-		} else {
-			GL_CHECK(glDisable(GL_BLEND));
-		}
-	}
-
 	void GlDevice::bindTexture(ITexture* texture, ITextureSampler* sampler, uint32_t index) {
 		ASSERT(texture != nullptr);
 		ASSERT(sampler != nullptr);
@@ -368,18 +735,22 @@ namespace gpu::gl {
 		GL_CHECK(glBindSampler(index, sampler->getNativeObject()));
 	}
 
-	void GlDevice::bindTexture(IFramebuffer* texture, ITextureSampler* sampler, uint32_t index) {
+	void GlDevice::bindTexture(IFramebuffer* texture, ITextureSampler* sampler, uint32_t index, uint32_t attachment) {
 		ASSERT(texture != nullptr);
 		ASSERT(sampler != nullptr);
 		ASSERT(index < m_maxCombinedTextureImageUnits);
 
 		GL_CHECK(glActiveTexture(GL_TEXTURE0 + index)); // we need to offset the binding offset for texture 0 with the user supplied index
-		GL_CHECK(glBindTexture(GL_TEXTURE_2D, texture->getTextureNativeObject()));
+		GL_CHECK(glBindTexture(texture->getDesc().cubeMap ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D, texture->getTextureNativeObject(attachment)));
 		GL_CHECK(glBindSampler(index, sampler->getNativeObject()));
 	}
 
-	void GlDevice::bindFramebuffer(IFramebuffer* texture) {
-		GL_CHECK(glBindFramebuffer(GL_RENDERBUFFER, texture != nullptr ? texture->getNativeObject() : 0));
+	void GlDevice::bindFramebuffer(IFramebuffer* texture, uint32_t cubeFace) {
+		GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, texture != nullptr ? texture->getNativeObject() : 0));
+		if (texture != nullptr && texture->getDesc().cubeMap) {
+			ASSERT(cubeFace < k_CUBEMAP_FACE_COUNT);
+			GL_CHECK(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + cubeFace, texture->getTextureNativeObject(0), 0));
+		}
 	}
 
 	void GlDevice::blitFramebuffer(IFramebuffer* textureSrc, IFramebuffer* textureDst) {
@@ -403,13 +774,46 @@ namespace gpu::gl {
 			GL_COLOR_BUFFER_BIT, GL_NEAREST));
 	}
 
+	void GlDevice::blitFramebufferDepth(IFramebuffer* textureSrc, IFramebuffer* textureDst) {
+		ASSERT(textureSrc != nullptr || textureDst != nullptr);
+
+		// Either side may be the backbuffer, which takes its size from the other one
+		const FramebufferDesc& sizeDesc = textureSrc != nullptr ? textureSrc->getDesc() : textureDst->getDesc();
+		GL_CHECK(glBindFramebuffer(GL_READ_FRAMEBUFFER, textureSrc != nullptr ? textureSrc->getNativeObject() : 0));
+		GL_CHECK(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, textureDst != nullptr ? textureDst->getNativeObject() : 0));
+		// Depth blits must use nearest filtering
+		GL_CHECK(glBlitFramebuffer(
+			0, 0, sizeDesc.depthStencilDesc.width, sizeDesc.depthStencilDesc.height,
+			0, 0, sizeDesc.depthStencilDesc.width, sizeDesc.depthStencilDesc.height,
+			GL_DEPTH_BUFFER_BIT, GL_NEAREST));
+	}
+
+	void GlDevice::clearColorAttachment(uint32_t attachment, Color color) {
+		GLfloat clearValue[4] = { color.r, color.g, color.b, color.a };
+		// Write masks also apply to clears
+		GL_CHECK(glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE));
+		m_appliedState.colorWrite = true;
+		GL_CHECK(glClearBufferfv(GL_COLOR, attachment, clearValue));
+	}
+
+	void GlDevice::readDepthBuffer(IBuffer* buffer, const Rect rect) {
+		ASSERT(buffer != nullptr);
+		ASSERT(buffer->getDesc().type == gpu::BufferType::PixelReadTarget);
+
+		// With a pixel pack buffer bound glReadPixels writes into the buffer instead of client memory, and returns without waiting on the GPU
+		bindBuffer(buffer);
+		GL_CHECK(glReadPixels(rect.left, rect.top, rect.getWidth(), rect.getHeight(), GL_DEPTH_COMPONENT, GL_FLOAT, nullptr));
+		// Leaving a pack buffer bound would redirect every later pixel read
+		unbindBuffer(buffer);
+	}
+
 	void GlDevice::debugMarkerPush(const std::string& title) {
-#if _DEBUG
+#if ENGINE_GPU_MARKERS
 		GL_CHECK(glPushDebugGroupKHR(GL_DEBUG_SOURCE_APPLICATION, 0, -1, title.c_str()));
 #endif
 	}
 	void GlDevice::debugMarkerPop() {
-#if _DEBUG
+#if ENGINE_GPU_MARKERS
 		GL_CHECK(glPopDebugGroupKHR());
 #endif
 	}
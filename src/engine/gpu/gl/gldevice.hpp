@@ -1,6 +1,8 @@
 #include "engine/gpu/idevice.hpp"
 #include "engine/log.hpp"
 
+#include <unordered_map>
+
 namespace gpu::gl {
 
 	// Macro to get errors from OpenGL at call sites
@@ -85,10 +87,11 @@ namespace gpu::gl {
 		~GlFramebuffer() override;
 		[[nodiscard]] const FramebufferDesc& getDesc() const override;
 		[[nodiscard]] const GpuPtr getNativeObject() const override;
-		[[nodiscard]] const GpuPtr getTextureNativeObject() const override;
+		[[nodiscard]] const GpuPtr getTextureNativeObject(uint32_t attachment = 0) const override;
 	private:
 		FramebufferDesc m_desc;
-		uint32_t m_textureAttachment = 0;
+		uint32_t m_textureAttachments[k_MAX_FRAMEBUFFER_COLOR_ATTACHMENTS] = {};
+		uint32_t m_colorAttachmentCount = 0;
 		uint32_t m_depthStencilAttachment = 0;
 		uint32_t m_pointer = 0;
 
@@ -104,6 +107,9 @@ namespace gpu::gl {
 		~GlShader();
 		[[nodiscard]] inline const ShaderDesc& getDesc() const override { return m_shaderDesc; }
 		[[nodiscard]] inline const GpuPtr getNativeObject() const override { return m_pointer; }
+		[[nodiscard]] inline bool isLoadedFromBinary() const override { return m_vertexShaderPtr == 0; }
+		[[nodiscard]] ShaderStatus pollStatus() override;
+		[[nodiscard]] inline const ShaderReflection& getReflection() const override { return m_reflection; }
 		// Inherited:
 		//	   uint32_t pointer;
 		//     uint32_t vertexShaderPtr;
@@ -111,9 +117,26 @@ namespace gpu::gl {
 	private:
 		ShaderDesc m_shaderDesc;
 		uint32_t m_pointer = 0;
+		// Both 0 when the program was loaded from a binary
 		uint32_t m_vertexShaderPtr = 0;
 		uint32_t m_pixelShaderPtr = 0;
 
+		// Checks the compile and link results, which waits for the driver if it hasn't finished yet
+		ShaderStatus finishCompile();
+		// Reads the linked program's uniform blocks and samplers
+		void reflect();
+		// Returns false if the program has no active block with that name
+		bool setBlockBinding(const std::string& blockName, uint32_t bindIndex);
+
+		ShaderStatus m_status = ShaderStatus::Compiling;
+		// GL_KHR_parallel_shader_compile, without it there's no way to ask without waiting
+		bool m_canPollCompletion = false;
+		// Uniform block bindings set while compiling, looking the blocks up would wait for the link
+		std::vector<std::pair<std::string, uint32_t>> m_pendingBlockBindings;
+		ShaderReflection m_reflection;
+		// GlDevice::m_uniformBlocksRevision when the registered blocks were last bound in this program
+		uint32_t m_uniformBlocksRevision = 0;
+
 		friend class gpu::gl::GlDevice;
 	};
 
@@ -131,6 +154,19 @@ namespace gpu::gl {
 		BlendStateDesc m_blendStateDesc;
 	};
 
+	//
+	// Pipeline
+	//
+	class GlPipeline : public gpu::IPipeline {
+	public:
+		GlPipeline(PipelineDesc pipelineDesc) : m_pipelineDesc(pipelineDesc) {}
+		~GlPipeline() = default;
+		[[nodiscard]] inline const PipelineDesc& getDesc() const override { return m_pipelineDesc; }
+
+	private:
+		PipelineDesc m_pipelineDesc;
+	};
+
 	//
 	// Device
 	//
@@ -140,8 +176,12 @@ namespace gpu::gl {
 		~GlDevice() override;
 
 		void setViewport(const Rect viewportRect) override;
+		void setScissor(bool enabled, const Rect scissorRect = {}) override;
 		InputLayoutHandle createInputLayout(const VertexAttributeDesc* desc, uint32_t attributeCount) override;
 		ShaderHandle makeShader(const ShaderDesc shaderDesc) override;
+		PipelineHandle makePipeline(const PipelineDesc pipelineDesc) override;
+		std::string getShaderBinaryTag() const override;
+		bool getShaderBinary(IShader* shader, ShaderBinary& outBinary) override;
 
 		BufferHandle makeBuffer(const BufferDesc bufferDesc) override;
 		void writeBuffer(IBuffer* handle, size_t size, const void* data) override;
@@ -152,43 +192,113 @@ namespace gpu::gl {
 		void setConstantBuffer(IBuffer* buffer, uint32_t bindIndex) override;
 		void unbindConstantBuffer(IBuffer* buffer, uint32_t bindIndex) override;
 		void setBufferBinding(IShader* shader, const std::string& name, uint32_t bindIndex) override;
+		void registerUniformBlock(const UniformBlockDesc& desc) override;
 
-		void draw(DrawCallState drawCallState, size_t triangleCount, size_t offset = 0, size_t instances = 1) override;
-		void drawIndexed(DrawCallState drawCallState, size_t triangleCount, size_t offset = 0, size_t instances = 1) override;
+		void draw(DrawCallState drawCallState, size_t triangleCount, size_t offset = 0, size_t instances = 1, size_t firstInstance = 0) override;
+		void drawIndexed(DrawCallState drawCallState, size_t triangleCount, size_t offset = 0, size_t instances = 1, size_t firstInstance = 0) override;
 
 		void clearColor(Color color, float depth) override;
 		void present() override;
 
 		// Blend state
 		BlendStateHandle makeBlendState(const BlendStateDesc blendStateDesc) override;
-		void bindBlendState(IBlendState* blendState) override;
 
 		// Textures
 		TextureHandle makeTexture(TextureDesc desc, void* textureData) override;
 		TextureSamplerHandle makeTextureSampler(TextureSamplerDesc desc) override;
 		void bindTexture(ITexture* texture, ITextureSampler* sampler, uint32_t index = 0) override;
-		void bindTexture(IFramebuffer* texture, ITextureSampler* sampler, uint32_t index = 0) override;
+		void bindTexture(IFramebuffer* texture, ITextureSampler* sampler, uint32_t index = 0, uint32_t attachment = 0) override;
 
 		FramebufferHandle makeFramebuffer(FramebufferDesc desc) override;
-		void bindFramebuffer(IFramebuffer* texture) override; 
+		void bindFramebuffer(IFramebuffer* texture, uint32_t cubeFace = 0) override;
 		void blitFramebuffer(IFramebuffer* textureSrc, IFramebuffer* textureDst) override;
+		void blitFramebufferDepth(IFramebuffer* textureSrc, IFramebuffer* textureDst) override;
+		void clearColorAttachment(uint32_t attachment, Color color) override;
+		void readDepthBuffer(IBuffer* buffer, const Rect rect) override;
+
+		void setDepthOverride(bool enabled, CompareFunc depthFunc = CompareFunc::Equal, bool depthWrite = false) override;
 
 		void debugMarkerPush(const std::string& title) override;
 		void debugMarkerPop() override;
 
+		void beginProfilingFrame() override;
+		void endProfilingFrame() override;
+		void profileScopePush(const char* name) override;
+		void profileScopePop() override;
+		[[nodiscard]] const std::vector<GpuScopeTiming>& getProfilingResults() const override;
+
 	private:
-		void bindShader(IShader* shader);
+		struct ProfileScope {
+			const char* name = "";
+			uint32_t depth = 0;
+			uint32_t beginQuery = 0;
+			// Stays UINT32_MAX if the scope was never popped
+			uint32_t endQuery = UINT32_MAX;
+		};
+
+		// Timestamp queries of a single frame. Query objects are reused every k_gpuProfilerLatency frames, and only ever grow
+		struct ProfileFrame {
+			std::vector<uint32_t> queries;
+			uint32_t usedQueries = 0;
+			std::vector<ProfileScope> scopes;
+			bool pending = false;
+		};
+
+		// Only issues the GL calls for state which differs from the last bound pipeline
+		void bindPipeline(IPipeline* pipeline);
 		const bool isExtensionAvailable(const std::string& extensionName) const;
+		// Links a program out of binary. Returns 0 if the driver rejects it
+		uint32_t loadProgramBinary(const ShaderBinary& binary);
+		// Binds the registered uniform blocks in the shader, and in debug builds checks them against its reflection
+		void applyUniformBlocks(GlShader* shader);
+		// Records a timestamp into the next free query of the frame, returns its index
+		uint32_t writeProfileTimestamp(ProfileFrame& frame);
+		void collectProfilingFrame(ProfileFrame& frame);
+
+		// State last sent to GL. Creating shaders and input layouts binds them, so they update it too
+		struct AppliedState {
+			uint32_t program = 0;
+			uint32_t vertexArray = 0;
+			FaceCullMode faceCullingMode = FaceCullMode::Never;
+			WindingOrder faceWindingOrder = WindingOrder::CounterClockwise;
+			bool depthTest = false;
+			// Depth function and writes in effect, which are the depth override's while it is enabled
+			CompareFunc depthFunc = CompareFunc::Less;
+			bool depthWrite = true;
+			bool colorWrite = true;
+			BlendStateDesc blendState;
+		};
+		AppliedState m_appliedState;
+		// Nothing is known about GL's state until the first pipeline is bound
+		bool m_appliedStateValid = false;
 
-		uint32_t m_boundShader = -1;
 		uint32_t m_currentBuffers[(uint32_t)gpu::BufferType::Count] = {};
 		Color m_clearColor = {};
 		float m_depth = 0xFFFFFFFF;
 
+		bool m_depthOverrideEnabled = false;
+		CompareFunc m_depthOverrideFunc = CompareFunc::Equal;
+		bool m_depthOverrideWrite = false;
+
 		std::vector<std::string> m_openGlExtensions;
 		int32_t m_maxUniformBufferBindings = 0;
 		int32_t m_maxCombinedTextureImageUnits = 0;
 		int32_t m_maxUniformBufferBlockSize = 0;
 		float m_maxTextureMaxAnisotropyExt = 0;
+		// Empty if the driver can't save program binaries
+		std::vector<int32_t> m_programBinaryFormats;
+		std::string m_shaderBinaryTag;
+		bool m_parallelShaderCompile = false;
+		// Blocks from registerUniformBlock by name. The revision goes up with every registration, so shaders made earlier
+		// pick the new block up the next time they're bound
+		std::unordered_map<std::string, UniformBlockDesc> m_uniformBlocks;
+		uint32_t m_uniformBlocksRevision = 0;
+
+		ProfileFrame m_profileFrames[k_gpuProfilerLatency];
+		uint32_t m_profileFrameIndex = 0;
+		bool m_profilingFrameOpen = false;
+		// Indices into the current frame's scopes
+		std::vector<uint32_t> m_profileScopeStack;
+		std::vector<GpuScopeTiming> m_profilingResults;
 	};
 }
\ No newline at end of file
@@ -25,6 +25,12 @@ namespace gpu::gl {
         { GpuFormat::RGB8_TYPELESS, 3, GL_FLOAT, false },
         { GpuFormat::RGBA8_TYPELESS, 4, GL_FLOAT, false },
 
+        { GpuFormat::RGBA16_UNORM, 4, GL_UNSIGNED_SHORT, true },
+
+        { GpuFormat::RG16_FLOAT, 2, GL_HALF_FLOAT, false },
+        { GpuFormat::RG16_SNORM, 2, GL_SHORT, true },
+        { GpuFormat::RGBA16_SNORM, 4, GL_SHORT, true },
+
     };
 
     GlGpuFormatMapping getGlFormat(gpu::GpuFormat format) {
@@ -196,6 +202,9 @@ namespace gpu::gl {
         { TextureFormat::SRGB8,             GL_SRGB8 },
         { TextureFormat::SRGB8_A8,          GL_SRGB8_ALPHA8 },
 
+        { TextureFormat::RGBA16F,           GL_RGBA16F },
+        { TextureFormat::R16F,              GL_R16F },
+
         { TextureFormat::Depth16,           GL_DEPTH_COMPONENT16 },
         { TextureFormat::Depth24,           GL_DEPTH_COMPONENT24 },
         { TextureFormat::Depth32,           GL_DEPTH_COMPONENT32F },
@@ -0,0 +1,106 @@
+#include "gldevice.hpp"
+#include "engine/core.hpp"
+#include "engine/gpu/gl/glmappings.hpp"
+
+#include <glad/glad.h>
+
+namespace gpu::gl {
+
+	uint32_t GlDevice::writeProfileTimestamp(ProfileFrame& frame) {
+		if (frame.usedQueries == frame.queries.size()) {
+			GLuint query = 0;
+			GL_CHECK(glGenQueries(1, &query));
+			frame.queries.push_back(query);
+		}
+		uint32_t index = frame.usedQueries++;
+		GL_CHECK(glQueryCounter(frame.queries[index], GL_TIMESTAMP));
+		return index;
+	}
+
+	void GlDevice::collectProfilingFrame(ProfileFrame& frame) {
+		frame.pending = false;
+		if (frame.usedQueries == 0) {
+			return;
+		}
+
+		// Queries finish in submission order, once the last one is available every other one is too
+		GLint available = 0;
+		GL_CHECK(glGetQueryObjectiv(frame.queries[frame.usedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available));
+		if (!available) {
+			// The GPU is further behind than the readback latency. Drop the frame rather than wait on it
+			return;
+		}
+
+		m_profilingResults.clear();
+		for (const ProfileScope& scope : frame.scopes) {
+			if (scope.endQuery == UINT32_MAX) {
+				continue;
+			}
+			GLuint64 begin = 0;
+			GLuint64 end = 0;
+			GL_CHECK(glGetQueryObjectui64v(frame.queries[scope.beginQuery], GL_QUERY_RESULT, &begin));
+			GL_CHECK(glGetQueryObjectui64v(frame.queries[scope.endQuery], GL_QUERY_RESULT, &end));
+			m_profilingResults.push_back({
+				.name = scope.name,
+				.depth = scope.depth,
+				// Timestamps are in nanoseconds
+				.milliseconds = end > begin ? (end - begin) * 0.000001 : 0.0,
+			});
+		}
+	}
+
+	void GlDevice::beginProfilingFrame() {
+		ASSERT(!m_profilingFrameOpen);
+
+		// The slot we are about to record into holds the oldest frame
+		ProfileFrame& frame = m_profileFrames[m_profileFrameIndex % k_gpuProfilerLatency];
+		if (frame.pending) {
+			collectProfilingFrame(frame);
+		}
+		frame.usedQueries = 0;
+		frame.scopes.clear();
+		m_profileScopeStack.clear();
+
+		m_profilingFrameOpen = true;
+		profileScopePush("Frame");
+	}
+
+	void GlDevice::endProfilingFrame() {
+		ASSERT(m_profilingFrameOpen);
+
+		// Close the frame scope, along with any scope left open by mistake
+		while (!m_profileScopeStack.empty()) {
+			profileScopePop();
+		}
+
+		m_profileFrames[m_profileFrameIndex % k_gpuProfilerLatency].pending = true;
+		m_profileFrameIndex++;
+		m_profilingFrameOpen = false;
+	}
+
+	void GlDevice::profileScopePush(const char* name) {
+		if (!m_profilingFrameOpen) {
+			return;
+		}
+		ProfileFrame& frame = m_profileFrames[m_profileFrameIndex % k_gpuProfilerLatency];
+		frame.scopes.push_back({
+			.name = name,
+			.depth = static_cast<uint32_t>(m_profileScopeStack.size()),
+			.beginQuery = writeProfileTimestamp(frame),
+		});
+		m_profileScopeStack.push_back(static_cast<uint32_t>(frame.scopes.size() - 1));
+	}
+
+	void GlDevice::profileScopePop() {
+		if (!m_profilingFrameOpen || m_profileScopeStack.empty()) {
+			return;
+		}
+		ProfileFrame& frame = m_profileFrames[m_profileFrameIndex % k_gpuProfilerLatency];
+		frame.scopes[m_profileScopeStack.back()].endQuery = writeProfileTimestamp(frame);
+		m_profileScopeStack.pop_back();
+	}
+
+	[[nodiscard]] const std::vector<GpuScopeTiming>& GlDevice::getProfilingResults() const {
+		return m_profilingResults;
+	}
+}
@@ -29,7 +29,16 @@ namespace gpu::gl {
 		GL_CHECK(glBindTexture(getGlTextureType(desc.type).glEnum, glTexture));
 
 		// Upload data
-		GL_CHECK(glTexImage2D(getGlTextureType(desc.type).glEnum, 0, GL_RGBA, desc.width, desc.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, textureData));
+		if (desc.type == gpu::TextureType::TextureCubeMap) {
+			ASSERT(desc.width == desc.height);
+			size_t faceSize = desc.width * desc.height * 4;
+			for (uint32_t face = 0; face < k_CUBEMAP_FACE_COUNT; face++) {
+				void* faceData = textureData != nullptr ? static_cast<uint8_t*>(textureData) + face * faceSize : nullptr;
+				GL_CHECK(glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGBA, desc.width, desc.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, faceData));
+			}
+		} else {
+			GL_CHECK(glTexImage2D(getGlTextureType(desc.type).glEnum, 0, GL_RGBA, desc.width, desc.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, textureData));
+		}
 		
 		if (desc.generateMipmaps) {
 			GL_CHECK(glGenerateMipmap(getGlTextureType(desc.type).glEnum));
@@ -98,7 +107,7 @@ namespace gpu::gl {
 	}
 
 	GlFramebuffer::~GlFramebuffer() {
-		glDeleteTextures(1, &m_textureAttachment);
+		glDeleteTextures(m_colorAttachmentCount, m_textureAttachments);
 		if (m_desc.hasDepth) {
 			glDeleteRenderbuffers(1, &m_depthStencilAttachment);
 		}
@@ -110,8 +119,9 @@ namespace gpu::gl {
 	[[nodiscard]] const GpuPtr GlFramebuffer::getNativeObject() const {
 		return m_pointer;
 	}
-	[[nodiscard]] const GpuPtr GlFramebuffer::getTextureNativeObject() const {
-		return m_textureAttachment;
+	[[nodiscard]] const GpuPtr GlFramebuffer::getTextureNativeObject(uint32_t attachment) const {
+		ASSERT(attachment < m_colorAttachmentCount);
+		return m_textureAttachments[attachment];
 	}
 
 	FramebufferHandle GlDevice::makeFramebuffer(FramebufferDesc desc) {
@@ -127,12 +137,18 @@ namespace gpu::gl {
 			desc.colorDesc.format != gpu::TextureFormat::Depth24_Stencil8 &&
 			desc.colorDesc.format != gpu::TextureFormat::Depth32_Stencil8
 		);
+		ASSERT(desc.additionalColorFormats.size() < k_MAX_FRAMEBUFFER_COLOR_ATTACHMENTS);
+		if (desc.cubeMap) {
+			ASSERT(desc.colorDesc.width == desc.colorDesc.height);
+			ASSERT(desc.colorDesc.samples == 1);
+			ASSERT(desc.additionalColorFormats.empty());
+		}
 
 		if (desc.hasDepth) {
 			// Ensure dimensions are the same as that of the colour attachment
 			ASSERT(desc.depthStencilDesc.width == desc.colorDesc.width);
 			ASSERT(desc.depthStencilDesc.height == desc.colorDesc.height);
-			// Ensure depth attachment is valid
+			// Ensure depth attachment is valid. It always takes the colour attachment's sample count
 			ASSERT(desc.depthStencilDesc.samples == 1);
 			ASSERT(
 				desc.depthStencilDesc.format == gpu::TextureFormat::Depth16 ||
@@ -148,33 +164,64 @@ namespace gpu::gl {
 		GL_CHECK(glGenFramebuffers(1, &glFramebuffer));
 		GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, glFramebuffer));
 
-		// make colour attachment
-		GLuint textureColorbuffer = 0;
-		GL_CHECK(glGenTextures(1, &textureColorbuffer));
-		GL_CHECK(glBindTexture(GL_TEXTURE_2D, textureColorbuffer));
-		GL_CHECK(glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, desc.colorDesc.samples, getGlTextureFormat(desc.colorDesc.format).glEnum, desc.colorDesc.width, desc.colorDesc.height, GL_TRUE));
-		GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
-		GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
-		GL_CHECK(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureColorbuffer, 0));
+		// make colour attachments
+		uint32_t colorAttachmentCount = 1 + static_cast<uint32_t>(desc.additionalColorFormats.size());
+		GLuint textureColorbuffers[k_MAX_FRAMEBUFFER_COLOR_ATTACHMENTS] = {};
+		GLenum drawBuffers[k_MAX_FRAMEBUFFER_COLOR_ATTACHMENTS] = {};
+		GLenum textureTarget = desc.cubeMap ? GL_TEXTURE_CUBE_MAP : desc.colorDesc.samples > 1 ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+		GL_CHECK(glGenTextures(colorAttachmentCount, textureColorbuffers));
+		for (uint32_t i = 0; i < colorAttachmentCount; i++) {
+			gpu::TextureFormat format = i == 0 ? desc.colorDesc.format : desc.additionalColorFormats[i - 1];
+			GL_CHECK(glBindTexture(textureTarget, textureColorbuffers[i]));
+			if (desc.cubeMap) {
+				for (uint32_t face = 0; face < k_CUBEMAP_FACE_COUNT; face++) {
+					GL_CHECK(glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, getGlTextureFormat(format).glEnum, desc.colorDesc.width, desc.colorDesc.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+				}
+				GL_CHECK(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+				GL_CHECK(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+				// Start out rendering into the first face, bindFramebuffer switches between them
+				GL_CHECK(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X, textureColorbuffers[i], 0));
+				drawBuffers[i] = GL_COLOR_ATTACHMENT0;
+				continue;
+			}
+			if (desc.colorDesc.samples > 1) {
+				GL_CHECK(glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, desc.colorDesc.samples, getGlTextureFormat(format).glEnum, desc.colorDesc.width, desc.colorDesc.height, GL_TRUE));
+			} else {
+				// No data is uploaded, the client format only has to be valid for a colour format
+				GL_CHECK(glTexImage2D(GL_TEXTURE_2D, 0, getGlTextureFormat(format).glEnum, desc.colorDesc.width, desc.colorDesc.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+				GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+				GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+			}
+			GL_CHECK(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, textureTarget, textureColorbuffers[i], 0));
+			drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+		}
+		GL_CHECK(glDrawBuffers(colorAttachmentCount, drawBuffers));
 
 		// make depth stencil attachment
 		GLuint rbo = 0;
 		if (desc.hasDepth) {
 			GL_CHECK(glGenRenderbuffers(1, &rbo));
 			GL_CHECK(glBindRenderbuffer(GL_RENDERBUFFER, rbo));
-			GL_CHECK(glRenderbufferStorage(GL_RENDERBUFFER, getGlTextureFormat(desc.depthStencilDesc.format).glEnum, desc.depthStencilDesc.width, desc.depthStencilDesc.height));
+			if (desc.colorDesc.samples > 1) {
+				// Every attachment of a multisampled framebuffer needs the same sample count
+				GL_CHECK(glRenderbufferStorageMultisample(GL_RENDERBUFFER, desc.colorDesc.samples, getGlTextureFormat(desc.depthStencilDesc.format).glEnum, desc.depthStencilDesc.width, desc.depthStencilDesc.height));
+			} else {
+				GL_CHECK(glRenderbufferStorage(GL_RENDERBUFFER, getGlTextureFormat(desc.depthStencilDesc.format).glEnum, desc.depthStencilDesc.width, desc.depthStencilDesc.height));
+			}
 			GL_CHECK(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo));
 		}
 
 		// reset state (unbind fbo)
-		GL_CHECK(glBindTexture(GL_TEXTURE_2D, 0));
+		GL_CHECK(glBindTexture(textureTarget, 0));
 		GL_CHECK(glBindRenderbuffer(GL_RENDERBUFFER, 0));
 		GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, 0));
 
 #if _DEBUG
 		if (!desc.debugName.empty()) {
 			GL_CHECK(glObjectLabel(GL_FRAMEBUFFER, glFramebuffer, -1, desc.debugName.c_str()));
-			GL_CHECK(glObjectLabel(GL_TEXTURE, textureColorbuffer, -1, fmt::format("{}_colorAttachment", desc.debugName).c_str()));
+			for (uint32_t i = 0; i < colorAttachmentCount; i++) {
+				GL_CHECK(glObjectLabel(GL_TEXTURE, textureColorbuffers[i], -1, fmt::format("{}_colorAttachment{}", desc.debugName, i).c_str()));
+			}
 			if (desc.hasDepth) {
 				GL_CHECK(glObjectLabel(GL_RENDERBUFFER, rbo, -1, fmt::format("{}_depthStencilAttachment", desc.debugName).c_str()));
 			}
@@ -184,7 +231,10 @@ namespace gpu::gl {
 		GlFramebuffer* framebuffer = new GlFramebuffer();
 		framebuffer->m_desc = desc;
 		framebuffer->m_pointer = glFramebuffer;
-		framebuffer->m_textureAttachment = textureColorbuffer;
+		for (uint32_t i = 0; i < colorAttachmentCount; i++) {
+			framebuffer->m_textureAttachments[i] = textureColorbuffers[i];
+		}
+		framebuffer->m_colorAttachmentCount = colorAttachmentCount;
 		framebuffer->m_depthStencilAttachment = rbo;
 
 		return FramebufferHandle::Create(framebuffer);
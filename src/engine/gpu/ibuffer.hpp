@@ -44,6 +44,7 @@ namespace gpu {
 
 	class IBuffer {
 	public:
+		virtual ~IBuffer() = default;
 		[[nodiscard]] virtual const BufferDesc& getDesc() const = 0;
 		[[nodiscard]] virtual const GpuPtr getNativeObject() const = 0;
 	};
@@ -59,6 +60,8 @@ namespace gpu {
 		size_t offset = 0;
 		// Must be the same between all elements
 		uint32_t elementStride = 0;
+		// 0 advances the attribute every vertex, N advances it every N instances
+		uint32_t instanceStepRate = 0;
 	};
 
 	class IInputLayout {
@@ -4,37 +4,124 @@
 #include <string>
 #include <memory>
 
+#include <vector>
+
 #include "engine/refcounter.hpp"
 #include "itypes.hpp"
 #include "itexture.hpp"
 #include "ibuffer.hpp"
 
+// Debug markers label groups of GPU work in graphics debuggers. Compiled into debug builds only, unless overridden
+#ifndef ENGINE_GPU_MARKERS
+#if _DEBUG
+#define ENGINE_GPU_MARKERS 1
+#else
+#define ENGINE_GPU_MARKERS 0
+#endif
+#endif
+
+// Timestamp queries around GPU_SCOPEs, for the GPU timings table. Compiled into every build, unless overridden
+#ifndef ENGINE_GPU_TIMINGS
+#define ENGINE_GPU_TIMINGS 1
+#endif
+
+#if ENGINE_GPU_MARKERS
+#include <fmt/format.h>
+#endif
+
 namespace gpu {
 
+	// Frames between recording a frame's timestamp queries and reading them back, so reading them never waits on the GPU
+	constexpr uint32_t k_gpuProfilerLatency = 3;
+
+	struct GpuScopeTiming {
+		// Name the scope was pushed with
+		const char* name = "";
+		// Number of scopes this one is nested in, the whole frame is depth 0
+		uint32_t depth = 0;
+		double milliseconds = 0.0;
+	};
+
 	struct GraphicsState {
 		CompareFunc depthState = CompareFunc::GreaterOrEqual;
 		bool depthWrite = true;
 		bool depthTest = true;
 		FaceCullMode faceCullingMode = FaceCullMode::Back;
 		WindingOrder faceWindingOrder = WindingOrder::CounterClockwise;
+		bool colorWrite = true;
+
+		bool operator==(const GraphicsState& other) const = default;
 	};
 
 	struct ShaderProgram {
 		// In the case of OpenGL, this points to a glsl file on disk
 		uint8_t* byteCode = nullptr;
 		std::string entryFunc = "main";
+		// File the source was loaded from, relative to assets/shaders. Backends which can't compile the source pick their own
+		// implementation of the stage by it
+		std::string sourceName = "";
+	};
+
+	// A linked shader program as the driver stores it. Only loads on the driver that produced it, see IDevice::getShaderBinaryTag
+	struct ShaderBinary {
+		uint32_t format = 0;
+		std::vector<uint8_t> data;
 	};
 
 	struct ShaderDesc {
 		ShaderProgram VS;
 		ShaderProgram PS;
-		GraphicsState graphicsState = {
-			.depthState = CompareFunc::GreaterOrEqual,
-			.depthWrite = true,
-			.faceCullingMode = FaceCullMode::Back,
-			.faceWindingOrder = WindingOrder::CounterClockwise,
-		};
 		std::string debugName = "";
+		// Program from an earlier run, tried before compiling VS and PS. The sources must still be set, they're compiled
+		// when the driver rejects the binary. Ignored by backends without binaries
+		const ShaderBinary* binary = nullptr;
+		// Return as soon as the compile is submitted instead of waiting for the driver. Poll IShader::pollStatus before drawing
+		// with the shader. Backends without a driver compiler are always synchronous
+		bool async = false;
+	};
+
+	struct ShaderUniformMember {
+		// As GLSL names it, struct fields are "light[0].type" and array elements "particles[0].position"
+		std::string name;
+		uint32_t offset = 0;
+	};
+
+	struct ShaderUniformBlock {
+		std::string name;
+		uint32_t index = 0;
+		uint32_t binding = 0;
+		uint32_t size = 0;
+		// Only the members the compiler kept
+		std::vector<ShaderUniformMember> members;
+	};
+
+	struct ShaderSampler {
+		std::string name;
+		// Texture unit
+		uint32_t binding = 0;
+	};
+
+	// What a linked shader reads. Filled once the shader is Ready, empty on backends that can't inspect their shaders
+	struct ShaderReflection {
+		std::vector<ShaderUniformBlock> uniformBlocks;
+		std::vector<ShaderSampler> samplers;
+	};
+
+	// A uniform block every shader shares, bound to the same index in all of them. members and size describe the C++ struct
+	// uploaded into the block, debug builds check them against each shader's reflection
+	struct UniformBlockDesc {
+		std::string name;
+		uint32_t bindIndex = 0;
+		// sizeof the C++ struct, 0 skips the size check
+		uint32_t size = 0;
+		// Offsets in the C++ struct, by GLSL member name. Members left out aren't checked
+		std::vector<ShaderUniformMember> members;
+	};
+
+	enum class ShaderStatus : uint8_t {
+		Compiling,
+		Ready,
+		Failed,
 	};
 
 	class IShader {
@@ -43,6 +130,14 @@ namespace gpu {
 		virtual ~IShader() = default;
 		[[nodiscard]] virtual const ShaderDesc& getDesc() const = 0;
 		[[nodiscard]] virtual const GpuPtr getNativeObject() const = 0;
+		// Whether the program came from ShaderDesc::binary instead of being compiled
+		[[nodiscard]] virtual bool isLoadedFromBinary() const { return false; }
+		// Whether an async compile has finished. Cheap once it returns Ready or Failed, the result is kept
+		[[nodiscard]] virtual ShaderStatus pollStatus() { return ShaderStatus::Ready; }
+		[[nodiscard]] virtual const ShaderReflection& getReflection() const {
+			static const ShaderReflection k_noReflection;
+			return k_noReflection;
+		}
 	};
 
 	typedef engine::RefCounter<IShader> ShaderHandle;
@@ -55,6 +150,8 @@ namespace gpu {
 		BlendFactor srcFactorAlpha = BlendFactor::One;
 		BlendFactor dstFactorAlpha = BlendFactor::Zero;
 		BlendOp blendOpAlpha = BlendOp::Add;
+
+		bool operator==(const BlendStateDesc& other) const = default;
 	};
 
 	class IBlendState {
@@ -66,20 +163,38 @@ namespace gpu {
 	};
 	typedef engine::RefCounter<IBlendState> BlendStateHandle;
 
-	struct DrawCallState {
-		// Buffers to draw
-		IBuffer* vertexBufer = nullptr;
-		IBuffer* indexBuffer = nullptr;
-
-		// Shader to draw and it's associated vertex layout
+	// Everything a draw needs besides its buffers and resources. Pipelines are immutable, fetch them through
+	// AssetManager::fetchPipeline so draws with the same state share one object
+	struct PipelineDesc {
 		IShader* shader = nullptr;
 
 		// Because OpenGL is horrible and vertex layout is tied to the vertex buffer (whats the point of even binding a vertex buffer then??)
-		IInputLayout* vertexLayout = nullptr;
+		IInputLayout* inputLayout = nullptr;
+
+		GraphicsState graphicsState;
 
-		// Blending properties
+		// Blending properties, nullptr draws without blending
 		IBlendState* blendState = nullptr;
 
+		bool operator==(const PipelineDesc& other) const = default;
+	};
+
+	class IPipeline {
+	public:
+		IPipeline() = default;
+		virtual ~IPipeline() = default;
+		[[nodiscard]] virtual const PipelineDesc& getDesc() const = 0;
+	};
+	typedef engine::RefCounter<IPipeline> PipelineHandle;
+
+	struct DrawCallState {
+		// Buffers to draw
+		IBuffer* vertexBufer = nullptr;
+		IBuffer* indexBuffer = nullptr;
+
+		// Shader, vertex layout and fixed function state to draw with
+		IPipeline* pipeline = nullptr;
+
 		PrimitiveType primitiveType = PrimitiveType::Triangles;
 	};
 
@@ -89,8 +204,16 @@ namespace gpu {
 		virtual ~IDevice() {};
 
 		virtual void setViewport(const Rect viewportRect) = 0;
+		// Limits every following draw and clear to scissorRect, in framebuffer pixels with the origin at the bottom left
+		virtual void setScissor(bool enabled, const Rect scissorRect = {}) = 0;
 		virtual InputLayoutHandle createInputLayout(const VertexAttributeDesc* desc, uint32_t attributeCount) = 0;
 		virtual ShaderHandle makeShader(const ShaderDesc shaderDesc) = 0;
+		// The shader, input layout and blend state must outlive the pipeline
+		virtual PipelineHandle makePipeline(const PipelineDesc pipelineDesc) = 0;
+		// Identifies the driver shader binaries are made by, they won't load anywhere else. Empty when the backend has no binaries
+		virtual std::string getShaderBinaryTag() const = 0;
+		// Reads back a compiled shader's program. Returns false if the backend has no binaries
+		virtual bool getShaderBinary(IShader* shader, ShaderBinary& outBinary) = 0;
 
 		virtual BufferHandle makeBuffer(const BufferDesc bufferDesc) = 0;
 		// size is in bytes
@@ -102,33 +225,97 @@ namespace gpu {
 		virtual void setConstantBuffer(IBuffer* buffer, uint32_t bindIndex) = 0;
 		virtual void unbindConstantBuffer(IBuffer* buffer, uint32_t bindIndex) = 0;
 		virtual void unbindBuffer(IBuffer* buffer) = 0;
+		// Overrides the binding of one shader's block. Blocks registered through registerUniformBlock don't need this
 		virtual void setBufferBinding(IShader* shader, const std::string& name, uint32_t bindIndex) = 0;
+		// Binds the block called desc.name to desc.bindIndex in every shader, including ones made before the call
+		virtual void registerUniformBlock(const UniformBlockDesc& desc) = 0;
 
-		virtual void draw(DrawCallState drawState, size_t triangleCount, size_t offset = 0, size_t instances = 1) = 0;
-		virtual void drawIndexed(DrawCallState drawState, size_t triangleCount, size_t offset = 0, size_t instances = 1) = 0;
+		// firstInstance offsets every attribute with an instanceStepRate, so several batches can share one instance buffer
+		virtual void draw(DrawCallState drawState, size_t triangleCount, size_t offset = 0, size_t instances = 1, size_t firstInstance = 0) = 0;
+		virtual void drawIndexed(DrawCallState drawState, size_t triangleCount, size_t offset = 0, size_t instances = 1, size_t firstInstance = 0) = 0;
 
 		virtual void clearColor(Color color, float depth = 0.0f) = 0;
 		virtual void present() = 0;
 
 		// Blend state
 		virtual BlendStateHandle makeBlendState(const BlendStateDesc blendStateDesc) = 0;
-		virtual void bindBlendState(IBlendState* blendState) = 0;
 
 		// Textures
 		// Assumes RGBA data in textureData
 		virtual TextureHandle makeTexture(TextureDesc desc, void* textureData) = 0;
 		virtual TextureSamplerHandle makeTextureSampler(TextureSamplerDesc desc) = 0;
 		virtual void bindTexture(ITexture* texture, ITextureSampler* sampler, uint32_t index = 0) = 0;
-		virtual void bindTexture(IFramebuffer* texture, ITextureSampler* sampler, uint32_t index = 0) = 0;
+		virtual void bindTexture(IFramebuffer* texture, ITextureSampler* sampler, uint32_t index = 0, uint32_t attachment = 0) = 0;
 
 		// Framebuffers
 		virtual FramebufferHandle makeFramebuffer(FramebufferDesc desc) = 0;
-		virtual void bindFramebuffer(IFramebuffer* texture) = 0;
+		// cubeFace selects the face rendered into when the framebuffer is a cube map
+		virtual void bindFramebuffer(IFramebuffer* texture, uint32_t cubeFace = 0) = 0;
 		virtual void blitFramebuffer(IFramebuffer* textureSrc, IFramebuffer* textureDst) = 0;
+		// Copies the depth stencil attachment between framebuffers. Both must use the same depth format
+		virtual void blitFramebufferDepth(IFramebuffer* textureSrc, IFramebuffer* textureDst) = 0;
+		// Clears a single colour attachment of the bound framebuffer, leaving depth and the other attachments untouched
+		virtual void clearColorAttachment(uint32_t attachment, Color color) = 0;
+		// Copies the depth buffer of the currently bound framebuffer into buffer as 32-bit floats. buffer must be a PixelReadTarget
+		// large enough to hold rect. The copy is asynchronous, map the buffer a few frames later to avoid stalling the pipeline
+		virtual void readDepthBuffer(IBuffer* buffer, const Rect rect) = 0;
+
+		// Forces the depth function and depth writes of every following draw, ignoring the pipeline's graphics state.
+		// Used to shade against a depth pre-pass. Pass enabled = false to return to the pipeline's own state
+		virtual void setDepthOverride(bool enabled, CompareFunc depthFunc = CompareFunc::Equal, bool depthWrite = false) = 0;
 
+		// Prefer GPU_MARKER_PUSH / GPU_SCOPE, which compile out along with the markers
 		virtual void debugMarkerPush(const std::string& title) = 0;
 		virtual void debugMarkerPop() = 0;
+
+		// GPU profiling. Every scope pushed between beginProfilingFrame and endProfilingFrame is timed with timestamp queries.
+		// Scopes pushed outside of a frame are ignored. Names are kept until the queries are read back, so they must be string literals
+		virtual void beginProfilingFrame() = 0;
+		virtual void endProfilingFrame() = 0;
+		virtual void profileScopePush(const char* name) = 0;
+		virtual void profileScopePop() = 0;
+		// Timings of the latest frame whose queries are available, in the order the scopes were pushed. The whole frame comes first
+		virtual const std::vector<GpuScopeTiming>& getProfilingResults() const = 0;
 	};
 
 	typedef engine::RefCounter<IDevice> DeviceHandle;
-}
\ No newline at end of file
+
+	// Debug marker and GPU timer around everything issued until the end of the enclosing C++ scope
+	class GpuScope {
+	public:
+		GpuScope(IDevice* pDevice, const char* name) : m_pDevice(pDevice) {
+#if ENGINE_GPU_MARKERS
+			m_pDevice->debugMarkerPush(name);
+#endif
+#if ENGINE_GPU_TIMINGS
+			m_pDevice->profileScopePush(name);
+#endif
+		}
+		~GpuScope() {
+#if ENGINE_GPU_TIMINGS
+			m_pDevice->profileScopePop();
+#endif
+#if ENGINE_GPU_MARKERS
+			m_pDevice->debugMarkerPop();
+#endif
+		}
+		GpuScope(const GpuScope&) = delete;
+		GpuScope& operator=(const GpuScope&) = delete;
+	private:
+		IDevice* m_pDevice;
+	};
+}
+
+#define GPU_SCOPE_CONCAT_INNER(a, b) a##b
+#define GPU_SCOPE_CONCAT(a, b) GPU_SCOPE_CONCAT_INNER(a, b)
+// name must be a string literal
+#define GPU_SCOPE(device, name) ::gpu::GpuScope GPU_SCOPE_CONCAT(gpuScope_, __LINE__)(device, name)
+
+#if ENGINE_GPU_MARKERS
+// Marker name is a fmt format string plus its arguments, only formatted when markers are compiled in
+#define GPU_MARKER_PUSH(device, ...) (device)->debugMarkerPush(fmt::format(__VA_ARGS__))
+#define GPU_MARKER_POP(device) (device)->debugMarkerPop()
+#else
+#define GPU_MARKER_PUSH(device, ...) ((void)0)
+#define GPU_MARKER_POP(device) ((void)0)
+#endif
\ No newline at end of file
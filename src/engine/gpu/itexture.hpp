@@ -2,6 +2,7 @@
 
 #include <inttypes.h>
 #include <string>
+#include <vector>
 
 #include "itypes.hpp"
 #include "engine/refcounter.hpp"
@@ -14,6 +15,7 @@ namespace gpu {
 
 		bool generateMipmaps = true;
 
+		// For TextureCubeMap the data holds all 6 faces back to back, in +X, -X, +Y, -Y, +Z, -Z order
 		TextureType type = TextureType::Texture2D;
 
 		std::string debugName = "";
@@ -65,6 +67,9 @@ namespace gpu {
 		gpu::TextureFormat format;
 	};
 
+	// Colour attachment 0 plus every additional colour attachment
+	constexpr uint32_t k_MAX_FRAMEBUFFER_COLOR_ATTACHMENTS = 4;
+
 	struct FramebufferDesc {
 		FramebufferAttachmentDesc colorDesc = {
 			.width = 1,
@@ -80,20 +85,31 @@ namespace gpu {
 		};
 		// must be set to true for depth stencil attachment to be valid
 		bool hasDepth = true;
+		// Formats of extra colour attachments for multiple render targets, bound after colorDesc from attachment 1 onwards.
+		// They share colorDesc's size and sample count
+		std::vector<gpu::TextureFormat> additionalColorFormats;
+		// Allocates colour attachment 0 as a cube map with square colorDesc sized faces. The face rendered into is picked
+		// when binding the framebuffer. Cube map framebuffers have a single sample and no extra colour attachments
+		bool cubeMap = false;
 
 		std::string debugName = "";
 	};
 
+	// Cube map faces, in the order the graphics API stores them
+	constexpr uint32_t k_CUBEMAP_FACE_COUNT = 6;
+
 	class IFramebuffer {
 	public:
 		virtual ~IFramebuffer() = default;
 		[[nodiscard]] virtual const FramebufferDesc& getDesc() const = 0;
 		[[nodiscard]] virtual const GpuPtr getNativeObject() const = 0;
-		[[nodiscard]] virtual const GpuPtr getTextureNativeObject() const = 0;
+		[[nodiscard]] virtual const GpuPtr getTextureNativeObject(uint32_t attachment = 0) const = 0;
 	};
 
 	typedef engine::RefCounter<IFramebuffer> FramebufferHandle;
 	
 	// default framebuffer constant, maps to backbuffer
 	constexpr IFramebuffer* k_defaultFramebuffer = static_cast<IFramebuffer*>(nullptr);
+	// MSAA samples the window asks for, so the backbuffer's depth can't be read back directly either
+	constexpr uint32_t k_BACKBUFFER_SAMPLES = 4;
 }
\ No newline at end of file
@@ -35,6 +35,13 @@ namespace gpu {
 		RG8_TYPELESS,
 		RGB8_TYPELESS,
 		RGBA8_TYPELESS,
+		// Normalised to [0, 1] when read by the shader
+		RGBA16_UNORM,
+		// Half floats, for texture coordinates
+		RG16_FLOAT,
+		// Normalised to [-1, 1] when read by the shader
+		RG16_SNORM,
+		RGBA16_SNORM,
 		Count,
 	};
 
@@ -142,6 +149,10 @@ namespace gpu {
 		SRGB8,
 		SRGB8_A8,
 
+		// Floating point render targets
+		RGBA16F,
+		R16F,
+
 		Depth16,
 		Depth24,
 		Depth32,
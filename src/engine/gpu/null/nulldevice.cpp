@@ -0,0 +1,588 @@
+#include "nulldevice.hpp"
+#include "engine/core.hpp"
+#include "engine/log.hpp"
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <cstring>
+
+// Logs and counts a misuse of the device API. On the GL backend these would be asserts, GL errors or undefined behaviour
+#define NULL_VALIDATE(condition, ...) \
+	do { \
+		if (!(condition)) { \
+			validationError(fmt::format(__VA_ARGS__)); \
+		} \
+	} while (0)
+
+namespace gpu::null {
+
+	//
+	// Objects
+	//
+
+	NullBuffer::NullBuffer(gpu::BufferDesc bufferDesc, GpuPtr pointer, std::shared_ptr<NullLiveObjects> liveObjects)
+		: m_bufferDesc(bufferDesc), m_pointer(pointer), m_liveObjects(std::move(liveObjects)) {
+		m_liveObjects->objects.insert(static_cast<const IBuffer*>(this));
+		m_liveObjects->buffers++;
+	}
+
+	NullBuffer::~NullBuffer() {
+		m_liveObjects->objects.erase(static_cast<const IBuffer*>(this));
+		m_liveObjects->buffers--;
+	}
+
+	NullInputLayout::NullInputLayout(GpuPtr pointer, std::shared_ptr<NullLiveObjects> liveObjects)
+		: m_pointer(pointer), m_liveObjects(std::move(liveObjects)) {
+		m_liveObjects->objects.insert(static_cast<const IInputLayout*>(this));
+		m_liveObjects->inputLayouts++;
+	}
+
+	NullInputLayout::~NullInputLayout() {
+		m_liveObjects->objects.erase(static_cast<const IInputLayout*>(this));
+		m_liveObjects->inputLayouts--;
+	}
+
+	NullTexture::NullTexture(TextureDesc desc, GpuPtr pointer, std::shared_ptr<NullLiveObjects> liveObjects)
+		: m_desc(desc), m_pointer(pointer), m_liveObjects(std::move(liveObjects)) {
+		m_liveObjects->objects.insert(static_cast<const ITexture*>(this));
+		m_liveObjects->textures++;
+	}
+
+	NullTexture::~NullTexture() {
+		m_liveObjects->objects.erase(static_cast<const ITexture*>(this));
+		m_liveObjects->textures--;
+	}
+
+	NullTextureSampler::NullTextureSampler(TextureSamplerDesc desc, GpuPtr pointer, std::shared_ptr<NullLiveObjects> liveObjects)
+		: m_desc(desc), m_pointer(pointer), m_liveObjects(std::move(liveObjects)) {
+		m_liveObjects->objects.insert(static_cast<const ITextureSampler*>(this));
+		m_liveObjects->textureSamplers++;
+	}
+
+	NullTextureSampler::~NullTextureSampler() {
+		m_liveObjects->objects.erase(static_cast<const ITextureSampler*>(this));
+		m_liveObjects->textureSamplers--;
+	}
+
+	NullFramebuffer::NullFramebuffer(FramebufferDesc desc, GpuPtr pointer, std::shared_ptr<NullLiveObjects> liveObjects)
+		: m_desc(desc), m_pointer(pointer), m_liveObjects(std::move(liveObjects)) {
+		m_liveObjects->objects.insert(static_cast<const IFramebuffer*>(this));
+		m_liveObjects->framebuffers++;
+	}
+
+	NullFramebuffer::~NullFramebuffer() {
+		m_liveObjects->objects.erase(static_cast<const IFramebuffer*>(this));
+		m_liveObjects->framebuffers--;
+	}
+
+	NullShader::NullShader(ShaderDesc shaderDesc, GpuPtr pointer, std::shared_ptr<NullLiveObjects> liveObjects)
+		: m_shaderDesc(shaderDesc), m_pointer(pointer), m_liveObjects(std::move(liveObjects)) {
+		m_liveObjects->objects.insert(static_cast<const IShader*>(this));
+		m_liveObjects->shaders++;
+	}
+
+	NullShader::~NullShader() {
+		m_liveObjects->objects.erase(static_cast<const IShader*>(this));
+		m_liveObjects->shaders--;
+	}
+
+	NullBlendState::NullBlendState(BlendStateDesc blendStateDesc, GpuPtr pointer, std::shared_ptr<NullLiveObjects> liveObjects)
+		: m_blendStateDesc(blendStateDesc), m_pointer(pointer), m_liveObjects(std::move(liveObjects)) {
+		m_liveObjects->objects.insert(static_cast<const IBlendState*>(this));
+		m_liveObjects->blendStates++;
+	}
+
+	NullBlendState::~NullBlendState() {
+		m_liveObjects->objects.erase(static_cast<const IBlendState*>(this));
+		m_liveObjects->blendStates--;
+	}
+
+	NullPipeline::NullPipeline(PipelineDesc pipelineDesc, std::shared_ptr<NullLiveObjects> liveObjects)
+		: m_pipelineDesc(pipelineDesc), m_liveObjects(std::move(liveObjects)) {
+		m_liveObjects->objects.insert(static_cast<const IPipeline*>(this));
+		m_liveObjects->pipelines++;
+	}
+
+	NullPipeline::~NullPipeline() {
+		m_liveObjects->objects.erase(static_cast<const IPipeline*>(this));
+		m_liveObjects->pipelines--;
+	}
+
+	static size_t getIndexSize(gpu::GpuFormat format) {
+		switch (format) {
+		case gpu::GpuFormat::Uint8_TYPELESS:
+			return 1;
+		case gpu::GpuFormat::Uint16_TYPELESS:
+			return 2;
+		case gpu::GpuFormat::Uint32_TYPELESS:
+			return 4;
+		default:
+			return 0;
+		}
+	}
+
+	//
+	// Device
+	//
+
+	NullDevice::NullDevice() : m_liveObjects(std::make_shared<NullLiveObjects>()) {
+		LOG_INFO("Created null device, nothing will be rendered");
+	}
+
+	NullDevice::~NullDevice() {
+		LOG_INFO("Null device destroyed after {} frames with {} validation errors", m_presentedFrames, m_validationErrors);
+	}
+
+	void NullDevice::validationError(const std::string& message) {
+		m_validationErrors++;
+		LOG_ERROR("NullDevice: {}", message);
+	}
+
+	bool NullDevice::validateObject(const void* object, const char* usage) {
+		if (object == nullptr) {
+			validationError(fmt::format("{} is null", usage));
+			return false;
+		}
+		if (!m_liveObjects->objects.contains(object)) {
+			validationError(fmt::format("{} was destroyed or wasn't made by this device", usage));
+			return false;
+		}
+		return true;
+	}
+
+	void NullDevice::setViewport(const Rect viewportRect) {
+		NULL_VALIDATE(viewportRect.right >= viewportRect.left && viewportRect.bottom >= viewportRect.top, "Inverted viewport");
+	}
+
+	void NullDevice::setScissor(bool enabled, const Rect scissorRect) {
+		if (enabled) {
+			NULL_VALIDATE(scissorRect.right >= scissorRect.left && scissorRect.bottom >= scissorRect.top, "Inverted scissor rect");
+		}
+	}
+
+	InputLayoutHandle NullDevice::createInputLayout(const VertexAttributeDesc* desc, uint32_t attributeCount) {
+		NULL_VALIDATE(desc != nullptr && attributeCount > 0, "Input layout without attributes");
+
+		NullInputLayout* inputLayout = new NullInputLayout(m_nextObjectId++, m_liveObjects);
+		if (desc != nullptr) {
+			inputLayout->attributes.assign(desc, desc + attributeCount);
+			for (uint32_t i = 0; i < attributeCount; i++) {
+				NULL_VALIDATE(desc[i].format != GpuFormat::Unknown && desc[i].format != GpuFormat::Count, "Vertex attribute \"{}\" has no format", desc[i].name);
+				NULL_VALIDATE(desc[i].elementStride == desc[0].elementStride, "Vertex attribute \"{}\" has a different stride to the rest of the layout", desc[i].name);
+			}
+		}
+		return InputLayoutHandle::Create(inputLayout);
+	}
+
+	ShaderHandle NullDevice::makeShader(const ShaderDesc shaderDesc) {
+		NULL_VALIDATE(shaderDesc.VS.byteCode != nullptr && shaderDesc.VS.byteCode[0] != 0, "Shader \"{}\" has no vertex stage", shaderDesc.debugName);
+		NULL_VALIDATE(shaderDesc.PS.byteCode != nullptr && shaderDesc.PS.byteCode[0] != 0, "Shader \"{}\" has no pixel stage", shaderDesc.debugName);
+
+		// The source is only valid for the duration of the call
+		ShaderDesc desc = shaderDesc;
+		desc.VS.byteCode = nullptr;
+		desc.PS.byteCode = nullptr;
+		desc.binary = nullptr;
+		return ShaderHandle::Create(new NullShader(desc, m_nextObjectId++, m_liveObjects));
+	}
+
+	std::string NullDevice::getShaderBinaryTag() const {
+		return "";
+	}
+
+	bool NullDevice::getShaderBinary(IShader* shader, ShaderBinary& outBinary) {
+		validateObject(shader, "Shader");
+		return false;
+	}
+
+	PipelineHandle NullDevice::makePipeline(const PipelineDesc pipelineDesc) {
+		validateObject(pipelineDesc.shader, "Pipeline shader");
+		validateObject(pipelineDesc.inputLayout, "Pipeline input layout");
+		if (pipelineDesc.blendState != nullptr) {
+			validateObject(pipelineDesc.blendState, "Pipeline blend state");
+		}
+		NULL_VALIDATE(pipelineDesc.graphicsState.depthState != CompareFunc::Count, "Pipeline without a depth compare function");
+		return PipelineHandle::Create(new NullPipeline(pipelineDesc, m_liveObjects));
+	}
+
+	bool NullDevice::validatePipeline(const IPipeline* pipeline) {
+		if (!validateObject(pipeline, "Pipeline")) {
+			return false;
+		}
+		// The pipeline doesn't own what it references, so they may have been destroyed before it
+		const PipelineDesc& desc = pipeline->getDesc();
+		bool valid = validateObject(desc.shader, "Shader");
+		valid &= validateObject(desc.inputLayout, "Vertex layout");
+		if (desc.blendState != nullptr) {
+			valid &= validateObject(desc.blendState, "Blend state");
+		}
+		return valid;
+	}
+
+	void NullDevice::bindPipeline(const IPipeline* pipeline) {
+		if (pipeline == m_boundPipeline) {
+			return;
+		}
+		m_boundPipeline = pipeline;
+		m_frameStats.pipelineChanges++;
+
+		const PipelineDesc& desc = pipeline->getDesc();
+		if (desc.shader != m_boundShader) {
+			m_boundShader = desc.shader;
+			m_frameStats.shaderChanges++;
+		}
+		if (desc.blendState != m_boundBlendState) {
+			m_boundBlendState = desc.blendState;
+			m_frameStats.blendStateChanges++;
+		}
+	}
+
+	//
+	// Buffers
+	//
+
+	BufferHandle NullDevice::makeBuffer(const BufferDesc bufferDesc) {
+		NULL_VALIDATE(bufferDesc.type != BufferType::Count, "Buffer \"{}\" has no type", bufferDesc.debugName);
+		return BufferHandle::Create(new NullBuffer(bufferDesc, m_nextObjectId++, m_liveObjects));
+	}
+
+	void NullDevice::writeBuffer(IBuffer* handle, size_t size, const void* data) {
+		if (!validateObject(handle, "Written buffer")) {
+			return;
+		}
+		NullBuffer* buffer = static_cast<NullBuffer*>(handle);
+		NULL_VALIDATE(size > 0, "Zero sized write to buffer \"{}\"", buffer->getDesc().debugName);
+		// Constant buffers and readback targets may be allocated without initial data
+		if (buffer->getDesc().type != BufferType::ConstantBuffer && buffer->getDesc().type != BufferType::PixelReadTarget) {
+			NULL_VALIDATE(data != nullptr, "Buffer \"{}\" allocated without data", buffer->getDesc().debugName);
+		}
+		NULL_VALIDATE(!buffer->m_mapped, "Buffer \"{}\" written while mapped", buffer->getDesc().debugName);
+
+		// Writing a buffer binds it on GL
+		m_boundBuffers[(uint32_t)buffer->getDesc().type] = handle;
+
+		buffer->m_data.resize(size);
+		if (data != nullptr) {
+			memcpy(buffer->m_data.data(), data, size);
+		}
+		m_frameStats.bufferWrites++;
+		m_frameStats.bytesWritten += size;
+	}
+
+	void NullDevice::mapBuffer(IBuffer* handle, uint32_t offset, size_t length, MapAccessFlags accessFlags, void** mappedDataPtr) {
+		ASSERT(mappedDataPtr != nullptr);
+		*mappedDataPtr = nullptr;
+		if (!validateObject(handle, "Mapped buffer")) {
+			return;
+		}
+		NullBuffer* buffer = static_cast<NullBuffer*>(handle);
+		// GL maps whatever is bound to the buffer's target
+		NULL_VALIDATE(m_boundBuffers[(uint32_t)buffer->getDesc().type] == handle, "Buffer \"{}\" mapped without being bound", buffer->getDesc().debugName);
+		if (buffer->m_mapped) {
+			validationError(fmt::format("Buffer \"{}\" mapped twice", buffer->getDesc().debugName));
+			return;
+		}
+		if (offset + length > buffer->m_data.size()) {
+			validationError(fmt::format("Mapped range {} + {} is past the end of buffer \"{}\" ({} bytes)", offset, length, buffer->getDesc().debugName, buffer->m_data.size()));
+			return;
+		}
+
+		buffer->m_mapped = true;
+		m_mappedBufferCount++;
+		m_frameStats.bufferMaps++;
+		*mappedDataPtr = buffer->m_data.data() + offset;
+	}
+
+	void NullDevice::unmapBuffer(IBuffer* handle) {
+		if (!validateObject(handle, "Unmapped buffer")) {
+			return;
+		}
+		NullBuffer* buffer = static_cast<NullBuffer*>(handle);
+		if (!buffer->m_mapped) {
+			validationError(fmt::format("Buffer \"{}\" unmapped without being mapped", buffer->getDesc().debugName));
+			return;
+		}
+		buffer->m_mapped = false;
+		m_mappedBufferCount--;
+	}
+
+	void NullDevice::bindBuffer(IBuffer* handle) {
+		if (validateObject(handle, "Bound buffer")) {
+			m_boundBuffers[(uint32_t)handle->getDesc().type] = handle;
+		}
+	}
+
+	void NullDevice::unbindBuffer(IBuffer* handle) {
+		if (validateObject(handle, "Unbound buffer")) {
+			m_boundBuffers[(uint32_t)handle->getDesc().type] = nullptr;
+		}
+	}
+
+	void NullDevice::setConstantBuffer(IBuffer* handle, uint32_t bindIndex) {
+		if (validateObject(handle, "Constant buffer")) {
+			NULL_VALIDATE(handle->getDesc().type == BufferType::ConstantBuffer, "Buffer \"{}\" bound as a constant buffer", handle->getDesc().debugName);
+			// glBindBufferBase also sets the generic binding, which is what a following map uses
+			m_boundBuffers[(uint32_t)BufferType::ConstantBuffer] = handle;
+		}
+		NULL_VALIDATE(bindIndex < k_nullMaxUniformBufferBindings, "Constant buffer bind index {} is out of range", bindIndex);
+	}
+
+	void NullDevice::unbindConstantBuffer(IBuffer* handle, uint32_t bindIndex) {
+		if (validateObject(handle, "Constant buffer")) {
+			NULL_VALIDATE(handle->getDesc().type == BufferType::ConstantBuffer, "Buffer \"{}\" unbound as a constant buffer", handle->getDesc().debugName);
+			// Binding 0 to the index clears the generic binding as well
+			m_boundBuffers[(uint32_t)BufferType::ConstantBuffer] = nullptr;
+		}
+		NULL_VALIDATE(bindIndex < k_nullMaxUniformBufferBindings, "Constant buffer bind index {} is out of range", bindIndex);
+	}
+
+	void NullDevice::setBufferBinding(IShader* shader, const std::string& name, uint32_t bindIndex) {
+		validateObject(shader, "Shader");
+		NULL_VALIDATE(!name.empty(), "Buffer binding without a block name");
+		NULL_VALIDATE(bindIndex < k_nullMaxUniformBufferBindings, "Binding of \"{}\" to index {} is out of range", name, bindIndex);
+	}
+
+	void NullDevice::registerUniformBlock(const UniformBlockDesc& desc) {
+		NULL_VALIDATE(!desc.name.empty(), "Uniform block registered without a name");
+		NULL_VALIDATE(desc.bindIndex < k_nullMaxUniformBufferBindings, "Uniform block \"{}\" registered to index {}, out of range", desc.name, desc.bindIndex);
+		for (const ShaderUniformMember& member : desc.members) {
+			NULL_VALIDATE(desc.size == 0 || member.offset < desc.size, "Uniform block member {}.{} at offset {} is past the end of its {} byte struct",
+				desc.name, member.name, member.offset, desc.size);
+		}
+	}
+
+	//
+	// Draws
+	//
+
+	void NullDevice::draw(DrawCallState drawCallState, size_t triangleCount, size_t offset, size_t instances, size_t firstInstance) {
+		NULL_VALIDATE(drawCallState.indexBuffer == nullptr, "Non-indexed draw with an index buffer");
+		NULL_VALIDATE(triangleCount > 0, "Draw with no triangles");
+		NULL_VALIDATE(drawCallState.primitiveType != PrimitiveType::Count, "Draw with no primitive type");
+		bool valid = validateObject(drawCallState.vertexBufer, "Vertex buffer");
+		valid &= validatePipeline(drawCallState.pipeline);
+		NULL_VALIDATE(m_mappedBufferCount == 0, "Draw while {} buffers are mapped", m_mappedBufferCount);
+		if (!valid || instances == 0) {
+			return;
+		}
+
+		bindPipeline(drawCallState.pipeline);
+		m_boundBuffers[(uint32_t)drawCallState.vertexBufer->getDesc().type] = drawCallState.vertexBufer;
+		m_boundBuffers[(uint32_t)BufferType::IndexBuffer] = nullptr;
+
+		m_frameStats.drawCalls++;
+		m_frameStats.triangles += triangleCount * instances;
+		m_frameStats.instances += instances;
+	}
+
+	void NullDevice::drawIndexed(DrawCallState drawCallState, size_t triangleCount, size_t offset, size_t instances, size_t firstInstance) {
+		NULL_VALIDATE(triangleCount > 0, "Indexed draw with no triangles");
+		NULL_VALIDATE(drawCallState.primitiveType != PrimitiveType::Count, "Indexed draw with no primitive type");
+		bool valid = validateObject(drawCallState.vertexBufer, "Vertex buffer");
+		valid &= validateObject(drawCallState.indexBuffer, "Index buffer");
+		valid &= validatePipeline(drawCallState.pipeline);
+		NULL_VALIDATE(m_mappedBufferCount == 0, "Indexed draw while {} buffers are mapped", m_mappedBufferCount);
+		if (!valid || instances == 0) {
+			return;
+		}
+
+		// offset is in bytes into the index buffer
+		const NullBuffer* indexBuffer = static_cast<const NullBuffer*>(drawCallState.indexBuffer);
+		size_t indexSize = getIndexSize(indexBuffer->getDesc().format);
+		NULL_VALIDATE(indexSize != 0, "Index buffer \"{}\" doesn't have an index format", indexBuffer->getDesc().debugName);
+		NULL_VALIDATE(offset + triangleCount * 3 * indexSize <= indexBuffer->m_data.size(),
+			"Indexed draw reads past the end of index buffer \"{}\"", indexBuffer->getDesc().debugName);
+
+		bindPipeline(drawCallState.pipeline);
+		m_boundBuffers[(uint32_t)drawCallState.vertexBufer->getDesc().type] = drawCallState.vertexBufer;
+		m_boundBuffers[(uint32_t)drawCallState.indexBuffer->getDesc().type] = drawCallState.indexBuffer;
+
+		m_frameStats.drawCalls++;
+		m_frameStats.indexedDrawCalls++;
+		m_frameStats.triangles += triangleCount * instances;
+		m_frameStats.instances += instances;
+	}
+
+	void NullDevice::clearColor(Color color, float depth) {
+		m_frameStats.clears++;
+	}
+
+	void NullDevice::present() {
+		NULL_VALIDATE(m_debugMarkerDepth == 0, "Frame presented with {} debug markers still pushed", m_debugMarkerDepth);
+		NULL_VALIDATE(m_mappedBufferCount == 0, "Frame presented with {} buffers still mapped", m_mappedBufferCount);
+		NULL_VALIDATE(!m_profilingFrameOpen, "Frame presented inside a profiling frame");
+
+		m_lastFrameStats = m_frameStats;
+		m_frameStats = {};
+		m_presentedFrames++;
+	}
+
+	//
+	// Blend state
+	//
+
+	BlendStateHandle NullDevice::makeBlendState(const BlendStateDesc blendStateDesc) {
+		return BlendStateHandle::Create(new NullBlendState(blendStateDesc, m_nextObjectId++, m_liveObjects));
+	}
+
+	//
+	// Textures
+	//
+
+	TextureHandle NullDevice::makeTexture(TextureDesc desc, void* textureData) {
+		NULL_VALIDATE(desc.width > 0 && desc.height > 0, "Texture \"{}\" is empty", desc.debugName);
+		if (desc.type == TextureType::TextureCubeMap) {
+			NULL_VALIDATE(desc.width == desc.height, "Cube map \"{}\" has non-square faces", desc.debugName);
+		}
+		return TextureHandle::Create(new NullTexture(desc, m_nextObjectId++, m_liveObjects));
+	}
+
+	TextureSamplerHandle NullDevice::makeTextureSampler(TextureSamplerDesc desc) {
+		return TextureSamplerHandle::Create(new NullTextureSampler(desc, m_nextObjectId++, m_liveObjects));
+	}
+
+	void NullDevice::bindTexture(ITexture* texture, ITextureSampler* sampler, uint32_t index) {
+		validateObject(texture, "Texture");
+		validateObject(sampler, "Sampler");
+		NULL_VALIDATE(index < k_nullMaxCombinedTextureImageUnits, "Texture unit {} is out of range", index);
+		m_frameStats.textureBinds++;
+	}
+
+	void NullDevice::bindTexture(IFramebuffer* texture, ITextureSampler* sampler, uint32_t index, uint32_t attachment) {
+		if (validateObject(texture, "Framebuffer texture")) {
+			NULL_VALIDATE(attachment <= texture->getDesc().additionalColorFormats.size(), "Framebuffer \"{}\" has no attachment {}", texture->getDesc().debugName, attachment);
+			NULL_VALIDATE(texture != m_boundFramebuffer, "Framebuffer \"{}\" sampled while it is being rendered into", texture->getDesc().debugName);
+		}
+		validateObject(sampler, "Sampler");
+		NULL_VALIDATE(index < k_nullMaxCombinedTextureImageUnits, "Texture unit {} is out of range", index);
+		m_frameStats.textureBinds++;
+	}
+
+	//
+	// Framebuffers
+	//
+
+	FramebufferHandle NullDevice::makeFramebuffer(FramebufferDesc desc) {
+		NULL_VALIDATE(desc.colorDesc.width > 0 && desc.colorDesc.height > 0, "Framebuffer \"{}\" is empty", desc.debugName);
+		NULL_VALIDATE(1 + desc.additionalColorFormats.size() <= k_MAX_FRAMEBUFFER_COLOR_ATTACHMENTS, "Framebuffer \"{}\" has too many colour attachments", desc.debugName);
+		if (desc.cubeMap) {
+			NULL_VALIDATE(desc.colorDesc.width == desc.colorDesc.height, "Cube map framebuffer \"{}\" has non-square faces", desc.debugName);
+			NULL_VALIDATE(desc.colorDesc.samples <= 1 && desc.additionalColorFormats.empty(), "Cube map framebuffer \"{}\" is multisampled or has extra attachments", desc.debugName);
+		}
+
+		// Reserve an id for every attachment as well, see NullFramebuffer::getTextureNativeObject
+		GpuPtr pointer = m_nextObjectId;
+		m_nextObjectId += 1 + k_MAX_FRAMEBUFFER_COLOR_ATTACHMENTS;
+		return FramebufferHandle::Create(new NullFramebuffer(desc, pointer, m_liveObjects));
+	}
+
+	void NullDevice::bindFramebuffer(IFramebuffer* texture, uint32_t cubeFace) {
+		if (texture != k_defaultFramebuffer && validateObject(texture, "Framebuffer")) {
+			NULL_VALIDATE(cubeFace == 0 || (texture->getDesc().cubeMap && cubeFace < k_CUBEMAP_FACE_COUNT),
+				"Face {} of framebuffer \"{}\" bound", cubeFace, texture->getDesc().debugName);
+		}
+		m_boundFramebuffer = texture;
+		m_frameStats.framebufferBinds++;
+	}
+
+	void NullDevice::blitFramebuffer(IFramebuffer* textureSrc, IFramebuffer* textureDst) {
+		if (textureSrc != k_defaultFramebuffer) {
+			validateObject(textureSrc, "Blit source");
+		}
+		if (textureDst != k_defaultFramebuffer) {
+			validateObject(textureDst, "Blit destination");
+		}
+	}
+
+	void NullDevice::blitFramebufferDepth(IFramebuffer* textureSrc, IFramebuffer* textureDst) {
+		if (textureSrc != k_defaultFramebuffer && validateObject(textureSrc, "Depth blit source")) {
+			NULL_VALIDATE(textureSrc->getDesc().hasDepth, "Depth blit from framebuffer \"{}\" without depth", textureSrc->getDesc().debugName);
+		}
+		if (textureDst != k_defaultFramebuffer && validateObject(textureDst, "Depth blit destination")) {
+			NULL_VALIDATE(textureDst->getDesc().hasDepth, "Depth blit into framebuffer \"{}\" without depth", textureDst->getDesc().debugName);
+		}
+	}
+
+	void NullDevice::clearColorAttachment(uint32_t attachment, Color color) {
+		if (m_boundFramebuffer != k_defaultFramebuffer) {
+			NULL_VALIDATE(attachment <= m_boundFramebuffer->getDesc().additionalColorFormats.size(), "Cleared missing attachment {}", attachment);
+		} else {
+			NULL_VALIDATE(attachment == 0, "Cleared attachment {} of the backbuffer", attachment);
+		}
+		m_frameStats.clears++;
+	}
+
+	void NullDevice::readDepthBuffer(IBuffer* handle, const Rect rect) {
+		if (!validateObject(handle, "Depth readback buffer")) {
+			return;
+		}
+		NullBuffer* buffer = static_cast<NullBuffer*>(handle);
+		NULL_VALIDATE(buffer->getDesc().type == BufferType::PixelReadTarget, "Depth read into buffer \"{}\", which isn't a PixelReadTarget", buffer->getDesc().debugName);
+		// glReadPixels can't read multisampled depth, it has to be resolved into a single sample framebuffer first
+		if (m_boundFramebuffer != k_defaultFramebuffer) {
+			NULL_VALIDATE(m_boundFramebuffer->getDesc().colorDesc.samples <= 1, "Depth read from multisampled framebuffer \"{}\"", m_boundFramebuffer->getDesc().debugName);
+		} else {
+			NULL_VALIDATE(k_BACKBUFFER_SAMPLES <= 1, "Depth read from the multisampled backbuffer");
+		}
+		size_t requiredSize = (size_t)(rect.right - rect.left) * (rect.bottom - rect.top) * sizeof(float);
+		if (requiredSize > buffer->m_data.size()) {
+			validationError(fmt::format("Depth read of {} bytes overflows buffer \"{}\" ({} bytes)", requiredSize, buffer->getDesc().debugName, buffer->m_data.size()));
+			return;
+		}
+		// Nothing was rendered, so everything is at the far plane
+		std::fill(buffer->m_data.begin(), buffer->m_data.begin() + requiredSize, 0);
+	}
+
+	void NullDevice::setDepthOverride(bool enabled, CompareFunc depthFunc, bool depthWrite) {
+		NULL_VALIDATE(depthFunc != CompareFunc::Count, "Depth override without a compare function");
+	}
+
+	//
+	// Debugging
+	//
+
+	void NullDevice::debugMarkerPush(const std::string& title) {
+		m_debugMarkerDepth++;
+	}
+
+	void NullDevice::debugMarkerPop() {
+		if (m_debugMarkerDepth == 0) {
+			validationError("Debug marker popped without a push");
+			return;
+		}
+		m_debugMarkerDepth--;
+	}
+
+	void NullDevice::beginProfilingFrame() {
+		NULL_VALIDATE(!m_profilingFrameOpen, "Profiling frame begun twice");
+		m_profilingFrameOpen = true;
+		m_profileScopeDepth = 0;
+	}
+
+	void NullDevice::endProfilingFrame() {
+		NULL_VALIDATE(m_profilingFrameOpen, "Profiling frame ended without beginning");
+		NULL_VALIDATE(m_profileScopeDepth == 0, "Profiling frame ended with {} scopes still pushed", m_profileScopeDepth);
+		m_profilingFrameOpen = false;
+	}
+
+	void NullDevice::profileScopePush(const char* name) {
+		if (m_profilingFrameOpen) {
+			m_profileScopeDepth++;
+		}
+	}
+
+	void NullDevice::profileScopePop() {
+		if (!m_profilingFrameOpen) {
+			return;
+		}
+		if (m_profileScopeDepth == 0) {
+			validationError("Profiling scope popped without a push");
+			return;
+		}
+		m_profileScopeDepth--;
+	}
+
+	const std::vector<GpuScopeTiming>& NullDevice::getProfilingResults() const {
+		return m_profilingResults;
+	}
+}
@@ -0,0 +1,262 @@
+#pragma once
+
+#include "engine/gpu/idevice.hpp"
+
+#include <memory>
+#include <unordered_set>
+
+namespace gpu::null {
+
+	// The null device enforces the limits every GL 3.3 driver guarantees, so code that only works on roomier hardware is caught
+	constexpr uint32_t k_nullMaxUniformBufferBindings = 36;
+	constexpr uint32_t k_nullMaxCombinedTextureImageUnits = 48;
+
+	// Every object the device created which hasn't been destroyed yet. Shared with the objects so they can remove themselves,
+	// objects may outlive the device
+	struct NullLiveObjects {
+		std::unordered_set<const void*> objects;
+		int64_t buffers = 0;
+		int64_t inputLayouts = 0;
+		int64_t shaders = 0;
+		int64_t blendStates = 0;
+		int64_t pipelines = 0;
+		int64_t textures = 0;
+		int64_t textureSamplers = 0;
+		int64_t framebuffers = 0;
+	};
+
+	// Work recorded between two presents
+	struct NullFrameStats {
+		uint32_t drawCalls = 0;
+		uint32_t indexedDrawCalls = 0;
+		uint64_t triangles = 0;
+		uint64_t instances = 0;
+		uint32_t pipelineChanges = 0;
+		uint32_t shaderChanges = 0;
+		uint32_t blendStateChanges = 0;
+		uint32_t textureBinds = 0;
+		uint32_t framebufferBinds = 0;
+		uint32_t clears = 0;
+		uint32_t bufferWrites = 0;
+		uint64_t bytesWritten = 0;
+		uint32_t bufferMaps = 0;
+	};
+
+	class NullDevice;
+
+	//
+	// Buffers
+	//
+	class NullBuffer : public gpu::IBuffer {
+	public:
+		NullBuffer(gpu::BufferDesc bufferDesc, GpuPtr pointer, std::shared_ptr<NullLiveObjects> liveObjects);
+		~NullBuffer() override;
+
+		[[nodiscard]] inline const BufferDesc& getDesc() const override { return m_bufferDesc; }
+		[[nodiscard]] inline const GpuPtr getNativeObject() const override { return m_pointer; }
+	private:
+		gpu::BufferDesc m_bufferDesc;
+		GpuPtr m_pointer = 0;
+		std::shared_ptr<NullLiveObjects> m_liveObjects;
+		// Backing store, so mapping a buffer hands out real memory
+		std::vector<uint8_t> m_data;
+		bool m_mapped = false;
+
+		friend class gpu::null::NullDevice;
+	};
+
+	class NullInputLayout : public gpu::IInputLayout {
+	public:
+		NullInputLayout(GpuPtr pointer, std::shared_ptr<NullLiveObjects> liveObjects);
+		~NullInputLayout() override;
+
+		[[nodiscard]] inline const GpuPtr getNativeObject() const override { return m_pointer; }
+	private:
+		GpuPtr m_pointer = 0;
+		std::shared_ptr<NullLiveObjects> m_liveObjects;
+	};
+
+	//
+	// Textures
+	//
+	class NullTexture : public gpu::ITexture {
+	public:
+		NullTexture(TextureDesc desc, GpuPtr pointer, std::shared_ptr<NullLiveObjects> liveObjects);
+		~NullTexture() override;
+		[[nodiscard]] inline const TextureDesc getDesc() const override { return m_desc; }
+		[[nodiscard]] inline const GpuPtr getNativeObject() const override { return m_pointer; }
+	private:
+		TextureDesc m_desc;
+		GpuPtr m_pointer = 0;
+		std::shared_ptr<NullLiveObjects> m_liveObjects;
+	};
+
+	class NullTextureSampler : public gpu::ITextureSampler {
+	public:
+		NullTextureSampler(TextureSamplerDesc desc, GpuPtr pointer, std::shared_ptr<NullLiveObjects> liveObjects);
+		~NullTextureSampler() override;
+		[[nodiscard]] inline const TextureSamplerDesc& getDesc() const override { return m_desc; }
+		[[nodiscard]] inline const GpuPtr getNativeObject() const override { return m_pointer; }
+	private:
+		TextureSamplerDesc m_desc;
+		GpuPtr m_pointer = 0;
+		std::shared_ptr<NullLiveObjects> m_liveObjects;
+	};
+
+	class NullFramebuffer : public gpu::IFramebuffer {
+	public:
+		NullFramebuffer(FramebufferDesc desc, GpuPtr pointer, std::shared_ptr<NullLiveObjects> liveObjects);
+		~NullFramebuffer() override;
+		[[nodiscard]] inline const FramebufferDesc& getDesc() const override { return m_desc; }
+		[[nodiscard]] inline const GpuPtr getNativeObject() const override { return m_pointer; }
+		// Attachments are numbered right after the framebuffer itself
+		[[nodiscard]] inline const GpuPtr getTextureNativeObject(uint32_t attachment = 0) const override { return m_pointer + 1 + attachment; }
+	private:
+		FramebufferDesc m_desc;
+		GpuPtr m_pointer = 0;
+		std::shared_ptr<NullLiveObjects> m_liveObjects;
+	};
+
+	//
+	// Shaders
+	//
+	class NullShader : public gpu::IShader {
+	public:
+		NullShader(ShaderDesc shaderDesc, GpuPtr pointer, std::shared_ptr<NullLiveObjects> liveObjects);
+		~NullShader() override;
+		[[nodiscard]] inline const ShaderDesc& getDesc() const override { return m_shaderDesc; }
+		[[nodiscard]] inline const GpuPtr getNativeObject() const override { return m_pointer; }
+	private:
+		ShaderDesc m_shaderDesc;
+		GpuPtr m_pointer = 0;
+		std::shared_ptr<NullLiveObjects> m_liveObjects;
+	};
+
+	//
+	// BlendState
+	//
+	class NullBlendState : public gpu::IBlendState {
+	public:
+		NullBlendState(BlendStateDesc blendStateDesc, GpuPtr pointer, std::shared_ptr<NullLiveObjects> liveObjects);
+		~NullBlendState() override;
+		[[nodiscard]] inline const BlendStateDesc& getDesc() const override { return m_blendStateDesc; }
+		[[nodiscard]] inline const GpuPtr getNativeObject() const override { return m_pointer; }
+	private:
+		BlendStateDesc m_blendStateDesc;
+		GpuPtr m_pointer = 0;
+		std::shared_ptr<NullLiveObjects> m_liveObjects;
+	};
+
+	//
+	// Pipeline
+	//
+	class NullPipeline : public gpu::IPipeline {
+	public:
+		NullPipeline(PipelineDesc pipelineDesc, std::shared_ptr<NullLiveObjects> liveObjects);
+		~NullPipeline() override;
+		[[nodiscard]] inline const PipelineDesc& getDesc() const override { return m_pipelineDesc; }
+	private:
+		PipelineDesc m_pipelineDesc;
+		std::shared_ptr<NullLiveObjects> m_liveObjects;
+	};
+
+	//
+	// Device
+	//
+	// Renders nothing. Every call is validated against the rules the GL backend relies on and the work is counted, so the
+	// CPU side of the renderer can run and be measured without a display or a GPU. Misuse is logged and counted rather than
+	// asserted on, so a headless run reports every problem it finds
+	class NullDevice : public ::gpu::IDevice {
+	public:
+		NullDevice();
+		~NullDevice() override;
+
+		void setViewport(const Rect viewportRect) override;
+		void setScissor(bool enabled, const Rect scissorRect = {}) override;
+		InputLayoutHandle createInputLayout(const VertexAttributeDesc* desc, uint32_t attributeCount) override;
+		ShaderHandle makeShader(const ShaderDesc shaderDesc) override;
+		PipelineHandle makePipeline(const PipelineDesc pipelineDesc) override;
+		// No binaries, shaders are always "compiled"
+		std::string getShaderBinaryTag() const override;
+		bool getShaderBinary(IShader* shader, ShaderBinary& outBinary) override;
+
+		BufferHandle makeBuffer(const BufferDesc bufferDesc) override;
+		void writeBuffer(IBuffer* handle, size_t size, const void* data) override;
+		void mapBuffer(IBuffer* buffer, uint32_t offset, size_t length, MapAccessFlags accessFlags, void** mappedDataPtr) override;
+		void unmapBuffer(IBuffer* buffer) override;
+		void bindBuffer(IBuffer* buffer) override;
+		void unbindBuffer(IBuffer* buffer) override;
+		void setConstantBuffer(IBuffer* buffer, uint32_t bindIndex) override;
+		void unbindConstantBuffer(IBuffer* buffer, uint32_t bindIndex) override;
+		void setBufferBinding(IShader* shader, const std::string& name, uint32_t bindIndex) override;
+		void registerUniformBlock(const UniformBlockDesc& desc) override;
+
+		void draw(DrawCallState drawCallState, size_t triangleCount, size_t offset = 0, size_t instances = 1, size_t firstInstance = 0) override;
+		void drawIndexed(DrawCallState drawCallState, size_t triangleCount, size_t offset = 0, size_t instances = 1, size_t firstInstance = 0) override;
+
+		void clearColor(Color color, float depth) override;
+		void present() override;
+
+		// Blend state
+		BlendStateHandle makeBlendState(const BlendStateDesc blendStateDesc) override;
+
+		// Textures
+		TextureHandle makeTexture(TextureDesc desc, void* textureData) override;
+		TextureSamplerHandle makeTextureSampler(TextureSamplerDesc desc) override;
+		void bindTexture(ITexture* texture, ITextureSampler* sampler, uint32_t index = 0) override;
+		void bindTexture(IFramebuffer* texture, ITextureSampler* sampler, uint32_t index = 0, uint32_t attachment = 0) override;
+
+		FramebufferHandle makeFramebuffer(FramebufferDesc desc) override;
+		void bindFramebuffer(IFramebuffer* texture, uint32_t cubeFace = 0) override;
+		void blitFramebuffer(IFramebuffer* textureSrc, IFramebuffer* textureDst) override;
+		void blitFramebufferDepth(IFramebuffer* textureSrc, IFramebuffer* textureDst) override;
+		void clearColorAttachment(uint32_t attachment, Color color) override;
+		void readDepthBuffer(IBuffer* buffer, const Rect rect) override;
+
+		void setDepthOverride(bool enabled, CompareFunc depthFunc = CompareFunc::Equal, bool depthWrite = false) override;
+
+		void debugMarkerPush(const std::string& title) override;
+		void debugMarkerPop() override;
+
+		// Scopes are validated but never timed, the results stay empty
+		void beginProfilingFrame() override;
+		void endProfilingFrame() override;
+		void profileScopePush(const char* name) override;
+		void profileScopePop() override;
+		[[nodiscard]] const std::vector<GpuScopeTiming>& getProfilingResults() const override;
+
+		[[nodiscard]] inline const NullFrameStats& getLastFrameStats() const { return m_lastFrameStats; }
+		[[nodiscard]] inline const NullLiveObjects& getLiveObjects() const { return *m_liveObjects; }
+		[[nodiscard]] inline uint64_t getValidationErrorCount() const { return m_validationErrors; }
+		[[nodiscard]] inline uint64_t getPresentedFrameCount() const { return m_presentedFrames; }
+
+	private:
+		void validationError(const std::string& message);
+		// Whether object was made by this device and is still alive. Logs a validation error otherwise
+		bool validateObject(const void* object, const char* usage);
+		// Validates the pipeline and every object it references
+		bool validatePipeline(const IPipeline* pipeline);
+		// Counts what changed since the last bound pipeline
+		void bindPipeline(const IPipeline* pipeline);
+
+		std::shared_ptr<NullLiveObjects> m_liveObjects;
+		GpuPtr m_nextObjectId = 1;
+
+		// Bound state, only compared against and never dereferenced, objects may have been destroyed since
+		const IBuffer* m_boundBuffers[(uint32_t)gpu::BufferType::Count] = {};
+		const IPipeline* m_boundPipeline = nullptr;
+		const IShader* m_boundShader = nullptr;
+		const IBlendState* m_boundBlendState = nullptr;
+		const IFramebuffer* m_boundFramebuffer = k_defaultFramebuffer;
+		uint32_t m_mappedBufferCount = 0;
+		uint32_t m_debugMarkerDepth = 0;
+		bool m_profilingFrameOpen = false;
+		uint32_t m_profileScopeDepth = 0;
+		std::vector<GpuScopeTiming> m_profilingResults;
+
+		NullFrameStats m_frameStats;
+		NullFrameStats m_lastFrameStats;
+		uint64_t m_presentedFrames = 0;
+		uint64_t m_validationErrors = 0;
+	};
+}
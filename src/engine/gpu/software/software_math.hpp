@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+// Just enough of GLSL's vector maths for the shader ports to read like the shaders they mirror. Matrices are column major
+// like GLSL's, so a mat4 read straight out of a uniform block matches what the GPU sees
+namespace gpu::software {
+
+	struct vec2 {
+		float x = 0, y = 0;
+		vec2() = default;
+		constexpr vec2(float x, float y) : x(x), y(y) {}
+		constexpr explicit vec2(float s) : x(s), y(s) {}
+	};
+
+	struct vec3 {
+		float x = 0, y = 0, z = 0;
+		vec3() = default;
+		constexpr vec3(float x, float y, float z) : x(x), y(y), z(z) {}
+		constexpr explicit vec3(float s) : x(s), y(s), z(s) {}
+		constexpr vec3(const vec2& xy, float z) : x(xy.x), y(xy.y), z(z) {}
+		[[nodiscard]] constexpr vec2 xy() const { return { x, y }; }
+	};
+
+	struct vec4 {
+		float x = 0, y = 0, z = 0, w = 0;
+		vec4() = default;
+		constexpr vec4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+		constexpr explicit vec4(float s) : x(s), y(s), z(s), w(s) {}
+		constexpr vec4(const vec3& xyz, float w) : x(xyz.x), y(xyz.y), z(xyz.z), w(w) {}
+		constexpr vec4(const vec2& xy, float z, float w) : x(xy.x), y(xy.y), z(z), w(w) {}
+		[[nodiscard]] constexpr vec2 xy() const { return { x, y }; }
+		[[nodiscard]] constexpr vec2 zw() const { return { z, w }; }
+		[[nodiscard]] constexpr vec3 xyz() const { return { x, y, z }; }
+		[[nodiscard]] constexpr vec3 rgb() const { return { x, y, z }; }
+	};
+
+	// Column major, columns[i] is the i-th column like GLSL's m[i]
+	struct mat4 {
+		vec4 columns[4];
+	};
+
+#define SOFTWARE_VECTOR_OPERATORS(T, ...) \
+	constexpr T operator+(const T& a, const T& b) { return { __VA_ARGS__(a, +, b) }; } \
+	constexpr T operator-(const T& a, const T& b) { return { __VA_ARGS__(a, -, b) }; } \
+	constexpr T operator*(const T& a, const T& b) { return { __VA_ARGS__(a, *, b) }; } \
+	constexpr T operator/(const T& a, const T& b) { return { __VA_ARGS__(a, /, b) }; } \
+	constexpr T operator+(const T& a, float b) { return a + T(b); } \
+	constexpr T operator-(const T& a, float b) { return a - T(b); } \
+	constexpr T operator*(const T& a, float b) { return a * T(b); } \
+	constexpr T operator/(const T& a, float b) { return a / T(b); } \
+	constexpr T operator+(float a, const T& b) { return T(a) + b; } \
+	constexpr T operator-(float a, const T& b) { return T(a) - b; } \
+	constexpr T operator*(float a, const T& b) { return T(a) * b; } \
+	constexpr T operator/(float a, const T& b) { return T(a) / b; } \
+	constexpr T operator-(const T& a) { return T(0.0f) - a; } \
+	constexpr T& operator+=(T& a, const T& b) { return a = a + b; } \
+	constexpr T& operator-=(T& a, const T& b) { return a = a - b; } \
+	constexpr T& operator*=(T& a, const T& b) { return a = a * b; } \
+	constexpr T& operator*=(T& a, float b) { return a = a * b; }
+
+#define SOFTWARE_VEC2_COMPONENTS(a, op, b) a.x op b.x, a.y op b.y
+#define SOFTWARE_VEC3_COMPONENTS(a, op, b) a.x op b.x, a.y op b.y, a.z op b.z
+#define SOFTWARE_VEC4_COMPONENTS(a, op, b) a.x op b.x, a.y op b.y, a.z op b.z, a.w op b.w
+	SOFTWARE_VECTOR_OPERATORS(vec2, SOFTWARE_VEC2_COMPONENTS)
+	SOFTWARE_VECTOR_OPERATORS(vec3, SOFTWARE_VEC3_COMPONENTS)
+	SOFTWARE_VECTOR_OPERATORS(vec4, SOFTWARE_VEC4_COMPONENTS)
+#undef SOFTWARE_VEC2_COMPONENTS
+#undef SOFTWARE_VEC3_COMPONENTS
+#undef SOFTWARE_VEC4_COMPONENTS
+#undef SOFTWARE_VECTOR_OPERATORS
+
+	constexpr vec4 operator*(const mat4& m, const vec4& v) {
+		return m.columns[0] * v.x + m.columns[1] * v.y + m.columns[2] * v.z + m.columns[3] * v.w;
+	}
+
+	constexpr mat4 operator*(const mat4& a, const mat4& b) {
+		return { { a * b.columns[0], a * b.columns[1], a * b.columns[2], a * b.columns[3] } };
+	}
+
+	constexpr float dot(const vec2& a, const vec2& b) { return a.x * b.x + a.y * b.y; }
+	constexpr float dot(const vec3& a, const vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	constexpr float dot(const vec4& a, const vec4& b) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+
+	template<typename T> inline float length(const T& v) { return std::sqrt(dot(v, v)); }
+	template<typename T> inline T normalize(const T& v) {
+		float lengthSquared = dot(v, v);
+		return lengthSquared > 0.0f ? v / std::sqrt(lengthSquared) : v;
+	}
+	inline vec3 reflect(const vec3& i, const vec3& n) { return i - 2.0f * dot(n, i) * n; }
+
+	constexpr float saturate(float x) { return std::clamp(x, 0.0f, 1.0f); }
+	constexpr float mix(float a, float b, float t) { return a + (b - a) * t; }
+	template<typename T> constexpr T mix(const T& a, const T& b, float t) { return a + (b - a) * t; }
+
+	inline vec3 max(const vec3& a, const vec3& b) { return { std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z) }; }
+	inline vec2 min(const vec2& a, const vec2& b) { return { std::min(a.x, b.x), std::min(a.y, b.y) }; }
+	inline vec3 clamp(const vec3& v, float lo, float hi) { return { std::clamp(v.x, lo, hi), std::clamp(v.y, lo, hi), std::clamp(v.z, lo, hi) }; }
+	inline vec4 pow(const vec4& v, const vec4& e) { return { std::pow(v.x, e.x), std::pow(v.y, e.y), std::pow(v.z, e.z), std::pow(v.w, e.w) }; }
+}
@@ -0,0 +1,595 @@
+#include "software_rasterizer.hpp"
+#include "engine/core.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define SOFTWARE_RASTER_SSE 1
+#else
+#define SOFTWARE_RASTER_SSE 0
+#endif
+
+namespace gpu::software {
+
+	//
+	// Worker pool
+	//
+
+	SoftwareWorkerPool::SoftwareWorkerPool(uint32_t threadCount) {
+		for (uint32_t i = 1; i < threadCount; i++) {
+			m_threads.emplace_back(&SoftwareWorkerPool::workerLoop, this);
+		}
+	}
+
+	SoftwareWorkerPool::~SoftwareWorkerPool() {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_exiting = true;
+		}
+		m_wake.notify_all();
+		for (std::thread& thread : m_threads) {
+			thread.join();
+		}
+	}
+
+	void SoftwareWorkerPool::parallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t begin, uint32_t end)>& task) {
+		ASSERT(batchSize > 0);
+		if (count == 0) {
+			return;
+		}
+		// Not worth waking anyone up for
+		if (m_threads.empty() || count <= batchSize) {
+			task(0, count);
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_task = &task;
+			m_count = count;
+			m_batchSize = batchSize;
+			m_nextIndex = 0;
+			m_busyWorkers = static_cast<uint32_t>(m_threads.size());
+			m_jobIndex++;
+		}
+		m_wake.notify_all();
+		runBatches();
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_finished.wait(lock, [this]() { return m_busyWorkers == 0; });
+		m_task = nullptr;
+	}
+
+	void SoftwareWorkerPool::runBatches() {
+		while (true) {
+			uint32_t begin = m_nextIndex.fetch_add(m_batchSize);
+			if (begin >= m_count) {
+				return;
+			}
+			(*m_task)(begin, std::min(begin + m_batchSize, m_count));
+		}
+	}
+
+	void SoftwareWorkerPool::workerLoop() {
+		uint64_t lastJobIndex = 0;
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_wake.wait(lock, [&]() { return m_exiting || m_jobIndex != lastJobIndex; });
+				if (m_exiting) {
+					return;
+				}
+				lastJobIndex = m_jobIndex;
+			}
+
+			runBatches();
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (--m_busyWorkers == 0) {
+				m_finished.notify_one();
+			}
+		}
+	}
+
+	//
+	// Fixed function helpers
+	//
+
+	static bool depthTestPasses(CompareFunc func, float fragmentDepth, float storedDepth) {
+		switch (func) {
+		case CompareFunc::Never:
+			return false;
+		case CompareFunc::Less:
+			return fragmentDepth < storedDepth;
+		case CompareFunc::Equal:
+			return fragmentDepth == storedDepth;
+		case CompareFunc::LessOrEqual:
+			return fragmentDepth <= storedDepth;
+		case CompareFunc::Greater:
+			return fragmentDepth > storedDepth;
+		case CompareFunc::NotEqual:
+			return fragmentDepth != storedDepth;
+		case CompareFunc::GreaterOrEqual:
+			return fragmentDepth >= storedDepth;
+		default:
+			return true;
+		}
+	}
+
+	// There's no second fragment output, dual source factors read the first one
+	static float getBlendFactor(BlendFactor factor, float srcChannel, float dstChannel, float srcAlpha, float dstAlpha) {
+		switch (factor) {
+		case BlendFactor::Zero:
+			return 0.0f;
+		case BlendFactor::One:
+			return 1.0f;
+		case BlendFactor::SrcColour:
+		case BlendFactor::Src1Colour:
+			return srcChannel;
+		case BlendFactor::OneMinusSrcColour:
+		case BlendFactor::OneMinusSrc1Colour:
+			return 1.0f - srcChannel;
+		case BlendFactor::SrcAlpha:
+		case BlendFactor::Src1Alpha:
+			return srcAlpha;
+		case BlendFactor::OneMinusSrcAlpha:
+		case BlendFactor::OneMinusSrc1Alpha:
+			return 1.0f - srcAlpha;
+		case BlendFactor::DstColour:
+			return dstChannel;
+		case BlendFactor::OneMinusDstColour:
+			return 1.0f - dstChannel;
+		case BlendFactor::DstAlpha:
+			return dstAlpha;
+		case BlendFactor::OneMinusDstAlpha:
+			return 1.0f - dstAlpha;
+		default:
+			return 1.0f;
+		}
+	}
+
+	// Like GL, min and max ignore the factors
+	static float blendChannel(BlendOp op, float src, float dst, float srcFactor, float dstFactor) {
+		switch (op) {
+		case BlendOp::Add:
+			return src * srcFactor + dst * dstFactor;
+		case BlendOp::Subtract:
+			return src * srcFactor - dst * dstFactor;
+		case BlendOp::InvSubtract:
+			return dst * dstFactor - src * srcFactor;
+		case BlendOp::Min:
+			return std::min(src, dst);
+		case BlendOp::Max:
+			return std::max(src, dst);
+		default:
+			return src;
+		}
+	}
+
+	static void writeColour(float* pixel, vec4 src, const BlendStateDesc& blend, bool clampColour) {
+		if (clampColour) {
+			src = { saturate(src.x), saturate(src.y), saturate(src.z), saturate(src.w) };
+		}
+		if (blend.blendEnable) {
+			float result[4];
+			const float srcChannels[4] = { src.x, src.y, src.z, src.w };
+			for (uint32_t channel = 0; channel < 3; channel++) {
+				float srcFactor = getBlendFactor(blend.srcFactor, srcChannels[channel], pixel[channel], src.w, pixel[3]);
+				float dstFactor = getBlendFactor(blend.dstFactor, srcChannels[channel], pixel[channel], src.w, pixel[3]);
+				result[channel] = blendChannel(blend.blendOp, srcChannels[channel], pixel[channel], srcFactor, dstFactor);
+			}
+			float srcFactor = getBlendFactor(blend.srcFactorAlpha, src.w, pixel[3], src.w, pixel[3]);
+			float dstFactor = getBlendFactor(blend.dstFactorAlpha, src.w, pixel[3], src.w, pixel[3]);
+			result[3] = blendChannel(blend.blendOpAlpha, src.w, pixel[3], srcFactor, dstFactor);
+			src = { result[0], result[1], result[2], result[3] };
+			if (clampColour) {
+				src = { saturate(src.x), saturate(src.y), saturate(src.z), saturate(src.w) };
+			}
+		}
+		pixel[0] = src.x;
+		pixel[1] = src.y;
+		pixel[2] = src.z;
+		pixel[3] = src.w;
+	}
+
+	//
+	// Clipping
+	//
+
+	// Signed distances to the clip planes that matter without a guard band limit. GL's zero to one depth range keeps 0 <= z <= w,
+	// the last plane keeps w away from 0. x and y are left to the viewport clamp in setup
+	constexpr uint32_t k_clipPlaneCount = 3;
+	constexpr float k_clipMinW = 1e-6f;
+
+	static float getClipDistance(const vec4& position, uint32_t plane) {
+		switch (plane) {
+		case 0:
+			return position.z;
+		case 1:
+			return position.w - position.z;
+		default:
+			return position.w - k_clipMinW;
+		}
+	}
+
+	static SoftwareVertexOutput lerpVertex(const SoftwareVertexOutput& a, const SoftwareVertexOutput& b, float t, uint32_t varyingCount) {
+		SoftwareVertexOutput result;
+		result.position = mix(a.position, b.position, t);
+		for (uint32_t i = 0; i < varyingCount; i++) {
+			result.varyings[i] = mix(a.varyings[i], b.varyings[i], t);
+		}
+		return result;
+	}
+
+	//
+	// Rasterizer
+	//
+
+	SoftwareRasterizer::SoftwareRasterizer(uint32_t threadCount) : m_workerPool(threadCount) {}
+
+	void SoftwareRasterizer::drawTriangles(const SoftwareRenderTarget& target, const SoftwareRasterState& state, const ISoftwareFragmentShader* fragmentShader,
+		uint32_t varyingCount, const std::vector<SoftwareVertexOutput>& vertices, const std::vector<uint32_t>& indices) {
+		ASSERT(fragmentShader != nullptr);
+		ASSERT(varyingCount <= k_softwareMaxVaryings);
+
+		uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+		m_stats.trianglesSubmitted += triangleCount;
+		if (triangleCount == 0 || target.width == 0 || target.height == 0) {
+			return;
+		}
+		if (state.cullMode == FaceCullMode::Both) {
+			m_stats.trianglesRejected += triangleCount;
+			return;
+		}
+
+		m_target = target;
+		m_state = state;
+
+		// Viewport, scissor and target intersected. GL never draws outside of the viewport either, its clipper sees to that
+		m_clipMinX = static_cast<int32_t>(state.viewport.left);
+		m_clipMinY = static_cast<int32_t>(state.viewport.top);
+		m_clipMaxX = std::min(static_cast<int32_t>(state.viewport.right), static_cast<int32_t>(target.width));
+		m_clipMaxY = std::min(static_cast<int32_t>(state.viewport.bottom), static_cast<int32_t>(target.height));
+		if (state.scissorEnabled) {
+			m_clipMinX = std::max(m_clipMinX, static_cast<int32_t>(state.scissor.left));
+			m_clipMinY = std::max(m_clipMinY, static_cast<int32_t>(state.scissor.top));
+			m_clipMaxX = std::min(m_clipMaxX, static_cast<int32_t>(state.scissor.right));
+			m_clipMaxY = std::min(m_clipMaxY, static_cast<int32_t>(state.scissor.bottom));
+		}
+		if (m_clipMinX >= m_clipMaxX || m_clipMinY >= m_clipMaxY) {
+			m_stats.trianglesRejected += triangleCount;
+			return;
+		}
+
+		m_tilesX = (target.width + k_softwareTileSize - 1) / k_softwareTileSize;
+		m_tilesY = (target.height + k_softwareTileSize - 1) / k_softwareTileSize;
+		uint32_t tileCount = m_tilesX * m_tilesY;
+		uint32_t batchCount = (triangleCount + k_softwareSetupBatchSize - 1) / k_softwareSetupBatchSize;
+		if (m_batches.size() < batchCount) {
+			m_batches.resize(batchCount);
+		}
+
+		// Clip, cull and bin
+		std::atomic<uint64_t> rejected = 0;
+		std::atomic<uint64_t> clipped = 0;
+		m_workerPool.parallelFor(batchCount, 1, [&](uint32_t begin, uint32_t end) {
+			for (uint32_t batchIndex = begin; batchIndex < end; batchIndex++) {
+				SetupBatch& batch = m_batches[batchIndex];
+				batch.triangles.clear();
+				batch.bins.resize(tileCount);
+				for (std::vector<uint32_t>& bin : batch.bins) {
+					bin.clear();
+				}
+
+				uint32_t firstTriangle = batchIndex * k_softwareSetupBatchSize;
+				uint32_t lastTriangle = std::min(firstTriangle + k_softwareSetupBatchSize, triangleCount);
+				for (uint32_t triangle = firstTriangle; triangle < lastTriangle; triangle++) {
+					setupTriangle(batch,
+						&vertices[indices[triangle * 3 + 0]],
+						&vertices[indices[triangle * 3 + 1]],
+						&vertices[indices[triangle * 3 + 2]],
+						varyingCount, rejected, clipped);
+				}
+			}
+		});
+
+		// Only wake workers for tiles something landed in
+		std::vector<uint32_t> activeTiles;
+		for (uint32_t tile = 0; tile < tileCount; tile++) {
+			for (uint32_t batchIndex = 0; batchIndex < batchCount; batchIndex++) {
+				if (!m_batches[batchIndex].bins[tile].empty()) {
+					activeTiles.push_back(tile);
+					break;
+				}
+			}
+		}
+		for (uint32_t batchIndex = 0; batchIndex < batchCount; batchIndex++) {
+			m_stats.trianglesBinned += m_batches[batchIndex].triangles.size();
+		}
+
+		std::atomic<uint64_t> shaded = 0;
+		std::atomic<uint64_t> discarded = 0;
+		m_workerPool.parallelFor(static_cast<uint32_t>(activeTiles.size()), 1, [&](uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; i++) {
+				rasterizeTile(activeTiles[i], batchCount, fragmentShader, varyingCount, shaded, discarded);
+			}
+		});
+
+		m_stats.trianglesRejected += rejected;
+		m_stats.trianglesClipped += clipped;
+		m_stats.fragmentsShaded += shaded;
+		m_stats.fragmentsDiscarded += discarded;
+	}
+
+	void SoftwareRasterizer::setupTriangle(SetupBatch& batch, const SoftwareVertexOutput* v0, const SoftwareVertexOutput* v1, const SoftwareVertexOutput* v2,
+		uint32_t varyingCount, std::atomic<uint64_t>& rejected, std::atomic<uint64_t>& clipped) {
+
+		// Trivial accept and reject
+		uint32_t outsideMask[3] = {};
+		const SoftwareVertexOutput* triangle[3] = { v0, v1, v2 };
+		for (uint32_t vertex = 0; vertex < 3; vertex++) {
+			for (uint32_t plane = 0; plane < k_clipPlaneCount; plane++) {
+				if (!(getClipDistance(triangle[vertex]->position, plane) >= 0.0f)) {
+					outsideMask[vertex] |= 1u << plane;
+				}
+			}
+		}
+		if ((outsideMask[0] | outsideMask[1] | outsideMask[2]) == 0) {
+			setupClippedTriangle(batch, *v0, *v1, *v2, varyingCount, rejected);
+			return;
+		}
+		if ((outsideMask[0] & outsideMask[1] & outsideMask[2]) != 0) {
+			rejected++;
+			return;
+		}
+
+		// Sutherland-Hodgman against each plane, in homogeneous clip space. Every plane adds at most one vertex
+		clipped++;
+		SoftwareVertexOutput polygons[2][3 + k_clipPlaneCount];
+		uint32_t polygonSize = 3;
+		polygons[0][0] = *v0;
+		polygons[0][1] = *v1;
+		polygons[0][2] = *v2;
+		uint32_t current = 0;
+		for (uint32_t plane = 0; plane < k_clipPlaneCount && polygonSize >= 3; plane++) {
+			const SoftwareVertexOutput* input = polygons[current];
+			SoftwareVertexOutput* output = polygons[current ^ 1];
+			uint32_t outputSize = 0;
+			for (uint32_t i = 0; i < polygonSize; i++) {
+				const SoftwareVertexOutput& a = input[i];
+				const SoftwareVertexOutput& b = input[(i + 1) % polygonSize];
+				float distanceA = getClipDistance(a.position, plane);
+				float distanceB = getClipDistance(b.position, plane);
+				if (distanceA >= 0.0f) {
+					output[outputSize++] = a;
+				}
+				if ((distanceA >= 0.0f) != (distanceB >= 0.0f)) {
+					output[outputSize++] = lerpVertex(a, b, distanceA / (distanceA - distanceB), varyingCount);
+				}
+			}
+			polygonSize = outputSize;
+			current ^= 1;
+		}
+
+		if (polygonSize < 3) {
+			rejected++;
+			return;
+		}
+		for (uint32_t i = 1; i + 1 < polygonSize; i++) {
+			setupClippedTriangle(batch, polygons[current][0], polygons[current][i], polygons[current][i + 1], varyingCount, rejected);
+		}
+	}
+
+	void SoftwareRasterizer::setupClippedTriangle(SetupBatch& batch, const SoftwareVertexOutput& v0, const SoftwareVertexOutput& v1, const SoftwareVertexOutput& v2,
+		uint32_t varyingCount, std::atomic<uint64_t>& rejected) {
+
+		// To window space, with the origin in the bottom left like GL
+		const SoftwareVertexOutput* vertices[3] = { &v0, &v1, &v2 };
+		double x[3], y[3];
+		float depth[3], invW[3];
+		float viewportWidth = static_cast<float>(m_state.viewport.getWidth());
+		float viewportHeight = static_cast<float>(m_state.viewport.getHeight());
+		for (uint32_t i = 0; i < 3; i++) {
+			const vec4& position = vertices[i]->position;
+			invW[i] = 1.0f / position.w;
+			x[i] = (position.x * invW[i] * 0.5f + 0.5f) * viewportWidth + m_state.viewport.left;
+			y[i] = (position.y * invW[i] * 0.5f + 0.5f) * viewportHeight + m_state.viewport.top;
+			depth[i] = position.z * invW[i];
+		}
+
+		// Positive when counter clockwise
+		double doubleArea = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+		if (!(doubleArea != 0.0) || !std::isfinite(doubleArea)) {
+			rejected++;
+			return;
+		}
+		bool frontFacing = (doubleArea > 0.0) == (m_state.frontFace == WindingOrder::CounterClockwise);
+		if ((m_state.cullMode == FaceCullMode::Back && !frontFacing) || (m_state.cullMode == FaceCullMode::Front && frontFacing)) {
+			rejected++;
+			return;
+		}
+
+		// Flip clockwise triangles so the inside is always positive
+		uint32_t order[3] = { 0, 1, 2 };
+		if (doubleArea < 0.0) {
+			std::swap(order[1], order[2]);
+			doubleArea = -doubleArea;
+		}
+
+		// Pixels whose centre may be covered
+		double minX = std::min({ x[0], x[1], x[2] });
+		double maxX = std::max({ x[0], x[1], x[2] });
+		double minY = std::min({ y[0], y[1], y[2] });
+		double maxY = std::max({ y[0], y[1], y[2] });
+		RasterTriangle triangle;
+		triangle.minX = static_cast<int32_t>(std::max(std::ceil(minX - 0.5), static_cast<double>(m_clipMinX)));
+		triangle.maxX = static_cast<int32_t>(std::min(std::floor(maxX - 0.5), static_cast<double>(m_clipMaxX - 1)));
+		triangle.minY = static_cast<int32_t>(std::max(std::ceil(minY - 0.5), static_cast<double>(m_clipMinY)));
+		triangle.maxY = static_cast<int32_t>(std::min(std::floor(maxY - 0.5), static_cast<double>(m_clipMaxY - 1)));
+		if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) {
+			rejected++;
+			return;
+		}
+
+		for (uint32_t i = 0; i < 3; i++) {
+			uint32_t a = order[(i + 1) % 3];
+			uint32_t b = order[(i + 2) % 3];
+			double edgeA = y[a] - y[b];
+			double edgeB = x[b] - x[a];
+			triangle.edgeA[i] = static_cast<float>(edgeA);
+			triangle.edgeB[i] = static_cast<float>(edgeB);
+			// From the rounded coefficients, so the edge still passes exactly through its vertices
+			triangle.edgeC[i] = -(static_cast<double>(triangle.edgeA[i]) * x[a] + static_cast<double>(triangle.edgeB[i]) * y[a]);
+			// Top left style rule, of two triangles sharing an edge exactly one owns it
+			bool ownsEdge = edgeA > 0.0 || (edgeA == 0.0 && edgeB > 0.0);
+			triangle.edgeThreshold[i] = ownsEdge ? 0.0f : FLT_MIN;
+
+			uint32_t vertex = order[i];
+			triangle.depth[i] = depth[vertex];
+			triangle.invW[i] = invW[vertex];
+			for (uint32_t varying = 0; varying < varyingCount; varying++) {
+				triangle.varyings[i][varying] = vertices[vertex]->varyings[varying] * invW[vertex];
+			}
+		}
+		triangle.invDoubleArea = static_cast<float>(1.0 / doubleArea);
+
+		uint32_t triangleIndex = static_cast<uint32_t>(batch.triangles.size());
+		batch.triangles.push_back(triangle);
+		for (uint32_t tileY = triangle.minY / k_softwareTileSize; tileY <= triangle.maxY / k_softwareTileSize; tileY++) {
+			for (uint32_t tileX = triangle.minX / k_softwareTileSize; tileX <= triangle.maxX / k_softwareTileSize; tileX++) {
+				batch.bins[tileY * m_tilesX + tileX].push_back(triangleIndex);
+			}
+		}
+	}
+
+	void SoftwareRasterizer::rasterizeTile(uint32_t tile, uint32_t batchCount, const ISoftwareFragmentShader* fragmentShader, uint32_t varyingCount,
+		std::atomic<uint64_t>& shaded, std::atomic<uint64_t>& discarded) {
+
+		const int32_t tileMinX = static_cast<int32_t>((tile % m_tilesX) * k_softwareTileSize);
+		const int32_t tileMinY = static_cast<int32_t>((tile / m_tilesX) * k_softwareTileSize);
+		const int32_t tileMaxX = tileMinX + static_cast<int32_t>(k_softwareTileSize) - 1;
+		const int32_t tileMaxY = tileMinY + static_cast<int32_t>(k_softwareTileSize) - 1;
+		const bool depthTest = m_state.depthTest && m_target.depth != nullptr;
+		const bool depthWrite = depthTest && m_state.depthWrite;
+		float* depthBuffer = m_target.depth != nullptr ? m_target.depth->data() : nullptr;
+
+		uint64_t shadedCount = 0;
+		uint64_t discardedCount = 0;
+		float varyings[k_softwareMaxVaryings];
+		SoftwareFragmentInput input;
+		input.varyings = varyings;
+		SoftwareFragmentOutput output;
+
+		auto shadePixel = [&](const RasterTriangle& triangle, int32_t x, int32_t y, const float edges[3]) {
+			float lambda0 = edges[0] * triangle.invDoubleArea;
+			float lambda1 = edges[1] * triangle.invDoubleArea;
+			float lambda2 = edges[2] * triangle.invDoubleArea;
+			float depth = lambda0 * triangle.depth[0] + lambda1 * triangle.depth[1] + lambda2 * triangle.depth[2];
+			size_t pixel = static_cast<size_t>(y) * m_target.width + x;
+			if (depthTest && !depthTestPasses(m_state.depthFunc, depth, depthBuffer[pixel])) {
+				return;
+			}
+
+			float invW = lambda0 * triangle.invW[0] + lambda1 * triangle.invW[1] + lambda2 * triangle.invW[2];
+			float w = 1.0f / invW;
+			for (uint32_t i = 0; i < varyingCount; i++) {
+				varyings[i] = (lambda0 * triangle.varyings[0][i] + lambda1 * triangle.varyings[1][i] + lambda2 * triangle.varyings[2][i]) * w;
+			}
+			input.fragCoord = vec4(x + 0.5f, y + 0.5f, depth, invW);
+
+			shadedCount++;
+			if (!fragmentShader->shade(input, output)) {
+				discardedCount++;
+				return;
+			}
+
+			if (depthWrite) {
+				depthBuffer[pixel] = depth;
+			}
+			if (m_state.colorWrite) {
+				for (uint32_t attachment = 0; attachment < m_target.colourCount; attachment++) {
+					writeColour(&m_target.colour[attachment]->rgba32f[pixel * 4], output.colour[attachment], m_state.blend, m_target.clampColour[attachment]);
+				}
+			}
+		};
+
+		for (uint32_t batchIndex = 0; batchIndex < batchCount; batchIndex++) {
+			const SetupBatch& batch = m_batches[batchIndex];
+			for (uint32_t triangleIndex : batch.bins[tile]) {
+				const RasterTriangle& triangle = batch.triangles[triangleIndex];
+				const int32_t minX = std::max(triangle.minX, tileMinX);
+				const int32_t maxX = std::min(triangle.maxX, tileMaxX);
+				const int32_t minY = std::max(triangle.minY, tileMinY);
+				const int32_t maxY = std::min(triangle.maxY, tileMaxY);
+
+				// Edge values at the centre of the first pixel, in double so triangles far outside the target keep their precision.
+				// Everything past that is a small offset and steps fine in float
+				float rowEdges[3];
+				for (uint32_t i = 0; i < 3; i++) {
+					rowEdges[i] = static_cast<float>(triangle.edgeA[i] * (minX + 0.5) + triangle.edgeB[i] * (minY + 0.5) + triangle.edgeC[i]);
+				}
+
+#if SOFTWARE_RASTER_SSE
+				// 4 pixels of a row at a time
+				const __m128 laneOffsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+				__m128 edgeStepX[3];
+				__m128 edgeThreshold[3];
+				for (uint32_t i = 0; i < 3; i++) {
+					edgeStepX[i] = _mm_set1_ps(triangle.edgeA[i]);
+					edgeThreshold[i] = _mm_set1_ps(triangle.edgeThreshold[i]);
+				}
+				for (int32_t y = minY; y <= maxY; y++) {
+					for (int32_t x = minX; x <= maxX; x += 4) {
+						__m128 offsets = _mm_add_ps(_mm_set1_ps(static_cast<float>(x - minX)), laneOffsets);
+						__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+						alignas(16) float laneEdges[3][4];
+						for (uint32_t i = 0; i < 3; i++) {
+							__m128 edge = _mm_add_ps(_mm_set1_ps(rowEdges[i]), _mm_mul_ps(edgeStepX[i], offsets));
+							inside = _mm_and_ps(inside, _mm_cmpge_ps(edge, edgeThreshold[i]));
+							_mm_store_ps(laneEdges[i], edge);
+						}
+						int32_t mask = _mm_movemask_ps(inside);
+						// Lanes past the end of the row
+						mask &= (1 << std::min(4, maxX - x + 1)) - 1;
+						while (mask != 0) {
+							int32_t lane = 0;
+							while ((mask & (1 << lane)) == 0) {
+								lane++;
+							}
+							mask &= ~(1 << lane);
+							const float edges[3] = { laneEdges[0][lane], laneEdges[1][lane], laneEdges[2][lane] };
+							shadePixel(triangle, x + lane, y, edges);
+						}
+					}
+					for (uint32_t i = 0; i < 3; i++) {
+						rowEdges[i] += triangle.edgeB[i];
+					}
+				}
+#else
+				for (int32_t y = minY; y <= maxY; y++) {
+					for (int32_t x = minX; x <= maxX; x++) {
+						float offset = static_cast<float>(x - minX);
+						const float edges[3] = {
+							rowEdges[0] + triangle.edgeA[0] * offset,
+							rowEdges[1] + triangle.edgeA[1] * offset,
+							rowEdges[2] + triangle.edgeA[2] * offset,
+						};
+						if (edges[0] >= triangle.edgeThreshold[0] && edges[1] >= triangle.edgeThreshold[1] && edges[2] >= triangle.edgeThreshold[2]) {
+							shadePixel(triangle, x, y, edges);
+						}
+					}
+					for (uint32_t i = 0; i < 3; i++) {
+						rowEdges[i] += triangle.edgeB[i];
+					}
+				}
+#endif
+			}
+		}
+
+		shaded += shadedCount;
+		discarded += discardedCount;
+	}
+}
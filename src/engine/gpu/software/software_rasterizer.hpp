@@ -0,0 +1,146 @@
+#pragma once
+
+#include "software_shader.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace gpu::software {
+
+	// Render targets are split into square tiles. Triangles are binned into every tile their bounds touch, then each tile is
+	// rasterized by a single worker, so pixels never need synchronising
+	constexpr uint32_t k_softwareTileSize = 64;
+	// Triangles set up per batch before another worker takes over
+	constexpr uint32_t k_softwareSetupBatchSize = 256;
+	// Vertices shaded per batch
+	constexpr uint32_t k_softwareVertexBatchSize = 256;
+
+	// Fixed set of worker threads running the batches of one parallelFor at a time. The calling thread works too
+	class SoftwareWorkerPool {
+	public:
+		// Spawns threadCount - 1 workers
+		explicit SoftwareWorkerPool(uint32_t threadCount);
+		~SoftwareWorkerPool();
+		SoftwareWorkerPool(const SoftwareWorkerPool&) = delete;
+		SoftwareWorkerPool& operator=(const SoftwareWorkerPool&) = delete;
+
+		// Calls task(begin, end) for batches of [0, count). Returns once every batch has run
+		void parallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t begin, uint32_t end)>& task);
+		[[nodiscard]] inline uint32_t getThreadCount() const { return static_cast<uint32_t>(m_threads.size()) + 1; }
+
+	private:
+		void workerLoop();
+		void runBatches();
+
+		std::vector<std::thread> m_threads;
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_finished;
+		// Current job, only written while every worker is idle
+		const std::function<void(uint32_t, uint32_t)>* m_task = nullptr;
+		uint32_t m_count = 0;
+		uint32_t m_batchSize = 1;
+		std::atomic<uint32_t> m_nextIndex = 0;
+		uint32_t m_busyWorkers = 0;
+		uint64_t m_jobIndex = 0;
+		bool m_exiting = false;
+	};
+
+	struct SoftwareRenderTarget {
+		uint32_t width = 0;
+		uint32_t height = 0;
+		SoftwareSurface* colour[k_MAX_FRAMEBUFFER_COLOR_ATTACHMENTS] = {};
+		// Fixed point attachments clamp what is written to [0, 1]
+		bool clampColour[k_MAX_FRAMEBUFFER_COLOR_ATTACHMENTS] = {};
+		uint32_t colourCount = 0;
+		// Null when the target has no depth attachment
+		std::vector<float>* depth = nullptr;
+	};
+
+	// Fixed function state of a draw
+	struct SoftwareRasterState {
+		// GL conventions, left and top are the bottom left corner
+		Rect viewport;
+		bool scissorEnabled = false;
+		Rect scissor;
+		bool depthTest = true;
+		CompareFunc depthFunc = CompareFunc::GreaterOrEqual;
+		bool depthWrite = true;
+		bool colorWrite = true;
+		FaceCullMode cullMode = FaceCullMode::Back;
+		WindingOrder frontFace = WindingOrder::CounterClockwise;
+		BlendStateDesc blend;
+	};
+
+	// Totals since the last present
+	struct SoftwareRasterStats {
+		uint64_t verticesShaded = 0;
+		uint64_t trianglesSubmitted = 0;
+		// Culled, clipped away or smaller than a pixel centre
+		uint64_t trianglesRejected = 0;
+		uint64_t trianglesClipped = 0;
+		uint64_t trianglesBinned = 0;
+		uint64_t fragmentsShaded = 0;
+		uint64_t fragmentsDiscarded = 0;
+	};
+
+	class SoftwareRasterizer {
+	public:
+		explicit SoftwareRasterizer(uint32_t threadCount);
+
+		// Rasterizes every 3 indices into vertices as a triangle. Returns once the target is written
+		void drawTriangles(const SoftwareRenderTarget& target, const SoftwareRasterState& state, const ISoftwareFragmentShader* fragmentShader,
+			uint32_t varyingCount, const std::vector<SoftwareVertexOutput>& vertices, const std::vector<uint32_t>& indices);
+
+		[[nodiscard]] inline SoftwareWorkerPool& getWorkerPool() { return m_workerPool; }
+		[[nodiscard]] inline SoftwareRasterStats& getStats() { return m_stats; }
+
+	private:
+		// A triangle ready to rasterize, in window space
+		struct RasterTriangle {
+			// Edge functions E(x, y) = a * x + b * y + c, positive inside. Edge i is opposite vertex i, so E_i / area is its barycentric
+			float edgeA[3];
+			float edgeB[3];
+			double edgeC[3];
+			// Pixels exactly on an edge belong to one of the two triangles sharing it, the other tests against the next float up
+			float edgeThreshold[3];
+			float invDoubleArea;
+			float depth[3];
+			float invW[3];
+			// Pixel bounds, inclusive, already clamped to the viewport and scissor
+			int32_t minX, minY, maxX, maxY;
+			// Pre-multiplied by invW for perspective correct interpolation
+			float varyings[3][k_softwareMaxVaryings];
+		};
+
+		// Triangles and bins filled by one setup batch. Batches are kept in submission order, so walking them in order keeps
+		// every tile's triangles in draw order
+		struct SetupBatch {
+			std::vector<RasterTriangle> triangles;
+			// Per tile, indices into triangles
+			std::vector<std::vector<uint32_t>> bins;
+		};
+
+		void setupTriangle(SetupBatch& batch, const SoftwareVertexOutput* v0, const SoftwareVertexOutput* v1, const SoftwareVertexOutput* v2,
+			uint32_t varyingCount, std::atomic<uint64_t>& rejected, std::atomic<uint64_t>& clipped);
+		void setupClippedTriangle(SetupBatch& batch, const SoftwareVertexOutput& v0, const SoftwareVertexOutput& v1, const SoftwareVertexOutput& v2,
+			uint32_t varyingCount, std::atomic<uint64_t>& rejected);
+		void rasterizeTile(uint32_t tile, uint32_t batchCount, const ISoftwareFragmentShader* fragmentShader, uint32_t varyingCount,
+			std::atomic<uint64_t>& shaded, std::atomic<uint64_t>& discarded);
+
+		SoftwareWorkerPool m_workerPool;
+		std::vector<SetupBatch> m_batches;
+		SoftwareRasterStats m_stats;
+
+		// State of the draw being rasterized
+		SoftwareRenderTarget m_target;
+		SoftwareRasterState m_state;
+		// Viewport, scissor and target bounds intersected, half open
+		int32_t m_clipMinX = 0, m_clipMinY = 0, m_clipMaxX = 0, m_clipMaxY = 0;
+		uint32_t m_tilesX = 0;
+		uint32_t m_tilesY = 0;
+	};
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "engine/gpu/idevice.hpp"
+#include "software_math.hpp"
+
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+
+// The software device can't compile GLSL. Instead every shader file has a C++ port, picked by the file name the shader was
+// loaded from (ShaderProgram::sourceName). Ports see the same uniform blocks, textures and vertex attributes as the GLSL
+namespace gpu::software {
+
+	// Floats passed from the vertex to the fragment stage. A vertex and fragment port pair agree on where each varying lives
+	constexpr uint32_t k_softwareMaxVaryings = 20;
+	// Vertex attribute locations
+	constexpr uint32_t k_softwareMaxVertexAttributes = 8;
+	constexpr uint32_t k_softwareMaxTextureUnits = 8;
+	constexpr uint32_t k_softwareMaxConstantBufferBindings = 16;
+
+	// An image in CPU memory. Textures loaded from disk stay RGBA8, render targets are float so HDR and OIT targets keep their range
+	struct SoftwareSurface {
+		uint32_t width = 0;
+		uint32_t height = 0;
+		// One of the two is filled, rows go bottom to top like GL's
+		std::vector<uint8_t> rgba8;
+		std::vector<float> rgba32f;
+
+		[[nodiscard]] inline bool isFloat() const { return !rgba32f.empty(); }
+	};
+
+	struct SoftwareTextureBinding {
+		// Mip chain, level 0 first. Null when nothing is bound to the unit
+		const SoftwareSurface* levels = nullptr;
+		uint32_t levelCount = 0;
+		TextureSamplerDesc sampler;
+	};
+
+	// GLSL's texture() and textureLod(). Reads black when nothing is bound
+	vec4 sampleTexture(const SoftwareTextureBinding& binding, vec2 uv, float lod = 0.0f);
+	// GLSL's texelFetch(), out of range texels read as black
+	vec4 fetchTexel(const SoftwareTextureBinding& binding, int32_t x, int32_t y, uint32_t level = 0);
+
+	struct SoftwareConstantBufferBinding {
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+	};
+
+	// Resources bound for a draw
+	struct SoftwareShaderContext {
+		// Uniform block name to binding index, set through IDevice::setBufferBinding. Blocks that were never bound use index 0 like GL
+		const std::unordered_map<std::string, uint32_t>* blockBindings = nullptr;
+		// IDevice::registerUniformBlock bindings, for blocks missing from blockBindings
+		const std::unordered_map<std::string, uint32_t>* registeredBlockBindings = nullptr;
+		const SoftwareConstantBufferBinding* constantBuffers = nullptr;
+		const SoftwareTextureBinding* textures = nullptr;
+
+		// Copies the constant buffer bound to the named uniform block into block. Returns false and leaves block untouched when
+		// no buffer is bound or the bound one is too small
+		template<typename T>
+		bool readBlock(const char* blockName, T& block) const {
+			const SoftwareConstantBufferBinding& binding = getBlockBinding(blockName);
+			if (binding.data == nullptr || binding.size < sizeof(T)) {
+				return false;
+			}
+			memcpy(&block, binding.data, sizeof(T));
+			return true;
+		}
+
+		[[nodiscard]] const SoftwareConstantBufferBinding& getBlockBinding(const char* blockName) const;
+	};
+
+	struct SoftwareVertexInput {
+		// Attributes by location, widened to floats. Components missing from the format read as (0, 0, 0, 1) like GL
+		vec4 attributes[k_softwareMaxVertexAttributes];
+		// gl_VertexID and gl_InstanceID
+		uint32_t vertexId = 0;
+		uint32_t instanceId = 0;
+	};
+
+	struct SoftwareVertexOutput {
+		// gl_Position
+		vec4 position;
+		float varyings[k_softwareMaxVaryings];
+	};
+
+	struct SoftwareFragmentInput {
+		// gl_FragCoord, window space pixel centre and depth
+		vec4 fragCoord;
+		// Perspective correct, only the vertex port's getVaryingCount() floats are valid
+		const float* varyings = nullptr;
+	};
+
+	struct SoftwareFragmentOutput {
+		vec4 colour[k_MAX_FRAMEBUFFER_COLOR_ATTACHMENTS];
+	};
+
+	class ISoftwareVertexShader {
+	public:
+		virtual ~ISoftwareVertexShader() = default;
+		// Called on the submitting thread before every draw, reads whatever the port needs out of the bound resources
+		virtual void prepare(const SoftwareShaderContext& context) = 0;
+		// Called from the worker threads, concurrently. Must not modify the port
+		virtual void shade(const SoftwareVertexInput& input, SoftwareVertexOutput& output) const = 0;
+		[[nodiscard]] virtual uint32_t getVaryingCount() const = 0;
+	};
+
+	class ISoftwareFragmentShader {
+	public:
+		virtual ~ISoftwareFragmentShader() = default;
+		virtual void prepare(const SoftwareShaderContext& context) = 0;
+		// Called from the worker threads, concurrently. Returns false to discard the fragment
+		virtual bool shade(const SoftwareFragmentInput& input, SoftwareFragmentOutput& output) const = 0;
+	};
+
+	// Ports of the files under assets/shaders, nullptr when a file has no port
+	std::unique_ptr<ISoftwareVertexShader> createVertexShader(const std::string& sourceName);
+	std::unique_ptr<ISoftwareFragmentShader> createFragmentShader(const std::string& sourceName);
+}
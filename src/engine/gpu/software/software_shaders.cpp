@@ -0,0 +1,874 @@
+#include "software_shader.hpp"
+#include "engine/core.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace gpu::software {
+
+	//
+	// Resources
+	//
+
+	const SoftwareConstantBufferBinding& SoftwareShaderContext::getBlockBinding(const char* blockName) const {
+		static const SoftwareConstantBufferBinding k_unbound = {};
+		uint32_t bindIndex = 0;
+		if (blockBindings != nullptr && blockBindings->find(blockName) != blockBindings->end()) {
+			bindIndex = blockBindings->at(blockName);
+		} else if (registeredBlockBindings != nullptr && registeredBlockBindings->find(blockName) != registeredBlockBindings->end()) {
+			bindIndex = registeredBlockBindings->at(blockName);
+		}
+		return bindIndex < k_softwareMaxConstantBufferBindings ? constantBuffers[bindIndex] : k_unbound;
+	}
+
+	static int32_t wrapTexelCoordinate(int32_t coordinate, int32_t size, TextureWrap wrap) {
+		switch (wrap) {
+		case TextureWrap::Repeat:
+			coordinate %= size;
+			return coordinate < 0 ? coordinate + size : coordinate;
+		case TextureWrap::MirrorRepeat: {
+			int32_t period = size * 2;
+			coordinate %= period;
+			coordinate = coordinate < 0 ? coordinate + period : coordinate;
+			return coordinate < size ? coordinate : period - 1 - coordinate;
+		}
+		default:
+			return std::clamp(coordinate, 0, size - 1);
+		}
+	}
+
+	static vec4 readTexel(const SoftwareSurface& surface, uint32_t x, uint32_t y) {
+		size_t index = (static_cast<size_t>(y) * surface.width + x) * 4;
+		if (surface.isFloat()) {
+			const float* texel = &surface.rgba32f[index];
+			return { texel[0], texel[1], texel[2], texel[3] };
+		}
+		const uint8_t* texel = &surface.rgba8[index];
+		return vec4(texel[0], texel[1], texel[2], texel[3]) * (1.0f / 255.0f);
+	}
+
+	// Texel coordinates are clamped well inside int range first, uvs can be anything
+	static float toTexelSpace(float uv, uint32_t size) {
+		return std::isfinite(uv) ? std::clamp(uv * size, -1e7f, 1e7f) : 0.0f;
+	}
+
+	static vec4 sampleSurface(const SoftwareSurface& surface, const TextureSamplerDesc& sampler, vec2 uv, bool linear) {
+		int32_t width = static_cast<int32_t>(surface.width);
+		int32_t height = static_cast<int32_t>(surface.height);
+		float x = toTexelSpace(uv.x, surface.width);
+		float y = toTexelSpace(uv.y, surface.height);
+		if (!linear) {
+			return readTexel(surface,
+				wrapTexelCoordinate(static_cast<int32_t>(std::floor(x)), width, sampler.wrapX),
+				wrapTexelCoordinate(static_cast<int32_t>(std::floor(y)), height, sampler.wrapY));
+		}
+
+		// Bilinear between the 4 texel centres around uv
+		x -= 0.5f;
+		y -= 0.5f;
+		float x0 = std::floor(x);
+		float y0 = std::floor(y);
+		float tx = x - x0;
+		float ty = y - y0;
+		int32_t left = wrapTexelCoordinate(static_cast<int32_t>(x0), width, sampler.wrapX);
+		int32_t right = wrapTexelCoordinate(static_cast<int32_t>(x0) + 1, width, sampler.wrapX);
+		int32_t bottom = wrapTexelCoordinate(static_cast<int32_t>(y0), height, sampler.wrapY);
+		int32_t top = wrapTexelCoordinate(static_cast<int32_t>(y0) + 1, height, sampler.wrapY);
+		return mix(
+			mix(readTexel(surface, left, bottom), readTexel(surface, right, bottom), tx),
+			mix(readTexel(surface, left, top), readTexel(surface, right, top), tx),
+			ty);
+	}
+
+	vec4 sampleTexture(const SoftwareTextureBinding& binding, vec2 uv, float lod) {
+		if (binding.levels == nullptr || binding.levelCount == 0) {
+			return { 0.0f, 0.0f, 0.0f, 1.0f };
+		}
+
+		// Fragments are shaded one at a time, so there are no derivatives to pick a level from. texture() reads the top level
+		lod = std::clamp(lod + binding.sampler.lodBias, 0.0f, static_cast<float>(binding.levelCount - 1));
+		if (lod <= 0.0f) {
+			return sampleSurface(binding.levels[0], binding.sampler, uv, binding.sampler.magFilter == SamplingMode::Linear);
+		}
+
+		bool linear = binding.sampler.minFilter == SamplingMode::Linear;
+		if (binding.sampler.mipFilter == SamplingMode::Nearest) {
+			return sampleSurface(binding.levels[static_cast<uint32_t>(lod + 0.5f)], binding.sampler, uv, linear);
+		}
+		uint32_t level = static_cast<uint32_t>(lod);
+		uint32_t nextLevel = std::min(level + 1, binding.levelCount - 1);
+		return mix(
+			sampleSurface(binding.levels[level], binding.sampler, uv, linear),
+			sampleSurface(binding.levels[nextLevel], binding.sampler, uv, linear),
+			lod - level);
+	}
+
+	vec4 fetchTexel(const SoftwareTextureBinding& binding, int32_t x, int32_t y, uint32_t level) {
+		if (binding.levels == nullptr || level >= binding.levelCount) {
+			return vec4(0.0f);
+		}
+		const SoftwareSurface& surface = binding.levels[level];
+		if (x < 0 || y < 0 || x >= static_cast<int32_t>(surface.width) || y >= static_cast<int32_t>(surface.height)) {
+			return vec4(0.0f);
+		}
+		return readTexel(surface, x, y);
+	}
+
+	//
+	// Uniform blocks, std140 like the declarations generated from RENDER_UNIFORM_BLOCKS (engine/renderer/uniform_blocks.hpp)
+	//
+
+	struct GeometryBlock {
+		mat4 model;
+		mat4 view;
+		mat4 projection;
+		vec3 cameraPos;
+		float elapsedTime;
+	};
+
+	struct MaterialBlock {
+		vec3 ambient;
+		float roughness;
+		vec3 diffuse;
+		float metallic;
+		vec3 specular;
+		float emissionIntensity;
+		vec3 emissionColour;
+		float glintFactor;
+	};
+
+	constexpr uint32_t k_lightTypeDirectional = 0;
+	constexpr uint32_t k_lightTypePoint = 1;
+	constexpr uint32_t k_lightTypeSpot = 2;
+
+	struct LightData {
+		vec3 position;
+		uint32_t type;
+		vec3 direction;
+		float intensity;
+		vec3 colour;
+		float innerRadius;
+		float outerRadius;
+		float padding[3];
+	};
+
+	struct LightsBlock {
+		LightData lights[4];
+	};
+
+	struct ParticleData {
+		vec3 position;
+		float sizeBegin;
+		vec4 colourBegin;
+		vec4 colourEnd;
+		float sizeEnd;
+		float life;
+		float particleTextureCount;
+		float padding;
+	};
+
+	constexpr uint32_t k_particleBlockSize = 800;
+
+	struct ParticleBlock {
+		ParticleData particles[k_particleBlockSize];
+	};
+
+	struct UpscaleBlock {
+		vec4 fragCoordScale_uvMax;
+	};
+
+	static_assert(sizeof(GeometryBlock) == 208 && sizeof(MaterialBlock) == 64 && sizeof(LightData) == 64 && sizeof(ParticleData) == 64,
+		"Uniform blocks must match their std140 layout");
+
+	//
+	// Shared shader code
+	//
+
+	static inline void writeVaryings(SoftwareVertexOutput& output, uint32_t offset, const vec2& value) {
+		output.varyings[offset + 0] = value.x;
+		output.varyings[offset + 1] = value.y;
+	}
+	static inline void writeVaryings(SoftwareVertexOutput& output, uint32_t offset, const vec3& value) {
+		output.varyings[offset + 0] = value.x;
+		output.varyings[offset + 1] = value.y;
+		output.varyings[offset + 2] = value.z;
+	}
+	static inline void writeVaryings(SoftwareVertexOutput& output, uint32_t offset, const vec4& value) {
+		output.varyings[offset + 0] = value.x;
+		output.varyings[offset + 1] = value.y;
+		output.varyings[offset + 2] = value.z;
+		output.varyings[offset + 3] = value.w;
+	}
+	static inline vec2 readVec2(const float* varyings, uint32_t offset) { return { varyings[offset], varyings[offset + 1] }; }
+	static inline vec3 readVec3(const float* varyings, uint32_t offset) { return { varyings[offset], varyings[offset + 1], varyings[offset + 2] }; }
+	static inline vec4 readVec4(const float* varyings, uint32_t offset) { return { varyings[offset], varyings[offset + 1], varyings[offset + 2], varyings[offset + 3] }; }
+
+	// common.glsl's decodeOctahedralNormal, mesh normals are octahedral encoded
+	static vec3 decodeOctahedralNormal(const vec2& encoded) {
+		vec3 n = vec3(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+		float t = std::max(-n.z, 0.0f);
+		n.x -= n.x >= 0.0f ? t : -t;
+		n.y -= n.y >= 0.0f ? t : -t;
+		return normalize(n);
+	}
+
+	// (left, bottom), (left, top), (right, bottom), (right, bottom), (left, top), (right, top)
+	constexpr vec2 k_quadCorners[6] = {
+		{ -1.0f, -1.0f }, { -1.0f, 1.0f }, { 1.0f, -1.0f },
+		{ 1.0f, -1.0f }, { -1.0f, 1.0f }, { 1.0f, 1.0f },
+	};
+
+	// oit.glsl
+	static void writeFragment(SoftwareFragmentOutput& output, bool weightedBlended, const vec3& premultipliedColour, float alpha, float viewDistance) {
+		if (!weightedBlended) {
+			output.colour[0] = vec4(premultipliedColour, alpha);
+			return;
+		}
+		float weight = alpha * std::clamp(10.0f / (1e-5f + std::pow(viewDistance / 5.0f, 2.0f) + std::pow(viewDistance / 200.0f, 6.0f)), 1e-2f, 3e3f);
+		output.colour[0] = vec4(premultipliedColour * weight, alpha);
+		output.colour[1] = vec4(alpha * weight, 0.0f, 0.0f, 0.0f);
+	}
+
+	// lighting.glsl, from https://google.github.io/filament/Filament.html
+	namespace lighting {
+		constexpr float k_pi = 3.14159265359f;
+
+		static float F_Schlick(float u, float f0, float f90) {
+			return f0 + (f90 - f0) * std::pow(1.0f - u, 5.0f);
+		}
+
+		static float Fd_Burley(float NdotV, float NdotL, float LdotH, float roughness) {
+			float f90 = 0.5f + 2.0f * roughness * LdotH * LdotH;
+			float lightScatter = F_Schlick(NdotL, 1.0f, f90);
+			float viewScatter = F_Schlick(NdotV, 1.0f, f90);
+			return lightScatter * viewScatter * (1.0f / k_pi);
+		}
+
+		static float D_GGX(float NdotH, float a) {
+			float a2 = a * a;
+			float f = (NdotH * NdotH * (a2 - 1.0f)) + 1.0f;
+			return a2 / (k_pi * f * f);
+		}
+
+		static vec3 F_Schlick3(float u, const vec3& f0) {
+			return f0 + (vec3(1.0f) - f0) * std::pow(1.0f - u, 5.0f);
+		}
+
+		static float V_SmithGGXCorrelated(float NdotV, float NdotL, float a) {
+			float a2 = a * a;
+			float GGXL = NdotV * std::sqrt((-NdotL * a2 + NdotL) * NdotL + a2);
+			float GGXV = NdotL * std::sqrt((-NdotV * a2 + NdotV) * NdotV + a2);
+			return 0.5f / (GGXV + GGXL);
+		}
+
+		static vec3 F_SchlickRoughness(float u, const vec3& f0, float roughness) {
+			return f0 + (max(vec3(1.0f - roughness), f0) - f0) * std::pow(1.0f - u, 5.0f);
+		}
+
+		static float getSquareFalloffAttenuation(const vec3& posToLight, float lightInvRadius) {
+			float distanceSquare = dot(posToLight, posToLight);
+			float factor = distanceSquare * lightInvRadius * lightInvRadius;
+			float smoothFactor = std::max(1.0f - factor * factor, 0.0f);
+			return (smoothFactor * smoothFactor) / std::max(distanceSquare, 1e-4f);
+		}
+
+		static float getSpotAngleAttenuation(const vec3& l, const vec3& lightDir, float innerAngle, float outerAngle) {
+			float cosOuter = std::cos(outerAngle);
+			float spotScale = 1.0f / std::max(std::cos(innerAngle) - cosOuter, 1e-4f);
+			float spotOffset = -cosOuter * spotScale;
+
+			float cd = dot(normalize(-lightDir), l);
+			float attenuation = saturate(cd * spotScale + spotOffset);
+			return attenuation * attenuation;
+		}
+
+		static void ComputeLight(const LightData& lightData, const vec3& worldPos, vec3& pLightDir, vec3& pLightColour, float& attenuation) {
+			attenuation = 1.0f;
+			pLightColour = lightData.colour * lightData.intensity;
+			pLightDir = vec3(0.0f, 1.0f, 0.0f);
+
+			if (lightData.type == k_lightTypeDirectional) {
+				attenuation = 1.0f;
+				pLightDir = lightData.direction;
+			}
+			if (lightData.type == k_lightTypePoint) {
+				attenuation = getSquareFalloffAttenuation(worldPos - lightData.position, lightData.outerRadius);
+				pLightDir = lightData.direction;
+			}
+			if (lightData.type == k_lightTypeSpot) {
+				attenuation = getSquareFalloffAttenuation(worldPos - lightData.position, lightData.outerRadius) *
+					getSpotAngleAttenuation(worldPos, lightData.direction, lightData.innerRadius, lightData.outerRadius);
+				pLightDir = lightData.direction;
+			}
+		}
+	}
+
+	//
+	// Vertex shaders
+	//
+
+	// Reads GeometryBuffer and caches the matrix products every vertex would otherwise compute
+	class GeometryVertexShader : public ISoftwareVertexShader {
+	public:
+		void prepare(const SoftwareShaderContext& context) override {
+			context.readBlock("GeometryBuffer", m_geometry);
+			m_modelView = m_geometry.view * m_geometry.model;
+			// Same order of operations as projection * view * model * position, so every port produces the same depth
+			m_modelViewProjection = m_geometry.projection * m_geometry.view * m_geometry.model;
+		}
+
+	protected:
+		GeometryBlock m_geometry = {};
+		mat4 m_modelView = {};
+		mat4 m_modelViewProjection = {};
+	};
+
+	// vert.glsl and classic_vert.glsl. Varyings: worldPos, normal, uv
+	class ForwardVertexShader final : public GeometryVertexShader {
+	public:
+		void shade(const SoftwareVertexInput& input, SoftwareVertexOutput& output) const override {
+			vec4 position = vec4(input.attributes[0].xyz(), 1.0f);
+			output.position = m_modelViewProjection * position;
+			writeVaryings(output, 0, (m_geometry.model * position).xyz());
+			writeVaryings(output, 3, (m_modelView * vec4(decodeOctahedralNormal(input.attributes[1].xy()), 0.0f)).xyz());
+			writeVaryings(output, 6, input.attributes[2].xy());
+		}
+		[[nodiscard]] uint32_t getVaryingCount() const override { return 8; }
+	};
+
+	// depth_prepass_vert.glsl
+	class DepthPrepassVertexShader final : public GeometryVertexShader {
+	public:
+		void shade(const SoftwareVertexInput& input, SoftwareVertexOutput& output) const override {
+			output.position = m_modelViewProjection * vec4(input.attributes[0].xyz(), 1.0f);
+		}
+		[[nodiscard]] uint32_t getVaryingCount() const override { return 0; }
+	};
+
+	// skybox_tex_vert.glsl. Varyings: normal, uv
+	class SkyboxTextureVertexShader final : public GeometryVertexShader {
+	public:
+		void shade(const SoftwareVertexInput& input, SoftwareVertexOutput& output) const override {
+			vec4 position = m_modelViewProjection * vec4(input.attributes[0].xyz(), 1.0f);
+			output.position = vec4(position.xy(), 0.0f, position.w);
+			writeVaryings(output, 0, decodeOctahedralNormal(input.attributes[1].xy()));
+			writeVaryings(output, 3, input.attributes[2].xy());
+		}
+		[[nodiscard]] uint32_t getVaryingCount() const override { return 5; }
+	};
+
+	// particle_vert.glsl. Varyings: worldPos, normal, uvLife, colourBegin, colourEnd
+	class ParticleVertexShader final : public GeometryVertexShader {
+	public:
+		void prepare(const SoftwareShaderContext& context) override {
+			GeometryVertexShader::prepare(context);
+			context.readBlock("ParticleBuffer", *m_particles);
+		}
+
+		void shade(const SoftwareVertexInput& input, SoftwareVertexOutput& output) const override {
+			const ParticleData& particle = m_particles->particles[input.instanceId % k_particleBlockSize];
+			float size = mix(particle.sizeEnd, particle.sizeBegin, particle.life);
+
+			vec3 particlePos = input.attributes[0].xyz() * size + particle.position;
+			// primitive z sort, push particles a hint away based on age
+			particlePos.z -= (1.0f - particle.life) * 0.1f;
+
+			// Billboard, only the translation of the model view matrix is kept
+			vec4 billboardPosition = m_modelView * vec4(0.0f, 0.0f, 0.0f, 1.0f) + vec4(particlePos.x, particlePos.y, 0.0f, 0.0f);
+			output.position = m_geometry.projection * billboardPosition;
+			writeVaryings(output, 0, (m_geometry.model * vec4(particlePos, 1.0f)).xyz());
+			writeVaryings(output, 3, (m_modelView * vec4(decodeOctahedralNormal(input.attributes[1].xy()), 0.0f)).xyz());
+
+			// UVs into the particle atlas
+			int32_t particleTextureCount = static_cast<int32_t>(particle.particleTextureCount);
+			int32_t particleTextureIndex = particleTextureCount > 0 ? static_cast<int32_t>(input.instanceId) % particleTextureCount : 0;
+			int32_t atlasColumns = 1;
+			int32_t atlasRows = 1;
+			calculateAtlasDimensions(particleTextureCount, atlasColumns, atlasRows);
+
+			float uvScaleX = 1.0f / atlasColumns;
+			float uvScaleY = 1.0f / atlasRows;
+			int32_t column = particleTextureIndex % atlasColumns;
+			int32_t row = particleTextureIndex / atlasColumns;
+			vec2 finalUv = input.attributes[2].xy() * vec2(uvScaleX, uvScaleY) + vec2(column * uvScaleX, row * uvScaleY);
+
+			writeVaryings(output, 6, vec3(finalUv, particle.life));
+			writeVaryings(output, 9, particle.colourBegin);
+			writeVaryings(output, 13, particle.colourEnd);
+		}
+		[[nodiscard]] uint32_t getVaryingCount() const override { return 17; }
+
+	private:
+		// Smallest power of two grid the atlas fits in. Unlike the GLSL an empty atlas is a single image, not a division by zero
+		static void calculateAtlasDimensions(int32_t particleTextureCount, int32_t& columns, int32_t& rows) {
+			if (particleTextureCount <= 1) {
+				columns = 1;
+				rows = 1;
+				return;
+			}
+			int32_t size = 1;
+			particleTextureCount--;
+			size |= particleTextureCount >> 1;
+			size |= particleTextureCount >> 2;
+			size |= particleTextureCount >> 4;
+			size |= particleTextureCount >> 8;
+			size |= particleTextureCount >> 16;
+			size++;
+
+			columns = size;
+			rows = size;
+			if (particleTextureCount + 1 <= size * (size / 2)) {
+				columns = size / 2;
+			}
+			columns = std::max(columns, rows);
+		}
+
+		// Too big to keep inline with the port
+		std::unique_ptr<ParticleBlock> m_particles = std::make_unique<ParticleBlock>();
+	};
+
+	// ui_shader_vert.glsl. Varyings: uv, textureTint
+	class UiVertexShader final : public ISoftwareVertexShader {
+	public:
+		void prepare(const SoftwareShaderContext& context) override {}
+
+		void shade(const SoftwareVertexInput& input, SoftwareVertexOutput& output) const override {
+			vec2 corner = k_quadCorners[input.vertexId % 6];
+			const vec4& originAxisX = input.attributes[0];
+			vec2 axisY = input.attributes[1].xy();
+			const vec4& uvRect = input.attributes[2];
+			vec2 position = originAxisX.xy() + corner.x * originAxisX.zw() + corner.y * axisY;
+			output.position = vec4(position, 0.0f, 1.0f);
+			vec2 cornerUv = corner * 0.5f + 0.5f;
+			writeVaryings(output, 0, vec2(mix(uvRect.x, uvRect.z, cornerUv.x), mix(uvRect.y, uvRect.w, cornerUv.y)));
+			writeVaryings(output, 2, input.attributes[3]);
+		}
+		[[nodiscard]] uint32_t getVaryingCount() const override { return 6; }
+	};
+
+	// text_shader_vert.glsl. Varyings: uv, colourForeground, colourOutline, outlineWidth
+	class TextVertexShader final : public ISoftwareVertexShader {
+	public:
+		void prepare(const SoftwareShaderContext& context) override {}
+
+		void shade(const SoftwareVertexInput& input, SoftwareVertexOutput& output) const override {
+			vec2 corner = k_quadCorners[input.vertexId % 6];
+			const vec4& originAxisX = input.attributes[0];
+			const vec4& axisYOutline = input.attributes[1];
+			const vec4& uvRect = input.attributes[2];
+			vec2 position = originAxisX.xy() + corner.x * originAxisX.zw() + corner.y * axisYOutline.xy();
+			output.position = vec4(position, 0.0f, 1.0f);
+			vec2 cornerUv = corner * 0.5f + 0.5f;
+			writeVaryings(output, 0, vec2(mix(uvRect.x, uvRect.z, cornerUv.x), mix(uvRect.y, uvRect.w, cornerUv.y)));
+			writeVaryings(output, 2, input.attributes[3]);
+			writeVaryings(output, 6, input.attributes[4]);
+			output.varyings[10] = axisYOutline.z;
+		}
+		[[nodiscard]] uint32_t getVaryingCount() const override { return 11; }
+	};
+
+	// oit_composite_vert.glsl, fullscreen quad already in clip space
+	class FullscreenVertexShader final : public ISoftwareVertexShader {
+	public:
+		void prepare(const SoftwareShaderContext& context) override {}
+		void shade(const SoftwareVertexInput& input, SoftwareVertexOutput& output) const override {
+			output.position = vec4(input.attributes[0].xy(), 0.0f, 1.0f);
+		}
+		[[nodiscard]] uint32_t getVaryingCount() const override { return 0; }
+	};
+
+	//
+	// Fragment shaders
+	//
+
+	// frag.glsl and frag_oit.glsl
+	class ForwardFragmentShader final : public ISoftwareFragmentShader {
+	public:
+		explicit ForwardFragmentShader(bool weightedBlended) : m_weightedBlended(weightedBlended) {}
+
+		void prepare(const SoftwareShaderContext& context) override {
+			context.readBlock("GeometryBuffer", m_geometry);
+			context.readBlock("MaterialBuffer", m_material);
+			context.readBlock("LightsBuffer", m_lights);
+			m_diffuseTex = context.textures[0];
+			m_metaTex = context.textures[1];
+			m_emissionTex = context.textures[2];
+			m_matcapTex = context.textures[3];
+			m_brdfLutTex = context.textures[4];
+		}
+
+		bool shade(const SoftwareFragmentInput& input, SoftwareFragmentOutput& output) const override {
+			vec3 worldPos = readVec3(input.varyings, 0);
+			vec3 normal = readVec3(input.varyings, 3);
+			vec2 uv = readVec2(input.varyings, 6);
+
+			vec4 albedo = vec4(sampleTexture(m_diffuseTex, uv).rgb(), 1.0f) * vec4(m_material.diffuse, 1.0f);
+			// read metaTex and convert to linear
+			vec4 meta = pow(vec4(sampleTexture(m_metaTex, uv).rgb(), 1.0f), vec4(1.0f / 2.2f));
+			vec4 emissionTexCol = sampleTexture(m_emissionTex, uv);
+			float roughness = meta.y * m_material.roughness;
+			float perceptualRoughness = std::clamp(roughness, 0.01f, 0.99f);
+
+			vec3 iblSpecular;
+			vec3 iblDiffuse = computeIBL(worldPos, albedo.rgb(), normal, perceptualRoughness, iblSpecular);
+
+			vec3 lightContribution = vec3(0.0f);
+			for (const LightData& light : m_lights.lights) {
+				lightContribution += computeLighting(light, worldPos, albedo.rgb(), normal, perceptualRoughness);
+			}
+
+			float glintFac = genGlint(uv) * m_material.glintFactor;
+
+			vec3 finalColor = iblDiffuse * albedo.rgb() +
+				m_material.ambient * iblSpecular +
+				lightContribution + vec3(glintFac) +
+				emissionTexCol.rgb() * m_material.emissionColour * m_material.emissionIntensity;
+
+			writeFragment(output, m_weightedBlended, finalColor * albedo.w, albedo.w, length(m_geometry.cameraPos - worldPos));
+			return true;
+		}
+
+	private:
+		vec3 computeLighting(const LightData& lightData, const vec3& worldPos, const vec3& albedo, const vec3& normal, float perceptualRoughness) const {
+			vec3 n = normalize(normal);
+			vec3 l = normalize(lightData.direction);
+			vec3 v = normalize(m_geometry.cameraPos - worldPos);
+			vec3 h = normalize(v + l);
+
+			float lightAttenuation = 1.0f;
+			vec3 lightColour = vec3(0.0f);
+			// Overwrites l like the GLSL does, h keeps the normalised direction
+			lighting::ComputeLight(lightData, worldPos, l, lightColour, lightAttenuation);
+
+			float NdotL = saturate(dot(n, l));
+			float NdotV = saturate(dot(n, v));
+			float LdotH = saturate(dot(l, h));
+			float HdotV = saturate(dot(h, v));
+			float NdotH = saturate(dot(n, h));
+
+			vec3 F0 = max(albedo, vec3(0.04f));
+
+			float Fd = lighting::Fd_Burley(NdotV, NdotL, LdotH, perceptualRoughness);
+
+			vec3 F = lighting::F_Schlick3(HdotV, F0);
+			float NDF = lighting::D_GGX(NdotH, perceptualRoughness);
+			float G = lighting::V_SmithGGXCorrelated(NdotV, NdotL, perceptualRoughness);
+			vec3 Fr = (NDF * G * F) / (4.0f * NdotV * NdotL + 0.001f);
+
+			float finalAtten = lightAttenuation * NdotL;
+			return albedo * Fd * lightColour * finalAtten + Fr * lightColour * finalAtten;
+		}
+
+		vec4 sampleMatcap(const vec3& normal, float roughness) const {
+			const float k_maxReflectionLod = 8.0f; // log2(matcapResolution)
+			float specularLevel = std::clamp(roughness * k_maxReflectionLod, 0.0f, k_maxReflectionLod);
+
+			const float k_matcapBorder = 0.43f;
+			vec2 matcapUv = normal.xy() * k_matcapBorder + vec2(0.5f);
+			return sampleTexture(m_matcapTex, matcapUv, specularLevel);
+		}
+
+		vec3 computeIBL(const vec3& worldPos, const vec3& albedo, const vec3& normal, float roughness, vec3& specular) const {
+			vec3 n = normalize(normal);
+			vec3 v = normalize(m_geometry.cameraPos - worldPos);
+			vec3 r = reflect(-v, n);
+
+			float NdotV = saturate(dot(n, v));
+
+			vec3 F0 = max(albedo, vec3(0.04f));
+			vec3 kS = lighting::F_SchlickRoughness(NdotV, F0, roughness);
+			vec3 kD = 1.0f - kS;
+			vec4 irradiance = sampleMatcap(n, 0.9f);
+			vec3 ambient = kD * irradiance.rgb();
+
+			// undo sRGB to read the linear brdf lut
+			vec4 brdf = sampleTexture(m_brdfLutTex, vec2(NdotV, roughness), 0.0f);
+			brdf.x = std::pow(brdf.x, 1.0f / 2.2f);
+			brdf.y = std::pow(brdf.y, 1.0f / 2.2f);
+
+			vec4 iblSpecular = sampleMatcap(r, roughness);
+			specular = iblSpecular.rgb() * (kS * brdf.x + brdf.y);
+			return ambient;
+		}
+
+		float genGlint(vec2 uv) const {
+			const float angle = -45.0f * (k_pi / 180.0f);
+			float s = std::sin(angle);
+			float c = std::cos(angle);
+
+			uv.y += m_geometry.elapsedTime * 2.0f;
+			// (uv * mat2(c, -s, s, c)).y
+			float samplePt = uv.x * s + uv.y * c;
+			return std::pow(std::clamp(std::sin(samplePt * 3.0f) - 0.75f + std::sin(samplePt * 4.0f) - 0.75f, 0.0f, 1.0f) * 2.2179342161f, 1.4f);
+		}
+
+		static constexpr float k_pi = lighting::k_pi;
+
+		bool m_weightedBlended = false;
+		GeometryBlock m_geometry = {};
+		MaterialBlock m_material = {};
+		LightsBlock m_lights = {};
+		SoftwareTextureBinding m_diffuseTex;
+		SoftwareTextureBinding m_metaTex;
+		SoftwareTextureBinding m_emissionTex;
+		SoftwareTextureBinding m_matcapTex;
+		SoftwareTextureBinding m_brdfLutTex;
+	};
+
+	// classic_frag.glsl
+	class ClassicFragmentShader final : public ISoftwareFragmentShader {
+	public:
+		void prepare(const SoftwareShaderContext& context) override {
+			context.readBlock("MaterialBuffer", m_material);
+			m_diffuseTex = context.textures[0];
+		}
+
+		bool shade(const SoftwareFragmentInput& input, SoftwareFragmentOutput& output) const override {
+			vec4 albedo = vec4(sampleTexture(m_diffuseTex, readVec2(input.varyings, 6)).rgb(), 1.0f) * vec4(m_material.diffuse, 1.0f);
+			output.colour[0] = albedo;
+			return true;
+		}
+
+	private:
+		MaterialBlock m_material = {};
+		SoftwareTextureBinding m_diffuseTex;
+	};
+
+	// depth_prepass_frag.glsl, colour writes are masked off by the pipeline state
+	class DepthOnlyFragmentShader final : public ISoftwareFragmentShader {
+	public:
+		void prepare(const SoftwareShaderContext& context) override {}
+		bool shade(const SoftwareFragmentInput& input, SoftwareFragmentOutput& output) const override { return true; }
+	};
+
+	// skybox_tex_frag.glsl
+	class SkyboxTextureFragmentShader final : public ISoftwareFragmentShader {
+	public:
+		void prepare(const SoftwareShaderContext& context) override {
+			context.readBlock("MaterialBuffer", m_material);
+			m_brickTex = context.textures[0];
+		}
+
+		bool shade(const SoftwareFragmentInput& input, SoftwareFragmentOutput& output) const override {
+			vec4 albedo = vec4(sampleTexture(m_brickTex, readVec2(input.varyings, 3)).rgb(), 1.0f);
+			float atten = saturate(dot(readVec3(input.varyings, 0), normalize(vec3(0.0f, 1.0f, 2.0f))));
+			output.colour[0] = albedo * atten + vec4(m_material.ambient, 0.0f);
+			return true;
+		}
+
+	private:
+		MaterialBlock m_material = {};
+		SoftwareTextureBinding m_brickTex;
+	};
+
+	// particle_frag.glsl and particle_oit_frag.glsl
+	class ParticleFragmentShader final : public ISoftwareFragmentShader {
+	public:
+		explicit ParticleFragmentShader(bool weightedBlended) : m_weightedBlended(weightedBlended) {}
+
+		void prepare(const SoftwareShaderContext& context) override {
+			context.readBlock("GeometryBuffer", m_geometry);
+			context.readBlock("MaterialBuffer", m_material);
+			m_diffuseTex = context.textures[0];
+		}
+
+		bool shade(const SoftwareFragmentInput& input, SoftwareFragmentOutput& output) const override {
+			vec3 worldPos = readVec3(input.varyings, 0);
+			vec3 uvLife = readVec3(input.varyings, 6);
+			vec4 colourBegin = readVec4(input.varyings, 9);
+			vec4 colourEnd = readVec4(input.varyings, 13);
+
+			vec4 colourBlend = mix(colourEnd, colourBegin, uvLife.z);
+			// premultiplied alpha
+			colourBlend = vec4(colourBlend.rgb() * colourBlend.w, colourBlend.w);
+
+			vec4 albedo = vec4(sampleTexture(m_diffuseTex, uvLife.xy()).rgb(), 1.0f) * vec4(m_material.diffuse, 1.0f) * colourBlend;
+			writeFragment(output, m_weightedBlended, albedo.rgb(), albedo.w, length(m_geometry.cameraPos - worldPos));
+			return true;
+		}
+
+	private:
+		bool m_weightedBlended = false;
+		GeometryBlock m_geometry = {};
+		MaterialBlock m_material = {};
+		SoftwareTextureBinding m_diffuseTex;
+	};
+
+	// ui_shader_frag.glsl
+	class UiFragmentShader final : public ISoftwareFragmentShader {
+	public:
+		void prepare(const SoftwareShaderContext& context) override {
+			m_uiTex = context.textures[0];
+		}
+
+		bool shade(const SoftwareFragmentInput& input, SoftwareFragmentOutput& output) const override {
+			vec4 textureTint = readVec4(input.varyings, 2);
+			vec4 textureColour = sampleTexture(m_uiTex, readVec2(input.varyings, 0));
+			// premultipled colour out
+			output.colour[0] = vec4(textureTint.rgb() * textureTint.w * textureColour.rgb() * textureColour.w, textureColour.w * textureTint.w);
+			return true;
+		}
+
+	private:
+		SoftwareTextureBinding m_uiTex;
+	};
+
+	// text_shader_frag.glsl
+	class TextFragmentShader final : public ISoftwareFragmentShader {
+	public:
+		void prepare(const SoftwareShaderContext& context) override {
+			m_msdfTex = context.textures[0];
+		}
+
+		bool shade(const SoftwareFragmentInput& input, SoftwareFragmentOutput& output) const override {
+			vec4 colourForeground = readVec4(input.varyings, 2);
+			vec4 colourOutline = readVec4(input.varyings, 6);
+			float outlineWidth = input.varyings[10];
+
+			vec3 msdfRaw = sampleTexture(m_msdfTex, readVec2(input.varyings, 0)).rgb();
+			float sd = std::max(std::min(msdfRaw.x, msdfRaw.y), std::min(std::max(msdfRaw.x, msdfRaw.y), msdfRaw.z));
+			// given a 32x32 distance field with a pixel range of 2 and a render resolution of 72x72
+			const float screenPxRange = 72.0f / 32.0f * 2.0f;
+			float screenPxDistance = screenPxRange * (sd - 0.5f);
+			float opacity = saturate(screenPxDistance + 0.5f);
+			float outlineOpacity = saturate(screenPxDistance + 0.5f + outlineWidth);
+
+			vec4 textColor = vec4(colourForeground.rgb() * opacity * colourForeground.w, opacity * colourForeground.w);
+			vec4 outlineColor = vec4(colourOutline.rgb() * outlineOpacity * colourOutline.w, outlineOpacity * colourOutline.w);
+			output.colour[0] = mix(outlineColor, textColor, opacity);
+			return true;
+		}
+
+	private:
+		SoftwareTextureBinding m_msdfTex;
+	};
+
+	// oit_composite_frag.glsl
+	class OitCompositeFragmentShader final : public ISoftwareFragmentShader {
+	public:
+		void prepare(const SoftwareShaderContext& context) override {
+			m_accumulationTex = context.textures[0];
+			m_weightTex = context.textures[1];
+		}
+
+		bool shade(const SoftwareFragmentInput& input, SoftwareFragmentOutput& output) const override {
+			int32_t x = static_cast<int32_t>(input.fragCoord.x);
+			int32_t y = static_cast<int32_t>(input.fragCoord.y);
+			vec4 accumulation = fetchTexel(m_accumulationTex, x, y);
+			float revealage = accumulation.w;
+			if (revealage >= 1.0f) {
+				// Nothing transparent covers this pixel
+				return false;
+			}
+			float weightSum = fetchTexel(m_weightTex, x, y).x;
+			output.colour[0] = vec4(accumulation.rgb() / std::max(weightSum, 1e-5f), 1.0f - revealage);
+			return true;
+		}
+
+	private:
+		SoftwareTextureBinding m_accumulationTex;
+		SoftwareTextureBinding m_weightTex;
+	};
+
+	// ui_canvas_composite_frag.glsl
+	class UiCanvasCompositeFragmentShader final : public ISoftwareFragmentShader {
+	public:
+		void prepare(const SoftwareShaderContext& context) override {
+			m_canvasTex = context.textures[0];
+		}
+
+		bool shade(const SoftwareFragmentInput& input, SoftwareFragmentOutput& output) const override {
+			vec4 canvasColour = fetchTexel(m_canvasTex, static_cast<int32_t>(input.fragCoord.x), static_cast<int32_t>(input.fragCoord.y));
+			if (canvasColour.w <= 0.0f) {
+				return false;
+			}
+			output.colour[0] = canvasColour;
+			return true;
+		}
+
+	private:
+		SoftwareTextureBinding m_canvasTex;
+	};
+
+	// scene_upscale_frag.glsl
+	class SceneUpscaleFragmentShader final : public ISoftwareFragmentShader {
+	public:
+		void prepare(const SoftwareShaderContext& context) override {
+			context.readBlock("UpscaleBuffer", m_upscale);
+			m_sceneTex = context.textures[0];
+		}
+
+		bool shade(const SoftwareFragmentInput& input, SoftwareFragmentOutput& output) const override {
+			vec2 uv = min(input.fragCoord.xy() * m_upscale.fragCoordScale_uvMax.xy(), m_upscale.fragCoordScale_uvMax.zw());
+			output.colour[0] = vec4(sampleTexture(m_sceneTex, uv).rgb(), 1.0f);
+			return true;
+		}
+
+	private:
+		UpscaleBlock m_upscale = {};
+		SoftwareTextureBinding m_sceneTex;
+	};
+
+	//
+	// Lookup
+	//
+
+	std::unique_ptr<ISoftwareVertexShader> createVertexShader(const std::string& sourceName) {
+		if (sourceName == "vert.glsl" || sourceName == "classic_vert.glsl") {
+			return std::make_unique<ForwardVertexShader>();
+		}
+		if (sourceName == "depth_prepass_vert.glsl") {
+			return std::make_unique<DepthPrepassVertexShader>();
+		}
+		if (sourceName == "skybox_tex_vert.glsl") {
+			return std::make_unique<SkyboxTextureVertexShader>();
+		}
+		if (sourceName == "particle_vert.glsl") {
+			return std::make_unique<ParticleVertexShader>();
+		}
+		if (sourceName == "ui_shader_vert.glsl") {
+			return std::make_unique<UiVertexShader>();
+		}
+		if (sourceName == "text_shader_vert.glsl") {
+			return std::make_unique<TextVertexShader>();
+		}
+		if (sourceName == "oit_composite_vert.glsl") {
+			return std::make_unique<FullscreenVertexShader>();
+		}
+		return nullptr;
+	}
+
+	std::unique_ptr<ISoftwareFragmentShader> createFragmentShader(const std::string& sourceName) {
+		if (sourceName == "frag.glsl" || sourceName == "frag_oit.glsl") {
+			return std::make_unique<ForwardFragmentShader>(sourceName == "frag_oit.glsl");
+		}
+		if (sourceName == "classic_frag.glsl") {
+			return std::make_unique<ClassicFragmentShader>();
+		}
+		if (sourceName == "depth_prepass_frag.glsl") {
+			return std::make_unique<DepthOnlyFragmentShader>();
+		}
+		if (sourceName == "skybox_tex_frag.glsl") {
+			return std::make_unique<SkyboxTextureFragmentShader>();
+		}
+		if (sourceName == "particle_frag.glsl" || sourceName == "particle_oit_frag.glsl") {
+			return std::make_unique<ParticleFragmentShader>(sourceName == "particle_oit_frag.glsl");
+		}
+		if (sourceName == "ui_shader_frag.glsl") {
+			return std::make_unique<UiFragmentShader>();
+		}
+		if (sourceName == "text_shader_frag.glsl") {
+			return std::make_unique<TextFragmentShader>();
+		}
+		if (sourceName == "oit_composite_frag.glsl") {
+			return std::make_unique<OitCompositeFragmentShader>();
+		}
+		if (sourceName == "ui_canvas_composite_frag.glsl") {
+			return std::make_unique<UiCanvasCompositeFragmentShader>();
+		}
+		if (sourceName == "scene_upscale_frag.glsl") {
+			return std::make_unique<SceneUpscaleFragmentShader>();
+		}
+		return nullptr;
+	}
+}
@@ -0,0 +1,973 @@
+#include "softwaredevice.hpp"
+#include "engine/core.hpp"
+#include "engine/log.hpp"
+
+#include <stb_image.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+
+namespace gpu::software {
+
+	//
+	// Objects
+	//
+
+	SoftwareBuffer::SoftwareBuffer(gpu::BufferDesc bufferDesc, GpuPtr pointer, std::shared_ptr<SoftwareLiveObjects> liveObjects)
+		: m_bufferDesc(bufferDesc), m_pointer(pointer), m_liveObjects(std::move(liveObjects)) {
+		m_liveObjects->objects.insert(static_cast<const IBuffer*>(this));
+	}
+
+	SoftwareBuffer::~SoftwareBuffer() {
+		m_liveObjects->objects.erase(static_cast<const IBuffer*>(this));
+	}
+
+	SoftwareInputLayout::SoftwareInputLayout(GpuPtr pointer, std::shared_ptr<SoftwareLiveObjects> liveObjects)
+		: m_pointer(pointer), m_liveObjects(std::move(liveObjects)) {
+		m_liveObjects->objects.insert(static_cast<const IInputLayout*>(this));
+	}
+
+	SoftwareInputLayout::~SoftwareInputLayout() {
+		m_liveObjects->objects.erase(static_cast<const IInputLayout*>(this));
+	}
+
+	SoftwareTexture::SoftwareTexture(TextureDesc desc, GpuPtr pointer, std::shared_ptr<SoftwareLiveObjects> liveObjects)
+		: m_desc(desc), m_pointer(pointer), m_liveObjects(std::move(liveObjects)) {
+		m_liveObjects->objects.insert(static_cast<const ITexture*>(this));
+	}
+
+	SoftwareTexture::~SoftwareTexture() {
+		m_liveObjects->objects.erase(static_cast<const ITexture*>(this));
+	}
+
+	SoftwareTextureSampler::SoftwareTextureSampler(TextureSamplerDesc desc, GpuPtr pointer, std::shared_ptr<SoftwareLiveObjects> liveObjects)
+		: m_desc(desc), m_pointer(pointer), m_liveObjects(std::move(liveObjects)) {
+		m_liveObjects->objects.insert(static_cast<const ITextureSampler*>(this));
+	}
+
+	SoftwareTextureSampler::~SoftwareTextureSampler() {
+		m_liveObjects->objects.erase(static_cast<const ITextureSampler*>(this));
+	}
+
+	SoftwareFramebuffer::SoftwareFramebuffer(FramebufferDesc desc, GpuPtr pointer, std::shared_ptr<SoftwareLiveObjects> liveObjects)
+		: m_desc(desc), m_pointer(pointer), m_liveObjects(std::move(liveObjects)) {
+		m_liveObjects->objects.insert(static_cast<const IFramebuffer*>(this));
+	}
+
+	SoftwareFramebuffer::~SoftwareFramebuffer() {
+		m_liveObjects->objects.erase(static_cast<const IFramebuffer*>(this));
+	}
+
+	SoftwareShader::SoftwareShader(ShaderDesc shaderDesc, GpuPtr pointer, std::shared_ptr<SoftwareLiveObjects> liveObjects)
+		: m_shaderDesc(shaderDesc), m_pointer(pointer), m_liveObjects(std::move(liveObjects)) {
+		m_liveObjects->objects.insert(static_cast<const IShader*>(this));
+	}
+
+	SoftwareShader::~SoftwareShader() {
+		m_liveObjects->objects.erase(static_cast<const IShader*>(this));
+	}
+
+	SoftwareBlendState::SoftwareBlendState(BlendStateDesc blendStateDesc, GpuPtr pointer, std::shared_ptr<SoftwareLiveObjects> liveObjects)
+		: m_blendStateDesc(blendStateDesc), m_pointer(pointer), m_liveObjects(std::move(liveObjects)) {
+		m_liveObjects->objects.insert(static_cast<const IBlendState*>(this));
+	}
+
+	SoftwareBlendState::~SoftwareBlendState() {
+		m_liveObjects->objects.erase(static_cast<const IBlendState*>(this));
+	}
+
+	SoftwarePipeline::SoftwarePipeline(PipelineDesc pipelineDesc, std::shared_ptr<SoftwareLiveObjects> liveObjects)
+		: m_pipelineDesc(pipelineDesc), m_liveObjects(std::move(liveObjects)) {
+		m_liveObjects->objects.insert(static_cast<const IPipeline*>(this));
+	}
+
+	SoftwarePipeline::~SoftwarePipeline() {
+		m_liveObjects->objects.erase(static_cast<const IPipeline*>(this));
+	}
+
+	//
+	// Format helpers
+	//
+
+	static size_t getIndexSize(gpu::GpuFormat format) {
+		switch (format) {
+		case gpu::GpuFormat::Uint8_TYPELESS:
+			return 1;
+		case gpu::GpuFormat::Uint16_TYPELESS:
+			return 2;
+		case gpu::GpuFormat::Uint32_TYPELESS:
+			return 4;
+		default:
+			return 0;
+		}
+	}
+
+	static uint32_t readIndex(const uint8_t* data, size_t indexSize) {
+		switch (indexSize) {
+		case 1:
+			return data[0];
+		case 2: {
+			uint16_t index;
+			memcpy(&index, data, sizeof(index));
+			return index;
+		}
+		default: {
+			uint32_t index;
+			memcpy(&index, data, sizeof(index));
+			return index;
+		}
+		}
+	}
+
+	// Size in bytes of a vertex attribute, see getGlFormat for how GL reads each format
+	static size_t getAttributeSize(gpu::GpuFormat format) {
+		switch (format) {
+		case GpuFormat::Uint8_TYPELESS:
+		case GpuFormat::Int8_TYPELESS:
+			return 1;
+		case GpuFormat::Uint16_TYPELESS:
+		case GpuFormat::Int16_TYPELESS:
+			return 2;
+		case GpuFormat::Uint32_TYPELESS:
+		case GpuFormat::Int32_TYPELESS:
+		case GpuFormat::R8_UNORM:
+		case GpuFormat::R8_TYPELESS:
+		case GpuFormat::RG16_FLOAT:
+		case GpuFormat::RG16_SNORM:
+			return 4;
+		case GpuFormat::RG8_UNORM:
+		case GpuFormat::RG8_TYPELESS:
+		case GpuFormat::RGBA16_UNORM:
+		case GpuFormat::RGBA16_SNORM:
+			return 8;
+		case GpuFormat::RGB8_UNORM:
+		case GpuFormat::RGB8_TYPELESS:
+			return 12;
+		case GpuFormat::RGBA8_UNORM:
+		case GpuFormat::RGBA8_TYPELESS:
+			return 16;
+		default:
+			return 0;
+		}
+	}
+
+	template<typename T>
+	static float readScalar(const uint8_t* data) {
+		T value;
+		memcpy(&value, data, sizeof(T));
+		return static_cast<float>(value);
+	}
+
+	static float halfToFloat(uint16_t half) {
+		const uint32_t sign = uint32_t(half & 0x8000) << 16;
+		const uint32_t exponent = (half >> 10) & 0x1F;
+		const uint32_t mantissa = half & 0x3FF;
+		if (exponent == 0) {
+			// Zero or denormal
+			const float value = std::ldexp(float(mantissa), -24);
+			return sign != 0 ? -value : value;
+		}
+		uint32_t bits = sign | (mantissa << 13);
+		bits |= exponent == 0x1F ? 0x7F800000 : (exponent + 112) << 23;
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	// Components missing from the format keep GL's defaults of (0, 0, 0, 1)
+	static vec4 readAttribute(gpu::GpuFormat format, const uint8_t* data) {
+		vec4 value = { 0.0f, 0.0f, 0.0f, 1.0f };
+		float* components = &value.x;
+		switch (format) {
+		case GpuFormat::Uint8_TYPELESS:
+			value.x = data[0];
+			break;
+		case GpuFormat::Uint16_TYPELESS:
+			value.x = readScalar<uint16_t>(data);
+			break;
+		case GpuFormat::Uint32_TYPELESS:
+			value.x = readScalar<uint32_t>(data);
+			break;
+		case GpuFormat::Int8_TYPELESS:
+			value.x = static_cast<int8_t>(data[0]);
+			break;
+		case GpuFormat::Int16_TYPELESS:
+			value.x = readScalar<int16_t>(data);
+			break;
+		case GpuFormat::Int32_TYPELESS:
+			value.x = readScalar<int32_t>(data);
+			break;
+		case GpuFormat::RGBA16_UNORM:
+			for (uint32_t i = 0; i < 4; i++) {
+				components[i] = readScalar<uint16_t>(data + i * sizeof(uint16_t)) * (1.0f / 65535.0f);
+			}
+			break;
+		case GpuFormat::RG16_FLOAT:
+			for (uint32_t i = 0; i < 2; i++) {
+				uint16_t half;
+				memcpy(&half, data + i * sizeof(uint16_t), sizeof(half));
+				components[i] = halfToFloat(half);
+			}
+			break;
+		case GpuFormat::RG16_SNORM:
+		case GpuFormat::RGBA16_SNORM:
+			for (uint32_t i = 0; i < (format == GpuFormat::RG16_SNORM ? 2U : 4U); i++) {
+				// -32768 and -32767 both read as -1
+				components[i] = std::max(readScalar<int16_t>(data + i * sizeof(int16_t)) * (1.0f / 32767.0f), -1.0f);
+			}
+			break;
+		default:
+			// Float vectors
+			memcpy(components, data, getAttributeSize(format));
+			break;
+		}
+		return value;
+	}
+
+	static bool isFixedPointFormat(gpu::TextureFormat format) {
+		return format != TextureFormat::RGBA16F && format != TextureFormat::R16F && format != TextureFormat::R11G11B10;
+	}
+
+	static void allocateSurface(SoftwareSurface& surface, uint32_t width, uint32_t height) {
+		surface.width = width;
+		surface.height = height;
+		surface.rgba8.clear();
+		surface.rgba32f.assign(static_cast<size_t>(width) * height * 4, 0.0f);
+	}
+
+	// Box filters level into the next one down, like glGenerateMipmap
+	static SoftwareSurface downsample(const SoftwareSurface& level) {
+		SoftwareSurface result;
+		result.width = std::max(level.width / 2, 1u);
+		result.height = std::max(level.height / 2, 1u);
+		result.rgba8.resize(static_cast<size_t>(result.width) * result.height * 4);
+		for (uint32_t y = 0; y < result.height; y++) {
+			uint32_t y0 = std::min(y * 2, level.height - 1);
+			uint32_t y1 = std::min(y * 2 + 1, level.height - 1);
+			for (uint32_t x = 0; x < result.width; x++) {
+				uint32_t x0 = std::min(x * 2, level.width - 1);
+				uint32_t x1 = std::min(x * 2 + 1, level.width - 1);
+				for (uint32_t channel = 0; channel < 4; channel++) {
+					uint32_t sum =
+						level.rgba8[(static_cast<size_t>(y0) * level.width + x0) * 4 + channel] +
+						level.rgba8[(static_cast<size_t>(y0) * level.width + x1) * 4 + channel] +
+						level.rgba8[(static_cast<size_t>(y1) * level.width + x0) * 4 + channel] +
+						level.rgba8[(static_cast<size_t>(y1) * level.width + x1) * 4 + channel];
+					result.rgba8[(static_cast<size_t>(y) * result.width + x) * 4 + channel] = static_cast<uint8_t>((sum + 2) / 4);
+				}
+			}
+		}
+		return result;
+	}
+
+	static double getMilliseconds() {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	//
+	// Device
+	//
+
+	SoftwareDevice::SoftwareDevice()
+		: m_liveObjects(std::make_shared<SoftwareLiveObjects>()),
+		m_threadCount(std::max(std::thread::hardware_concurrency(), 1u)),
+		m_rasterizer(m_threadCount) {
+		// Textures are stored bottom row first, like GL
+		stbi_set_flip_vertically_on_load(true);
+		resizeBackbuffer(1, 1);
+		LOG_INFO("Created software device, rendering on {} threads", m_threadCount);
+	}
+
+	SoftwareDevice::~SoftwareDevice() {
+		LOG_INFO("Software device destroyed");
+	}
+
+	bool SoftwareDevice::isLive(const void* object) const {
+		return object != nullptr && m_liveObjects->objects.contains(object);
+	}
+
+	void SoftwareDevice::resizeBackbuffer(uint32_t width, uint32_t height) {
+		ASSERT(width > 0 && height > 0);
+		m_backbuffer.width = width;
+		m_backbuffer.height = height;
+		m_backbuffer.colourCount = 1;
+		m_backbuffer.fixedPoint[0] = true;
+		allocateSurface(m_backbuffer.colour[0][0], width, height);
+		m_backbuffer.depth.assign(static_cast<size_t>(width) * height, 0.0f);
+	}
+
+	bool SoftwareDevice::writeBackbufferImage(const std::string& path) const {
+		FILE* file = fopen(path.c_str(), "wb");
+		if (file == nullptr) {
+			LOG_ERROR("Failed to open \"{}\" for writing the backbuffer", path);
+			return false;
+		}
+
+		const SoftwareSurface& surface = m_backbuffer.colour[0][0];
+		fprintf(file, "P6\n%u %u\n255\n", surface.width, surface.height);
+		std::vector<uint8_t> row(static_cast<size_t>(surface.width) * 3);
+		// Rows are stored bottom to top, images go top to bottom
+		for (uint32_t y = surface.height; y-- > 0;) {
+			const float* pixels = &surface.rgba32f[static_cast<size_t>(y) * surface.width * 4];
+			for (uint32_t x = 0; x < surface.width; x++) {
+				for (uint32_t channel = 0; channel < 3; channel++) {
+					row[x * 3 + channel] = static_cast<uint8_t>(std::clamp(pixels[x * 4 + channel], 0.0f, 1.0f) * 255.0f + 0.5f);
+				}
+			}
+			fwrite(row.data(), 1, row.size(), file);
+		}
+		bool succeeded = ferror(file) == 0;
+		fclose(file);
+		if (succeeded) {
+			LOG_INFO("Wrote the backbuffer to \"{}\"", path);
+		}
+		return succeeded;
+	}
+
+	void SoftwareDevice::setViewport(const Rect viewportRect) {
+		ASSERT(viewportRect.right >= viewportRect.left && viewportRect.bottom >= viewportRect.top);
+		m_viewport = viewportRect;
+	}
+
+	void SoftwareDevice::setScissor(bool enabled, const Rect scissorRect) {
+		m_scissorEnabled = enabled;
+		if (enabled) {
+			m_scissor = scissorRect;
+		}
+	}
+
+	InputLayoutHandle SoftwareDevice::createInputLayout(const VertexAttributeDesc* desc, uint32_t attributeCount) {
+		SoftwareInputLayout* inputLayout = new SoftwareInputLayout(m_nextObjectId++, m_liveObjects);
+		for (uint32_t i = 0; i < attributeCount; i++) {
+			ASSERT(desc[i].format != GpuFormat::Unknown);
+			ASSERT(desc[i].bufferIndex < k_softwareMaxVertexAttributes);
+		}
+		inputLayout->attributes.assign(desc, desc + attributeCount);
+		return InputLayoutHandle::Create(inputLayout);
+	}
+
+	ShaderHandle SoftwareDevice::makeShader(const ShaderDesc shaderDesc) {
+		// The source is only valid for the duration of the call, and the ports don't need it
+		ShaderDesc desc = shaderDesc;
+		desc.VS.byteCode = nullptr;
+		desc.PS.byteCode = nullptr;
+		desc.binary = nullptr;
+
+		SoftwareShader* shader = new SoftwareShader(desc, m_nextObjectId++, m_liveObjects);
+		shader->m_vertexShader = createVertexShader(desc.VS.sourceName);
+		shader->m_fragmentShader = createFragmentShader(desc.PS.sourceName);
+		if (shader->m_vertexShader == nullptr || shader->m_fragmentShader == nullptr) {
+			LOG_WARNING("Shader \"{}\" ({}, {}) has no software implementation, draws with it will be skipped",
+				desc.debugName, desc.VS.sourceName, desc.PS.sourceName);
+		}
+		return ShaderHandle::Create(shader);
+	}
+
+	PipelineHandle SoftwareDevice::makePipeline(const PipelineDesc pipelineDesc) {
+		ASSERT(pipelineDesc.shader != nullptr);
+		ASSERT(pipelineDesc.inputLayout != nullptr);
+		return PipelineHandle::Create(new SoftwarePipeline(pipelineDesc, m_liveObjects));
+	}
+
+	std::string SoftwareDevice::getShaderBinaryTag() const {
+		return "";
+	}
+
+	bool SoftwareDevice::getShaderBinary(IShader* shader, ShaderBinary& outBinary) {
+		return false;
+	}
+
+	//
+	// Buffers
+	//
+
+	BufferHandle SoftwareDevice::makeBuffer(const BufferDesc bufferDesc) {
+		return BufferHandle::Create(new SoftwareBuffer(bufferDesc, m_nextObjectId++, m_liveObjects));
+	}
+
+	void SoftwareDevice::writeBuffer(IBuffer* handle, size_t size, const void* data) {
+		ASSERT(handle != nullptr);
+		ASSERT(size > 0);
+		SoftwareBuffer* buffer = static_cast<SoftwareBuffer*>(handle);
+		// Constant buffers and readback targets may be allocated without initial data
+		buffer->m_data.resize(size);
+		if (data != nullptr) {
+			memcpy(buffer->m_data.data(), data, size);
+		} else {
+			std::fill(buffer->m_data.begin(), buffer->m_data.end(), 0);
+		}
+	}
+
+	void SoftwareDevice::mapBuffer(IBuffer* handle, uint32_t offset, size_t length, MapAccessFlags accessFlags, void** mappedDataPtr) {
+		ASSERT(handle != nullptr);
+		ASSERT(mappedDataPtr != nullptr);
+		SoftwareBuffer* buffer = static_cast<SoftwareBuffer*>(handle);
+		if (offset + length > buffer->m_data.size()) {
+			LOG_ERROR("Mapped range {} + {} is past the end of buffer \"{}\" ({} bytes)", offset, length, buffer->getDesc().debugName, buffer->m_data.size());
+			*mappedDataPtr = nullptr;
+			return;
+		}
+		// Draws run synchronously, so the memory is never in use when it is handed out
+		*mappedDataPtr = buffer->m_data.data() + offset;
+	}
+
+	void SoftwareDevice::unmapBuffer(IBuffer* buffer) {
+		ASSERT(buffer != nullptr);
+	}
+
+	// Vertex and index buffers are passed with every draw, there's no binding to track
+	void SoftwareDevice::bindBuffer(IBuffer* buffer) {
+		ASSERT(buffer != nullptr);
+	}
+
+	void SoftwareDevice::unbindBuffer(IBuffer* buffer) {
+		ASSERT(buffer != nullptr);
+	}
+
+	void SoftwareDevice::setConstantBuffer(IBuffer* buffer, uint32_t bindIndex) {
+		ASSERT(buffer != nullptr);
+		ASSERT(buffer->getDesc().type == BufferType::ConstantBuffer);
+		ASSERT(bindIndex < k_softwareMaxConstantBufferBindings);
+		m_constantBuffers[bindIndex] = buffer;
+	}
+
+	void SoftwareDevice::unbindConstantBuffer(IBuffer* buffer, uint32_t bindIndex) {
+		ASSERT(bindIndex < k_softwareMaxConstantBufferBindings);
+		if (m_constantBuffers[bindIndex] == buffer) {
+			m_constantBuffers[bindIndex] = nullptr;
+		}
+	}
+
+	void SoftwareDevice::setBufferBinding(IShader* shader, const std::string& name, uint32_t bindIndex) {
+		ASSERT(shader != nullptr);
+		ASSERT(!name.empty());
+		ASSERT(bindIndex < k_softwareMaxConstantBufferBindings);
+		static_cast<SoftwareShader*>(shader)->m_blockBindings[name] = bindIndex;
+	}
+
+	void SoftwareDevice::registerUniformBlock(const UniformBlockDesc& desc) {
+		ASSERT(!desc.name.empty());
+		ASSERT(desc.bindIndex < k_softwareMaxConstantBufferBindings);
+		// The ports copy blocks out as their own structs, there's no GLSL layout to check against
+		m_uniformBlockBindings[desc.name] = desc.bindIndex;
+	}
+
+	//
+	// Draws
+	//
+
+	void SoftwareDevice::draw(DrawCallState drawCallState, size_t triangleCount, size_t offset, size_t instances, size_t firstInstance) {
+		ASSERT(drawCallState.vertexBufer != nullptr);
+		ASSERT(drawCallState.indexBuffer == nullptr);
+		ASSERT(drawCallState.pipeline != nullptr);
+		ASSERT(triangleCount > 0);
+		if (instances == 0) {
+			return;
+		}
+
+		// Vertices are shaded in the order GL numbers them, gl_VertexID starts at offset
+		uint32_t vertexCount = static_cast<uint32_t>(triangleCount * 3);
+		m_indices.resize(vertexCount);
+		std::iota(m_indices.begin(), m_indices.end(), 0u);
+		drawVertices(drawCallState, static_cast<uint32_t>(offset), vertexCount,
+			m_indices, static_cast<uint32_t>(instances), static_cast<uint32_t>(firstInstance));
+	}
+
+	void SoftwareDevice::drawIndexed(DrawCallState drawCallState, size_t triangleCount, size_t offset, size_t instances, size_t firstInstance) {
+		ASSERT(drawCallState.vertexBufer != nullptr);
+		ASSERT(drawCallState.indexBuffer != nullptr);
+		ASSERT(drawCallState.pipeline != nullptr);
+		ASSERT(triangleCount > 0);
+		if (instances == 0) {
+			return;
+		}
+
+		// offset is in bytes into the index buffer
+		const SoftwareBuffer* indexBuffer = static_cast<const SoftwareBuffer*>(drawCallState.indexBuffer);
+		size_t indexSize = getIndexSize(indexBuffer->getDesc().format);
+		ASSERT(indexSize != 0);
+		size_t indexCount = triangleCount * 3;
+		if (indexSize == 0 || offset + indexCount * indexSize > indexBuffer->m_data.size()) {
+			LOG_ERROR("Indexed draw reads past the end of index buffer \"{}\"", indexBuffer->getDesc().debugName);
+			return;
+		}
+
+		// Only the range of vertices the indices touch is shaded, each of them once per instance
+		m_indices.resize(indexCount);
+		uint32_t minIndex = UINT32_MAX;
+		uint32_t maxIndex = 0;
+		const uint8_t* indexData = indexBuffer->m_data.data() + offset;
+		for (size_t i = 0; i < indexCount; i++) {
+			uint32_t index = readIndex(indexData + i * indexSize, indexSize);
+			m_indices[i] = index;
+			minIndex = std::min(minIndex, index);
+			maxIndex = std::max(maxIndex, index);
+		}
+		for (uint32_t& index : m_indices) {
+			index -= minIndex;
+		}
+		drawVertices(drawCallState, minIndex, maxIndex - minIndex + 1,
+			m_indices, static_cast<uint32_t>(instances), static_cast<uint32_t>(firstInstance));
+	}
+
+	void SoftwareDevice::drawVertices(const DrawCallState& drawCallState, uint32_t firstVertex, uint32_t vertexCount,
+		const std::vector<uint32_t>& indices, uint32_t instances, uint32_t firstInstance) {
+
+		const PipelineDesc& pipeline = drawCallState.pipeline->getDesc();
+		SoftwareShader* shader = static_cast<SoftwareShader*>(pipeline.shader);
+		if (shader->m_vertexShader == nullptr || shader->m_fragmentShader == nullptr) {
+			m_frameStats.skippedDrawCalls++;
+			return;
+		}
+		double startTime = getMilliseconds();
+		m_frameStats.drawCalls++;
+
+		// Resources, as the shader sees them
+		SoftwareConstantBufferBinding constantBuffers[k_softwareMaxConstantBufferBindings];
+		for (uint32_t i = 0; i < k_softwareMaxConstantBufferBindings; i++) {
+			if (isLive(m_constantBuffers[i])) {
+				const SoftwareBuffer* buffer = static_cast<const SoftwareBuffer*>(m_constantBuffers[i]);
+				constantBuffers[i] = { buffer->m_data.data(), buffer->m_data.size() };
+			}
+		}
+		SoftwareTextureBinding textures[k_softwareMaxTextureUnits];
+		for (uint32_t i = 0; i < k_softwareMaxTextureUnits; i++) {
+			const TextureUnit& unit = m_textureUnits[i];
+			if (isLive(unit.texture)) {
+				textures[i].levels = unit.levels;
+				textures[i].levelCount = unit.levelCount;
+				if (isLive(unit.sampler)) {
+					textures[i].sampler = unit.sampler->getDesc();
+				}
+			}
+		}
+		SoftwareShaderContext context = {
+			.blockBindings = &shader->m_blockBindings,
+			.registeredBlockBindings = &m_uniformBlockBindings,
+			.constantBuffers = constantBuffers,
+			.textures = textures,
+		};
+		shader->m_vertexShader->prepare(context);
+		shader->m_fragmentShader->prepare(context);
+
+		// Vertex fetch and shading, in parallel batches
+		const std::vector<VertexAttributeDesc>& attributes = pipeline.inputLayout->attributes;
+		const std::vector<uint8_t>& vertexData = static_cast<const SoftwareBuffer*>(drawCallState.vertexBufer)->m_data;
+		const ISoftwareVertexShader* vertexShader = shader->m_vertexShader.get();
+		uint32_t totalVertices = vertexCount * instances;
+		m_vertexOutputs.resize(totalVertices);
+		m_rasterizer.getWorkerPool().parallelFor(totalVertices, k_softwareVertexBatchSize, [&](uint32_t begin, uint32_t end) {
+			SoftwareVertexInput input;
+			for (uint32_t vertex = begin; vertex < end; vertex++) {
+				uint32_t instance = vertex / vertexCount;
+				input.vertexId = firstVertex + vertex % vertexCount;
+				input.instanceId = instance;
+				for (const VertexAttributeDesc& attribute : attributes) {
+					// Like the GL backend, firstInstance moves the start of every instanced attribute
+					size_t element = attribute.instanceStepRate == 0
+						? input.vertexId
+						: firstInstance / attribute.instanceStepRate + instance / attribute.instanceStepRate;
+					size_t address = attribute.offset + element * attribute.elementStride;
+					if (address + getAttributeSize(attribute.format) <= vertexData.size()) {
+						input.attributes[attribute.bufferIndex] = readAttribute(attribute.format, vertexData.data() + address);
+					} else {
+						input.attributes[attribute.bufferIndex] = { 0.0f, 0.0f, 0.0f, 1.0f };
+					}
+				}
+				vertexShader->shade(input, m_vertexOutputs[vertex]);
+			}
+		});
+		m_rasterizer.getStats().verticesShaded += totalVertices;
+
+		// Every instance's triangles, in instance order like GL
+		const std::vector<uint32_t>* drawIndices = &indices;
+		if (instances > 1) {
+			m_instancedIndices.resize(indices.size() * instances);
+			for (uint32_t instance = 0; instance < instances; instance++) {
+				uint32_t baseVertex = instance * vertexCount;
+				uint32_t* instanceIndices = &m_instancedIndices[indices.size() * instance];
+				for (size_t i = 0; i < indices.size(); i++) {
+					instanceIndices[i] = indices[i] + baseVertex;
+				}
+			}
+			drawIndices = &m_instancedIndices;
+		}
+
+		// Fixed function state
+		const GraphicsState& graphicsState = pipeline.graphicsState;
+		SoftwareRasterState state = {
+			.viewport = m_viewport,
+			.scissorEnabled = m_scissorEnabled,
+			.scissor = m_scissor,
+			.depthTest = graphicsState.depthTest,
+			.depthFunc = m_depthOverrideEnabled ? m_depthOverrideFunc : graphicsState.depthState,
+			.depthWrite = m_depthOverrideEnabled ? m_depthOverrideWrite : graphicsState.depthWrite,
+			.colorWrite = graphicsState.colorWrite,
+			.cullMode = graphicsState.faceCullingMode,
+			.frontFace = graphicsState.faceWindingOrder,
+		};
+		if (isLive(pipeline.blendState)) {
+			state.blend = pipeline.blendState->getDesc();
+		}
+
+		m_rasterizer.drawTriangles(getBoundRenderTarget(), state, shader->m_fragmentShader.get(), vertexShader->getVaryingCount(), m_vertexOutputs, *drawIndices);
+		m_frameStats.rasterMilliseconds += getMilliseconds() - startTime;
+	}
+
+	//
+	// Render targets
+	//
+
+	SoftwareFramebufferStorage& SoftwareDevice::getBoundStorage() {
+		if (m_boundFramebuffer != k_defaultFramebuffer && isLive(m_boundFramebuffer)) {
+			return static_cast<SoftwareFramebuffer*>(m_boundFramebuffer)->m_storage;
+		}
+		return m_backbuffer;
+	}
+
+	SoftwareRenderTarget SoftwareDevice::getBoundRenderTarget() {
+		SoftwareFramebufferStorage& storage = getBoundStorage();
+		SoftwareRenderTarget target;
+		target.width = storage.width;
+		target.height = storage.height;
+		target.colourCount = storage.colourCount;
+		for (uint32_t i = 0; i < storage.colourCount; i++) {
+			// Only the first attachment of a cube map framebuffer has faces
+			target.colour[i] = &storage.colour[i][i == 0 ? m_boundCubeFace : 0];
+			target.clampColour[i] = storage.fixedPoint[i];
+		}
+		target.depth = storage.depth.empty() ? nullptr : &storage.depth;
+		return target;
+	}
+
+	// Clears are limited by the scissor rect, like on GL
+	static void getClearRect(uint32_t width, uint32_t height, bool scissorEnabled, const Rect& scissor,
+		uint32_t& minX, uint32_t& minY, uint32_t& maxX, uint32_t& maxY) {
+		minX = 0;
+		minY = 0;
+		maxX = width;
+		maxY = height;
+		if (scissorEnabled) {
+			minX = std::min(scissor.left, width);
+			minY = std::min(scissor.top, height);
+			maxX = std::clamp(scissor.right, minX, width);
+			maxY = std::clamp(scissor.bottom, minY, height);
+		}
+	}
+
+	void SoftwareDevice::clearSurface(SoftwareSurface& surface, const Color& color) {
+		uint32_t minX, minY, maxX, maxY;
+		getClearRect(surface.width, surface.height, m_scissorEnabled, m_scissor, minX, minY, maxX, maxY);
+		for (uint32_t y = minY; y < maxY; y++) {
+			float* row = &surface.rgba32f[static_cast<size_t>(y) * surface.width * 4];
+			for (uint32_t x = minX; x < maxX; x++) {
+				row[x * 4 + 0] = color.r;
+				row[x * 4 + 1] = color.g;
+				row[x * 4 + 2] = color.b;
+				row[x * 4 + 3] = color.a;
+			}
+		}
+	}
+
+	void SoftwareDevice::clearDepth(SoftwareFramebufferStorage& storage, float value) {
+		if (storage.depth.empty()) {
+			return;
+		}
+		uint32_t minX, minY, maxX, maxY;
+		getClearRect(storage.width, storage.height, m_scissorEnabled, m_scissor, minX, minY, maxX, maxY);
+		for (uint32_t y = minY; y < maxY; y++) {
+			float* row = &storage.depth[static_cast<size_t>(y) * storage.width];
+			std::fill(row + minX, row + maxX, value);
+		}
+	}
+
+	void SoftwareDevice::clearColor(Color color, float depth) {
+		double startTime = getMilliseconds();
+		SoftwareRenderTarget target = getBoundRenderTarget();
+		for (uint32_t i = 0; i < target.colourCount; i++) {
+			Color clampedColor = color;
+			if (target.clampColour[i]) {
+				clampedColor = { saturate(color.r), saturate(color.g), saturate(color.b), saturate(color.a) };
+			}
+			clearSurface(*target.colour[i], clampedColor);
+		}
+		clearDepth(getBoundStorage(), depth);
+		m_frameStats.clears++;
+		m_frameStats.rasterMilliseconds += getMilliseconds() - startTime;
+	}
+
+	void SoftwareDevice::clearColorAttachment(uint32_t attachment, Color color) {
+		SoftwareRenderTarget target = getBoundRenderTarget();
+		ASSERT(attachment < target.colourCount);
+		if (attachment >= target.colourCount) {
+			return;
+		}
+		if (target.clampColour[attachment]) {
+			color = { saturate(color.r), saturate(color.g), saturate(color.b), saturate(color.a) };
+		}
+		clearSurface(*target.colour[attachment], color);
+		m_frameStats.clears++;
+	}
+
+	void SoftwareDevice::present() {
+		m_frameStats.raster = m_rasterizer.getStats();
+		m_rasterizer.getStats() = {};
+		m_lastFrameStats = m_frameStats;
+		m_frameStats = {};
+	}
+
+	//
+	// Blend state
+	//
+
+	BlendStateHandle SoftwareDevice::makeBlendState(const BlendStateDesc blendStateDesc) {
+		return BlendStateHandle::Create(new SoftwareBlendState(blendStateDesc, m_nextObjectId++, m_liveObjects));
+	}
+
+	//
+	// Textures
+	//
+
+	TextureHandle SoftwareDevice::makeTexture(TextureDesc desc, void* textureData) {
+		ASSERT(desc.width > 0);
+		ASSERT(desc.height > 0);
+		ASSERT(desc.type != gpu::TextureType::Count);
+
+		SoftwareTexture* texture = new SoftwareTexture(desc, m_nextObjectId++, m_liveObjects);
+		uint32_t faceCount = desc.type == TextureType::TextureCubeMap ? k_CUBEMAP_FACE_COUNT : 1;
+		size_t faceSize = static_cast<size_t>(desc.width) * desc.height * 4;
+		for (uint32_t face = 0; face < faceCount; face++) {
+			std::vector<SoftwareSurface>& levels = texture->m_faces[face];
+			SoftwareSurface& baseLevel = levels.emplace_back();
+			baseLevel.width = desc.width;
+			baseLevel.height = desc.height;
+			baseLevel.rgba8.resize(faceSize);
+			if (textureData != nullptr) {
+				memcpy(baseLevel.rgba8.data(), static_cast<const uint8_t*>(textureData) + face * faceSize, faceSize);
+			}
+			if (desc.generateMipmaps) {
+				while (levels.back().width > 1 || levels.back().height > 1) {
+					levels.push_back(downsample(levels.back()));
+				}
+			}
+		}
+		return TextureHandle::Create(texture);
+	}
+
+	TextureSamplerHandle SoftwareDevice::makeTextureSampler(TextureSamplerDesc desc) {
+		return TextureSamplerHandle::Create(new SoftwareTextureSampler(desc, m_nextObjectId++, m_liveObjects));
+	}
+
+	// Cube maps are sampled through their first face, none of the ported shaders read a cube map
+	void SoftwareDevice::bindTexture(ITexture* texture, ITextureSampler* sampler, uint32_t index) {
+		ASSERT(texture != nullptr);
+		ASSERT(sampler != nullptr);
+		ASSERT(index < k_softwareMaxTextureUnits);
+		const SoftwareTexture* softwareTexture = static_cast<const SoftwareTexture*>(texture);
+		m_textureUnits[index] = {
+			.texture = static_cast<const ITexture*>(texture),
+			.levels = softwareTexture->m_faces[0].data(),
+			.levelCount = static_cast<uint32_t>(softwareTexture->m_faces[0].size()),
+			.sampler = sampler,
+		};
+	}
+
+	void SoftwareDevice::bindTexture(IFramebuffer* texture, ITextureSampler* sampler, uint32_t index, uint32_t attachment) {
+		ASSERT(texture != nullptr);
+		ASSERT(sampler != nullptr);
+		ASSERT(index < k_softwareMaxTextureUnits);
+		const SoftwareFramebuffer* framebuffer = static_cast<const SoftwareFramebuffer*>(texture);
+		ASSERT(attachment < framebuffer->m_storage.colourCount);
+		m_textureUnits[index] = {
+			.texture = static_cast<const IFramebuffer*>(texture),
+			.levels = &framebuffer->m_storage.colour[attachment][0],
+			.levelCount = 1,
+			.sampler = sampler,
+		};
+	}
+
+	//
+	// Framebuffers
+	//
+
+	FramebufferHandle SoftwareDevice::makeFramebuffer(FramebufferDesc desc) {
+		ASSERT(desc.colorDesc.width > 0);
+		ASSERT(desc.colorDesc.height > 0);
+		ASSERT(desc.additionalColorFormats.size() < k_MAX_FRAMEBUFFER_COLOR_ATTACHMENTS);
+
+		// Reserve an id for every attachment as well, see SoftwareFramebuffer::getTextureNativeObject
+		GpuPtr pointer = m_nextObjectId;
+		m_nextObjectId += 1 + k_MAX_FRAMEBUFFER_COLOR_ATTACHMENTS;
+		SoftwareFramebuffer* framebuffer = new SoftwareFramebuffer(desc, pointer, m_liveObjects);
+
+		// Multisampled framebuffers are rendered with a single sample, blits resolve them by copying
+		SoftwareFramebufferStorage& storage = framebuffer->m_storage;
+		storage.width = desc.colorDesc.width;
+		storage.height = desc.colorDesc.height;
+		storage.colourCount = 1 + static_cast<uint32_t>(desc.additionalColorFormats.size());
+		for (uint32_t i = 0; i < storage.colourCount; i++) {
+			storage.fixedPoint[i] = isFixedPointFormat(i == 0 ? desc.colorDesc.format : desc.additionalColorFormats[i - 1]);
+			uint32_t faceCount = desc.cubeMap && i == 0 ? k_CUBEMAP_FACE_COUNT : 1;
+			for (uint32_t face = 0; face < faceCount; face++) {
+				allocateSurface(storage.colour[i][face], storage.width, storage.height);
+			}
+		}
+		if (desc.hasDepth) {
+			// Reverse Z, cleared to the far plane
+			storage.depth.assign(static_cast<size_t>(storage.width) * storage.height, 0.0f);
+		}
+		return FramebufferHandle::Create(framebuffer);
+	}
+
+	void SoftwareDevice::bindFramebuffer(IFramebuffer* texture, uint32_t cubeFace) {
+		ASSERT(cubeFace == 0 || (texture != nullptr && texture->getDesc().cubeMap && cubeFace < k_CUBEMAP_FACE_COUNT));
+		m_boundFramebuffer = texture;
+		m_boundCubeFace = cubeFace < k_CUBEMAP_FACE_COUNT ? cubeFace : 0;
+	}
+
+	void SoftwareDevice::blitFramebuffer(IFramebuffer* textureSrc, IFramebuffer* textureDst) {
+		ASSERT(textureSrc != nullptr);
+		if (!isLive(textureSrc) || (textureDst != k_defaultFramebuffer && !isLive(textureDst))) {
+			return;
+		}
+		double startTime = getMilliseconds();
+
+		const SoftwareFramebufferStorage& source = static_cast<const SoftwareFramebuffer*>(textureSrc)->m_storage;
+		SoftwareFramebufferStorage& destination = textureDst != k_defaultFramebuffer ? static_cast<SoftwareFramebuffer*>(textureDst)->m_storage : m_backbuffer;
+		const SoftwareSurface& sourceSurface = source.colour[0][0];
+
+		// Source scaled onto the destination with nearest filtering, the backbuffer takes the source's size like on GL
+		uint32_t blitWidth = textureDst != k_defaultFramebuffer ? destination.width : source.width;
+		uint32_t blitHeight = textureDst != k_defaultFramebuffer ? destination.height : source.height;
+		uint32_t minX, minY, maxX, maxY;
+		getClearRect(std::min(blitWidth, destination.width), std::min(blitHeight, destination.height), m_scissorEnabled, m_scissor, minX, minY, maxX, maxY);
+
+		// Every colour attachment of the destination is a draw buffer, GL writes the source into all of them
+		for (uint32_t attachment = 0; attachment < destination.colourCount; attachment++) {
+			SoftwareSurface& destinationSurface = destination.colour[attachment][0];
+			bool clampColour = destination.fixedPoint[attachment];
+			for (uint32_t y = minY; y < maxY; y++) {
+				uint32_t sourceY = static_cast<uint32_t>((y + 0.5) * source.height / blitHeight);
+				const float* sourceRow = &sourceSurface.rgba32f[static_cast<size_t>(sourceY) * source.width * 4];
+				float* destinationRow = &destinationSurface.rgba32f[static_cast<size_t>(y) * destination.width * 4];
+				for (uint32_t x = minX; x < maxX; x++) {
+					uint32_t sourceX = static_cast<uint32_t>((x + 0.5) * source.width / blitWidth);
+					for (uint32_t channel = 0; channel < 4; channel++) {
+						float value = sourceRow[sourceX * 4 + channel];
+						destinationRow[x * 4 + channel] = clampColour ? saturate(value) : value;
+					}
+				}
+			}
+		}
+		m_frameStats.rasterMilliseconds += getMilliseconds() - startTime;
+	}
+
+	void SoftwareDevice::blitFramebufferDepth(IFramebuffer* textureSrc, IFramebuffer* textureDst) {
+		ASSERT(textureSrc != nullptr || textureDst != nullptr);
+		if ((textureSrc != k_defaultFramebuffer && !isLive(textureSrc)) || (textureDst != k_defaultFramebuffer && !isLive(textureDst))) {
+			return;
+		}
+
+		const SoftwareFramebufferStorage& source = textureSrc != k_defaultFramebuffer ? static_cast<const SoftwareFramebuffer*>(textureSrc)->m_storage : m_backbuffer;
+		SoftwareFramebufferStorage& destination = textureDst != k_defaultFramebuffer ? static_cast<SoftwareFramebuffer*>(textureDst)->m_storage : m_backbuffer;
+		if (source.depth.empty() || destination.depth.empty()) {
+			return;
+		}
+		uint32_t width = std::min(source.width, destination.width);
+		uint32_t height = std::min(source.height, destination.height);
+		for (uint32_t y = 0; y < height; y++) {
+			memcpy(&destination.depth[static_cast<size_t>(y) * destination.width], &source.depth[static_cast<size_t>(y) * source.width], width * sizeof(float));
+		}
+	}
+
+	void SoftwareDevice::readDepthBuffer(IBuffer* handle, const Rect rect) {
+		ASSERT(handle != nullptr);
+		ASSERT(handle->getDesc().type == gpu::BufferType::PixelReadTarget);
+		SoftwareBuffer* buffer = static_cast<SoftwareBuffer*>(handle);
+		size_t requiredSize = static_cast<size_t>(rect.getWidth()) * rect.getHeight() * sizeof(float);
+		if (requiredSize > buffer->m_data.size()) {
+			LOG_ERROR("Depth read of {} bytes overflows buffer \"{}\" ({} bytes)", requiredSize, buffer->getDesc().debugName, buffer->m_data.size());
+			return;
+		}
+
+		// Rows bottom to top like glReadPixels. Pixels outside of the framebuffer read as the far plane
+		const SoftwareFramebufferStorage& storage = getBoundStorage();
+		float* output = reinterpret_cast<float*>(buffer->m_data.data());
+		for (uint32_t y = rect.top; y < rect.bottom; y++) {
+			for (uint32_t x = rect.left; x < rect.right; x++) {
+				bool inside = !storage.depth.empty() && x < storage.width && y < storage.height;
+				*output++ = inside ? storage.depth[static_cast<size_t>(y) * storage.width + x] : 0.0f;
+			}
+		}
+	}
+
+	void SoftwareDevice::setDepthOverride(bool enabled, CompareFunc depthFunc, bool depthWrite) {
+		m_depthOverrideEnabled = enabled;
+		m_depthOverrideFunc = depthFunc;
+		m_depthOverrideWrite = depthWrite;
+	}
+
+	//
+	// Debugging
+	//
+
+	void SoftwareDevice::debugMarkerPush(const std::string& title) {}
+
+	void SoftwareDevice::debugMarkerPop() {}
+
+	void SoftwareDevice::beginProfilingFrame() {
+		ASSERT(!m_profilingFrameOpen);
+		m_profileScopes.clear();
+		m_openProfileScopes.clear();
+		m_profilingFrameOpen = true;
+		profileScopePush("Frame");
+	}
+
+	void SoftwareDevice::endProfilingFrame() {
+		ASSERT(m_profilingFrameOpen);
+
+		// Close the frame scope, along with any scope left open by mistake
+		while (!m_openProfileScopes.empty()) {
+			profileScopePop();
+		}
+		m_profilingFrameOpen = false;
+
+		// Work is finished by the time a draw returns, so results are available straight away
+		m_profilingResults.clear();
+		for (const ProfileScope& scope : m_profileScopes) {
+			m_profilingResults.push_back({
+				.name = scope.name,
+				.depth = scope.depth,
+				.milliseconds = scope.milliseconds,
+			});
+		}
+	}
+
+	void SoftwareDevice::profileScopePush(const char* name) {
+		if (!m_profilingFrameOpen) {
+			return;
+		}
+		m_profileScopes.push_back({
+			.name = name,
+			.depth = static_cast<uint32_t>(m_openProfileScopes.size()),
+			.start = getMilliseconds(),
+		});
+		m_openProfileScopes.push_back(static_cast<uint32_t>(m_profileScopes.size() - 1));
+	}
+
+	void SoftwareDevice::profileScopePop() {
+		if (!m_profilingFrameOpen || m_openProfileScopes.empty()) {
+			return;
+		}
+		ProfileScope& scope = m_profileScopes[m_openProfileScopes.back()];
+		scope.milliseconds = getMilliseconds() - scope.start;
+		m_openProfileScopes.pop_back();
+	}
+
+	const std::vector<GpuScopeTiming>& SoftwareDevice::getProfilingResults() const {
+		return m_profilingResults;
+	}
+}
@@ -0,0 +1,306 @@
+#pragma once
+
+#include "engine/gpu/idevice.hpp"
+#include "software_rasterizer.hpp"
+
+#include <array>
+#include <memory>
+#include <unordered_set>
+
+namespace gpu::software {
+
+	// Every object the device created which hasn't been destroyed yet. Bound state is checked against it before a draw reads
+	// through it, objects may be destroyed while bound and may outlive the device
+	struct SoftwareLiveObjects {
+		std::unordered_set<const void*> objects;
+	};
+
+	// Work done between two presents
+	struct SoftwareFrameStats {
+		uint32_t drawCalls = 0;
+		// Draws with a shader that has no C++ port
+		uint32_t skippedDrawCalls = 0;
+		uint32_t clears = 0;
+		SoftwareRasterStats raster;
+		// Wall clock time spent inside draws and clears
+		double rasterMilliseconds = 0.0;
+	};
+
+	class SoftwareDevice;
+
+	//
+	// Buffers
+	//
+	class SoftwareBuffer : public gpu::IBuffer {
+	public:
+		SoftwareBuffer(gpu::BufferDesc bufferDesc, GpuPtr pointer, std::shared_ptr<SoftwareLiveObjects> liveObjects);
+		~SoftwareBuffer() override;
+
+		[[nodiscard]] inline const BufferDesc& getDesc() const override { return m_bufferDesc; }
+		[[nodiscard]] inline const GpuPtr getNativeObject() const override { return m_pointer; }
+	private:
+		gpu::BufferDesc m_bufferDesc;
+		GpuPtr m_pointer = 0;
+		std::shared_ptr<SoftwareLiveObjects> m_liveObjects;
+		std::vector<uint8_t> m_data;
+
+		friend class gpu::software::SoftwareDevice;
+	};
+
+	class SoftwareInputLayout : public gpu::IInputLayout {
+	public:
+		SoftwareInputLayout(GpuPtr pointer, std::shared_ptr<SoftwareLiveObjects> liveObjects);
+		~SoftwareInputLayout() override;
+
+		[[nodiscard]] inline const GpuPtr getNativeObject() const override { return m_pointer; }
+	private:
+		GpuPtr m_pointer = 0;
+		std::shared_ptr<SoftwareLiveObjects> m_liveObjects;
+	};
+
+	//
+	// Textures
+	//
+	class SoftwareTexture : public gpu::ITexture {
+	public:
+		SoftwareTexture(TextureDesc desc, GpuPtr pointer, std::shared_ptr<SoftwareLiveObjects> liveObjects);
+		~SoftwareTexture() override;
+		[[nodiscard]] inline const TextureDesc getDesc() const override { return m_desc; }
+		[[nodiscard]] inline const GpuPtr getNativeObject() const override { return m_pointer; }
+	private:
+		TextureDesc m_desc;
+		GpuPtr m_pointer = 0;
+		std::shared_ptr<SoftwareLiveObjects> m_liveObjects;
+		// Mip chain per face, RGBA8. Only cube maps use more than the first face
+		std::array<std::vector<SoftwareSurface>, k_CUBEMAP_FACE_COUNT> m_faces;
+
+		friend class gpu::software::SoftwareDevice;
+	};
+
+	class SoftwareTextureSampler : public gpu::ITextureSampler {
+	public:
+		SoftwareTextureSampler(TextureSamplerDesc desc, GpuPtr pointer, std::shared_ptr<SoftwareLiveObjects> liveObjects);
+		~SoftwareTextureSampler() override;
+		[[nodiscard]] inline const TextureSamplerDesc& getDesc() const override { return m_desc; }
+		[[nodiscard]] inline const GpuPtr getNativeObject() const override { return m_pointer; }
+	private:
+		TextureSamplerDesc m_desc;
+		GpuPtr m_pointer = 0;
+		std::shared_ptr<SoftwareLiveObjects> m_liveObjects;
+	};
+
+	// Colour and depth storage of a framebuffer, or of the device's backbuffer
+	struct SoftwareFramebufferStorage {
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t colourCount = 0;
+		// Float surfaces, so HDR targets keep their range. Only cube maps use more than the first face
+		std::array<std::array<SoftwareSurface, k_CUBEMAP_FACE_COUNT>, k_MAX_FRAMEBUFFER_COLOR_ATTACHMENTS> colour;
+		// Whether the attachment's format is fixed point, what is written to it is clamped to [0, 1]
+		std::array<bool, k_MAX_FRAMEBUFFER_COLOR_ATTACHMENTS> fixedPoint = {};
+		// Empty without a depth attachment
+		std::vector<float> depth;
+	};
+
+	class SoftwareFramebuffer : public gpu::IFramebuffer {
+	public:
+		SoftwareFramebuffer(FramebufferDesc desc, GpuPtr pointer, std::shared_ptr<SoftwareLiveObjects> liveObjects);
+		~SoftwareFramebuffer() override;
+		[[nodiscard]] inline const FramebufferDesc& getDesc() const override { return m_desc; }
+		[[nodiscard]] inline const GpuPtr getNativeObject() const override { return m_pointer; }
+		// Attachments are numbered right after the framebuffer itself
+		[[nodiscard]] inline const GpuPtr getTextureNativeObject(uint32_t attachment = 0) const override { return m_pointer + 1 + attachment; }
+	private:
+		FramebufferDesc m_desc;
+		GpuPtr m_pointer = 0;
+		std::shared_ptr<SoftwareLiveObjects> m_liveObjects;
+		SoftwareFramebufferStorage m_storage;
+
+		friend class gpu::software::SoftwareDevice;
+	};
+
+	//
+	// Shaders
+	//
+	class SoftwareShader : public gpu::IShader {
+	public:
+		SoftwareShader(ShaderDesc shaderDesc, GpuPtr pointer, std::shared_ptr<SoftwareLiveObjects> liveObjects);
+		~SoftwareShader() override;
+		[[nodiscard]] inline const ShaderDesc& getDesc() const override { return m_shaderDesc; }
+		[[nodiscard]] inline const GpuPtr getNativeObject() const override { return m_pointer; }
+	private:
+		ShaderDesc m_shaderDesc;
+		GpuPtr m_pointer = 0;
+		std::shared_ptr<SoftwareLiveObjects> m_liveObjects;
+		// Null when the stage's source file has no port, draws with the shader are skipped
+		std::unique_ptr<ISoftwareVertexShader> m_vertexShader;
+		std::unique_ptr<ISoftwareFragmentShader> m_fragmentShader;
+		// Uniform block bindings set through setBufferBinding
+		std::unordered_map<std::string, uint32_t> m_blockBindings;
+
+		friend class gpu::software::SoftwareDevice;
+	};
+
+	//
+	// BlendState
+	//
+	class SoftwareBlendState : public gpu::IBlendState {
+	public:
+		SoftwareBlendState(BlendStateDesc blendStateDesc, GpuPtr pointer, std::shared_ptr<SoftwareLiveObjects> liveObjects);
+		~SoftwareBlendState() override;
+		[[nodiscard]] inline const BlendStateDesc& getDesc() const override { return m_blendStateDesc; }
+		[[nodiscard]] inline const GpuPtr getNativeObject() const override { return m_pointer; }
+	private:
+		BlendStateDesc m_blendStateDesc;
+		GpuPtr m_pointer = 0;
+		std::shared_ptr<SoftwareLiveObjects> m_liveObjects;
+	};
+
+	//
+	// Pipeline
+	//
+	class SoftwarePipeline : public gpu::IPipeline {
+	public:
+		SoftwarePipeline(PipelineDesc pipelineDesc, std::shared_ptr<SoftwareLiveObjects> liveObjects);
+		~SoftwarePipeline() override;
+		[[nodiscard]] inline const PipelineDesc& getDesc() const override { return m_pipelineDesc; }
+	private:
+		PipelineDesc m_pipelineDesc;
+		std::shared_ptr<SoftwareLiveObjects> m_liveObjects;
+	};
+
+	//
+	// Device
+	//
+	// Renders on the CPU, without a driver or a window. Vertices are shaded in parallel batches, triangles are binned into
+	// screen tiles and each tile is rasterized by one worker thread, see SoftwareRasterizer. Shaders run as the C++ ports
+	// in software_shaders.cpp. The backbuffer lives in memory and can be written to an image with writeBackbufferImage
+	class SoftwareDevice : public ::gpu::IDevice {
+	public:
+		SoftwareDevice();
+		~SoftwareDevice() override;
+
+		void setViewport(const Rect viewportRect) override;
+		void setScissor(bool enabled, const Rect scissorRect = {}) override;
+		InputLayoutHandle createInputLayout(const VertexAttributeDesc* desc, uint32_t attributeCount) override;
+		ShaderHandle makeShader(const ShaderDesc shaderDesc) override;
+		PipelineHandle makePipeline(const PipelineDesc pipelineDesc) override;
+		// Shaders are C++ ports, there's nothing to cache
+		std::string getShaderBinaryTag() const override;
+		bool getShaderBinary(IShader* shader, ShaderBinary& outBinary) override;
+
+		BufferHandle makeBuffer(const BufferDesc bufferDesc) override;
+		void writeBuffer(IBuffer* handle, size_t size, const void* data) override;
+		void mapBuffer(IBuffer* buffer, uint32_t offset, size_t length, MapAccessFlags accessFlags, void** mappedDataPtr) override;
+		void unmapBuffer(IBuffer* buffer) override;
+		void bindBuffer(IBuffer* buffer) override;
+		void unbindBuffer(IBuffer* buffer) override;
+		void setConstantBuffer(IBuffer* buffer, uint32_t bindIndex) override;
+		void unbindConstantBuffer(IBuffer* buffer, uint32_t bindIndex) override;
+		void setBufferBinding(IShader* shader, const std::string& name, uint32_t bindIndex) override;
+		void registerUniformBlock(const UniformBlockDesc& desc) override;
+
+		void draw(DrawCallState drawCallState, size_t triangleCount, size_t offset = 0, size_t instances = 1, size_t firstInstance = 0) override;
+		void drawIndexed(DrawCallState drawCallState, size_t triangleCount, size_t offset = 0, size_t instances = 1, size_t firstInstance = 0) override;
+
+		void clearColor(Color color, float depth) override;
+		void present() override;
+
+		// Blend state
+		BlendStateHandle makeBlendState(const BlendStateDesc blendStateDesc) override;
+
+		// Textures
+		TextureHandle makeTexture(TextureDesc desc, void* textureData) override;
+		TextureSamplerHandle makeTextureSampler(TextureSamplerDesc desc) override;
+		void bindTexture(ITexture* texture, ITextureSampler* sampler, uint32_t index = 0) override;
+		void bindTexture(IFramebuffer* texture, ITextureSampler* sampler, uint32_t index = 0, uint32_t attachment = 0) override;
+
+		FramebufferHandle makeFramebuffer(FramebufferDesc desc) override;
+		void bindFramebuffer(IFramebuffer* texture, uint32_t cubeFace = 0) override;
+		void blitFramebuffer(IFramebuffer* textureSrc, IFramebuffer* textureDst) override;
+		void blitFramebufferDepth(IFramebuffer* textureSrc, IFramebuffer* textureDst) override;
+		void clearColorAttachment(uint32_t attachment, Color color) override;
+		void readDepthBuffer(IBuffer* buffer, const Rect rect) override;
+
+		void setDepthOverride(bool enabled, CompareFunc depthFunc = CompareFunc::Equal, bool depthWrite = false) override;
+
+		// Markers have nowhere to go
+		void debugMarkerPush(const std::string& title) override;
+		void debugMarkerPop() override;
+
+		// Everything runs synchronously, scopes are timed on the CPU clock
+		void beginProfilingFrame() override;
+		void endProfilingFrame() override;
+		void profileScopePush(const char* name) override;
+		void profileScopePop() override;
+		[[nodiscard]] const std::vector<GpuScopeTiming>& getProfilingResults() const override;
+
+		// The backbuffer stands in for the window's default framebuffer, it must be sized to match the window
+		void resizeBackbuffer(uint32_t width, uint32_t height);
+		// Writes the backbuffer to a binary PPM image, call it after a present. Returns false if the file couldn't be written
+		bool writeBackbufferImage(const std::string& path) const;
+
+		[[nodiscard]] inline const SoftwareFrameStats& getLastFrameStats() const { return m_lastFrameStats; }
+		[[nodiscard]] inline uint32_t getThreadCount() const { return m_threadCount; }
+
+	private:
+		// Whether object was made by this device and is still alive
+		[[nodiscard]] bool isLive(const void* object) const;
+		[[nodiscard]] SoftwareFramebufferStorage& getBoundStorage();
+		[[nodiscard]] SoftwareRenderTarget getBoundRenderTarget();
+		// Clear the pixels inside the scissor rect
+		void clearSurface(SoftwareSurface& surface, const Color& color);
+		void clearDepth(SoftwareFramebufferStorage& storage, float value);
+		// Shades vertexCount vertices per instance and rasterizes indices into them. Instance i's vertices start at i * vertexCount
+		void drawVertices(const DrawCallState& drawCallState, uint32_t firstVertex, uint32_t vertexCount,
+			const std::vector<uint32_t>& indices, uint32_t instances, uint32_t firstInstance);
+
+		std::shared_ptr<SoftwareLiveObjects> m_liveObjects;
+		GpuPtr m_nextObjectId = 1;
+		// Uniform block bindings from registerUniformBlock, used for blocks a shader has no binding of its own for
+		std::unordered_map<std::string, uint32_t> m_uniformBlockBindings;
+		uint32_t m_threadCount = 1;
+		SoftwareRasterizer m_rasterizer;
+
+		// Stands in for the default framebuffer
+		SoftwareFramebufferStorage m_backbuffer;
+
+		// Bound state. Pointers are checked with isLive before they are read through
+		IFramebuffer* m_boundFramebuffer = k_defaultFramebuffer;
+		uint32_t m_boundCubeFace = 0;
+		IBuffer* m_constantBuffers[k_softwareMaxConstantBufferBindings] = {};
+		struct TextureUnit {
+			const void* texture = nullptr;
+			const SoftwareSurface* levels = nullptr;
+			uint32_t levelCount = 0;
+			ITextureSampler* sampler = nullptr;
+		};
+		TextureUnit m_textureUnits[k_softwareMaxTextureUnits];
+		Rect m_viewport;
+		bool m_scissorEnabled = false;
+		Rect m_scissor;
+		bool m_depthOverrideEnabled = false;
+		CompareFunc m_depthOverrideFunc = CompareFunc::Equal;
+		bool m_depthOverrideWrite = false;
+
+		// Reused between draws
+		std::vector<SoftwareVertexOutput> m_vertexOutputs;
+		std::vector<uint32_t> m_indices;
+		std::vector<uint32_t> m_instancedIndices;
+
+		// CPU timed profiling scopes
+		struct ProfileScope {
+			const char* name = "";
+			uint32_t depth = 0;
+			double start = 0.0;
+			double milliseconds = 0.0;
+		};
+		bool m_profilingFrameOpen = false;
+		std::vector<ProfileScope> m_profileScopes;
+		std::vector<uint32_t> m_openProfileScopes;
+		std::vector<GpuScopeTiming> m_profilingResults;
+
+		SoftwareFrameStats m_frameStats;
+		SoftwareFrameStats m_lastFrameStats;
+	};
+}
@@ -1,7 +1,11 @@
 #include "asset_manager.hpp"
 #include "engine/log.hpp"
+#include "engine/core.hpp"
+#include "engine/renderer/uniform_blocks.hpp"
 
 #include <filesystem>
+#include <algorithm>
+#include <cfloat>
 
 #include <stb_image.h>
 #include <fmt/format.h>
@@ -10,6 +14,30 @@
 #include <stb_include.h>
 
 #define SHADER_HEADER "#version 460 core\n\n"
+// Bump when the cache file layout changes, older files are then recompiled and overwritten
+#define SHADER_CACHE_MAGIC 0x48534743 // "CGSH"
+#define SHADER_CACHE_VERSION 1
+
+struct ShaderCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t binaryFormat;
+    uint32_t vertSize;
+    uint32_t fragSize;
+    uint32_t binarySize;
+};
+
+// FNV-1a, stable between runs unlike std::hash
+static uint64_t hashShaderString(uint64_t hash, const std::string& str) {
+    for (const char c : str) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 0x100000001b3ull;
+    }
+    // Separate consecutive strings so "ab" + "c" and "a" + "bc" differ
+    hash ^= 0xff;
+    hash *= 0x100000001b3ull;
+    return hash;
+}
 
 // @TODO: In a more production ready environment, replace this with a proper mesh, like the Source ERROR mesh
 render::PositionNormalTexcoordVertex errorVertices[] = {
@@ -101,22 +129,25 @@ namespace managers {
 
     void AssetManager::initialiseErrorData() {
 
-        m_device->debugMarkerPush(fmt::format("Initialising error data..."));
+        GPU_MARKER_PUSH(m_device, "Initialising error data...");
         // Initialises error mesh, error shader and texture
 
         // Init errMesh
+        m_errorMesh.mesh.boundsMin = hlslpp::float3(-1, -1, -1);
+        m_errorMesh.mesh.boundsMax = hlslpp::float3(1, 1, 1);
+        std::vector<render::QuantisedMeshVertex> quantisedErrorVertices = render::quantiseMeshVertices(errorVertices, ARRAY_COUNT(errorVertices), m_errorMesh.mesh);
         m_errorMesh.vertexBuffer = m_device->makeBuffer({ .type = gpu::BufferType::VertexBuffer, .usage = gpu::Usage::Default, .debugName = "ErrorVertexBuffer"});
-        m_device->writeBuffer(m_errorMesh.vertexBuffer, sizeof(errorVertices), errorVertices);
+        m_device->writeBuffer(m_errorMesh.vertexBuffer, quantisedErrorVertices.size() * sizeof(render::QuantisedMeshVertex), quantisedErrorVertices.data());
 
         // Triangle indices
         m_errorMesh.indexBuffer = m_device->makeBuffer({ .type = gpu::BufferType::IndexBuffer, .usage = gpu::Usage::Default, .format = gpu::GpuFormat::Uint32_TYPELESS, .debugName = "ErrorIndexBuffer"});
         m_device->writeBuffer(m_errorMesh.indexBuffer, sizeof(errorIndices), errorIndices);
 
-        // Requires mesh to be initialised first
+        // Requires mesh to be initialised first. Same layout as fetchMesh's
         gpu::VertexAttributeDesc vDesc[] = {
-            {.name = "POSITION", .format = gpu::GpuFormat::RGB8_TYPELESS, .bufferIndex = 0, .offset = offsetof(render::PositionNormalTexcoordVertex, position), .elementStride = sizeof(render::PositionNormalTexcoordVertex)},
-            {.name = "NORMAL", .format = gpu::GpuFormat::RGB8_TYPELESS, .bufferIndex = 1, .offset = offsetof(render::PositionNormalTexcoordVertex, normal), .elementStride = sizeof(render::PositionNormalTexcoordVertex)},
-            {.name = "TEXCOORD0", .format = gpu::GpuFormat::RG8_TYPELESS, .bufferIndex = 2, .offset = offsetof(render::PositionNormalTexcoordVertex, uv), .elementStride = sizeof(render::PositionNormalTexcoordVertex)}
+            {.name = "POSITION", .format = gpu::GpuFormat::RGBA16_SNORM, .bufferIndex = 0, .offset = offsetof(render::QuantisedMeshVertex, position), .elementStride = sizeof(render::QuantisedMeshVertex)},
+            {.name = "NORMAL", .format = gpu::GpuFormat::RG16_SNORM, .bufferIndex = 1, .offset = offsetof(render::QuantisedMeshVertex, normal), .elementStride = sizeof(render::QuantisedMeshVertex)},
+            {.name = "TEXCOORD0", .format = gpu::GpuFormat::RG16_FLOAT, .bufferIndex = 2, .offset = offsetof(render::QuantisedMeshVertex, uv), .elementStride = sizeof(render::QuantisedMeshVertex)}
         };
 
         m_errorMesh.vertexLayout = m_device->createInputLayout(vDesc, sizeof(vDesc) / sizeof(vDesc[0]));
@@ -194,12 +225,9 @@ void main()
         m_errorShader = m_device->makeShader({
             .VS {.byteCode = (uint8_t*)shader_vert, .entryFunc = "main" },
             .PS {.byteCode = (uint8_t*)shader_pixel, .entryFunc = "main" },
-            .graphicsState = {
-                .depthState = gpu::CompareFunc::LessOrEqual, // inverse Z
-            },
             .debugName = "ErrorShader",
         });
-        m_device->debugMarkerPop();
+        GPU_MARKER_POP(m_device);
 
         m_intialisedDefaultAssets = true;
     }
@@ -223,7 +251,8 @@ void main()
         //           used mesh file formats such as Autodesk FBX and GLTF.
         //        2. Dynamically determine the vertex layout based on the mesh data, currently this is hardcoded to only support position normal and UV0 data, what if I want to import tangent vectors or UV1?
         //        3. Introduce a "baked" asset pipeline, where assets are pre-processed ahead of time from builds. This allows us to better optimise assets.
-        //        4. Use meshoptimizer. meshoptimizer is a library which better distributes the data to make it easier for the GPU to work with, and can generate LODs and similar too.
+        //        4. Use meshoptimizer. Welding, vertex cache and vertex fetch ordering are done below in-engine, but its overdraw optimiser isn't.
+        //           LODs are generated below with a simple vertex clustering pass, meshoptimizer's edge collapse simplifier would preserve silhouettes better.
 
         // Triangulate quads, ignore vertex colours and search for MTLs in the same dir as objs
         tinyobj::ObjReaderConfig reader_config;
@@ -253,11 +282,13 @@ void main()
         std::vector<render::PositionNormalTexcoordVertex> vertices;
         std::vector<uint32_t> indices;
 
+        float boundsMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float boundsMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
         // Loop over shapes
         for (size_t s = 0; s < shapes.size(); s++) {
             // Loop over faces(polygon)
             size_t index_offset = 0;
-            size_t index_buffer_offset = 0;
             for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++) {
                 size_t fv = size_t(shapes[s].mesh.num_face_vertices[f]);
 
@@ -271,6 +302,11 @@ void main()
                     currentVertex.position[1] = attrib.vertices[3 * size_t(idx.vertex_index) + 1];
                     currentVertex.position[2] = attrib.vertices[3 * size_t(idx.vertex_index) + 2];
 
+                    for (int axis = 0; axis < 3; axis++) {
+                        boundsMin[axis] = std::min(boundsMin[axis], currentVertex.position[axis]);
+                        boundsMax[axis] = std::max(boundsMax[axis], currentVertex.position[axis]);
+                    }
+
                     // Check if `normal_index` is zero or positive. negative = no normal data
                     if (idx.normal_index >= 0) {
                         currentVertex.normal[0] = attrib.normals[3 * size_t(idx.normal_index) + 0];
@@ -289,51 +325,99 @@ void main()
                     // tinyobj::real_t green = attrib.colors[3*size_t(idx.vertex_index)+1];
                     // tinyobj::real_t blue  = attrib.colors[3*size_t(idx.vertex_index)+2];
 
+                    // Every corner gets its own vertex for now, weldMeshVertices merges them below
+                    indices.push_back(static_cast<uint32_t>(vertices.size()));
                     vertices.push_back(currentVertex);
                 }
-                for (uint32_t i = 0; i < fv; i += 3) {
-                    indices.push_back(index_buffer_offset + i + 0);
-                    indices.push_back(index_buffer_offset + i + 1);
-                    indices.push_back(index_buffer_offset + i + 2);
-                }
                 index_offset += fv;
-                index_buffer_offset += fv;
 
                 // per-face material
                 // shapes[s].mesh.material_ids[f];
             }
         }
 
-        m_device->debugMarkerPush(fmt::format("Loading mesh {}...", meshPath));
+        // Share vertices between faces, then order triangles for the post-transform cache
+        const size_t importedVertexCount = vertices.size();
+        const float importedAcmr = render::computeVertexCacheAcmr(indices.data(), indices.size(), vertices.size());
+        render::weldMeshVertices(vertices, indices);
+        const float weldedAcmr = render::computeVertexCacheAcmr(indices.data(), indices.size(), vertices.size());
+        render::optimiseVertexCache(indices.data(), indices.size(), vertices.size());
+        const float optimisedAcmr = render::computeVertexCacheAcmr(indices.data(), indices.size(), vertices.size());
+
+        // Generate LODs by clustering LOD 0 onto progressively coarser grids. The simplified index lists are appended after
+        // LOD 0 so that every level shares the same buffers. Levels which don't remove enough triangles are skipped
+        const uint32_t lodGridResolutions[] = { 32, 16, 8 };
+        const size_t lod0IndexCount = indices.size();
+        render::MeshLod lods[render::k_MAX_MESH_LODS] = {};
+        uint32_t lodCount = 1;
+        lods[0] = { .firstIndex = 0, .triangleCount = lod0IndexCount / 3U };
+        for (uint32_t i = 0; i < ARRAY_COUNT(lodGridResolutions) && lodCount < render::k_MAX_MESH_LODS; i++) {
+            std::vector<uint32_t> lodIndices = render::simplifyMeshClustered(vertices.data(), vertices.size(), indices.data(), lod0IndexCount, lodGridResolutions[i]);
+            size_t lodTriangleCount = lodIndices.size() / 3U;
+            if (lodTriangleCount == 0 || lodTriangleCount * 4 > lods[lodCount - 1].triangleCount * 3) {
+                continue;
+            }
+            render::optimiseVertexCache(lodIndices.data(), lodIndices.size(), vertices.size());
+            lods[lodCount] = { .firstIndex = indices.size(), .triangleCount = lodTriangleCount };
+            indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+            lodCount++;
+        }
+
+        // Vertex buffer in the order LOD 0 first reads it. Vertices only coarser LODs use end up after those
+        render::optimiseVertexFetch(vertices, indices.data(), indices.size());
+        LOG_INFO("[Mesh]: {} has {} vertices ({} imported), ACMR {:.3f} ({:.3f} imported, {:.3f} welded)",
+            meshPath, vertices.size(), importedVertexCount, optimisedAcmr, importedAcmr, weldedAcmr);
+
+        GPU_MARKER_PUSH(m_device, "Loading mesh {}...", meshPath);
+
+        render::Mesh outputMesh{};
+        if (!vertices.empty()) {
+            outputMesh.boundsMin = hlslpp::float3(boundsMin[0], boundsMin[1], boundsMin[2]);
+            outputMesh.boundsMax = hlslpp::float3(boundsMax[0], boundsMax[1], boundsMax[2]);
+        }
+
+        // LODs are simplified from the float vertices above, quantise only what gets uploaded
+        std::vector<render::QuantisedMeshVertex> quantisedVertices = render::quantiseMeshVertices(vertices.data(), vertices.size(), outputMesh);
+        const gpu::GpuFormat indexFormat = render::getMeshIndexFormat(vertices.size());
 
         gpu::BufferHandle vertexBufferHandle;
         gpu::BufferHandle indexBufferHandle;
 
         // Vertex buffer
         vertexBufferHandle = m_device->makeBuffer({ .type = gpu::BufferType::VertexBuffer, .usage = gpu::Usage::Default, .debugName = fmt::format("{}_vertexBuffer", meshPath) });
-        m_device->writeBuffer(vertexBufferHandle, vertices.size() * sizeof(render::PositionNormalTexcoordVertex), vertices.data());
+        m_device->writeBuffer(vertexBufferHandle, quantisedVertices.size() * sizeof(render::QuantisedMeshVertex), quantisedVertices.data());
 
         // Triangle indices
-        indexBufferHandle = m_device->makeBuffer({ .type = gpu::BufferType::IndexBuffer, .usage = gpu::Usage::Default, .format = gpu::GpuFormat::Uint32_TYPELESS, .debugName = fmt::format("{}_indexBuffer", meshPath) });
-        m_device->writeBuffer(indexBufferHandle, indices.size() * sizeof(uint32_t), indices.data());
+        indexBufferHandle = m_device->makeBuffer({ .type = gpu::BufferType::IndexBuffer, .usage = gpu::Usage::Default, .format = indexFormat, .debugName = fmt::format("{}_indexBuffer", meshPath) });
+        if (indexFormat == gpu::GpuFormat::Uint16_TYPELESS) {
+            std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+            m_device->writeBuffer(indexBufferHandle, shortIndices.size() * sizeof(uint16_t), shortIndices.data());
+            outputMesh.indexSize = sizeof(uint16_t);
+        } else {
+            m_device->writeBuffer(indexBufferHandle, indices.size() * sizeof(uint32_t), indices.data());
+            outputMesh.indexSize = sizeof(uint32_t);
+        }
 
         // the VAO is tied to the mesh, soooo
+        // Positions are dequantised by the model matrix, normals by decodeOctahedralNormal in common.glsl
         gpu::VertexAttributeDesc vDesc[] = {
-            {.name = "POSITION", .format = gpu::GpuFormat::RGB8_TYPELESS, .bufferIndex = 0, .offset = offsetof(render::PositionNormalTexcoordVertex, position), .elementStride = sizeof(render::PositionNormalTexcoordVertex)},
-            {.name = "NORMAL", .format = gpu::GpuFormat::RGB8_TYPELESS, .bufferIndex = 1, .offset = offsetof(render::PositionNormalTexcoordVertex, normal), .elementStride = sizeof(render::PositionNormalTexcoordVertex)},
-            {.name = "TEXCOORD0", .format = gpu::GpuFormat::RG8_TYPELESS, .bufferIndex = 2, .offset = offsetof(render::PositionNormalTexcoordVertex, uv), .elementStride = sizeof(render::PositionNormalTexcoordVertex)}
+            {.name = "POSITION", .format = gpu::GpuFormat::RGBA16_SNORM, .bufferIndex = 0, .offset = offsetof(render::QuantisedMeshVertex, position), .elementStride = sizeof(render::QuantisedMeshVertex)},
+            {.name = "NORMAL", .format = gpu::GpuFormat::RG16_SNORM, .bufferIndex = 1, .offset = offsetof(render::QuantisedMeshVertex, normal), .elementStride = sizeof(render::QuantisedMeshVertex)},
+            {.name = "TEXCOORD0", .format = gpu::GpuFormat::RG16_FLOAT, .bufferIndex = 2, .offset = offsetof(render::QuantisedMeshVertex, uv), .elementStride = sizeof(render::QuantisedMeshVertex)}
         };
 
         gpu::InputLayoutHandle vertexLayoutHandle = m_device->createInputLayout(vDesc, sizeof(vDesc) / sizeof(vDesc[0]));
 
-        render::Mesh outputMesh{
-            .vertexBuffer = vertexBufferHandle,
-            .indexBuffer = indexBufferHandle,
-            .vertexLayout = vertexLayoutHandle,
-            .triangleCount = indices.size() / 3U // There are 3 vertices per triangle, so divide by 3
-        };
+        outputMesh.vertexBuffer = vertexBufferHandle;
+        outputMesh.indexBuffer = indexBufferHandle;
+        outputMesh.vertexLayout = vertexLayoutHandle;
+        outputMesh.triangleCount = lod0IndexCount / 3U; // There are 3 vertices per triangle, so divide by 3
+        for (uint32_t i = 0; i < lodCount; i++) {
+            outputMesh.lods[i] = lods[i];
+        }
+        outputMesh.lodCount = lodCount;
 
-        m_device->debugMarkerPop();
+        GPU_MARKER_POP(m_device);
 
         if (vertexBufferHandle.Get() != nullptr && indexBufferHandle.Get() != nullptr && vertexLayoutHandle.Get() != nullptr) {
             // Cache
@@ -359,7 +443,12 @@ void main()
         }
 
         // Check if the shader was loaded before
-        std::string shaderKey = params.vertShader + params.fragShader;
+        std::string shaderKey = fmt::format("{}:{}|{}:{}", params.vertShader, params.vertShaderEntryFunction, params.fragShader, params.fragShaderEntryFunction);
+        std::string shaderDefines;
+        for (const std::string& define : params.defines) {
+            shaderKey += fmt::format("|{}", define);
+            shaderDefines += fmt::format("#define {}\n", define);
+        }
         if (m_shaders.find(shaderKey) != m_shaders.end()) {
             return m_shaders[shaderKey];
         }
@@ -370,13 +459,15 @@ void main()
         std::string filePathFrag = fmt::format("{}/assets/shaders/{}", m_applicationRootPath, params.fragShader);
 
         char stbError[256] = {};
-        std::string vertContents = SHADER_HEADER;
-        std::string fragContents = SHADER_HEADER;
+        // Defines go straight after the #version line, ahead of every include
+        std::string vertContents = SHADER_HEADER + shaderDefines;
+        std::string fragContents = SHADER_HEADER + shaderDefines;
         
         // stb_include is used to be able to separate common buffers between shaders
-        // e.g. light data, camera data, etc
+        // e.g. light data, camera data, etc. #inject in common.glsl takes the generated uniform block declarations
+        std::string uniformBlocksGlsl = render::getUniformBlocksGlsl();
         {
-            char* vertContentsRaw = stb_include_file(filePathVert.data(), nullptr, fmt::format("{}/assets/shaders", m_applicationRootPath).data(), stbError);
+            char* vertContentsRaw = stb_include_file(filePathVert.data(), uniformBlocksGlsl.data(), fmt::format("{}/assets/shaders", m_applicationRootPath).data(), stbError);
             if (vertContentsRaw != nullptr) {
                 // Sucessfully loaded the file
                 vertContents += vertContentsRaw;
@@ -387,7 +478,7 @@ void main()
             }
         }
         {
-            char* fragContentsRaw = stb_include_file(filePathFrag.data(), nullptr, fmt::format("{}/assets/shaders", m_applicationRootPath).data(), stbError);
+            char* fragContentsRaw = stb_include_file(filePathFrag.data(), uniformBlocksGlsl.data(), fmt::format("{}/assets/shaders", m_applicationRootPath).data(), stbError);
             if (fragContentsRaw != nullptr) {
                 // Sucessfully loaded the file
                 fragContents += fragContentsRaw;
@@ -398,18 +489,43 @@ void main()
             }
         }
 
-        m_device->debugMarkerPush(fmt::format("Loading shader {} , {}...", params.vertShader, params.fragShader));
+        const bool hasVariants = params.defines.empty() &&
+            (vertContents.find("MATERIAL_VARIANT") != std::string::npos || fragContents.find("MATERIAL_VARIANT") != std::string::npos);
+
+        // Skip compiling if an earlier run left the linked program behind
+        std::string cachePath = getShaderCachePath(vertContents, fragContents, params);
+        gpu::ShaderBinary shaderBinary;
+        bool hasBinary = !cachePath.empty() && loadShaderBinary(cachePath, vertContents, fragContents, shaderBinary);
+
+        GPU_MARKER_PUSH(m_device, "Loading shader {} , {}...", params.vertShader, params.fragShader);
 
         auto shaderHandle = m_device->makeShader({
-            .VS {.byteCode = (uint8_t*)vertContents.c_str(), .entryFunc = params.vertShaderEntryFunction },
-            .PS {.byteCode = (uint8_t*)fragContents.c_str(), .entryFunc = params.fragShaderEntryFunction },
-            .graphicsState = params.graphicsState,
+            .VS {.byteCode = (uint8_t*)vertContents.c_str(), .entryFunc = params.vertShaderEntryFunction, .sourceName = params.vertShader },
+            .PS {.byteCode = (uint8_t*)fragContents.c_str(), .entryFunc = params.fragShaderEntryFunction, .sourceName = params.fragShader },
             .debugName = params.debugName,
+            .binary = hasBinary ? &shaderBinary : nullptr,
+            .async = true,
         });
 
-        m_device->debugMarkerPop();
+        GPU_MARKER_POP(m_device);
 
         if (shaderHandle.Get() != nullptr) {
+            if (shaderHandle->isLoadedFromBinary()) {
+                LOG_INFO("Loaded shader {} , {} from the shader cache", params.vertShader, params.fragShader);
+            } else {
+                // Draws use the error shader until the driver is done, see resolveShader
+                m_pendingShaders.emplace(shaderHandle.Get(), PendingShader{
+                    .shader = shaderHandle,
+                    .cachePath = cachePath,
+                    .vertContents = std::move(vertContents),
+                    .fragContents = std::move(fragContents),
+                });
+            }
+
+            if (hasVariants) {
+                m_variantShaderParams.emplace(shaderHandle.Get(), params);
+            }
+
             // Cache
             m_shaders.emplace(shaderKey, shaderHandle);
             return shaderHandle;
@@ -418,6 +534,157 @@ void main()
             return m_errorShader;
         }
     }
+
+    gpu::IShader* AssetManager::fetchShaderVariant(gpu::IShader* shader, const std::vector<std::string>& defines) {
+        auto baseParams = m_variantShaderParams.find(shader);
+        if (baseParams == m_variantShaderParams.end()) {
+            return shader;
+        }
+
+        FetchShaderParams params = baseParams->second;
+        params.defines = defines;
+        for (const std::string& define : defines) {
+            params.debugName += fmt::format(" {}", define);
+        }
+        return fetchShader(params);
+    }
+
+    std::string AssetManager::getShaderCachePath(const std::string& vertContents, const std::string& fragContents, const FetchShaderParams& params) {
+        const std::string driverTag = m_device->getShaderBinaryTag();
+        if (driverTag.empty()) {
+            return "";
+        }
+
+        // Includes and defines are already expanded into the contents, so they're part of the hash too
+        uint64_t hash = 0xcbf29ce484222325ull;
+        hash = hashShaderString(hash, driverTag);
+        hash = hashShaderString(hash, vertContents);
+        hash = hashShaderString(hash, params.vertShaderEntryFunction);
+        hash = hashShaderString(hash, fragContents);
+        hash = hashShaderString(hash, params.fragShaderEntryFunction);
+        return fmt::format("{}/shader_cache/{:016x}.bin", m_applicationRootPath, hash);
+    }
+
+    bool AssetManager::loadShaderBinary(const std::string& cachePath, const std::string& vertContents, const std::string& fragContents, gpu::ShaderBinary& outBinary) {
+        FILE* file = fopen(cachePath.c_str(), "rb");
+        if (file == nullptr) {
+            return false;
+        }
+
+        bool valid = false;
+        ShaderCacheHeader header = {};
+        if (fread(&header, sizeof(header), 1, file) == 1 &&
+            header.magic == SHADER_CACHE_MAGIC &&
+            header.version == SHADER_CACHE_VERSION &&
+            header.vertSize == vertContents.size() &&
+            header.fragSize == fragContents.size() &&
+            header.binarySize > 0) {
+
+            std::string cachedVert(header.vertSize, '\0');
+            std::string cachedFrag(header.fragSize, '\0');
+            outBinary.format = header.binaryFormat;
+            outBinary.data.resize(header.binarySize);
+            valid = fread(cachedVert.data(), 1, cachedVert.size(), file) == cachedVert.size() &&
+                fread(cachedFrag.data(), 1, cachedFrag.size(), file) == cachedFrag.size() &&
+                fread(outBinary.data.data(), 1, outBinary.data.size(), file) == outBinary.data.size() &&
+                cachedVert == vertContents &&
+                cachedFrag == fragContents;
+        }
+        fclose(file);
+
+        if (!valid) {
+            LOG_WARNING("Shader cache entry {} is stale or corrupt, recompiling", cachePath);
+            outBinary = {};
+        }
+        return valid;
+    }
+
+    void AssetManager::saveShaderBinary(const std::string& cachePath, const std::string& vertContents, const std::string& fragContents, gpu::IShader* shader) {
+        gpu::ShaderBinary shaderBinary;
+        if (!m_device->getShaderBinary(shader, shaderBinary)) {
+            return;
+        }
+
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path(), error);
+
+        FILE* file = fopen(cachePath.c_str(), "wb");
+        if (file == nullptr) {
+            LOG_WARNING("Failed to write shader cache entry {}", cachePath);
+            return;
+        }
+
+        ShaderCacheHeader header = {
+            .magic = SHADER_CACHE_MAGIC,
+            .version = SHADER_CACHE_VERSION,
+            .binaryFormat = shaderBinary.format,
+            .vertSize = static_cast<uint32_t>(vertContents.size()),
+            .fragSize = static_cast<uint32_t>(fragContents.size()),
+            .binarySize = static_cast<uint32_t>(shaderBinary.data.size()),
+        };
+        fwrite(&header, sizeof(header), 1, file);
+        fwrite(vertContents.data(), 1, vertContents.size(), file);
+        fwrite(fragContents.data(), 1, fragContents.size(), file);
+        fwrite(shaderBinary.data.data(), 1, shaderBinary.data.size(), file);
+        fclose(file);
+    }
+
+    size_t AssetManager::PipelineDescHash::operator()(const gpu::PipelineDesc& desc) const {
+        size_t seed = std::hash<const void*>{}(desc.shader);
+        auto hashCombine = [&seed](size_t value) {
+            seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        };
+        hashCombine(std::hash<const void*>{}(desc.inputLayout));
+        hashCombine(std::hash<const void*>{}(desc.blendState));
+        // Every field of the graphics state fits in a few bits
+        const gpu::GraphicsState& state = desc.graphicsState;
+        hashCombine((size_t)state.depthState
+            | ((size_t)state.faceCullingMode << 8)
+            | ((size_t)state.faceWindingOrder << 16)
+            | ((size_t)state.depthWrite << 24)
+            | ((size_t)state.depthTest << 25)
+            | ((size_t)state.colorWrite << 26));
+        return seed;
+    }
+
+    gpu::IShader* AssetManager::resolveShader(gpu::IShader* shader) {
+        const gpu::ShaderStatus status = shader->pollStatus();
+        if (status == gpu::ShaderStatus::Compiling) {
+            m_compilingShaderFallbacks++;
+            return m_errorShader;
+        }
+
+        auto pending = m_pendingShaders.find(shader);
+        if (pending != m_pendingShaders.end()) {
+            const gpu::ShaderDesc& shaderDesc = shader->getDesc();
+            if (status == gpu::ShaderStatus::Failed) {
+                LOG_CRITICAL("Failed loading shader {} , {}!", shaderDesc.VS.sourceName, shaderDesc.PS.sourceName);
+            } else if (!pending->second.cachePath.empty()) {
+                // Missing, stale or rejected by the driver
+                saveShaderBinary(pending->second.cachePath, pending->second.vertContents, pending->second.fragContents, shader);
+            }
+            m_pendingShaders.erase(pending);
+        }
+        return status == gpu::ShaderStatus::Ready ? shader : m_errorShader.Get();
+    }
+
+    gpu::IPipeline* AssetManager::fetchPipeline(const gpu::PipelineDesc& desc) {
+        ASSERT(desc.shader != nullptr);
+        ASSERT(desc.inputLayout != nullptr);
+
+        // Pipelines are looked up every draw, so this is also where async compiles get noticed finishing
+        gpu::PipelineDesc resolvedDesc = desc;
+        resolvedDesc.shader = resolveShader(desc.shader);
+
+        auto pipeline = m_pipelines.find(resolvedDesc);
+        if (pipeline != m_pipelines.end()) {
+            return pipeline->second;
+        }
+
+        gpu::PipelineHandle pipelineHandle = m_device->makePipeline(resolvedDesc);
+        m_pipelines.emplace(resolvedDesc, pipelineHandle);
+        return pipelineHandle;
+    }
     gpu::ITexture* AssetManager::fetchTexture(const std::string& texturePath, const bool genMipmaps) {
 
         if (!m_intialisedDefaultAssets) {   
@@ -437,7 +704,7 @@ void main()
             return m_errorTexture;
         }
 
-        m_device->debugMarkerPush(fmt::format("Loading texture {}...", texturePath));
+        GPU_MARKER_PUSH(m_device, "Loading texture {}...", texturePath);
         gpu::TextureHandle textureHandle = m_device->makeTexture({
             .width = (uint32_t)texWidth,
             .height = (uint32_t)texHeight,
@@ -445,7 +712,7 @@ void main()
             .type = gpu::TextureType::Texture2D,
             .debugName = texturePath,
             }, texData);
-        m_device->debugMarkerPop();
+        GPU_MARKER_POP(m_device);
 
         if (textureHandle.Get() != nullptr) {
             // Cache
@@ -18,22 +18,40 @@ namespace managers {
         ~AssetManager();
 
         struct FetchShaderParams {
-            gpu::GraphicsState graphicsState;
             std::string vertShader;
             std::string fragShader;
             std::string vertShaderEntryFunction = "main";
             std::string fragShaderEntryFunction = "main";
             std::string debugName = "";
+            // Each one is "NAME" or "NAME value", inserted as a #define after the #version line
+            std::vector<std::string> defines;
         };
         
         render::Mesh fetchMesh(const std::string& meshPath);
+        // Shaders compile asynchronously. Until the driver finishes, or if it fails, fetchPipeline swaps in the error shader
         gpu::IShader* fetchShader(const FetchShaderParams& params);
+        // A permutation of a shader from fetchShader, compiled again with defines added. Only shaders whose sources mention
+        // MATERIAL_VARIANT have permutations, any other shader is returned as is. Variants are cached like any other shader
+        gpu::IShader* fetchShaderVariant(gpu::IShader* shader, const std::vector<std::string>& defines);
+        // Pipelines are cached by their whole descriptor, so every draw with the same shader, layout and state shares one.
+        // The cache refers to the shader, input layout and blend state by pointer, they must outlive the asset manager
+        gpu::IPipeline* fetchPipeline(const gpu::PipelineDesc& desc);
+        // Counts the fetchPipeline calls that swapped in the error shader for one still compiling. Anything rendered once and
+        // reused across frames compares it before and after drawing, and renders again later if it moved
+        [[nodiscard]] inline uint64_t getCompilingShaderFallbackCount() const { return m_compilingShaderFallbacks; }
         gpu::ITexture* fetchTexture(const std::string& texturePath, const bool genMipmaps = true);
         inline gpu::ITexture* fetchWhiteTexture() { return m_whiteTexture; }
         std::string getExecutableDir();
         
     private:
         void initialiseErrorData();
+        // Linked programs are cached under shader_cache, keyed by the preprocessed sources and the driver. The sources are
+        // stored next to the binary and compared on load, so a hash collision compiles instead of using the wrong program
+        std::string getShaderCachePath(const std::string& vertContents, const std::string& fragContents, const FetchShaderParams& params);
+        bool loadShaderBinary(const std::string& cachePath, const std::string& vertContents, const std::string& fragContents, gpu::ShaderBinary& outBinary);
+        void saveShaderBinary(const std::string& cachePath, const std::string& vertContents, const std::string& fragContents, gpu::IShader* shader);
+        // The shader to draw with in place of shader, the error shader while it's compiling or if it failed
+        gpu::IShader* resolveShader(gpu::IShader* shader);
 
     private:
 
@@ -48,9 +66,25 @@ namespace managers {
             render::Mesh mesh;
         };
 
+        // A shader still being compiled. The sources are kept to write the binary cache entry once it's done
+        struct PendingShader {
+            gpu::ShaderHandle shader;
+            std::string cachePath;
+            std::string vertContents;
+            std::string fragContents;
+        };
+
+        struct PipelineDescHash {
+            size_t operator()(const gpu::PipelineDesc& desc) const;
+        };
+
         std::unordered_map<std::string, gpu::ShaderHandle> m_shaders;
         std::unordered_map<std::string, gpu::TextureHandle> m_textures;
         std::unordered_map<std::string, MeshTracker_t> m_meshes;
+        std::unordered_map<gpu::PipelineDesc, gpu::PipelineHandle, PipelineDescHash> m_pipelines;
+        std::unordered_map<gpu::IShader*, PendingShader> m_pendingShaders;
+        // How shaders with permutations were fetched, to fetch their variants
+        std::unordered_map<gpu::IShader*, FetchShaderParams> m_variantShaderParams;
 
         gpu::ShaderHandle m_errorShader;
         gpu::TextureHandle m_errorTexture;
@@ -58,6 +92,7 @@ namespace managers {
         MeshTracker_t m_errorMesh;
 
         bool m_intialisedDefaultAssets = false;
+        uint64_t m_compilingShaderFallbacks = 0;
         gpu::IDevice* m_device;
 
         std::string m_applicationRootPath;
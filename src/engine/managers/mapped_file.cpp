@@ -0,0 +1,92 @@
+#include "mapped_file.hpp"
+#include "engine/log.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace managers {
+
+    MappedFile::~MappedFile() {
+        close();
+    }
+
+    bool MappedFile::open(const std::string& filePath) {
+        close();
+
+#ifdef _WIN32
+        HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            LOG_ERROR("[MappedFile]: File {} could not be opened.", filePath);
+            return false;
+        }
+        LARGE_INTEGER fileSize = {};
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+            LOG_ERROR("[MappedFile]: File {} is empty.", filePath);
+            CloseHandle(file);
+            return false;
+        }
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr) {
+            LOG_ERROR("[MappedFile]: File {} could not be mapped.", filePath);
+            CloseHandle(file);
+            return false;
+        }
+        void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (view == nullptr) {
+            LOG_ERROR("[MappedFile]: File {} could not be mapped.", filePath);
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+        m_fileHandle = file;
+        m_mappingHandle = mapping;
+        m_data = static_cast<const uint8_t*>(view);
+        m_size = static_cast<size_t>(fileSize.QuadPart);
+#else
+        int file = ::open(filePath.c_str(), O_RDONLY);
+        if (file < 0) {
+            LOG_ERROR("[MappedFile]: File {} could not be opened.", filePath);
+            return false;
+        }
+        struct stat fileStat = {};
+        if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0) {
+            LOG_ERROR("[MappedFile]: File {} is empty.", filePath);
+            ::close(file);
+            return false;
+        }
+        void* view = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+        // The mapping keeps its own reference to the file
+        ::close(file);
+        if (view == MAP_FAILED) {
+            LOG_ERROR("[MappedFile]: File {} could not be mapped.", filePath);
+            return false;
+        }
+        m_data = static_cast<const uint8_t*>(view);
+        m_size = static_cast<size_t>(fileStat.st_size);
+#endif
+        return true;
+    }
+
+    void MappedFile::close() {
+        if (m_data == nullptr) {
+            return;
+        }
+#ifdef _WIN32
+        UnmapViewOfFile(m_data);
+        CloseHandle(m_mappingHandle);
+        CloseHandle(m_fileHandle);
+        m_mappingHandle = nullptr;
+        m_fileHandle = nullptr;
+#else
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+        m_data = nullptr;
+        m_size = 0;
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <inttypes.h>
+#include <string>
+
+namespace managers {
+
+    // Read only view of a whole file mapped into memory. Pages are only read from disk when touched
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // Returns false (and logs) if the file couldn't be opened or mapped
+        bool open(const std::string& filePath);
+        void close();
+
+        inline const uint8_t* getData() const { return m_data; }
+        inline size_t getSize() const { return m_size; }
+
+    private:
+        const uint8_t* m_data = nullptr;
+        size_t m_size = 0;
+
+#ifdef _WIN32
+        void* m_fileHandle = nullptr;
+        void* m_mappingHandle = nullptr;
+#endif
+    };
+}
@@ -0,0 +1,60 @@
+#include "dynamic_resolution.hpp"
+#include "engine/core.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace render {
+
+    void DynamicResolutionController::init(const DynamicResolutionDesc& desc) {
+        ASSERT(desc.targetFrameTime > 0.0);
+        ASSERT(desc.minScale > 0.0f);
+        ASSERT(desc.minScale <= desc.maxScale);
+
+        m_desc = desc;
+        m_scale = desc.maxScale;
+        m_smoothedFrameTime = 0.0;
+        m_framesSinceChange = 0;
+    }
+
+    void DynamicResolutionController::update(double cpuFrameTime, double gpuFrameTime) {
+        if (!m_desc.enabled) {
+            return;
+        }
+
+        double frameTime = std::max(cpuFrameTime, gpuFrameTime);
+        if (frameTime <= 0.0) {
+            // First frame of the app, nothing was measured yet
+            return;
+        }
+        m_smoothedFrameTime = m_smoothedFrameTime > 0.0
+            ? m_smoothedFrameTime + (frameTime - m_smoothedFrameTime) * k_dynamicResolutionSmoothing
+            : frameTime;
+
+        m_framesSinceChange++;
+        if (m_framesSinceChange < k_dynamicResolutionSettleFrames) {
+            return;
+        }
+
+        bool overBudget = m_smoothedFrameTime > m_desc.targetFrameTime;
+        bool underBudget = m_smoothedFrameTime < m_desc.targetFrameTime * k_dynamicResolutionHeadroom;
+        if (!overBudget && !underBudget) {
+            return;
+        }
+
+        // Pixel count goes with the square of the scale
+        float idealScale = m_scale * static_cast<float>(std::sqrt(m_desc.targetFrameTime / m_smoothedFrameTime));
+        float newScale = std::clamp(idealScale, m_scale - k_dynamicResolutionMaxStep, m_scale + k_dynamicResolutionMaxStep);
+        newScale = std::round(newScale / k_dynamicResolutionGranularity) * k_dynamicResolutionGranularity;
+        if (overBudget && newScale >= m_scale) {
+            // Slightly over budget rounds back to the same scale, always step down at least once
+            newScale = m_scale - k_dynamicResolutionGranularity;
+        }
+        newScale = std::clamp(newScale, m_desc.minScale, m_desc.maxScale);
+
+        if (newScale != m_scale) {
+            m_scale = newScale;
+            m_framesSinceChange = 0;
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <inttypes.h>
+
+namespace render {
+
+    // Weight of the newest frame in the smoothed frame time. Low enough that a single hitch doesn't drop the resolution
+    constexpr double k_dynamicResolutionSmoothing = 0.1;
+    // Frames to wait after changing the scale before changing it again, so the smoothed frame time can catch up
+    constexpr uint32_t k_dynamicResolutionSettleFrames = 10;
+    // Only scale up once frames take less than this fraction of the budget, stops the scale oscillating around the target
+    constexpr double k_dynamicResolutionHeadroom = 0.85;
+    // Largest change to the scale in a single step
+    constexpr float k_dynamicResolutionMaxStep = 0.1f;
+    // Scales are rounded to multiples of this, small changes aren't worth rendering at a different size
+    constexpr float k_dynamicResolutionGranularity = 1.0f / 32.0f;
+
+    struct DynamicResolutionDesc {
+        bool enabled = true;
+        // Frame time budget in seconds
+        double targetFrameTime = 1.0 / 60.0;
+        // Bounds of the scale applied to each axis of the window size
+        float minScale = 0.5f;
+        float maxScale = 1.0f;
+    };
+
+    // Picks the resolution the 3D scene renders at, as a fraction of the window size, from measured frame times.
+    // Rendering cost is assumed to be proportional to the number of pixels, so the scale moves with the square root of
+    // how far the frame time is from the budget
+    class DynamicResolutionController {
+    public:
+        void init(const DynamicResolutionDesc& desc);
+
+        // Feeds the time it took to produce the last frame, excluding any time spent waiting for the frame limiter or vsync.
+        // gpuFrameTime is optional, when it is known the slower of the two drives the scale
+        void update(double cpuFrameTime, double gpuFrameTime = 0.0);
+
+        inline bool isEnabled() const { return m_desc.enabled; }
+        inline float getScale() const { return m_desc.enabled ? m_scale : 1.0f; }
+        // Largest scale the controller can pick, render targets are allocated for this so they never resize with the scale
+        inline float getMaxScale() const { return m_desc.enabled ? m_desc.maxScale : 1.0f; }
+        inline double getSmoothedFrameTime() const { return m_smoothedFrameTime; }
+        inline const DynamicResolutionDesc& getDesc() const { return m_desc; }
+
+    private:
+        DynamicResolutionDesc m_desc;
+        float m_scale = 1.0f;
+        double m_smoothedFrameTime = 0.0;
+        uint32_t m_framesSinceChange = 0;
+    };
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <inttypes.h>
+
+// Layout of the cooked font files written by the font cooker (tools/font_cooker) and mapped by FontRenderer::loadFont.
+// Everything is little endian and 4 byte aligned, so the tables can be used in place without any parsing.
+// Kept free of engine dependencies as the cooker includes it too
+namespace render {
+
+    constexpr uint32_t k_fontFileMagic = 0x544E4642; // "BFNT"
+    constexpr uint32_t k_fontFileVersion = 1;
+
+    struct FontFileHeader {
+        uint32_t magic;
+        uint32_t version;
+
+        // Metrics, in ems except for emSize
+        // Pixels per em the atlas was generated with
+        float emSize;
+        float lineHeight;
+        float ascender;
+        float descender;
+
+        // Glyph table, indexed by code point - firstCodePoint. Slots without a glyph are zeroed
+        uint32_t firstCodePoint;
+        uint32_t glyphCount;
+        uint32_t glyphTableOffset;
+
+        // Kerning table, sorted by (first, second) code point
+        uint32_t kerningPairCount;
+        uint32_t kerningTableOffset;
+    };
+
+    struct GlyphInfo {
+        // 0 if the font has no glyph for this slot
+        uint32_t unicodeCodePoint;
+        float horizAdvanceEm;
+        // left, bottom, right, top in ems, relative to the caret
+        float quadBounds[4];
+        // left, bottom, right, top in atlas pixels
+        float pixelBounds[4];
+    };
+
+    struct KerningPair {
+        uint32_t firstCodePoint;
+        uint32_t secondCodePoint;
+        // Added to the advance between the two glyphs, in ems
+        float advanceEm;
+    };
+
+    static_assert(sizeof(FontFileHeader) == 44);
+    static_assert(sizeof(GlyphInfo) == 40);
+    static_assert(sizeof(KerningPair) == 12);
+}
@@ -4,4 +4,58 @@ namespace render {
     void bindMaterial(Material& mat) {
         // @TODO: bind material
     }
+
+    uint32_t getMaterialFeatures(const Material& mat) {
+        uint32_t features = 0;
+        if (mat.diffuseTex != nullptr) {
+            features |= k_materialFeature_DiffuseTex;
+        }
+        if (mat.metaTex != nullptr) {
+            features |= k_materialFeature_MetaTex;
+        }
+        if (mat.emissionIntensity != 0.0f &&
+            ((float)mat.emissionColour.x != 0.0f || (float)mat.emissionColour.y != 0.0f || (float)mat.emissionColour.z != 0.0f)) {
+            features |= k_materialFeature_Emission;
+            if (mat.emissionTex != nullptr) {
+                features |= k_materialFeature_EmissionTex;
+            }
+        }
+        if (mat.matcapTex != nullptr) {
+            features |= k_materialFeature_MatcapTex;
+        }
+        if (mat.brdfLutTex != nullptr) {
+            features |= k_materialFeature_BrdfLutTex;
+        }
+        if (mat.glintFactor != 0.0f) {
+            features |= k_materialFeature_Glint;
+        }
+        return features;
+    }
+
+    std::vector<std::string> getMaterialVariantDefines(uint32_t features, uint32_t lightCount) {
+        std::vector<std::string> defines = { "MATERIAL_VARIANT" };
+        if (features & k_materialFeature_DiffuseTex) {
+            defines.push_back("HAS_DIFFUSE_TEX");
+        }
+        if (features & k_materialFeature_MetaTex) {
+            defines.push_back("HAS_META_TEX");
+        }
+        if (features & k_materialFeature_Emission) {
+            defines.push_back("HAS_EMISSION");
+        }
+        if (features & k_materialFeature_EmissionTex) {
+            defines.push_back("HAS_EMISSION_TEX");
+        }
+        if (features & k_materialFeature_MatcapTex) {
+            defines.push_back("HAS_MATCAP_TEX");
+        }
+        if (features & k_materialFeature_BrdfLutTex) {
+            defines.push_back("HAS_BRDF_LUT_TEX");
+        }
+        if (features & k_materialFeature_Glint) {
+            defines.push_back("HAS_GLINT");
+        }
+        defines.push_back("LIGHT_COUNT " + std::to_string(lightCount));
+        return defines;
+    }
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <inttypes.h>
 #include <string>
+#include <vector>
 #include <hlsl++.h>
 #include <engine/gpu/idevice.hpp>
 
@@ -12,9 +13,29 @@ namespace render {
 	constexpr uint32_t k_drawOrder_Transparent	= 3000;
 	constexpr uint32_t k_drawOrder_Ui			= 4000;
 
+	enum class TransparencyMode : uint8_t {
+		// Drawn back to front, one object at a time, with the object's own blend state
+		Sorted,
+		// Weighted blended order independent transparency. Never sorted, the shader must define WEIGHTED_BLENDED_OIT
+		// and write its colour through oit.glsl (e.g. frag_oit.glsl, particle_oit_frag.glsl)
+		WeightedBlended,
+	};
+
+	// Optional parts of a shader with material variants (one that checks MATERIAL_VARIANT, like frag.glsl). A variant leaves out
+	// every feature the material doesn't use
+	constexpr uint32_t k_materialFeature_DiffuseTex		= 1 << 0;
+	constexpr uint32_t k_materialFeature_MetaTex		= 1 << 1;
+	constexpr uint32_t k_materialFeature_Emission		= 1 << 2;
+	constexpr uint32_t k_materialFeature_EmissionTex	= 1 << 3;
+	constexpr uint32_t k_materialFeature_MatcapTex		= 1 << 4;
+	constexpr uint32_t k_materialFeature_BrdfLutTex		= 1 << 5;
+	constexpr uint32_t k_materialFeature_Glint			= 1 << 6;
+
 	struct Material {
 		// shader must not be null, or we will hit an assert
 		gpu::IShader* shader = nullptr;
+		// Depth, culling and colour writes to draw the shader with. Blending comes from the draw order and transparency mode
+		gpu::GraphicsState graphicsState;
 
 		std::string name = ""; // debug name
 
@@ -36,8 +57,16 @@ namespace render {
 		gpu::ITexture* brdfLutTex = nullptr;
 
 		uint32_t drawOrder = k_drawOrder_Opaque;
+		// Only used if drawOrder is above k_drawOrder_Opaque
+		TransparencyMode transparencyMode = TransparencyMode::Sorted;
 	};
 
 	// bind material to the opengl state machine
 	void bindMaterial(Material& mat);
+
+	// The features mat's values need. Textures that aren't set are bound as the white fallback, and zero emission or glint adds
+	// nothing, so the variant without them draws the same
+	uint32_t getMaterialFeatures(const Material& mat);
+	// Defines for the variant with features and the first lightCount lights, passed to AssetManager::fetchShaderVariant
+	std::vector<std::string> getMaterialVariantDefines(uint32_t features, uint32_t lightCount);
 }
\ No newline at end of file
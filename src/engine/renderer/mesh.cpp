@@ -1,2 +1,354 @@
 #include "mesh.hpp"
+#include "engine/core.hpp"
 
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace render {
+
+    std::vector<uint32_t> simplifyMeshClustered(const PositionNormalTexcoordVertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, uint32_t gridResolution) {
+        std::vector<uint32_t> simplified;
+        if (vertexCount == 0 || indexCount < 3 || gridResolution == 0) {
+            return simplified;
+        }
+
+        float boundsMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float boundsMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        for (size_t i = 0; i < vertexCount; i++) {
+            for (int axis = 0; axis < 3; axis++) {
+                boundsMin[axis] = std::min(boundsMin[axis], vertices[i].position[axis]);
+                boundsMax[axis] = std::max(boundsMax[axis], vertices[i].position[axis]);
+            }
+        }
+        float extent = std::max({ boundsMax[0] - boundsMin[0], boundsMax[1] - boundsMin[1], boundsMax[2] - boundsMin[2] });
+        float cellScale = extent > 0.0f ? gridResolution / extent : 0.0f;
+
+        auto cellOf = [&](const PositionNormalTexcoordVertex& vertex) -> uint64_t {
+            uint64_t cell[3] = {};
+            for (int axis = 0; axis < 3; axis++) {
+                cell[axis] = std::min<uint64_t>(gridResolution - 1, static_cast<uint64_t>((vertex.position[axis] - boundsMin[axis]) * cellScale));
+            }
+            // 21 bits per axis is far more than any grid we'd use
+            return cell[0] | (cell[1] << 21) | (cell[2] << 42);
+        };
+
+        struct Cluster {
+            float centroid[3] = {};
+            uint32_t vertexCount = 0;
+            uint32_t representative = 0;
+            float representativeDistance = FLT_MAX;
+        };
+        std::unordered_map<uint64_t, Cluster> clusters;
+        std::vector<uint64_t> vertexCells(vertexCount);
+
+        // Average every cell's vertices...
+        for (size_t i = 0; i < vertexCount; i++) {
+            vertexCells[i] = cellOf(vertices[i]);
+            Cluster& cluster = clusters[vertexCells[i]];
+            for (int axis = 0; axis < 3; axis++) {
+                cluster.centroid[axis] += vertices[i].position[axis];
+            }
+            cluster.vertexCount++;
+        }
+        for (auto& [cell, cluster] : clusters) {
+            for (int axis = 0; axis < 3; axis++) {
+                cluster.centroid[axis] /= cluster.vertexCount;
+            }
+        }
+
+        // ...then keep the existing vertex closest to the average. Reusing a real vertex keeps its normal and UV intact
+        for (size_t i = 0; i < vertexCount; i++) {
+            Cluster& cluster = clusters[vertexCells[i]];
+            float distance = 0;
+            for (int axis = 0; axis < 3; axis++) {
+                float delta = vertices[i].position[axis] - cluster.centroid[axis];
+                distance += delta * delta;
+            }
+            if (distance < cluster.representativeDistance) {
+                cluster.representativeDistance = distance;
+                cluster.representative = static_cast<uint32_t>(i);
+            }
+        }
+
+        simplified.reserve(indexCount);
+        for (size_t i = 0; i + 2 < indexCount; i += 3) {
+            uint32_t a = clusters[vertexCells[indices[i + 0]]].representative;
+            uint32_t b = clusters[vertexCells[indices[i + 1]]].representative;
+            uint32_t c = clusters[vertexCells[indices[i + 2]]].representative;
+            // Triangle collapsed into a line or point
+            if (a == b || b == c || a == c) {
+                continue;
+            }
+            simplified.push_back(a);
+            simplified.push_back(b);
+            simplified.push_back(c);
+        }
+
+        return simplified;
+    }
+
+    struct VertexBitsHash {
+        size_t operator()(const PositionNormalTexcoordVertex& vertex) const {
+            // FNV-1a over the raw floats
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&vertex);
+            uint64_t hash = 0xcbf29ce484222325ull;
+            for (size_t i = 0; i < sizeof(PositionNormalTexcoordVertex); i++) {
+                hash ^= bytes[i];
+                hash *= 0x100000001b3ull;
+            }
+            return static_cast<size_t>(hash);
+        }
+    };
+
+    struct VertexBitsEqual {
+        bool operator()(const PositionNormalTexcoordVertex& a, const PositionNormalTexcoordVertex& b) const {
+            return memcmp(&a, &b, sizeof(PositionNormalTexcoordVertex)) == 0;
+        }
+    };
+
+    size_t weldMeshVertices(std::vector<PositionNormalTexcoordVertex>& vertices, std::vector<uint32_t>& indices) {
+        // Corners sharing an OBJ position, normal and uv index read the same floats, so exact matches are enough
+        std::unordered_map<PositionNormalTexcoordVertex, uint32_t, VertexBitsHash, VertexBitsEqual> unique;
+        unique.reserve(vertices.size());
+        std::vector<uint32_t> remap(vertices.size());
+        std::vector<PositionNormalTexcoordVertex> welded;
+        welded.reserve(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++) {
+            auto [it, inserted] = unique.try_emplace(vertices[i], static_cast<uint32_t>(welded.size()));
+            if (inserted) {
+                welded.push_back(vertices[i]);
+            }
+            remap[i] = it->second;
+        }
+        for (uint32_t& index : indices) {
+            index = remap[index];
+        }
+        vertices.swap(welded);
+        return vertices.size();
+    }
+
+    void optimiseVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize) {
+        const size_t triangleCount = indexCount / 3;
+        if (triangleCount == 0 || vertexCount == 0) {
+            return;
+        }
+
+        // Triangles using each vertex, packed: triangles of vertex v are adjacency[adjacencyOffset[v] .. adjacencyOffset[v + 1]]
+        std::vector<uint32_t> liveTriangles(vertexCount, 0);
+        for (size_t i = 0; i < triangleCount * 3; i++) {
+            liveTriangles[indices[i]]++;
+        }
+        std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+        for (size_t v = 0; v < vertexCount; v++) {
+            adjacencyOffset[v + 1] = adjacencyOffset[v] + liveTriangles[v];
+        }
+        std::vector<uint32_t> adjacency(triangleCount * 3);
+        std::vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; i++) {
+            adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        // A vertex is still cached while fewer than cacheSize misses happened since it was last loaded
+        std::vector<uint32_t> cacheTime(vertexCount, 0);
+        uint32_t time = cacheSize + 1;
+        std::vector<bool> emitted(triangleCount, false);
+        // Vertices of recently emitted triangles, to continue from when the fanning vertex runs out of triangles
+        std::vector<uint32_t> deadEnds;
+        std::vector<uint32_t> candidates;
+        std::vector<uint32_t> optimised;
+        optimised.reserve(triangleCount * 3);
+        size_t cursor = 0;
+
+        int64_t fanVertex = 0;
+        while (fanVertex >= 0) {
+            candidates.clear();
+            for (uint32_t a = adjacencyOffset[fanVertex]; a < adjacencyOffset[fanVertex + 1]; a++) {
+                uint32_t triangle = adjacency[a];
+                if (emitted[triangle]) {
+                    continue;
+                }
+                for (uint32_t corner = 0; corner < 3; corner++) {
+                    uint32_t vertex = indices[triangle * 3 + corner];
+                    optimised.push_back(vertex);
+                    deadEnds.push_back(vertex);
+                    candidates.push_back(vertex);
+                    liveTriangles[vertex]--;
+                    if (time - cacheTime[vertex] > cacheSize) {
+                        cacheTime[vertex] = time++;
+                    }
+                }
+                emitted[triangle] = true;
+            }
+
+            // Fan next around the candidate that stays cached longest once its remaining triangles are emitted
+            fanVertex = -1;
+            int64_t bestPriority = -1;
+            for (uint32_t vertex : candidates) {
+                if (liveTriangles[vertex] == 0) {
+                    continue;
+                }
+                int64_t priority = 0;
+                if (time - cacheTime[vertex] + 2 * liveTriangles[vertex] <= cacheSize) {
+                    priority = time - cacheTime[vertex];
+                }
+                if (priority > bestPriority) {
+                    bestPriority = priority;
+                    fanVertex = vertex;
+                }
+            }
+
+            // Dead end, back up through recently used vertices, then scan for any vertex with triangles left
+            while (fanVertex < 0 && !deadEnds.empty()) {
+                uint32_t vertex = deadEnds.back();
+                deadEnds.pop_back();
+                if (liveTriangles[vertex] > 0) {
+                    fanVertex = vertex;
+                }
+            }
+            for (; fanVertex < 0 && cursor < vertexCount; cursor++) {
+                if (liveTriangles[cursor] > 0) {
+                    fanVertex = static_cast<int64_t>(cursor);
+                }
+            }
+        }
+
+        ASSERT(optimised.size() == triangleCount * 3);
+        std::copy(optimised.begin(), optimised.end(), indices);
+    }
+
+    void optimiseVertexFetch(std::vector<PositionNormalTexcoordVertex>& vertices, uint32_t* indices, size_t indexCount) {
+        std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+        std::vector<PositionNormalTexcoordVertex> reordered;
+        reordered.reserve(vertices.size());
+        for (size_t i = 0; i < indexCount; i++) {
+            uint32_t& newIndex = remap[indices[i]];
+            if (newIndex == UINT32_MAX) {
+                newIndex = static_cast<uint32_t>(reordered.size());
+                reordered.push_back(vertices[indices[i]]);
+            }
+            indices[i] = newIndex;
+        }
+        vertices.swap(reordered);
+    }
+
+    float computeVertexCacheAcmr(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize) {
+        if (indexCount < 3) {
+            return 0.0f;
+        }
+        // Same timestamp trick as optimiseVertexCache, simulates a FIFO without storing it
+        std::vector<uint32_t> cacheTime(vertexCount, 0);
+        uint32_t time = cacheSize + 1;
+        size_t misses = 0;
+        for (size_t i = 0; i < indexCount; i++) {
+            if (time - cacheTime[indices[i]] > cacheSize) {
+                cacheTime[indices[i]] = time++;
+                misses++;
+            }
+        }
+        return static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+    }
+
+    static int16_t quantiseSnorm16(float value) {
+        return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    // Rounds to nearest, out of range values become infinity and tiny ones denormals or zero
+    static uint16_t floatToHalf(float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+        const uint32_t floatExponent = (bits >> 23) & 0xFF;
+        uint32_t mantissa = bits & 0x7FFFFF;
+        if (floatExponent == 0xFF) {
+            // Infinity or NaN
+            return sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0);
+        }
+        const int32_t exponent = static_cast<int32_t>(floatExponent) - 127 + 15;
+        if (exponent >= 0x1F) {
+            return sign | 0x7C00;
+        }
+        if (exponent <= 0) {
+            if (exponent < -10) {
+                return sign;
+            }
+            mantissa |= 0x800000;
+            const uint32_t shift = static_cast<uint32_t>(14 - exponent);
+            uint32_t half = mantissa >> shift;
+            half += (mantissa >> (shift - 1)) & 1;
+            return static_cast<uint16_t>(sign | half);
+        }
+        uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+        // A carry out of the mantissa bumps the exponent, which is still the right rounding
+        half += (mantissa >> 12) & 1;
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    // Projects the normal onto an octahedron and unfolds the lower half over the upper one. Decoded by decodeOctahedralNormal in common.glsl
+    static void encodeOctahedralNormal(const float normal[3], int16_t encoded[2]) {
+        const float length = std::abs(normal[0]) + std::abs(normal[1]) + std::abs(normal[2]);
+        if (length <= 0.0f) {
+            // Meshes without normals, decodes to +Z
+            encoded[0] = 0;
+            encoded[1] = 0;
+            return;
+        }
+        float x = normal[0] / length;
+        float y = normal[1] / length;
+        if (normal[2] < 0.0f) {
+            const float foldedX = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            const float foldedY = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = foldedX;
+            y = foldedY;
+        }
+        encoded[0] = quantiseSnorm16(x);
+        encoded[1] = quantiseSnorm16(y);
+    }
+
+    std::vector<QuantisedMeshVertex> quantiseMeshVertices(const PositionNormalTexcoordVertex* vertices, size_t vertexCount, Mesh& mesh) {
+        float boundsMin[3];
+        float boundsMax[3];
+        hlslpp::store(mesh.boundsMin, boundsMin);
+        hlslpp::store(mesh.boundsMax, boundsMax);
+
+        // The scale is the same on every axis, so normals transformed by the folded model matrix only change length
+        bool insideUnitCube = true;
+        float offset[3] = {};
+        float scale = 0.0f;
+        for (int axis = 0; axis < 3; axis++) {
+            insideUnitCube &= boundsMin[axis] >= -1.0f && boundsMax[axis] <= 1.0f;
+            offset[axis] = (boundsMin[axis] + boundsMax[axis]) * 0.5f;
+            scale = std::max(scale, (boundsMax[axis] - boundsMin[axis]) * 0.5f);
+        }
+        if (insideUnitCube || scale <= 0.0f) {
+            offset[0] = offset[1] = offset[2] = 0.0f;
+            scale = 1.0f;
+        }
+        mesh.positionOffset = hlslpp::float3(offset[0], offset[1], offset[2]);
+        mesh.positionScale = scale;
+
+        std::vector<QuantisedMeshVertex> quantised(vertexCount);
+        const float invScale = 1.0f / scale;
+        for (size_t i = 0; i < vertexCount; i++) {
+            for (int axis = 0; axis < 3; axis++) {
+                quantised[i].position[axis] = quantiseSnorm16((vertices[i].position[axis] - offset[axis]) * invScale);
+            }
+            quantised[i].position[3] = 32767;
+            encodeOctahedralNormal(vertices[i].normal, quantised[i].normal);
+            quantised[i].uv[0] = floatToHalf(vertices[i].uv[0]);
+            quantised[i].uv[1] = floatToHalf(vertices[i].uv[1]);
+        }
+        return quantised;
+    }
+
+    hlslpp::float4x4 getPositionDequantisation(const Mesh& mesh) {
+        const float scale = mesh.positionScale;
+        return hlslpp::float4x4(
+            hlslpp::float4(scale, 0.0f, 0.0f, 0.0f),
+            hlslpp::float4(0.0f, scale, 0.0f, 0.0f),
+            hlslpp::float4(0.0f, 0.0f, scale, 0.0f),
+            hlslpp::float4(mesh.positionOffset, 1.0f));
+    }
+}
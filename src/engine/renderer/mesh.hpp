@@ -2,6 +2,7 @@
 
 #include <inttypes.h>
 #include <hlsl++.h>
+#include <vector>
 #include <engine/gpu/idevice.hpp>
 #include "engine/renderer/scene_graph.hpp"
 #include "engine/renderer/material.hpp"
@@ -21,6 +22,23 @@ namespace render {
         float uv[2] = {};
     };
 
+    // What loaded meshes are uploaded as, 16 bytes instead of PositionNormalTexcoordVertex's 32. Positions are snorm16
+    // inside the mesh's bounds (w is 1), normals are octahedral encoded into two snorm16s and uvs are half floats
+    struct QuantisedMeshVertex {
+        int16_t position[4] = {};
+        int16_t normal[2] = {};
+        uint16_t uv[2] = {};
+    };
+    static_assert(sizeof(QuantisedMeshVertex) == 16);
+
+    constexpr uint32_t k_MAX_MESH_LODS = 4;
+
+    // A range of the mesh's index buffer holding one level of detail
+    struct MeshLod {
+        size_t firstIndex = 0;
+        size_t triangleCount = 0;
+    };
+
     // Collection of mesh data
     struct Mesh {
     public:
@@ -28,9 +46,58 @@ namespace render {
         gpu::IBuffer* indexBuffer = nullptr;
         gpu::IInputLayout* vertexLayout = nullptr; // WHY IS VAO TIED TO THE VERTEX BUFFER?????
         size_t triangleCount = 0;
+
+        // LOD 0 is always the full mesh. All levels share the vertex buffer and live back to back in the index buffer.
+        // A lodCount of 0 means no LOD table was generated and the whole mesh is drawn
+        MeshLod lods[k_MAX_MESH_LODS] = {};
+        uint32_t lodCount = 0;
+
+        // Bytes per index, 2 when the index buffer is Uint16_TYPELESS
+        uint32_t indexSize = sizeof(uint32_t);
+        // Quantised positions decode to position * positionScale + positionOffset, see getPositionDequantisation
+        hlslpp::float3 positionOffset = { 0, 0, 0 };
+        float positionScale = 1.0f;
+
+        // Local space axis aligned bounding box, used for culling
+        hlslpp::float3 boundsMin = { 0, 0, 0 };
+        hlslpp::float3 boundsMax = { 0, 0, 0 };
     };
 
+    // Simplifies an indexed triangle list by snapping vertices onto a uniform grid with gridResolution cells along the mesh's longest axis.
+    // Every vertex in a cell collapses onto the one closest to the cell's centroid, and triangles that become degenerate are dropped
+    std::vector<uint32_t> simplifyMeshClustered(const PositionNormalTexcoordVertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, uint32_t gridResolution);
+
+    // FIFO post-transform cache size the index optimisers target. Real hardware varies, 16 is a safe middle ground
+    constexpr uint32_t k_VERTEX_CACHE_SIZE = 16;
+
+    // Merges bitwise identical vertices and remaps indices onto the survivors. Returns the new vertex count
+    size_t weldMeshVertices(std::vector<PositionNormalTexcoordVertex>& vertices, std::vector<uint32_t>& indices);
+
+    // Reorders triangles so vertices are reused while still in the post-transform cache (Tipsify, Sander et al. 2007)
+    void optimiseVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = k_VERTEX_CACHE_SIZE);
+
+    // Reorders vertices by first use in indices so fetches walk the vertex buffer forwards. Vertices no index refers to are dropped
+    void optimiseVertexFetch(std::vector<PositionNormalTexcoordVertex>& vertices, uint32_t* indices, size_t indexCount);
+
+    // Average cache miss ratio, vertex shader invocations per triangle with a FIFO cache. 3 means no reuse, 0.5 is the best a regular grid gets
+    float computeVertexCacheAcmr(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = k_VERTEX_CACHE_SIZE);
+
+    // Converts vertices to QuantisedMeshVertex and picks the mesh's positionOffset and positionScale. Needs the mesh's bounds.
+    // Meshes inside the unit cube keep an identity dequantisation so shaders reading raw positions (fullscreen passes) still can
+    std::vector<QuantisedMeshVertex> quantiseMeshVertices(const PositionNormalTexcoordVertex* vertices, size_t vertexCount, Mesh& mesh);
+
+    // Mesh space from quantised positions, goes before the model matrix: mul(getPositionDequantisation(mesh), model)
+    hlslpp::float4x4 getPositionDequantisation(const Mesh& mesh);
+
+    // Index buffer format for a mesh. 16-bit when every index fits, leaving 0xFFFF free as the primitive restart index
+    inline gpu::GpuFormat getMeshIndexFormat(size_t vertexCount) {
+        return vertexCount <= 0xFFFF ? gpu::GpuFormat::Uint16_TYPELESS : gpu::GpuFormat::Uint32_TYPELESS;
+    }
+
+    class SceneRenderer;
+
     class MeshRenderer : public IComponent {
+        friend class SceneRenderer;
     public:
         MeshRenderer(Entity* parent) : IComponent(parent) {
             componentType = ::render::ComponentType::MeshRenderer;
@@ -38,9 +105,20 @@ namespace render {
         ~MeshRenderer() = default;
 
         Mesh mesh{};
+        // Changing drawOrder or transparencyMode moves the renderer to another render list, do that through setMaterial
         Material material;
+
+        inline void setMaterial(const Material& newMaterial) {
+            if (newMaterial.drawOrder != material.drawOrder || newMaterial.transparencyMode != material.transparencyMode) {
+                Entity::markHierarchyChanged();
+            }
+            material = newMaterial;
+        }
     private:
         // derived classes are forbidden from modifying componentType
         using IComponent::componentType;
+
+        // LOD picked by the renderer last frame, used for hysteresis
+        uint32_t m_currentLod = 0;
     };
 }
\ No newline at end of file
@@ -0,0 +1,223 @@
+#include "occlusion_culling.hpp"
+#include "engine/core.hpp"
+#include "engine/log.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace render {
+
+    void HiZOcclusionCuller::init(gpu::IDevice* pDevice) {
+        ASSERT(pDevice != nullptr);
+        m_pDevice = pDevice;
+
+        for (uint32_t i = 0; i < k_hiZReadbackLatency; i++) {
+            m_readbacks[i].buffer = m_pDevice->makeBuffer({ .type = gpu::BufferType::PixelReadTarget, .usage = gpu::Usage::Staging, .debugName = "HiZDepthReadback" });
+        }
+
+        // Allocate the whole mip chain up front, the pyramid never changes size
+        uint32_t width = k_hiZBaseWidth;
+        uint32_t height = k_hiZBaseHeight;
+        while (true) {
+            m_mips.push_back({ .width = width, .height = height, .depth = std::vector<float>(width * height, 0.0f) });
+            if (width == 1 && height == 1) {
+                break;
+            }
+            width = std::max(1u, width / 2);
+            height = std::max(1u, height / 2);
+        }
+    }
+
+    void HiZOcclusionCuller::beginFrame() {
+        m_testedCount = 0;
+        m_culledCount = 0;
+
+        // The slot we are about to write into this frame holds the oldest readback
+        DepthReadback& readback = m_readbacks[m_frameIndex % k_hiZReadbackLatency];
+        if (!readback.pending) {
+            return;
+        }
+        readback.pending = false;
+
+        float* depthView = nullptr;
+        m_pDevice->bindBuffer(readback.buffer);
+        m_pDevice->mapBuffer(readback.buffer, 0, readback.width * readback.height * sizeof(float), gpu::MapAccessFlags::Read, reinterpret_cast<void**>(&depthView));
+        if (depthView != nullptr) {
+            buildPyramid(depthView, readback.width, readback.height);
+            m_viewProjection = readback.viewProjection;
+            m_valid = true;
+            m_pDevice->unmapBuffer(readback.buffer);
+        }
+        m_pDevice->unbindBuffer(readback.buffer);
+    }
+
+    void HiZOcclusionCuller::captureDepth(gpu::IFramebuffer* source, uint32_t width, uint32_t height, const hlslpp::float4x4& viewProjection) {
+        ASSERT(m_pDevice != nullptr);
+
+        DepthReadback& readback = m_readbacks[m_frameIndex % k_hiZReadbackLatency];
+        m_frameIndex++;
+
+        if (!enabled || width == 0 || height == 0) {
+            m_valid = false;
+            return;
+        }
+
+        size_t requiredSize = width * height * sizeof(float);
+        if (readback.allocatedSize < requiredSize) {
+            // Window was resized or the dynamic resolution went up, reallocate
+            m_pDevice->writeBuffer(readback.buffer, requiredSize, nullptr);
+            readback.allocatedSize = requiredSize;
+        }
+
+        // Only grows, dynamic resolution moves the viewport around every few frames. Just the viewport is read back
+        if (!m_depthResolve || m_depthResolve->getDesc().colorDesc.width < width || m_depthResolve->getDesc().colorDesc.height < height) {
+            uint32_t resolveWidth = m_depthResolve ? std::max(width, m_depthResolve->getDesc().colorDesc.width) : width;
+            uint32_t resolveHeight = m_depthResolve ? std::max(height, m_depthResolve->getDesc().colorDesc.height) : height;
+            // The colour attachment is only there because every framebuffer needs one, keep it small
+            m_depthResolve = m_pDevice->makeFramebuffer({
+                .colorDesc = {
+                    .width = resolveWidth,
+                    .height = resolveHeight,
+                    .samples = 1,
+                    .format = gpu::TextureFormat::RGBA4,
+                },
+                .depthStencilDesc = {
+                    .width = resolveWidth,
+                    .height = resolveHeight,
+                    .samples = 1,
+                    .format = gpu::TextureFormat::Depth24_Stencil8,
+                },
+                .hasDepth = true,
+                .debugName = "HiZDepthResolve"
+            });
+        }
+
+        {
+            GPU_SCOPE(m_pDevice, "Hi-Z depth readback");
+            // Resolves multisampled depth, GL keeps one sample per pixel
+            m_pDevice->blitFramebufferDepth(source, m_depthResolve);
+            m_pDevice->bindFramebuffer(m_depthResolve);
+            m_pDevice->readDepthBuffer(readback.buffer, { .left = 0, .right = width, .top = 0, .bottom = height });
+            m_pDevice->bindFramebuffer(source);
+        }
+
+        readback.width = width;
+        readback.height = height;
+        readback.viewProjection = viewProjection;
+        readback.pending = true;
+    }
+
+    void HiZOcclusionCuller::buildPyramid(const float* depth, uint32_t width, uint32_t height) {
+        // Base level, each texel takes the farthest (smallest with reverse-Z) depth of every pixel it touches.
+        // Texel footprints are rounded outwards so the result stays conservative when the sizes don't divide evenly
+        HiZMip& base = m_mips[0];
+        for (uint32_t y = 0; y < base.height; y++) {
+            uint32_t srcY0 = (y * height) / base.height;
+            uint32_t srcY1 = std::min(height, ((y + 1) * height + base.height - 1) / base.height);
+            for (uint32_t x = 0; x < base.width; x++) {
+                uint32_t srcX0 = (x * width) / base.width;
+                uint32_t srcX1 = std::min(width, ((x + 1) * width + base.width - 1) / base.width);
+
+                float farthest = FLT_MAX;
+                for (uint32_t srcY = srcY0; srcY < srcY1; srcY++) {
+                    const float* row = depth + srcY * width;
+                    for (uint32_t srcX = srcX0; srcX < srcX1; srcX++) {
+                        farthest = std::min(farthest, row[srcX]);
+                    }
+                }
+                // Source smaller than the pyramid base. Nothing to occlude with
+                base.depth[y * base.width + x] = farthest == FLT_MAX ? 0.0f : farthest;
+            }
+        }
+
+        // Downsample the rest of the chain with a 2x2 min filter
+        for (size_t level = 1; level < m_mips.size(); level++) {
+            const HiZMip& src = m_mips[level - 1];
+            HiZMip& dst = m_mips[level];
+            for (uint32_t y = 0; y < dst.height; y++) {
+                uint32_t srcY0 = std::min(src.height - 1, y * 2);
+                uint32_t srcY1 = std::min(src.height - 1, y * 2 + 1);
+                for (uint32_t x = 0; x < dst.width; x++) {
+                    uint32_t srcX0 = std::min(src.width - 1, x * 2);
+                    uint32_t srcX1 = std::min(src.width - 1, x * 2 + 1);
+                    dst.depth[y * dst.width + x] = std::min(
+                        std::min(src.depth[srcY0 * src.width + srcX0], src.depth[srcY0 * src.width + srcX1]),
+                        std::min(src.depth[srcY1 * src.width + srcX0], src.depth[srcY1 * src.width + srcX1]));
+                }
+            }
+        }
+    }
+
+    bool HiZOcclusionCuller::isVisible(const hlslpp::float3& boundsMin, const hlslpp::float3& boundsMax, const hlslpp::float4x4& model, bool countStats) {
+        if (!enabled || !m_valid) {
+            return true;
+        }
+        m_testedCount += countStats ? 1 : 0;
+
+        hlslpp::float4x4 modelViewProjection = hlslpp::mul(model, m_viewProjection);
+
+        // Project the 8 corners of the box and take their screen space bounds
+        float minX = FLT_MAX, minY = FLT_MAX;
+        float maxX = -FLT_MAX, maxY = -FLT_MAX;
+        float nearestDepth = -FLT_MAX;
+        for (uint32_t corner = 0; corner < 8; corner++) {
+            hlslpp::float4 position = hlslpp::float4(
+                (corner & 1) ? boundsMax.x : boundsMin.x,
+                (corner & 2) ? boundsMax.y : boundsMin.y,
+                (corner & 4) ? boundsMax.z : boundsMin.z,
+                1.0f);
+            hlslpp::float4 clip = hlslpp::mul(position, modelViewProjection);
+            float w = clip.w;
+            if (w <= 0.0f) {
+                // Box crosses the camera plane, too close to reason about
+                return true;
+            }
+            float ndcX = (float)clip.x / w;
+            float ndcY = (float)clip.y / w;
+            float ndcZ = (float)clip.z / w;
+            minX = std::min(minX, ndcX);
+            maxX = std::max(maxX, ndcX);
+            minY = std::min(minY, ndcY);
+            maxY = std::max(maxY, ndcY);
+            nearestDepth = std::max(nearestDepth, ndcZ);
+        }
+
+        // Entirely outside the view frustum
+        if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f || nearestDepth < 0.0f) {
+            m_culledCount += countStats ? 1 : 0;
+            return false;
+        }
+
+        // NDC to [0, 1]. Both glReadPixels rows and NDC start at the bottom of the screen, so no flip is needed
+        float u0 = std::clamp(minX * 0.5f + 0.5f, 0.0f, 1.0f);
+        float u1 = std::clamp(maxX * 0.5f + 0.5f, 0.0f, 1.0f);
+        float v0 = std::clamp(minY * 0.5f + 0.5f, 0.0f, 1.0f);
+        float v1 = std::clamp(maxY * 0.5f + 0.5f, 0.0f, 1.0f);
+
+        // Pick the mip where the box spans at most 2 texels per axis, so at most 3x3 texels need to be read
+        float extent = std::max((u1 - u0) * k_hiZBaseWidth, (v1 - v0) * k_hiZBaseHeight);
+        uint32_t level = extent > 1.0f ? static_cast<uint32_t>(std::ceil(std::log2(extent))) : 0;
+        level = std::min(level, static_cast<uint32_t>(m_mips.size() - 1));
+        const HiZMip& mip = m_mips[level];
+
+        uint32_t x0 = std::min(mip.width - 1, static_cast<uint32_t>(u0 * mip.width));
+        uint32_t x1 = std::min(mip.width - 1, static_cast<uint32_t>(u1 * mip.width));
+        uint32_t y0 = std::min(mip.height - 1, static_cast<uint32_t>(v0 * mip.height));
+        uint32_t y1 = std::min(mip.height - 1, static_cast<uint32_t>(v1 * mip.height));
+
+        float occluderDepth = FLT_MAX;
+        for (uint32_t y = y0; y <= y1; y++) {
+            for (uint32_t x = x0; x <= x1; x++) {
+                occluderDepth = std::min(occluderDepth, mip.depth[y * mip.width + x]);
+            }
+        }
+
+        // Reverse-Z: the box is hidden if its nearest point is still farther (smaller) than the farthest occluder over it
+        if (nearestDepth < occluderDepth) {
+            m_culledCount += countStats ? 1 : 0;
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <inttypes.h>
+#include <hlsl++.h>
+#include <vector>
+#include "engine/gpu/idevice.hpp"
+
+namespace render {
+
+    // Number of frames between queueing a depth readback and consuming it. Gives the GPU time to finish
+    // the copy so that mapping the buffer doesn't stall the pipeline
+    constexpr uint32_t k_hiZReadbackLatency = 2;
+    // Size of the base level of the Hi-Z pyramid. Power of two so every mip halves cleanly
+    constexpr uint32_t k_hiZBaseWidth = 256;
+    constexpr uint32_t k_hiZBaseHeight = 128;
+
+    // Hierarchical-Z occlusion culling against an earlier frame's depth buffer.
+    // The engine uses reverse-Z, so the farthest depth in a region is the smallest value. Every texel of the pyramid
+    // stores the minimum depth of the pixels it covers, which makes it a conservative occluder for everything behind it.
+    class HiZOcclusionCuller {
+    public:
+        void init(gpu::IDevice* pDevice);
+
+        // Consumes the oldest depth readback (if any) and rebuilds the Hi-Z mip chain from it
+        void beginFrame();
+        // Queues a readback of source's depth over the width x height viewport. Should be called once opaque geometry has been drawn.
+        // Leaves source bound
+        void captureDepth(gpu::IFramebuffer* source, uint32_t width, uint32_t height, const hlslpp::float4x4& viewProjection);
+        // Tests a local space bounding box against the Hi-Z pyramid. Returns false only if the box is guaranteed to be hidden.
+        // Passes that test a drawable again after another pass already has should leave countStats off, so it's counted once
+        bool isVisible(const hlslpp::float3& boundsMin, const hlslpp::float3& boundsMax, const hlslpp::float4x4& model, bool countStats = true);
+
+        inline uint32_t getTestedCount() const { return m_testedCount; }
+        inline uint32_t getCulledCount() const { return m_culledCount; }
+
+        bool enabled = true;
+
+    private:
+        struct HiZMip {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            std::vector<float> depth;
+        };
+
+        struct DepthReadback {
+            gpu::BufferHandle buffer;
+            uint32_t width = 0;
+            uint32_t height = 0;
+            size_t allocatedSize = 0;
+            hlslpp::float4x4 viewProjection = hlslpp::float4x4::identity();
+            bool pending = false;
+        };
+
+        void buildPyramid(const float* depth, uint32_t width, uint32_t height);
+
+        gpu::IDevice* m_pDevice = nullptr;
+
+        // Single sample copy of the source's depth. Multisampled depth can't be read back, so it is resolved in here first
+        gpu::FramebufferHandle m_depthResolve;
+        DepthReadback m_readbacks[k_hiZReadbackLatency];
+        uint32_t m_frameIndex = 0;
+
+        std::vector<HiZMip> m_mips;
+        // View projection the current pyramid was rendered with
+        hlslpp::float4x4 m_viewProjection = hlslpp::float4x4::identity();
+        bool m_valid = false;
+
+        uint32_t m_testedCount = 0;
+        uint32_t m_culledCount = 0;
+    };
+}
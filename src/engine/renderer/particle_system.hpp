@@ -40,9 +40,17 @@ namespace render {
 
         inline uint32_t getActiveParticleCount() const { return m_particleCount; }
 
+        // Changing drawOrder or transparencyMode moves the system to another render list, do that through setMaterial
         Material material = {};
         gpu::IBlendState* blendState = nullptr;
 
+        inline void setMaterial(const Material& newMaterial) {
+            if (newMaterial.drawOrder != material.drawOrder || newMaterial.transparencyMode != material.transparencyMode) {
+                Entity::markHierarchyChanged();
+            }
+            material = newMaterial;
+        }
+
         uint32_t particleTextureCount = 1;
 
     private:
@@ -7,7 +7,7 @@ namespace render {
     EntityBuilder& EntityBuilder::withCamera(CameraCreateParams params) {
         std::shared_ptr<Camera> camera = std::make_shared<Camera>(m_entity.get());
 
-        camera->enabled = params.enabled;
+        camera->setEnabled(params.enabled);
         camera->setProjection(params.projection);
         camera->setFov(params.fov);
         camera->setNearPlane(params.nearPlane);
@@ -21,7 +21,7 @@ namespace render {
     EntityBuilder& EntityBuilder::withLight(LightCreateParams params) {
         std::shared_ptr<Light> light = std::make_shared<Light>(m_entity.get());
 
-        light->enabled = params.enabled;
+        light->setEnabled(params.enabled);
         light->type = params.type;
         light->colour = params.colour;
         light->intensity = params.intensity;
@@ -35,7 +35,7 @@ namespace render {
     EntityBuilder& EntityBuilder::withPhysics(PhysicsCreateParams params) {
         std::shared_ptr<physics::PhysicsComponent> physicsComponent = std::make_shared<physics::PhysicsComponent>(m_entity.get());
 
-        physicsComponent->enabled = params.enabled;
+        physicsComponent->setEnabled(params.enabled);
         physicsComponent->density = params.density;
         physicsComponent->friction = params.friction;
         physicsComponent->bounciness = params.bounciness;
@@ -54,7 +54,7 @@ namespace render {
     EntityBuilder& EntityBuilder::withMeshRenderer(MeshRendererCreateParams params) {
         std::shared_ptr<MeshRenderer> renderer = std::make_shared<MeshRenderer>(m_entity.get());
 
-        renderer->enabled = params.enabled;
+        renderer->setEnabled(params.enabled);
         renderer->material = params.material;
         renderer->mesh = params.mesh;
 
@@ -65,7 +65,7 @@ namespace render {
     EntityBuilder& EntityBuilder::withParticleSystem(ParticleSystemCreateParams params) {
         std::shared_ptr<ParticleSystem> particleSystem = std::make_shared<ParticleSystem>(m_entity.get());
 
-        particleSystem->enabled = params.enabled;
+        particleSystem->setEnabled(params.enabled);
         particleSystem->material = params.material;
         particleSystem->blendState = params.blendState;
         particleSystem->particleTextureCount = params.particleTextureCount;
@@ -74,10 +74,11 @@ namespace render {
         return *this;
     }
 
-    EntityBuilder& EntityBuilder::withUiCanvas(bool enabled) {
+    EntityBuilder& EntityBuilder::withUiCanvas(bool enabled, bool cacheRendering) {
         std::shared_ptr<UICanvas> uiCanvas = std::make_shared<UICanvas>(m_entity.get());
 
-        uiCanvas->enabled = enabled;
+        uiCanvas->setEnabled(enabled);
+        uiCanvas->cacheRendering = cacheRendering;
 
         m_entity->push_back(uiCanvas);
         return *this;
@@ -86,7 +87,7 @@ namespace render {
     EntityBuilder& EntityBuilder::withUiSprite(UiSpriteCreateParams params) {
         std::shared_ptr<UIElement> uiElement = std::make_shared<UIElement>(m_entity.get());
 
-        uiElement->enabled = params.enabled;
+        uiElement->setEnabled(params.enabled);
         uiElement->uiType = render::UIElementType::Sprite;
         uiElement->posX = params.posX;
         uiElement->posY = params.posY;
@@ -102,7 +103,7 @@ namespace render {
     EntityBuilder& EntityBuilder::withUiText(UiTextCreateParams params) {
         std::shared_ptr<UIElement> uiElement = std::make_shared<UIElement>(m_entity.get());
 
-        uiElement->enabled = params.enabled;
+        uiElement->setEnabled(params.enabled);
         uiElement->uiType = render::UIElementType::Text;
         uiElement->posX = params.posX;
         uiElement->posY = params.posY;
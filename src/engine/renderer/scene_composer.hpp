@@ -28,7 +28,7 @@ namespace render {
         }
 
         inline EntityBuilder& withEnabled(bool enabled) {
-            m_entity->enabled = enabled;
+            m_entity->setEnabled(enabled);
             m_entity->_lastFrameEnabled = enabled;
             return *this;
         }
@@ -113,7 +113,7 @@ namespace render {
         };
         EntityBuilder& withParticleSystem(ParticleSystemCreateParams params);
 
-        EntityBuilder& withUiCanvas(bool enabled = true);
+        EntityBuilder& withUiCanvas(bool enabled = true, bool cacheRendering = false);
 
         struct UiSpriteCreateParams {
             bool enabled = true;
@@ -159,7 +159,7 @@ namespace render {
     template<class T, typename... Args>
     EntityBuilder& EntityBuilder::withBehaviour(bool enabled, Args&&... args) {
         std::shared_ptr<T> userBehaviour = std::make_shared<T>(m_entity.get(), std::forward<Args>(args)...);
-        userBehaviour->enabled = enabled;
+        userBehaviour->setEnabled(enabled);
         userBehaviour->m_lastFrameEnabled = enabled;
         m_entity->push_back(userBehaviour);
         return *this;
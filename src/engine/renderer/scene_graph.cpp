@@ -1,21 +1,49 @@
 #include "scene_graph.hpp"
 #include "scene_composer.hpp"
 
+#include <algorithm>
+
 namespace render {
 
     using namespace ::hlslpp;
 
+    // Physics writes every body back each tick, only real changes should make the renderer recompute anything
+    static bool differs(const float3& a, const float3& b) {
+        return (float)a.x != (float)b.x || (float)a.y != (float)b.y || (float)a.z != (float)b.z;
+    }
+    static bool differs(const quaternion& a, const quaternion& b) {
+        return (float)a.x != (float)b.x || (float)a.y != (float)b.y || (float)a.z != (float)b.z || (float)a.w != (float)b.w;
+    }
+
     void Transform::setPosition(float3 newPosition) {
+        if (!differs(m_position, newPosition)) {
+            return;
+        }
         m_position = newPosition;
         m_isDirty = true;
+        if (m_entity != nullptr) {
+            m_entity->markRenderStateDirty();
+        }
     }
     void Transform::setRotation(quaternion newRotation) {
+        if (!differs(m_rotation, newRotation)) {
+            return;
+        }
         m_rotation = newRotation;
         m_isDirty = true;
+        if (m_entity != nullptr) {
+            m_entity->markRenderStateDirty();
+        }
     }
     void Transform::setScale(float3 newScale) {
+        if (!differs(m_scale, newScale)) {
+            return;
+        }
         m_scale = newScale;
         m_isDirty = true;
+        if (m_entity != nullptr) {
+            m_entity->markRenderStateDirty();
+        }
     }
 
     const float4x4 Transform::getModel() {
@@ -35,9 +63,39 @@ namespace render {
         return m_model;
     }
 
+    void IComponent::setEnabled(bool enabled) {
+        if (m_enabled == enabled) {
+            return;
+        }
+        m_enabled = enabled;
+        if (m_parent != nullptr) {
+            m_parent->markRenderStateDirty();
+        }
+    }
+
+    uint64_t Entity::s_hierarchyRevision = 0;
+
+    void Entity::setEnabled(bool enabled) {
+        if (m_enabled == enabled) {
+            return;
+        }
+        m_enabled = enabled;
+        markRenderStateDirty();
+    }
+
+    void Entity::markRenderStateDirty() {
+        m_renderStateDirty = true;
+        // Entities above an already flagged one are flagged too, so the walk up can stop there
+        for (Entity* ancestor = parent; ancestor != nullptr && !ancestor->m_childRenderStateDirty; ancestor = ancestor->parent) {
+            ancestor->m_childRenderStateDirty = true;
+        }
+    }
+
     Entity* Entity::push_back(std::shared_ptr<Entity> entity) {
         this->children.push_back(entity);
         this->children.back()->parent = this;
+        this->children.back()->markRenderStateDirty();
+        s_hierarchyRevision++;
         return this->children.back().get();
     }
     Entity* Entity::push_back(EntityBuilder& entityBuilder) {
@@ -50,6 +108,24 @@ namespace render {
             component->setParent(this);
         }
         this->components.push_back(component);
+        s_hierarchyRevision++;
+    }
+
+    bool Entity::remove(Entity* child) {
+        auto iterEntity = std::find_if(children.begin(), children.end(), [&](const std::shared_ptr<Entity>& entity) {
+            return entity.get() == child;
+        });
+        if (iterEntity == children.end()) {
+            return false;
+        }
+        children.erase(iterEntity);
+        s_hierarchyRevision++;
+        return true;
+    }
+
+    void Entity::clearChildren() {
+        children.clear();
+        s_hierarchyRevision++;
     }
 
     Entity* Entity::findNamedEntity(const std::string& name, bool ignoreDisabled /* = false */) const {
@@ -61,7 +137,7 @@ namespace render {
         // Entity didn't have any components we wanted attached to itself, check children
         for (const std::shared_ptr<Entity> entity : children) {
             // may return null, if not null its what we're after anyway
-            if (ignoreDisabled || (!ignoreDisabled && entity->enabled)) {
+            if (ignoreDisabled || (!ignoreDisabled && entity->isEnabled())) {
                 Entity* childEntity = entity->findNamedEntity(name, ignoreDisabled);
                 if (childEntity != nullptr) {
                     return childEntity;
@@ -84,7 +160,7 @@ namespace render {
         // Entity didn't have any components we wanted attached to itself, check children
         for (const std::shared_ptr<Entity> entity : children) {
             // may return null, if not null its what we're after anyway
-            if (ignoreDisabled || (!ignoreDisabled && entity->enabled)) {
+            if (ignoreDisabled || (!ignoreDisabled && entity->isEnabled())) {
                 Entity* childEntity = entity->findEntityWithType(type, ignoreDisabled);
                 if (childEntity != nullptr) {
                     return childEntity;
@@ -108,7 +184,7 @@ namespace render {
         if (traverseChildren) {
             for (const std::shared_ptr<Entity> entity : children) {
                 // may return null, if not null its what we're after anyway
-                if (ignoreDisabled || (!ignoreDisabled && entity->enabled)) {
+                if (ignoreDisabled || (!ignoreDisabled && entity->isEnabled())) {
                     IComponent* childComponent = entity->findComponent(type, traverseChildren, ignoreDisabled);
                     if (childComponent != nullptr) {
                         return childComponent;
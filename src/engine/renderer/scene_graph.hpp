@@ -24,6 +24,7 @@ namespace render {
     struct Transform {
         friend class Camera;
         friend class SceneUpdater;
+        friend class Entity;
 
         inline const hlslpp::float3 getPosition() const { return m_position;}
         inline const hlslpp::quaternion getRotation() const { return m_rotation; }
@@ -44,6 +45,8 @@ namespace render {
 
         bool m_isDirty = true;
         hlslpp::float4x4 m_model = hlslpp::float4x4::identity();
+        // Owner, told when the transform changes so the renderer only recomputes what moved
+        Entity* m_entity = nullptr;
     };
 
     // Each of these is associated with a unique type of component. The components defined here are considered special cases and handled uniquely by the render loop
@@ -68,7 +71,9 @@ namespace render {
         friend class SceneUpdater;
     public:
         IComponent(Entity* parent) : m_parent (parent) {}
-        bool enabled = true;
+
+        inline bool isEnabled() const { return m_enabled; }
+        void setEnabled(bool enabled);
 
         inline ComponentType getComponentType() const { return componentType; }
         inline Entity* getEntity() const { return m_parent; }
@@ -76,6 +81,7 @@ namespace render {
         void setParent(Entity* entity) { m_parent = entity; }
         ComponentType componentType = ComponentType::Unknown;
         Entity* m_parent = nullptr;
+        bool m_enabled = true;
         bool m_lastFrameEnabled = true;
     };
 
@@ -100,9 +106,15 @@ namespace render {
     };
 
     class Entity {
+        friend class SceneRenderer;
     public:
+        Entity() { transform.m_entity = this; }
+        explicit Entity(std::string name) : Entity() { this->name = std::move(name); }
+        // The transform points back at its entity
+        Entity(const Entity&) = delete;
+        Entity& operator=(const Entity&) = delete;
+
         std::string name = "";
-        bool enabled = true;
         Entity* parent = nullptr; // If null, assume this is a root node, or leaked entity
         Transform transform;
         std::vector<std::shared_ptr<Entity>> children;
@@ -110,6 +122,9 @@ namespace render {
         // optional "layers", to allow one to attach arbitrary data to an entity
         std::vector<std::shared_ptr<IComponent>> components;
 
+        inline bool isEnabled() const { return m_enabled; }
+        void setEnabled(bool enabled);
+
         // finds an entity with a given name (exact match) in the list of child entities
         Entity* findNamedEntity(const std::string& name, bool ignoreDisabled = false) const;
         // finds an entity with a given type in the list of child entities
@@ -118,18 +133,62 @@ namespace render {
         Entity* push_back(std::shared_ptr<Entity> entity);
         Entity* push_back(EntityBuilder& entity);
         void push_back(std::shared_ptr<IComponent> component);
+        // removes a direct child entity, returns false if it isn't a child of this entity
+        bool remove(Entity* child);
+        void clearChildren();
         bool _lastFrameEnabled = true;
+
+        // Bumped whenever an entity or component is attached to or detached from any entity. Lets systems that cache
+        // parts of the scene graph (e.g. render lists) know when they have to be rebuilt
+        [[nodiscard]] static inline uint64_t getHierarchyRevision() { return s_hierarchyRevision; }
+        // For changes that move a drawable to another render list without touching the hierarchy, e.g. a new draw order
+        static inline void markHierarchyChanged() { s_hierarchyRevision++; }
+
+        // Flags this entity's world state for the renderer to recompute, along with everything below it.
+        // Called by the enable and transform setters of the entity and its components
+        void markRenderStateDirty();
+
+        // World state, recomputed top-down by SceneRenderer for dirty subtrees only. Valid for entities in the scene it last drew
+        // Product of the models of every entity above this one
+        [[nodiscard]] inline const hlslpp::float4x4& getParentMatrix() const { return m_parentMatrix; }
+        // This entity and every entity above it are enabled
+        [[nodiscard]] inline bool isHierarchyEnabled() const { return m_hierarchyEnabled; }
+
+    private:
+        static uint64_t s_hierarchyRevision;
+
+        bool m_enabled = true;
+
+        // Set when this entity's enable or transform changed, its whole subtree is recomputed
+        bool m_renderStateDirty = true;
+        // Set on every entity above a dirty one, so the renderer only descends into subtrees that changed
+        bool m_childRenderStateDirty = false;
+        hlslpp::float4x4 m_parentMatrix = hlslpp::float4x4::identity();
+        bool m_hierarchyEnabled = true;
+    };
+
+    enum class DepthPrepassMode : uint8_t {
+        // Never run a depth pre-pass
+        Disabled,
+        // Always run a depth pre-pass
+        Enabled,
+        // Let the renderer decide per frame from the estimated opaque overdraw
+        Automatic,
     };
 
     class Scene {
     public:
         std::string sceneName = "";
-        Entity root { .name="Root" };
+        Entity root { "Root" };
         struct LightingParameters {
             Light* sunLight = nullptr; // Reference to the entity whose Light component represents the sun, data passed onto skybox shader
             Skybox skybox;
         } lightingParams;
 
+        struct RenderingParameters {
+            DepthPrepassMode depthPrepass = DepthPrepassMode::Automatic;
+        } renderingParams;
+
         struct PhysicsParameters {
             hlslpp::float2 gravity{0, -9.8f};
         private:
@@ -6,16 +6,55 @@
 #include "engine/core.hpp"
 #include "engine/app.hpp"
 
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
 namespace render {
 
+    static void hashCombine(size_t& seed, size_t value) {
+        seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+
+    static void hashCombine(size_t& seed, const hlslpp::float4& value) {
+        for (float component : { (float)value.x, (float)value.y, (float)value.z, (float)value.w }) {
+            hashCombine(seed, std::hash<float>{}(component));
+        }
+    }
+
+    // Fullscreen composites and the skybox bake cover every pixel they draw to, without depth
+    static constexpr gpu::GraphicsState k_fullscreenState = {
+        .depthState = gpu::CompareFunc::Always,
+        .depthWrite = false,
+        .depthTest = false,
+        .faceCullingMode = gpu::FaceCullMode::Never,
+    };
+
+    // Drawn behind everything, only where nothing wrote depth
+    static constexpr gpu::GraphicsState k_skyboxState = {
+        .depthState = gpu::CompareFunc::GreaterOrEqual,
+        .depthWrite = false,
+        .depthTest = true,
+        .faceCullingMode = gpu::FaceCullMode::Never,
+    };
+
+    static constexpr gpu::GraphicsState k_depthPrepassState = {
+        .depthState = gpu::CompareFunc::GreaterOrEqual,
+        .depthWrite = true,
+        .depthTest = true,
+        .colorWrite = false,
+    };
+
     void SceneRenderer::init(gpu::IDevice* pDevice, managers::AssetManager* pAssetManager) {
         ASSERT(pDevice != nullptr);
         ASSERT(pAssetManager != nullptr);
         m_pDevice = pDevice;
         m_pAssetManager = pAssetManager;
         m_fontRenderer.init(pDevice);
+        m_spriteBatcher.init(pDevice, pAssetManager);
+        m_occlusionCuller.init(pDevice);
 
-        m_fontData = m_fontRenderer.loadFont("font_layout.csv", pAssetManager->fetchTexture("font.png"));
+        m_fontData = m_fontRenderer.loadFont("font.fontbin", pAssetManager->fetchTexture("font.png"));
         // prepare renderer state
 
         // 1. load skybox
@@ -35,47 +74,74 @@ namespace render {
         m_particlesCbuffer = m_pDevice->makeBuffer({ .type = gpu::BufferType::ConstantBuffer, .usage = gpu::Usage::Dynamic, .debugName = "ParticlesCbuffer" });
         m_pDevice->writeBuffer(m_particlesCbuffer, sizeof(ParticlesCBuffer), nullptr);
 
-        m_UiCbuffer = m_pDevice->makeBuffer({ .type = gpu::BufferType::ConstantBuffer, .usage = gpu::Usage::Dynamic, .debugName = "UiCbuffer" });
-        m_pDevice->writeBuffer(m_UiCbuffer, sizeof(ParticlesCBuffer), nullptr);
+        m_upscaleCbuffer = m_pDevice->makeBuffer({ .type = gpu::BufferType::ConstantBuffer, .usage = gpu::Usage::Dynamic, .debugName = "UpscaleCbuffer" });
+        m_pDevice->writeBuffer(m_upscaleCbuffer, sizeof(UpscaleCBuffer), nullptr);
+
+        registerUniformBlocks();
 
         m_trillinearAniso16ClampSampler = m_pDevice->makeTextureSampler({ /* default (linear, wrap, 16x-aniso) */ });
         
         m_skyboxTexShader = m_pAssetManager->fetchShader({
-        .graphicsState = {
-                .depthState = gpu::CompareFunc::GreaterOrEqual,
-                .depthWrite = false,
-                .depthTest = true,
-            },
             .vertShader = "skybox_tex_vert.glsl",
             .fragShader = "skybox_tex_frag.glsl",
             .debugName = "SkyboxTexture"
         });
         
+        // The procedural sky and equirectangular HDRIs are only ever rendered into the skybox cube map, a face at a time
         m_skyboxProceduralShader = m_pAssetManager->fetchShader({
-        .graphicsState = {
-                .depthState = gpu::CompareFunc::GreaterOrEqual,
-                .depthWrite = false,
-                .depthTest = true,
-                .faceCullingMode = gpu::FaceCullMode::Never,
-            },
-            .vertShader = "skybox_procedural_vert.glsl",
+            .vertShader = "skybox_bake_vert.glsl",
             // .fragShader = "skybox_procedural_frag.glsl",
             .fragShader = "skybox_starfield_frag.glsl",
             .debugName = "SkyboxProcedural"
         });
 
-        m_uiShader = m_pAssetManager->fetchShader({
-        .graphicsState = {
-                .depthState = gpu::CompareFunc::Always,
-                .depthWrite = false,
-                .depthTest = false,
-                .faceCullingMode = gpu::FaceCullMode::Never,
-            },
-            .vertShader = "ui_shader_vert.glsl",
-            .fragShader = "ui_shader_frag.glsl",
-            .debugName = "UIShader"
+        m_skyboxEquirectShader = m_pAssetManager->fetchShader({
+            .vertShader = "skybox_bake_vert.glsl",
+            .fragShader = "skybox_equirect_frag.glsl",
+            .debugName = "SkyboxEquirect"
+        });
+
+        m_skyboxCubemapShader = m_pAssetManager->fetchShader({
+            .vertShader = "skybox_procedural_vert.glsl",
+            .fragShader = "skybox_cubemap_frag.glsl",
+            .debugName = "SkyboxCubemap"
+        });
+
+        // Render targets have no mips, and must not wrap across their edges
+        m_linearClampSampler = m_pDevice->makeTextureSampler({
+            .minFilter = gpu::SamplingMode::Linear,
+            .magFilter = gpu::SamplingMode::Linear,
+            .mipFilter = gpu::SamplingMode::Nearest,
+            .wrapX = gpu::TextureWrap::ClampToEdge,
+            .wrapY = gpu::TextureWrap::ClampToEdge,
+            .wrapZ = gpu::TextureWrap::ClampToEdge,
+            .anisotropy = 1.0f,
+            .debugName = "LinearClampSampler"
+        });
+
+        m_depthPrepassShader = m_pAssetManager->fetchShader({
+            .vertShader = "depth_prepass_vert.glsl",
+            .fragShader = "depth_prepass_frag.glsl",
+            .debugName = "DepthPrepass"
+        });
+
+        m_oitCompositeShader = m_pAssetManager->fetchShader({
+            .vertShader = "oit_composite_vert.glsl",
+            .fragShader = "oit_composite_frag.glsl",
+            .debugName = "OitComposite"
+        });
+
+        m_uiCanvasCompositeShader = m_pAssetManager->fetchShader({
+            .vertShader = "oit_composite_vert.glsl",
+            .fragShader = "ui_canvas_composite_frag.glsl",
+            .debugName = "UiCanvasComposite"
+        });
+
+        m_sceneUpscaleShader = m_pAssetManager->fetchShader({
+            .vertShader = "oit_composite_vert.glsl",
+            .fragShader = "scene_upscale_frag.glsl",
+            .debugName = "SceneUpscale"
         });
-        m_pDevice->setBufferBinding(m_uiShader, "UiBuffer", 0);
 
         // m_skyboxQuad = m_pAssetManager->fetchMesh("skybox_quad.obj");
         m_skyboxSphere = m_pAssetManager->fetchMesh("skybox_sphere.obj");
@@ -94,39 +160,188 @@ namespace render {
             .dstFactor          = gpu::BlendFactor::OneMinusSrcAlpha,
             .blendOp            = gpu::BlendOp::Add,
         });
+
+        // Colour channels add up into both OIT targets (weighted colour and weight sum), while the accumulation
+        // target's alpha multiplies down by (1 - alpha) into the revealage. One blend state covers both targets
+        m_oitAccumulate_BlendState = m_pDevice->makeBlendState({
+            .blendEnable        = true,
+            .srcFactor          = gpu::BlendFactor::One,
+            .dstFactor          = gpu::BlendFactor::One,
+            .blendOp            = gpu::BlendOp::Add,
+            .srcFactorAlpha     = gpu::BlendFactor::Zero,
+            .dstFactorAlpha     = gpu::BlendFactor::OneMinusSrcAlpha,
+            .blendOpAlpha       = gpu::BlendOp::Add,
+        });
+
+        // Blends colour exactly like m_alphaBlend_BlendState, while alpha accumulates the coverage of everything drawn.
+        // Compositing the result with m_premultipliedAlpha_BlendState then matches drawing the elements straight to the backbuffer
+        m_uiCanvas_BlendState = m_pDevice->makeBlendState({
+            .blendEnable        = true,
+            .srcFactor          = gpu::BlendFactor::SrcAlpha,
+            .dstFactor          = gpu::BlendFactor::OneMinusSrcAlpha,
+            .blendOp            = gpu::BlendOp::Add,
+            .srcFactorAlpha     = gpu::BlendFactor::One,
+            .dstFactorAlpha     = gpu::BlendFactor::OneMinusSrcAlpha,
+            .blendOpAlpha       = gpu::BlendOp::Add,
+        });
+        m_premultipliedAlpha_BlendState = m_pDevice->makeBlendState({
+            .blendEnable        = true,
+            .srcFactor          = gpu::BlendFactor::One,
+            .dstFactor          = gpu::BlendFactor::OneMinusSrcAlpha,
+            .blendOp            = gpu::BlendOp::Add,
+        });
     }
 
-    void SceneRenderer::drawSkybox(Scene& scene, Camera* cameraComponent, Light* sunLight) {
-        m_pDevice->debugMarkerPush("Drawing skybox...");
+    void SceneRenderer::bindSceneTarget() {
+        uint32_t windowWidth = engine::App::getInstance()->getWindow()->getWidth();
+        uint32_t windowHeight = engine::App::getInstance()->getWindow()->getHeight();
+        render::DynamicResolutionController& dynamicResolution = engine::App::getInstance()->getDynamicResolution();
+
+        if (!dynamicResolution.isEnabled() || windowWidth == 0 || windowHeight == 0) {
+            // Straight into the backbuffer, which the layer already cleared
+            m_pSceneTarget = gpu::k_defaultFramebuffer;
+            m_sceneTargetWidth = windowWidth;
+            m_sceneTargetHeight = windowHeight;
+            m_sceneViewport = { .left = 0, .right = windowWidth, .top = 0, .bottom = windowHeight };
+            return;
+        }
 
-        hlslpp::float4x4 skyboxProjection = cameraComponent->getProjectionMatrix();
+        uint32_t targetWidth = std::max(1u, static_cast<uint32_t>(std::ceil(windowWidth * dynamicResolution.getMaxScale())));
+        uint32_t targetHeight = std::max(1u, static_cast<uint32_t>(std::ceil(windowHeight * dynamicResolution.getMaxScale())));
+        if (!m_sceneFramebuffer || m_sceneFramebuffer->getDesc().colorDesc.width != targetWidth || m_sceneFramebuffer->getDesc().colorDesc.height != targetHeight) {
+            // Same sample count and depth format as the backbuffer, so the scene renders exactly like it would into it
+            m_sceneFramebuffer = m_pDevice->makeFramebuffer({
+                .colorDesc = {
+                    .width = targetWidth,
+                    .height = targetHeight,
+                    .samples = gpu::k_BACKBUFFER_SAMPLES,
+                    .format = gpu::TextureFormat::RGBA8,
+                },
+                .depthStencilDesc = {
+                    .width = targetWidth,
+                    .height = targetHeight,
+                    .samples = 1,
+                    .format = gpu::TextureFormat::Depth24_Stencil8,
+                },
+                .hasDepth = true,
+                .debugName = "SceneTarget"
+            });
+            m_sceneResolveFramebuffer = m_pDevice->makeFramebuffer({
+                .colorDesc = {
+                    .width = targetWidth,
+                    .height = targetHeight,
+                    .samples = 1,
+                    .format = gpu::TextureFormat::RGBA8,
+                },
+                .hasDepth = false,
+                .debugName = "SceneResolveTarget"
+            });
+        }
 
-        switch (scene.lightingParams.skybox.type) {
-        case SkyboxType::Procedural:
-        {
+        m_pSceneTarget = m_sceneFramebuffer;
+        m_sceneTargetWidth = targetWidth;
+        m_sceneTargetHeight = targetHeight;
+        m_sceneViewport = {
+            .left = 0,
+            .right = std::clamp(static_cast<uint32_t>(std::round(windowWidth * dynamicResolution.getScale())), 1u, targetWidth),
+            .top = 0,
+            .bottom = std::clamp(static_cast<uint32_t>(std::round(windowHeight * dynamicResolution.getScale())), 1u, targetHeight),
+        };
 
-            // Set geometry cbuffer on bind slot 0
-            m_pDevice->setConstantBuffer(m_geometryCbuffer, 0);
-            GeometryCBuffer* geometryView = nullptr;
-            m_pDevice->mapBuffer(m_geometryCbuffer, 0, sizeof(GeometryCBuffer), gpu::MapAccessFlags::Write | gpu::MapAccessFlags::InvalidateBuffer, reinterpret_cast<void**>(&geometryView));
-            if (geometryView != nullptr) {
+        m_pDevice->bindFramebuffer(m_sceneFramebuffer);
+        m_pDevice->setViewport(m_sceneViewport);
+        m_pDevice->clearColor({ 0, 0, 0, 1 });
+    }
 
-                // Skybox is a special case, we need the inverse view without translation
-                auto rot = cameraComponent->getEntity()->transform.getRotation();
-                hlslpp::float3 forward = hlslpp::normalize(hlslpp::mul(cameraComponent->getEntity()->transform.getRotation(), hlslpp::float3(0.0f, 0.0f, -1.0f)));
-                // hlslpp::float3 up = hlslpp::normalize(hlslpp::mul(cameraComponent->getEntity()->transform.getRotation(), hlslpp::float3(0.0f, 1.0f, 0.0f)));
-                geometryView->view = hlslpp::float4x4::look_at(hlslpp::float3(0,0,0), forward, hlslpp::float3(0.0f, 1.0f, 0.0f));
+    void SceneRenderer::resolveSceneTarget() {
+        if (m_pSceneTarget == gpu::k_defaultFramebuffer) {
+            return;
+        }
+        GPU_SCOPE(m_pDevice, "Upscale");
+
+        uint32_t windowWidth = engine::App::getInstance()->getWindow()->getWidth();
+        uint32_t windowHeight = engine::App::getInstance()->getWindow()->getHeight();
+
+        // Resolve MSAA first, multisampled textures can't be filtered
+        m_pDevice->blitFramebuffer(m_sceneFramebuffer, m_sceneResolveFramebuffer);
+
+        m_pDevice->bindFramebuffer(gpu::k_defaultFramebuffer);
+        m_pDevice->setViewport({ .left = 0, .right = windowWidth, .top = 0, .bottom = windowHeight });
+
+        m_pDevice->setConstantBuffer(m_upscaleCbuffer, k_uniformSlot_Upscale);
+        UpscaleCBuffer* upscaleView = nullptr;
+        m_pDevice->mapBuffer(m_upscaleCbuffer, 0, sizeof(UpscaleCBuffer), gpu::MapAccessFlags::Write | gpu::MapAccessFlags::InvalidateBuffer, reinterpret_cast<void**>(&upscaleView));
+        if (upscaleView != nullptr) {
+            float sceneWidth = static_cast<float>(m_sceneViewport.getWidth());
+            float sceneHeight = static_cast<float>(m_sceneViewport.getHeight());
+            upscaleView->fragCoordScale_uvMax = hlslpp::float4(
+                sceneWidth / (windowWidth * m_sceneTargetWidth),
+                sceneHeight / (windowHeight * m_sceneTargetHeight),
+                (sceneWidth - 0.5f) / m_sceneTargetWidth,
+                (sceneHeight - 0.5f) / m_sceneTargetHeight);
+            m_pDevice->unmapBuffer(m_upscaleCbuffer);
+        }
 
-                geometryView->model = hlslpp::float4x4::identity();
-                geometryView->projection = cameraComponent->getProjectionMatrix();
-                geometryView->cameraPosTime.xyz = cameraComponent->getEntity()->transform.getPosition();
-                geometryView->cameraPosTime.w = m_elapsedTime;
+        m_pDevice->bindTexture(m_sceneResolveFramebuffer, m_linearClampSampler, 0, 0);
+        m_pDevice->drawIndexed({
+            .vertexBufer = m_particleQuad.vertexBuffer,
+            .indexBuffer = m_particleQuad.indexBuffer,
+            .pipeline = m_pAssetManager->fetchPipeline({
+                .shader = m_sceneUpscaleShader,
+                .inputLayout = m_particleQuad.vertexLayout,
+                .graphicsState = k_fullscreenState,
+                .blendState = m_opaque_BlendState,
+            }),
+            }, m_particleQuad.triangleCount);
+
+        m_pSceneTarget = gpu::k_defaultFramebuffer;
+    }
 
-                m_pDevice->unmapBuffer(m_geometryCbuffer);
+    size_t SceneRenderer::computeSkyboxSignature(const Skybox& skybox, Light* sunLight) {
+        size_t signature = std::hash<uint8_t>{}((uint8_t)skybox.type);
+        hashCombine(signature, skybox.cubemapSize);
+        switch (skybox.type) {
+        case SkyboxType::Procedural:
+            hashCombine(signature, hlslpp::float4(skybox.proceduralOrigin, skybox.proceduralTime));
+            if (sunLight != nullptr) {
+                hashCombine(signature, hlslpp::float4(sunLight->getDirection(), sunLight->intensity));
+                hashCombine(signature, hlslpp::float4(sunLight->colour, (float)sunLight->type));
             }
+            break;
+        case SkyboxType::HDRI:
+            hashCombine(signature, std::hash<gpu::ITexture*>{}(skybox.m_skyTexture));
+            break;
+        default:
+            break;
+        }
+        return signature;
+    }
+
+    void SceneRenderer::bakeSkybox(const Skybox& skybox, Light* sunLight) {
+        ASSERT(skybox.cubemapSize > 0);
+        GPU_SCOPE(m_pDevice, "Skybox bake");
+
+        if (!m_skyboxCubemap || m_skyboxCubemap->getDesc().colorDesc.width != skybox.cubemapSize) {
+            m_skyboxCubemap = m_pDevice->makeFramebuffer({
+                .colorDesc = {
+                    .width = skybox.cubemapSize,
+                    .height = skybox.cubemapSize,
+                    .samples = 1,
+                    .format = gpu::TextureFormat::RGBA16F,
+                },
+                .hasDepth = false,
+                .cubeMap = true,
+                .debugName = "SkyboxCubemap"
+            });
+        }
 
+        gpu::IShader* bakeShader = m_skyboxProceduralShader;
+        if (skybox.type == SkyboxType::HDRI) {
+            bakeShader = m_skyboxEquirectShader;
+            m_pDevice->bindTexture(skybox.m_skyTexture, m_trillinearAniso16ClampSampler, 0);
+        } else {
             // Set lights cbuffer on bind slot 2
-            m_pDevice->setConstantBuffer(m_lightsCbuffer, 2);
+            m_pDevice->setConstantBuffer(m_lightsCbuffer, k_uniformSlot_Lights);
             LightsCbuffer* lightsView = nullptr;
             m_pDevice->mapBuffer(m_lightsCbuffer, 0, sizeof(LightsCbuffer), gpu::MapAccessFlags::Write | gpu::MapAccessFlags::InvalidateBuffer, reinterpret_cast<void**>(&lightsView));
             if (lightsView != nullptr) {
@@ -147,42 +362,526 @@ namespace render {
 #undef BIND_LIGHT
                 m_pDevice->unmapBuffer(m_lightsCbuffer);
             }
-            
-            // Draw procedural skybox
+        }
+
+        // World space directions of each face's x axis, y axis and normal, following the GL cube map face layout
+        static const hlslpp::float3 k_faceBases[gpu::k_CUBEMAP_FACE_COUNT][3] = {
+            { { 0,  0, -1 }, { 0, -1,  0 }, {  1,  0,  0 } }, // +X
+            { { 0,  0,  1 }, { 0, -1,  0 }, { -1,  0,  0 } }, // -X
+            { { 1,  0,  0 }, { 0,  0,  1 }, {  0,  1,  0 } }, // +Y
+            { { 1,  0,  0 }, { 0,  0, -1 }, {  0, -1,  0 } }, // -Y
+            { { 1,  0,  0 }, { 0, -1,  0 }, {  0,  0,  1 } }, // +Z
+            { {-1,  0,  0 }, { 0, -1,  0 }, {  0,  0, -1 } }, // -Z
+        };
+
+        m_pDevice->setViewport({ .left = 0, .right = skybox.cubemapSize, .top = 0, .bottom = skybox.cubemapSize });
+        m_pDevice->setConstantBuffer(m_geometryCbuffer, k_uniformSlot_Geometry);
+        for (uint32_t face = 0; face < gpu::k_CUBEMAP_FACE_COUNT; face++) {
+            GeometryCBuffer* geometryView = nullptr;
+            m_pDevice->mapBuffer(m_geometryCbuffer, 0, sizeof(GeometryCBuffer), gpu::MapAccessFlags::Write | gpu::MapAccessFlags::InvalidateBuffer, reinterpret_cast<void**>(&geometryView));
+            if (geometryView != nullptr) {
+                geometryView->model = hlslpp::float4x4::identity();
+                // See skybox_bake_vert.glsl, the view matrix carries the face's basis
+                geometryView->view = hlslpp::float4x4(
+                    hlslpp::float4(k_faceBases[face][0], 0.0f),
+                    hlslpp::float4(k_faceBases[face][1], 0.0f),
+                    hlslpp::float4(k_faceBases[face][2], 0.0f),
+                    hlslpp::float4(0.0f, 0.0f, 0.0f, 1.0f));
+                geometryView->projection = hlslpp::float4x4::identity();
+                geometryView->cameraPos = skybox.proceduralOrigin;
+                geometryView->elapsedTime = skybox.proceduralTime;
+                m_pDevice->unmapBuffer(m_geometryCbuffer);
+            }
+
+            m_pDevice->bindFramebuffer(m_skyboxCubemap, face);
             m_pDevice->drawIndexed({
-                .vertexBufer = m_skyboxSphere.vertexBuffer,
-                .indexBuffer = m_skyboxSphere.indexBuffer,
-                .shader = m_skyboxProceduralShader,
-                .vertexLayout = m_skyboxSphere.vertexLayout,
-                }, m_skyboxSphere.triangleCount
-            );
-            break;
+                .vertexBufer = m_particleQuad.vertexBuffer,
+                .indexBuffer = m_particleQuad.indexBuffer,
+                .pipeline = m_pAssetManager->fetchPipeline({
+                    .shader = bakeShader,
+                    .inputLayout = m_particleQuad.vertexLayout,
+                    .graphicsState = k_fullscreenState,
+                    .blendState = m_opaque_BlendState,
+                }),
+                }, m_particleQuad.triangleCount);
         }
-        case SkyboxType::HDRI:
-        {
-            // @TODO: Draw HDRI skybox (read: cubemap)
-            break;
+
+        m_pDevice->bindFramebuffer(m_pSceneTarget);
+        m_pDevice->setViewport(m_sceneViewport);
+    }
+
+    void SceneRenderer::drawSkybox(Scene& scene, Camera* cameraComponent, Light* sunLight) {
+        const Skybox& skybox = scene.lightingParams.skybox;
+        if (skybox.type >= SkyboxType::Count) {
+            LOG_WARN("Unknown skybox type {}! Not drawing skybox...", (uint8_t) skybox.type);
+            return;
         }
-        default:
-            LOG_WARN("Unknown skybox type {}! Not drawing skybox...", (uint8_t) scene.lightingParams.skybox.type);
+        if (skybox.type == SkyboxType::HDRI && skybox.m_skyTexture == nullptr) {
+            return;
+        }
+
+        GPU_SCOPE(m_pDevice, "Skybox");
+
+        // Cube map HDRIs are sampled as is, everything else goes through the baked cube map
+        bool sampleSkyTexture = skybox.type == SkyboxType::HDRI && skybox.m_skyTexture->getDesc().type == gpu::TextureType::TextureCubeMap;
+        if (!sampleSkyTexture) {
+            size_t signature = computeSkyboxSignature(skybox, sunLight);
+            if (!m_skyboxCubemap || m_skyboxBakeIncomplete || signature != m_skyboxSignature) {
+                const uint64_t fallbackCount = m_pAssetManager->getCompilingShaderFallbackCount();
+                bakeSkybox(skybox, sunLight);
+                m_skyboxSignature = signature;
+                // Bake again next frame, the signature won't change once the shader is ready
+                m_skyboxBakeIncomplete = fallbackCount != m_pAssetManager->getCompilingShaderFallbackCount();
+            }
+        }
+
+        // Set geometry cbuffer on bind slot 0
+        m_pDevice->setConstantBuffer(m_geometryCbuffer, k_uniformSlot_Geometry);
+        GeometryCBuffer* geometryView = nullptr;
+        m_pDevice->mapBuffer(m_geometryCbuffer, 0, sizeof(GeometryCBuffer), gpu::MapAccessFlags::Write | gpu::MapAccessFlags::InvalidateBuffer, reinterpret_cast<void**>(&geometryView));
+        if (geometryView != nullptr) {
+
+            // Skybox is a special case, we need the inverse view without translation
+            hlslpp::float3 forward = hlslpp::normalize(hlslpp::mul(cameraComponent->getEntity()->transform.getRotation(), hlslpp::float3(0.0f, 0.0f, -1.0f)));
+            geometryView->view = hlslpp::float4x4::look_at(hlslpp::float3(0,0,0), forward, hlslpp::float3(0.0f, 1.0f, 0.0f));
+
+            geometryView->model = getPositionDequantisation(m_skyboxSphere);
+            geometryView->projection = cameraComponent->getProjectionMatrix();
+            geometryView->cameraPos = cameraComponent->getEntity()->transform.getPosition();
+            geometryView->elapsedTime = m_elapsedTime;
+
+            m_pDevice->unmapBuffer(m_geometryCbuffer);
+        }
+
+        if (sampleSkyTexture) {
+            m_pDevice->bindTexture(skybox.m_skyTexture, m_linearClampSampler, 0);
+        } else {
+            m_pDevice->bindTexture(m_skyboxCubemap, m_linearClampSampler, 0, 0);
+        }
+
+        m_pDevice->drawIndexed({
+            .vertexBufer = m_skyboxSphere.vertexBuffer,
+            .indexBuffer = m_skyboxSphere.indexBuffer,
+            .pipeline = m_pAssetManager->fetchPipeline({
+                .shader = m_skyboxCubemapShader,
+                .inputLayout = m_skyboxSphere.vertexLayout,
+                .graphicsState = k_skyboxState,
+                .blendState = m_opaque_BlendState,
+            }),
+            }, m_skyboxSphere.triangleCount
+        );
+    }
+
+    MeshLod SceneRenderer::selectMeshLod(MeshRenderer* pRenderer, const hlslpp::float4x4& model, Camera* cameraComponent) {
+        const Mesh& mesh = pRenderer->mesh;
+        if (mesh.lodCount <= 1 || cameraComponent->getProjection() != CameraProjection::Perspective) {
+            // Orthographic cameras don't shrink things with distance
+            pRenderer->m_currentLod = 0;
+            return { .firstIndex = 0, .triangleCount = mesh.triangleCount };
+        }
+
+        // World space bounding sphere. Scale the radius by the largest axis so non-uniform scales stay conservative
+        hlslpp::float3 centre = hlslpp::mul(hlslpp::float4((mesh.boundsMin + mesh.boundsMax) * 0.5f, 1.0f), model).xyz;
+        float scale = hlslpp::max(hlslpp::max(
+            hlslpp::length(hlslpp::mul(hlslpp::float4(1.0f, 0.0f, 0.0f, 0.0f), model).xyz),
+            hlslpp::length(hlslpp::mul(hlslpp::float4(0.0f, 1.0f, 0.0f, 0.0f), model).xyz)),
+            hlslpp::length(hlslpp::mul(hlslpp::float4(0.0f, 0.0f, 1.0f, 0.0f), model).xyz));
+        float radius = hlslpp::length(mesh.boundsMax - mesh.boundsMin) * 0.5f * scale;
+        float distance = hlslpp::length(centre - cameraComponent->getEntity()->transform.getPosition());
+
+        uint32_t level = std::min(pRenderer->m_currentLod, mesh.lodCount - 1);
+        if (distance <= radius) {
+            // Camera is inside the bounds
+            level = 0;
+        } else {
+            // Projected radius as a fraction of half the screen height
+            float coverage = radius / (distance * tanf(hlslpp::radians(hlslpp::float1(cameraComponent->getFov())) * 0.5f));
+
+            // Only step a level once the coverage is clearly past the threshold, in either direction
+            while (level + 1 < mesh.lodCount && coverage < k_lodScreenCoverage[level] * (1.0f - k_lodHysteresis)) {
+                level++;
+            }
+            while (level > 0 && coverage > k_lodScreenCoverage[level - 1] * (1.0f + k_lodHysteresis)) {
+                level--;
+            }
+        }
+
+        pRenderer->m_currentLod = level;
+        return mesh.lods[level];
+    }
+
+    bool SceneRenderer::isDepthPrepassEligible(MeshRenderer* pRenderer) const {
+        // The pre-pass always rasterises with the default state. Anything else (double sided, no depth writes...) would
+        // leave the depth buffer out of sync with what the material draws, so those meshes shade normally instead
+        if (pRenderer->material.shader == nullptr) {
+            return false;
+        }
+        const gpu::GraphicsState& state = pRenderer->material.graphicsState;
+        return state.depthTest && state.depthWrite
+            && state.depthState == gpu::CompareFunc::GreaterOrEqual
+            && state.faceCullingMode == gpu::FaceCullMode::Back
+            && state.faceWindingOrder == gpu::WindingOrder::CounterClockwise;
+    }
+
+    void SceneRenderer::registerUniformBlocks() {
+        m_pDevice->registerUniformBlock(getUniformBlockDesc<GeometryCBuffer>(k_uniformSlot_Geometry));
+        m_pDevice->registerUniformBlock(getUniformBlockDesc<MaterialCBuffer>(k_uniformSlot_Material));
+        m_pDevice->registerUniformBlock(getUniformBlockDesc<LightsCbuffer>(k_uniformSlot_Lights));
+        m_pDevice->registerUniformBlock(getUniformBlockDesc<ParticlesCBuffer>(k_uniformSlot_Particles));
+        m_pDevice->registerUniformBlock(getUniformBlockDesc<UpscaleCBuffer>(k_uniformSlot_Upscale));
+    }
+
+    gpu::IShader* SceneRenderer::fetchMaterialShader(const Material& material, uint32_t lightCount) {
+        const uint32_t features = getMaterialFeatures(material);
+        const uint32_t variantKey = features | (lightCount << 24);
+
+        auto& variants = m_materialShaderVariants[material.shader];
+        auto variant = variants.find(variantKey);
+        if (variant != variants.end()) {
+            return variant->second;
+        }
+
+        gpu::IShader* pShader = m_pAssetManager->fetchShaderVariant(material.shader, getMaterialVariantDefines(features, lightCount));
+        variants.emplace(variantKey, pShader);
+        return pShader;
+    }
+
+    float SceneRenderer::estimateDepthComplexity(std::vector<RenderListElement>& drawables, Camera* cameraComponent) {
+        // Sums the screen area of every opaque mesh's projected bounds. Boxes overestimate the real surface area,
+        // but the ratio between scenes is what matters when deciding whether a pre-pass pays for itself
+        hlslpp::float4x4 viewProjection = hlslpp::mul(cameraComponent->getViewMatrix(), cameraComponent->getProjectionMatrix());
+        float coveredArea = 0;
+        for (const RenderListElement& drawable : drawables) {
+            if (drawable.componentType != ComponentType::MeshRenderer) {
+                continue;
+            }
+            MeshRenderer* pRenderer = drawable.pMeshRenderer;
+            if (!drawable.isActive() || pRenderer->mesh.triangleCount < 1) {
+                continue;
+            }
+
+            hlslpp::float4x4 modelViewProjection = hlslpp::mul(hlslpp::mul(drawable.getParentMatrix(), pRenderer->getEntity()->transform.getModel()), viewProjection);
+            float minX = 1.0f, minY = 1.0f, maxX = -1.0f, maxY = -1.0f;
+            bool crossesCameraPlane = false;
+            for (uint32_t corner = 0; corner < 8; corner++) {
+                hlslpp::float4 clip = hlslpp::mul(hlslpp::float4(
+                    (corner & 1) ? pRenderer->mesh.boundsMax.x : pRenderer->mesh.boundsMin.x,
+                    (corner & 2) ? pRenderer->mesh.boundsMax.y : pRenderer->mesh.boundsMin.y,
+                    (corner & 4) ? pRenderer->mesh.boundsMax.z : pRenderer->mesh.boundsMin.z,
+                    1.0f), modelViewProjection);
+                float w = clip.w;
+                if (w <= 0.0f) {
+                    crossesCameraPlane = true;
+                    break;
+                }
+                minX = std::min(minX, (float)clip.x / w);
+                maxX = std::max(maxX, (float)clip.x / w);
+                minY = std::min(minY, (float)clip.y / w);
+                maxY = std::max(maxY, (float)clip.y / w);
+            }
+            if (crossesCameraPlane) {
+                // Assume it fills the screen
+                coveredArea += 1.0f;
+                continue;
+            }
+
+            // Clamp to the screen, NDC spans 2 units on each axis
+            float width = std::max(0.0f, std::min(maxX, 1.0f) - std::max(minX, -1.0f)) * 0.5f;
+            float height = std::max(0.0f, std::min(maxY, 1.0f) - std::max(minY, -1.0f)) * 0.5f;
+            coveredArea += width * height;
+        }
+        return coveredArea;
+    }
+
+    void SceneRenderer::drawDepthPrepass(std::vector<RenderListElement>& drawables, Camera* cameraComponent) {
+        GPU_SCOPE(m_pDevice, "Depth pre-pass");
+
+        m_pDevice->setConstantBuffer(m_geometryCbuffer, k_uniformSlot_Geometry);
+        for (const RenderListElement& drawable : drawables) {
+            // Particles are billboards built in their own vertex shader, they only ever shade in the main pass
+            if (drawable.componentType != ComponentType::MeshRenderer) {
+                continue;
+            }
+            MeshRenderer* pRenderer = drawable.pMeshRenderer;
+            if (!drawable.isActive() || pRenderer->mesh.triangleCount < 1 || !isDepthPrepassEligible(pRenderer)) {
+                continue;
+            }
+
+            hlslpp::float4x4 model = hlslpp::mul(drawable.getParentMatrix(), pRenderer->getEntity()->transform.getModel());
+            // The shading pass tests the same drawable again and counts it in the Hi-Z stats
+            if (!m_occlusionCuller.isVisible(pRenderer->mesh.boundsMin, pRenderer->mesh.boundsMax, model, false)) {
+                continue;
+            }
+
+            GeometryCBuffer* geometryView = nullptr;
+            m_pDevice->mapBuffer(m_geometryCbuffer, 0, sizeof(GeometryCBuffer), gpu::MapAccessFlags::Write | gpu::MapAccessFlags::InvalidateBuffer, reinterpret_cast<void**>(&geometryView));
+            if (geometryView != nullptr) {
+                geometryView->model = hlslpp::mul(getPositionDequantisation(pRenderer->mesh), model);
+                geometryView->view = cameraComponent->getViewMatrix();
+                geometryView->projection = cameraComponent->getProjectionMatrix();
+                geometryView->cameraPos = cameraComponent->getEntity()->transform.getPosition();
+                geometryView->elapsedTime = m_elapsedTime;
+                m_pDevice->unmapBuffer(m_geometryCbuffer);
+            }
+
+            // Same LOD as the main pass will pick, otherwise the depth won't match
+            MeshLod lod = selectMeshLod(pRenderer, model, cameraComponent);
+            m_pDevice->drawIndexed({
+                .vertexBufer = pRenderer->mesh.vertexBuffer,
+                .indexBuffer = pRenderer->mesh.indexBuffer,
+                .pipeline = m_pAssetManager->fetchPipeline({
+                    .shader = m_depthPrepassShader,
+                    .inputLayout = pRenderer->mesh.vertexLayout,
+                    .graphicsState = k_depthPrepassState,
+                    .blendState = m_opaque_BlendState,
+                }),
+                }, lod.triangleCount, lod.firstIndex * pRenderer->mesh.indexSize, 1);
+        }
+    }
+
+    void SceneRenderer::drawWeightedBlendedTransparency(Camera* cameraComponent, Light* sunLight) {
+        bool anyActive = std::any_of(m_forwardWeightedBlendedList.begin(), m_forwardWeightedBlendedList.end(), [](const RenderListElement& drawable) {
+            return drawable.isActive();
+        });
+        // The OIT targets have to match the framebuffer the scene renders into, so its depth can be copied over
+        uint32_t width = m_sceneTargetWidth;
+        uint32_t height = m_sceneTargetHeight;
+        if (!anyActive || width == 0 || height == 0) {
+            return;
+        }
+
+        if (!m_oitFramebuffer || m_oitFramebuffer->getDesc().colorDesc.width != width || m_oitFramebuffer->getDesc().colorDesc.height != height) {
+            // (Re)allocate the targets to match the scene target. Depth is copied from it, so its format has to match too
+            m_oitFramebuffer = m_pDevice->makeFramebuffer({
+                .colorDesc = {
+                    .width = width,
+                    .height = height,
+                    .samples = 1,
+                    .format = gpu::TextureFormat::RGBA16F,
+                },
+                .depthStencilDesc = {
+                    .width = width,
+                    .height = height,
+                    .samples = 1,
+                    .format = gpu::TextureFormat::Depth24_Stencil8,
+                },
+                .hasDepth = true,
+                .additionalColorFormats = { gpu::TextureFormat::R16F },
+                .debugName = "OitTargets"
+            });
+        }
+
+        GPU_SCOPE(m_pDevice, "Weighted blended OIT");
+
+        // Transparent surfaces still have to be hidden behind opaque ones
+        m_pDevice->blitFramebufferDepth(m_pSceneTarget, m_oitFramebuffer);
+        m_pDevice->bindFramebuffer(m_oitFramebuffer);
+        // Nothing accumulated yet, and the background is fully revealed
+        m_pDevice->clearColorAttachment(0, { 0, 0, 0, 1 });
+        m_pDevice->clearColorAttachment(1, { 0, 0, 0, 0 });
+
+        m_drawingWeightedBlended = true;
+        drawRenderList(m_forwardWeightedBlendedList, cameraComponent, sunLight, m_oitAccumulate_BlendState);
+        m_drawingWeightedBlended = false;
+        m_pDevice->setDepthOverride(false);
+
+        // Resolve the average colour over the scene
+        m_pDevice->bindFramebuffer(m_pSceneTarget);
+        m_pDevice->bindTexture(m_oitFramebuffer, m_trillinearAniso16ClampSampler, 0, 0);
+        m_pDevice->bindTexture(m_oitFramebuffer, m_trillinearAniso16ClampSampler, 1, 1);
+        m_pDevice->drawIndexed({
+            .vertexBufer = m_particleQuad.vertexBuffer,
+            .indexBuffer = m_particleQuad.indexBuffer,
+            .pipeline = m_pAssetManager->fetchPipeline({
+                .shader = m_oitCompositeShader,
+                .inputLayout = m_particleQuad.vertexLayout,
+                .graphicsState = k_fullscreenState,
+                .blendState = m_alphaBlend_BlendState,
+            }),
+            }, m_particleQuad.triangleCount);
+    }
+
+    static FontRenderer::TextDrawParams makeTextDrawParams(const UIElement* pUiElement) {
+        return {
+            .posX = pUiElement->posX,
+            .posY = pUiElement->posY,
+            .outlineWidth = pUiElement->outlineWidth,
+            .colourForeground = pUiElement->textColour,
+            .colourOutline = pUiElement->outlineColour,
+            .size = pUiElement->textScale,
+            .text = pUiElement->text,
+        };
+    }
+
+    // Bounds are stored as min xy, max xy in clip space. Inverted bounds are empty, and grow correctly under min/max
+    static const hlslpp::float4 k_emptyUiBounds = hlslpp::float4(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+    static hlslpp::float4 unionUiBounds(const hlslpp::float4& a, const hlslpp::float4& b) {
+        return hlslpp::float4(
+            std::min((float)a.x, (float)b.x), std::min((float)a.y, (float)b.y),
+            std::max((float)a.z, (float)b.z), std::max((float)a.w, (float)b.w));
+    }
+
+    static bool overlapsUiBounds(const hlslpp::float4& a, const hlslpp::float4& b) {
+        return (float)a.x < (float)b.z && (float)b.x < (float)a.z && (float)a.y < (float)b.w && (float)b.y < (float)a.w;
+    }
+
+    hlslpp::float4 SceneRenderer::computeUiElementBounds(const UIElement* pElement, const hlslpp::float4x4& modelProjection) {
+        // Element space rectangle covered by the element, see ui_shader_vert.glsl and the text layout
+        hlslpp::float4 localRect;
+        switch (pElement->uiType) {
+        case UIElementType::Sprite:
+            localRect = hlslpp::float4(
+                pElement->posX - pElement->sizeX * 0.5f, -pElement->posY - pElement->sizeY * 0.5f,
+                pElement->posX + pElement->sizeX * 0.5f, -pElement->posY + pElement->sizeY * 0.5f);
+            break;
+        case UIElementType::Text:
+            localRect = m_fontRenderer.measureText(m_fontData, makeTextDrawParams(pElement));
+            if ((float)localRect.x == (float)localRect.z) {
+                return k_emptyUiBounds;
+            }
             break;
         }
-        m_pDevice->debugMarkerPop();
+
+        hlslpp::float4 bounds = k_emptyUiBounds;
+        for (uint32_t corner = 0; corner < 4; corner++) {
+            hlslpp::float4 position = hlslpp::float4(
+                (corner & 1) ? localRect.z : localRect.x,
+                (corner & 2) ? localRect.w : localRect.y,
+                0.0f, 1.0f);
+            hlslpp::float4 clip = hlslpp::mul(position, modelProjection);
+            bounds = unionUiBounds(bounds, hlslpp::float4(clip.x, clip.y, clip.x, clip.y));
+        }
+        return bounds;
+    }
+
+    hlslpp::float4 SceneRenderer::findCachedUiCanvasDirtyBounds(CachedUiCanvas& canvas) {
+        canvas.signatures.resize(canvas.elements.size(), 0);
+        canvas.bounds.resize(canvas.elements.size(), k_emptyUiBounds);
+
+        hlslpp::float4 dirtyBounds = canvas.valid ? k_emptyUiBounds : hlslpp::float4(-1, -1, 1, 1);
+        for (size_t i = 0; i < canvas.elements.size(); i++) {
+            const RenderListElement& drawable = canvas.elements[i];
+            const UIElement* pElement = drawable.pUiElement;
+
+            // Sprites are placed by their offset alone and text with its entity's model, as in drawRenderList
+            hlslpp::float4x4 model = pElement->uiType == UIElementType::Sprite ? hlslpp::float4x4::identity() : pElement->getEntity()->transform.getModel();
+            hlslpp::float4x4 modelProjection = hlslpp::mul(model, m_uiProjection);
+
+            // Everything that changes what the element puts on screen
+            size_t signature = drawable.isActive() ? 1 : 0;
+            hashCombine(signature, (size_t)pElement->uiType);
+            hashCombine(signature, hlslpp::mul(hlslpp::float4(0, 0, 0, 1), modelProjection));
+            hashCombine(signature, hlslpp::mul(hlslpp::float4(1, 0, 0, 0), modelProjection));
+            hashCombine(signature, hlslpp::mul(hlslpp::float4(0, 1, 0, 0), modelProjection));
+            hashCombine(signature, hlslpp::float4(pElement->posX, pElement->posY, pElement->sizeX, pElement->sizeY));
+            hashCombine(signature, hlslpp::float4(pElement->outlineWidth, pElement->textScale, 0, 0));
+            hashCombine(signature, std::hash<const void*>{}(pElement->texture));
+            hashCombine(signature, pElement->textureTint);
+            hashCombine(signature, pElement->uvRect);
+            if (pElement->uiType == UIElementType::Text) {
+                hashCombine(signature, std::hash<std::string>{}(pElement->text));
+                hashCombine(signature, pElement->textColour);
+                hashCombine(signature, pElement->outlineColour);
+            }
+
+            if (canvas.valid && signature == canvas.signatures[i]) {
+                continue;
+            }
+
+            // Both where the element was and where it is now have to be redrawn
+            hlslpp::float4 bounds = drawable.isActive() ? computeUiElementBounds(pElement, modelProjection) : k_emptyUiBounds;
+            dirtyBounds = unionUiBounds(dirtyBounds, unionUiBounds(canvas.bounds[i], bounds));
+            canvas.signatures[i] = signature;
+            canvas.bounds[i] = bounds;
+        }
+        return dirtyBounds;
+    }
+
+    void SceneRenderer::drawCachedUiCanvas(CachedUiCanvas& canvas, Camera* cameraComponent, Light* sunLight, gpu::IBlendState* blendState) {
+        uint32_t width = engine::App::getInstance()->getWindow()->getWidth();
+        uint32_t height = engine::App::getInstance()->getWindow()->getHeight();
+        if (width == 0 || height == 0) {
+            return;
+        }
+
+        // Anything queued so far belongs underneath the canvas
+        m_spriteBatcher.flush(blendState);
+        m_fontRenderer.flush(m_fontData, blendState);
+
+        if (!canvas.framebuffer || canvas.framebuffer->getDesc().colorDesc.width != width || canvas.framebuffer->getDesc().colorDesc.height != height) {
+            canvas.framebuffer = m_pDevice->makeFramebuffer({
+                .colorDesc = {
+                    .width = width,
+                    .height = height,
+                    .samples = 1,
+                    .format = gpu::TextureFormat::RGBA8,
+                },
+                .hasDepth = false,
+                .debugName = "UiCanvasCache"
+            });
+            canvas.valid = false;
+        }
+
+        hlslpp::float4 dirtyBounds = findCachedUiCanvasDirtyBounds(canvas);
+        bool drewWithCompilingShaders = false;
+        if (overlapsUiBounds(dirtyBounds, hlslpp::float4(-1, -1, 1, 1))) {
+            // Clip space to pixels, grown by a pixel to cover filtering at the edges
+            auto toPixel = [](float clip, uint32_t size, float bias) -> uint32_t {
+                float pixel = (clip * 0.5f + 0.5f) * size + bias;
+                return static_cast<uint32_t>(std::clamp(pixel, 0.0f, (float)size));
+            };
+            gpu::Rect dirtyRect = {
+                .left = toPixel(dirtyBounds.x, width, -1.0f),
+                .right = toPixel(dirtyBounds.z, width, 2.0f),
+                .top = toPixel(dirtyBounds.y, height, -1.0f),
+                .bottom = toPixel(dirtyBounds.w, height, 2.0f),
+            };
+
+            m_dirtyUiElements.clear();
+            for (size_t i = 0; i < canvas.elements.size(); i++) {
+                if (canvas.elements[i].isActive() && overlapsUiBounds(canvas.bounds[i], dirtyBounds)) {
+                    m_dirtyUiElements.push_back(canvas.elements[i]);
+                }
+            }
+
+            GPU_SCOPE(m_pDevice, "Cached UI canvas redraw");
+            m_pDevice->bindFramebuffer(canvas.framebuffer);
+            m_pDevice->setScissor(true, dirtyRect);
+            m_pDevice->clearColorAttachment(0, { 0, 0, 0, 0 });
+            const uint64_t fallbackCount = m_pAssetManager->getCompilingShaderFallbackCount();
+            drawRenderList(m_dirtyUiElements, cameraComponent, sunLight, m_uiCanvas_BlendState);
+            drewWithCompilingShaders = fallbackCount != m_pAssetManager->getCompilingShaderFallbackCount();
+            m_pDevice->setScissor(false);
+            m_pDevice->bindFramebuffer(gpu::k_defaultFramebuffer);
+        }
+        // Element signatures don't change once a shader is ready, so redraw the whole canvas until nothing was missing
+        canvas.valid = !drewWithCompilingShaders;
+
+        m_pDevice->bindTexture(canvas.framebuffer, m_trillinearAniso16ClampSampler, 0, 0);
+        m_pDevice->drawIndexed({
+            .vertexBufer = m_particleQuad.vertexBuffer,
+            .indexBuffer = m_particleQuad.indexBuffer,
+            .pipeline = m_pAssetManager->fetchPipeline({
+                .shader = m_uiCanvasCompositeShader,
+                .inputLayout = m_particleQuad.vertexLayout,
+                .graphicsState = k_fullscreenState,
+                .blendState = m_premultipliedAlpha_BlendState,
+            }),
+            }, m_particleQuad.triangleCount);
     }
 
     void SceneRenderer::drawRenderList(std::vector<RenderListElement>& drawables, Camera* cameraComponent, Light* sunLight, gpu::IBlendState* blendState) {
         ASSERT(cameraComponent != nullptr);
         ASSERT(blendState != nullptr);
 
-        // Entity didn't have any components we wanted attached to itself, check children
-        m_pDevice->bindBlendState(blendState);
         for (RenderListElement drawable : drawables) {
             switch (drawable.componentType) {
             case ComponentType::MeshRenderer:
             {
                 MeshRenderer* pRenderer = drawable.pMeshRenderer;
                 // may return null, if not null its what we're after anyway
-                if (pRenderer->enabled && pRenderer->getEntity()->enabled) {
+                if (drawable.isActive()) {
                     if (pRenderer->mesh.triangleCount < 1) {
                         if (pRenderer->mesh.vertexBuffer) {
                             LOG_WARN("Tried rendering mesh with no triangles. Skipping...");
@@ -192,30 +891,38 @@ namespace render {
                         }
                     } else {
 
+                        // @TODO: May need to flip
+                        hlslpp::float4x4 model = hlslpp::mul(drawable.getParentMatrix(), pRenderer->getEntity()->transform.getModel());
+
+                        // Skip meshes hidden behind last frame's opaque geometry
+                        if (!m_occlusionCuller.isVisible(pRenderer->mesh.boundsMin, pRenderer->mesh.boundsMax, model)) {
+                            break;
+                        }
+
                         // Set geometry cbuffer on bind slot 0
-                        m_pDevice->setConstantBuffer(m_geometryCbuffer, 0);
+                        m_pDevice->setConstantBuffer(m_geometryCbuffer, k_uniformSlot_Geometry);
                         GeometryCBuffer* geometryView = nullptr;
                         m_pDevice->mapBuffer(m_geometryCbuffer, 0, sizeof(GeometryCBuffer), gpu::MapAccessFlags::Write | gpu::MapAccessFlags::InvalidateBuffer, reinterpret_cast<void**>(&geometryView));
                         if (geometryView != nullptr) {
-                            // @TODO: May need to flip
-                            geometryView->model = hlslpp::mul(drawable.parentMatrix, pRenderer->getEntity()->transform.getModel());
+                            // Bounds, culling and LODs stay in mesh space, only the GPU sees the quantised positions
+                            geometryView->model = hlslpp::mul(getPositionDequantisation(pRenderer->mesh), model);
                             geometryView->view = cameraComponent->getViewMatrix();
                             geometryView->projection = cameraComponent->getProjectionMatrix();
-                            geometryView->cameraPosTime.xyz = cameraComponent->getEntity()->transform.getPosition();
-                            geometryView->cameraPosTime.w = m_elapsedTime;
+                            geometryView->cameraPos = cameraComponent->getEntity()->transform.getPosition();
+                            geometryView->elapsedTime = m_elapsedTime;
                             m_pDevice->unmapBuffer(m_geometryCbuffer);
                         }
 
                         // Set material cbuffer on bind slot 1
-                        m_pDevice->setConstantBuffer(m_materialCbuffer, 1);
+                        m_pDevice->setConstantBuffer(m_materialCbuffer, k_uniformSlot_Material);
                         MaterialCBuffer* materialView = nullptr;
                         m_pDevice->mapBuffer(m_materialCbuffer, 0, sizeof(MaterialCBuffer), gpu::MapAccessFlags::Write | gpu::MapAccessFlags::InvalidateBuffer, reinterpret_cast<void**>(&materialView));
                         if (materialView != nullptr) {
                             materialView->ambient = pRenderer->material.ambient;
                             materialView->diffuse = pRenderer->material.diffuse;
                             materialView->specular = pRenderer->material.specular;
-                            materialView->emissionColour_glintFactor.xyz = pRenderer->material.emissionColour;
-                            materialView->emissionColour_glintFactor.w = pRenderer->material.glintFactor;
+                            materialView->emissionColour = pRenderer->material.emissionColour;
+                            materialView->glintFactor = pRenderer->material.glintFactor;
                             materialView->roughness = pRenderer->material.roughness;
                             materialView->metallic = pRenderer->material.metallic;
                             materialView->emissionIntensity = pRenderer->material.emissionIntensity;
@@ -223,7 +930,9 @@ namespace render {
                         }
 
                         // Set lights cbuffer on bind slot 2
-                        m_pDevice->setConstantBuffer(m_lightsCbuffer, 2);
+                        m_pDevice->setConstantBuffer(m_lightsCbuffer, k_uniformSlot_Lights);
+                        // Lights past this are zeroed, the material's shader variant skips them
+                        uint32_t lightCount = k_MAX_LIGHTS;
                         LightsCbuffer* lightsView = nullptr;
                         m_pDevice->mapBuffer(m_lightsCbuffer, 0, sizeof(LightsCbuffer), gpu::MapAccessFlags::Write | gpu::MapAccessFlags::InvalidateBuffer, reinterpret_cast<void**>(&lightsView));
                         if (lightsView != nullptr) {
@@ -242,7 +951,7 @@ namespace render {
                                 for (int i = 0; i < m_lights.size() && i < k_MAX_LIGHTS; i++) {
                                     BIND_LIGHT(lightsView->light[i], m_lights[i]);
                                 }
-
+                                lightCount = (uint32_t)std::min<size_t>(m_lights.size(), k_MAX_LIGHTS);
                             }
                             else {
                                 BIND_LIGHT(lightsView->light[0], sunLight);
@@ -253,6 +962,7 @@ namespace render {
                                         lightWriteIdx++;
                                     }
                                 }
+                                lightCount = lightWriteIdx;
                             }
 #undef BIND_LIGHT
                             m_pDevice->unmapBuffer(m_lightsCbuffer);
@@ -295,12 +1005,25 @@ namespace render {
                         }
 
                         // Issue draw call
+                        // The LOD's first index is scaled by Mesh::indexSize to get a byte offset into the index buffer
+                        MeshLod lod = selectMeshLod(pRenderer, model, cameraComponent);
+                        if (m_drawingWeightedBlended) {
+                            // Test against the opaque depth but never write it, every layer has to reach the OIT targets
+                            m_pDevice->setDepthOverride(true, gpu::CompareFunc::GreaterOrEqual, false);
+                        } else {
+                            // Depth is already resolved by the pre-pass, only shade the surviving fragment of each pixel
+                            m_pDevice->setDepthOverride(m_shadingAgainstPrepass && isDepthPrepassEligible(pRenderer), gpu::CompareFunc::Equal, false);
+                        }
                         m_pDevice->drawIndexed({
                             .vertexBufer = pRenderer->mesh.vertexBuffer,
                             .indexBuffer = pRenderer->mesh.indexBuffer,
-                            .shader = pRenderer->material.shader,
-                            .vertexLayout = pRenderer->mesh.vertexLayout,
-                            }, pRenderer->mesh.triangleCount, 0, 1);
+                            .pipeline = m_pAssetManager->fetchPipeline({
+                                .shader = fetchMaterialShader(pRenderer->material, lightCount),
+                                .inputLayout = pRenderer->mesh.vertexLayout,
+                                .graphicsState = pRenderer->material.graphicsState,
+                                .blendState = blendState,
+                            }),
+                            }, lod.triangleCount, lod.firstIndex * pRenderer->mesh.indexSize, 1);
                     }
                 }
                 break;
@@ -309,33 +1032,33 @@ namespace render {
 
                 ParticleSystem* pParticleSystem = drawable.pParticleSystem;
                 // may return null, if not null its what we're after anyway
-                if (pParticleSystem->enabled && pParticleSystem->getEntity()->enabled && pParticleSystem->getActiveParticleCount() > 0) {
+                if (drawable.isActive() && pParticleSystem->getActiveParticleCount() > 0) {
                     
                     // Set geometry cbuffer on bind slot 0
-                    m_pDevice->setConstantBuffer(m_geometryCbuffer, 0);
+                    m_pDevice->setConstantBuffer(m_geometryCbuffer, k_uniformSlot_Geometry);
                     GeometryCBuffer* geometryView = nullptr;
                     m_pDevice->mapBuffer(m_geometryCbuffer, 0, sizeof(GeometryCBuffer), gpu::MapAccessFlags::Write | gpu::MapAccessFlags::InvalidateBuffer, reinterpret_cast<void**>(&geometryView));
                     if (geometryView != nullptr) {
                         // @TODO: May need to flip
-                        // geometryView->model = hlslpp::mul(drawable.parentMatrix, pParticleSystem->getEntity()->transform.getModel());
-                        geometryView->model = drawable.parentMatrix;
+                        // geometryView->model = hlslpp::mul(drawable.getParentMatrix(), pParticleSystem->getEntity()->transform.getModel());
+                        geometryView->model = drawable.getParentMatrix();
                         geometryView->view = cameraComponent->getViewMatrix();
                         geometryView->projection = cameraComponent->getProjectionMatrix();
-                        geometryView->cameraPosTime.xyz = cameraComponent->getEntity()->transform.getPosition();
-                        geometryView->cameraPosTime.w = m_elapsedTime;
+                        geometryView->cameraPos = cameraComponent->getEntity()->transform.getPosition();
+                        geometryView->elapsedTime = m_elapsedTime;
                         m_pDevice->unmapBuffer(m_geometryCbuffer);
                     }
 
                     // Set material cbuffer on bind slot 1
-                    m_pDevice->setConstantBuffer(m_materialCbuffer, 1);
+                    m_pDevice->setConstantBuffer(m_materialCbuffer, k_uniformSlot_Material);
                     MaterialCBuffer* materialView = nullptr;
                     m_pDevice->mapBuffer(m_materialCbuffer, 0, sizeof(MaterialCBuffer), gpu::MapAccessFlags::Write | gpu::MapAccessFlags::InvalidateBuffer, reinterpret_cast<void**>(&materialView));
                     if (materialView != nullptr) {
                         materialView->ambient = pParticleSystem->material.ambient;
                         materialView->diffuse = pParticleSystem->material.diffuse;
                         materialView->specular = pParticleSystem->material.specular;
-                        materialView->emissionColour_glintFactor.xyz = pParticleSystem->material.emissionColour.xyz;
-                        materialView->emissionColour_glintFactor.w = 0;
+                        materialView->emissionColour = pParticleSystem->material.emissionColour;
+                        materialView->glintFactor = 0;
                         materialView->roughness = pParticleSystem->material.roughness;
                         materialView->metallic = pParticleSystem->material.metallic;
                         materialView->emissionIntensity = pParticleSystem->material.emissionIntensity;
@@ -343,7 +1066,7 @@ namespace render {
                     }
 
                     // Set lights cbuffer on bind slot 2
-                    m_pDevice->setConstantBuffer(m_lightsCbuffer, 2);
+                    m_pDevice->setConstantBuffer(m_lightsCbuffer, k_uniformSlot_Lights);
                     LightsCbuffer* lightsView = nullptr;
                     m_pDevice->mapBuffer(m_lightsCbuffer, 0, sizeof(LightsCbuffer), gpu::MapAccessFlags::Write | gpu::MapAccessFlags::InvalidateBuffer, reinterpret_cast<void**>(&lightsView));
                     if (lightsView != nullptr) {
@@ -379,7 +1102,7 @@ namespace render {
                     }
 
                     // Set particles cbuffer on bind slot 3
-                    m_pDevice->setConstantBuffer(m_particlesCbuffer, 3);
+                    m_pDevice->setConstantBuffer(m_particlesCbuffer, k_uniformSlot_Particles);
                     ParticlesCBuffer* particlesView = nullptr;
                     m_pDevice->mapBuffer(m_particlesCbuffer, 0, sizeof(ParticlesCBuffer), gpu::MapAccessFlags::Write | gpu::MapAccessFlags::InvalidateBuffer, reinterpret_cast<void**>(&particlesView));
                     int particleCount = 0;
@@ -393,10 +1116,9 @@ namespace render {
                             }
 
                             // Copy params to cbuffer
-                            particlesView->particles[particleCount].position.xyz = pParticleSystem->m_particlePool[i].position.xyz;
-                            particlesView->particles[particleCount].velocity.xyz = pParticleSystem->m_particlePool[i].velocity.xyz;
-                            particlesView->particles[particleCount].colourBegin.rgba = pParticleSystem->m_particlePool[i].colourBegin.rgba;
-                            particlesView->particles[particleCount].colourEnd.rgba = pParticleSystem->m_particlePool[i].colourEnd.rgba;
+                            particlesView->particles[particleCount].position = pParticleSystem->m_particlePool[i].position;
+                            particlesView->particles[particleCount].colourBegin = pParticleSystem->m_particlePool[i].colourBegin;
+                            particlesView->particles[particleCount].colourEnd = pParticleSystem->m_particlePool[i].colourEnd;
 
                             particlesView->particles[particleCount].sizeBegin = pParticleSystem->m_particlePool[i].sizeBegin;
                             particlesView->particles[particleCount].sizeEnd = pParticleSystem->m_particlePool[i].sizeEnd;
@@ -443,185 +1165,239 @@ namespace render {
                     }
 
                     // Issue draw call
-                    m_pDevice->bindBlendState(pParticleSystem->blendState);
+                    gpu::IBlendState* particleBlendState = pParticleSystem->blendState;
+                    if (m_drawingWeightedBlended) {
+                        // Keep the OIT blend state, the particle system's own one would break the accumulation
+                        m_pDevice->setDepthOverride(true, gpu::CompareFunc::GreaterOrEqual, false);
+                        particleBlendState = blendState;
+                    } else {
+                        m_pDevice->setDepthOverride(false);
+                    }
 
                     m_pDevice->drawIndexed({
                         .vertexBufer = m_particleQuad.vertexBuffer,
                         .indexBuffer = m_particleQuad.indexBuffer,
-                        .shader = pParticleSystem->material.shader,
-                        .vertexLayout = m_particleQuad.vertexLayout,
+                        .pipeline = m_pAssetManager->fetchPipeline({
+                            .shader = pParticleSystem->material.shader,
+                            .inputLayout = m_particleQuad.vertexLayout,
+                            .graphicsState = pParticleSystem->material.graphicsState,
+                            .blendState = particleBlendState,
+                        }),
                         }, m_particleQuad.triangleCount, 0, pParticleSystem->getActiveParticleCount()
                         );
-
-                    // Restore blend state
-                    m_pDevice->bindBlendState(blendState);
-
                 }
                 break;
             }
             case ComponentType::UIElement:
             {
                 UIElement* pUiElement = drawable.pUiElement;
+                if (!drawable.isActive()) {
+                    break;
+                }
                 switch (pUiElement->uiType) {
                 case render::UIElementType::Sprite:
                 {
-                    // Set geometry cbuffer on bind slot 0
-                    m_pDevice->setConstantBuffer(m_UiCbuffer, 0);
-                    UiCBuffer* uiBufferView = nullptr;
-                    m_pDevice->mapBuffer(m_UiCbuffer, 0, sizeof(UiCBuffer), gpu::MapAccessFlags::Write | gpu::MapAccessFlags::InvalidateBuffer, reinterpret_cast<void**>(&uiBufferView));
-                    if (uiBufferView != nullptr) {
-                        uiBufferView->model = drawable.parentMatrix;
-                        uiBufferView->view = cameraComponent->getViewMatrix();
-                        uiBufferView->projection = hlslpp::float4x4::orthographic(hlslpp::projection(hlslpp::frustum(
-                            /* width */ engine::App::getInstance()->getWindow()->getWidth(),
-                            /* height */ engine::App::getInstance()->getWindow()->getHeight(),
-                            /* near_z */ 0.1f,
-                            /* far_z */ 100.0f),
-                            hlslpp::zclip::minus_one, hlslpp::zdirection::reverse, hlslpp::zplane::infinite));
-                        uiBufferView->sizePosition = hlslpp::float4(pUiElement->sizeX, pUiElement->sizeY, pUiElement->posX, pUiElement->posY);
-                        uiBufferView->textureTint = pUiElement->textureTint;
-                        uiBufferView->screenSize = hlslpp::float4(
-                            engine::App::getInstance()->getWindow()->getWidth(),
-                            engine::App::getInstance()->getWindow()->getHeight(),
-                            1.0f / engine::App::getInstance()->getWindow()->getWidth(),
-                            1.0f / engine::App::getInstance()->getWindow()->getHeight()
-                        );
-                        m_pDevice->unmapBuffer(m_UiCbuffer);
-                    }
-
-                    // bind texture to slot 0
-                    if (pUiElement->texture) {
-                        m_pDevice->bindTexture(pUiElement->texture, m_trillinearAniso16ClampSampler, 0);
-                    } else {
-                        m_pDevice->bindTexture(m_pAssetManager->fetchWhiteTexture(), m_trillinearAniso16ClampSampler, 0);
-                    }
-
-                    m_pDevice->drawIndexed({
-                        .vertexBufer = m_particleQuad.vertexBuffer,
-                        .indexBuffer = m_particleQuad.indexBuffer,
-                        .shader = m_uiShader,
-                        .vertexLayout = m_particleQuad.vertexLayout,
-                        }, m_particleQuad.triangleCount
-                        );
+                    // Text queued before this sprite has to land underneath it
+                    m_fontRenderer.flush(m_fontData, blendState);
+                    // UI elements don't pick up the transforms of the entities above them, sprites are placed by their offset alone
+                    m_spriteBatcher.submitSprite(pUiElement, hlslpp::float4x4::identity());
                     break;
                 }
                 case render::UIElementType::Text:
                 {
-                    m_fontRenderer.drawText(m_fontData, {
-                        .posX = pUiElement->posX,
-                        .posY = pUiElement->posY,
-                        .outlineWidth = pUiElement->outlineWidth,
-                        .colourForeground = pUiElement->textColour,
-                        .colourOutline = pUiElement->outlineColour,
-                        .size = pUiElement->textScale,
-                        .text = pUiElement->text,
-                        }, pUiElement->getEntity(), cameraComponent);
+                    // Likewise for sprites queued before this text
+                    m_spriteBatcher.flush(blendState);
+                    m_fontRenderer.submitText(m_fontData, makeTextDrawParams(pUiElement), pUiElement);
                     break;
                 }
                 }
                 break;
             }
+            case ComponentType::UICanvas:
+            {
+                if (!drawable.isActive()) {
+                    break;
+                }
+                auto iter = m_cachedUiCanvases.find(drawable.pUiCanvas);
+                if (iter != m_cachedUiCanvases.end()) {
+                    drawCachedUiCanvas(iter->second, cameraComponent, sunLight, blendState);
+                }
+                break;
+            }
             default:
                 LOG_WARN("Unknown component {} in render list. Ignoring...", (uint32_t)drawable.componentType);
                 break;
             }
         }
+
+        // Draw whatever UI is still queued. Submitting one kind flushes the other, so at most one of these draws
+        m_spriteBatcher.flush(blendState);
+        m_fontRenderer.flush(m_fontData, blendState);
     }
 
-    void SceneRenderer::buildForwardRenderGraph(Entity* entity, hlslpp::float4x4 parentMatrix) {
+    // Sorts a list that is already almost in order. Draw order and camera distance rarely change much between frames,
+    // so each element usually only moves a slot or two and this is close to linear
+    template <typename T, typename Compare>
+    static void repairSortOrder(std::vector<T>& list, Compare compare) {
+        for (size_t i = 1; i < list.size(); i++) {
+            for (size_t j = i; j > 0 && compare(list[j], list[j - 1]); j--) {
+                std::swap(list[j], list[j - 1]);
+            }
+        }
+    }
+
+    void SceneRenderer::buildRenderLists(Entity* entity, CachedUiCanvas* pCachedCanvas) {
 
         // iterate through the scene and push entities / renderers into 
         ASSERT(entity != nullptr);
 
-        // entity.children
-        if (entity->enabled) {
-
-            for (const std::shared_ptr<IComponent> component : entity->components) {
-                if (component->getComponentType() == render::ComponentType::MeshRenderer) {
-                    MeshRenderer* pRenderer = (MeshRenderer*)component.get();
-                    if (pRenderer->enabled) {
-                        if (pRenderer->material.drawOrder <= k_drawOrder_Opaque) {
-                            m_forwardOpaqueList.push_back({ .componentType = render::ComponentType::MeshRenderer, .pMeshRenderer = pRenderer, .parentMatrix = parentMatrix });
-                        } else {
-                            m_forwardTransparentList.push_back({ .componentType = render::ComponentType::MeshRenderer,  .pMeshRenderer = pRenderer, .parentMatrix = parentMatrix });
-                        }
-                    }
-                }
-
-                if (component->getComponentType() == render::ComponentType::ParticleSystem) {
-                    ParticleSystem* pParticleSystem = (ParticleSystem*)component.get();
-                    if (pParticleSystem->enabled) {
-                        if (pParticleSystem->material.drawOrder <= k_drawOrder_Opaque) {
-                            m_forwardOpaqueList.push_back({ .componentType = render::ComponentType::ParticleSystem, .pParticleSystem = pParticleSystem, .parentMatrix = parentMatrix });
-                        } else {
-                            m_forwardTransparentList.push_back({ .componentType = render::ComponentType::ParticleSystem,  .pParticleSystem = pParticleSystem, .parentMatrix = parentMatrix });
-                        }
-                    }
-                }
-
-                if (component->getComponentType() == render::ComponentType::Light) {
-                    Light* pLight = (Light*)component.get();
-                    if (pLight->enabled) {
-                        m_lights.push_back(pLight);
-                    }
-                }
+        // A cached canvas takes its place in the UI list, everything under it is drawn into its texture
+        for (const std::shared_ptr<IComponent>& component : entity->components) {
+            if (component->getComponentType() != render::ComponentType::UICanvas || pCachedCanvas != nullptr) {
+                continue;
+            }
+            UICanvas* pCanvas = (UICanvas*)component.get();
+            if (pCanvas->cacheRendering) {
+                m_uiRenderList.push_back({ .componentType = render::ComponentType::UICanvas, .pUiCanvas = pCanvas, .pComponent = pCanvas });
+                pCachedCanvas = &m_cachedUiCanvases[pCanvas];
+                pCachedCanvas->elements.clear();
+                pCachedCanvas->valid = false;
+                pCachedCanvas->seen = true;
             }
+        }
 
-            // Entity didn't have any components we wanted attached to itself, check children
-            for (const std::shared_ptr<Entity> childEntity : entity->children) {
-                // may return null, if not null its what we're after anyway
-                if (childEntity->enabled) {
-                    buildForwardRenderGraph(childEntity.get(), hlslpp::mul(entity->transform.getModel(), parentMatrix));
+        // Disabled components are kept too, enabling them later shouldn't force a rebuild
+        bool foundCamera = false;
+        for (const std::shared_ptr<IComponent> component : entity->components) {
+            switch (component->getComponentType()) {
+            case render::ComponentType::MeshRenderer: {
+                MeshRenderer* pRenderer = (MeshRenderer*)component.get();
+                selectForwardRenderList(pRenderer->material).push_back({ .componentType = render::ComponentType::MeshRenderer, .pMeshRenderer = pRenderer, .pComponent = pRenderer });
+                break;
+            }
+            case render::ComponentType::ParticleSystem: {
+                ParticleSystem* pParticleSystem = (ParticleSystem*)component.get();
+                selectForwardRenderList(pParticleSystem->material).push_back({ .componentType = render::ComponentType::ParticleSystem, .pParticleSystem = pParticleSystem, .pComponent = pParticleSystem });
+                break;
+            }
+            case render::ComponentType::UIElement: {
+                UIElement* pElement = (UIElement*)component.get();
+                std::vector<RenderListElement>& uiList = pCachedCanvas != nullptr ? pCachedCanvas->elements : m_uiRenderList;
+                uiList.push_back({ .componentType = render::ComponentType::UIElement, .pUiElement = pElement, .pComponent = pElement });
+                break;
+            }
+            case render::ComponentType::Light:
+                m_allLights.push_back((Light*)component.get());
+                break;
+            case render::ComponentType::Camera:
+                // Only the first camera on an entity is ever used
+                if (!foundCamera) {
+                    m_cameras.push_back((Camera*)component.get());
+                    foundCamera = true;
                 }
+                break;
+            default:
+                break;
             }
         }
+
+        for (const std::shared_ptr<Entity> childEntity : entity->children) {
+            buildRenderLists(childEntity.get(), pCachedCanvas);
+        }
     }
 
-    void SceneRenderer::buildUiRenderGraph(Entity* entity) {
+    std::vector<SceneRenderer::RenderListElement>& SceneRenderer::selectForwardRenderList(const Material& material) {
+        if (material.drawOrder <= k_drawOrder_Opaque) {
+            return m_forwardOpaqueList;
+        }
+        if (material.transparencyMode == TransparencyMode::WeightedBlended) {
+            return m_forwardWeightedBlendedList;
+        }
+        return m_forwardTransparentList;
+    }
 
-        // iterate through the scene and push entities / renderers into 
-        ASSERT(entity != nullptr);
+    bool SceneRenderer::refreshRenderStates(Entity* entity, const hlslpp::float4x4& parentMatrix, bool parentEnabled, bool parentRecomputed) {
+        bool recompute = parentRecomputed || entity->m_renderStateDirty;
+        if (!recompute && !entity->m_childRenderStateDirty) {
+            return false;
+        }
+        if (recompute) {
+            entity->m_parentMatrix = parentMatrix;
+            entity->m_hierarchyEnabled = parentEnabled && entity->isEnabled();
+        }
+        entity->m_renderStateDirty = false;
+        entity->m_childRenderStateDirty = false;
 
-        // entity.children
-        if (entity->enabled) {
+        if (!entity->children.empty()) {
+            hlslpp::float4x4 childParentMatrix = hlslpp::mul(entity->transform.getModel(), entity->m_parentMatrix);
+            for (const std::shared_ptr<Entity>& childEntity : entity->children) {
+                refreshRenderStates(childEntity.get(), childParentMatrix, entity->m_hierarchyEnabled, recompute);
+            }
+        }
+        return true;
+    }
 
-            for (const std::shared_ptr<IComponent> component : entity->components) {
-                if (component->getComponentType() == render::ComponentType::UIElement) {
-                    UIElement* pElement = (UIElement*)component.get();
-                    if (pElement->enabled) {
-                        m_uiRenderList.push_back({ .componentType = render::ComponentType::UIElement, .pUiElement = pElement, .parentMatrix = hlslpp::float4x4::identity() });
-                    }
-                }
+    void SceneRenderer::draw(Scene& scene, const float aspect, float deltaTime) {
+        // Render lists are only rebuilt from a full scene walk when entities or components were attached or detached, or a
+        // drawable changed list. Every other frame they are kept as is, and their order repaired from the previous frame's
+        bool rebuiltRenderLists = false;
+        if (m_cachedScene != &scene || m_cachedHierarchyRevision != Entity::getHierarchyRevision()) {
+            m_cameras.clear();
+            m_allLights.clear();
+            m_forwardOpaqueList.clear();
+            m_forwardTransparentList.clear();
+            m_forwardWeightedBlendedList.clear();
+            m_uiRenderList.clear();
+            for (auto& [pCanvas, canvas] : m_cachedUiCanvases) {
+                canvas.seen = false;
             }
+            buildRenderLists(&scene.root);
+            std::erase_if(m_cachedUiCanvases, [](const auto& entry) { return !entry.second.seen; });
+
+            // OIT draws can go in any order, group them by shader so consecutive draws share program state
+            std::sort(m_forwardWeightedBlendedList.begin(), m_forwardWeightedBlendedList.end(), [](const RenderListElement& a, const RenderListElement& b) {
+                gpu::IShader* a_shader = a.componentType == ComponentType::MeshRenderer ? a.pMeshRenderer->material.shader : a.pParticleSystem->material.shader;
+                gpu::IShader* b_shader = b.componentType == ComponentType::MeshRenderer ? b.pMeshRenderer->material.shader : b.pParticleSystem->material.shader;
+                return a_shader < b_shader;
+            });
+
+            m_cachedScene = &scene;
+            m_cachedHierarchyRevision = Entity::getHierarchyRevision();
+            rebuiltRenderLists = true;
+        }
 
-            // Entity didn't have any components we wanted attached to itself, check children
-            for (const std::shared_ptr<Entity> childEntity : entity->children) {
-                // may return null, if not null its what we're after anyway
-                if (childEntity->enabled) {
-                    buildUiRenderGraph(childEntity.get());
+        // Only entities whose enable flag or transform changed (and what's below them) are recomputed, the lists read the
+        // world state straight off their entities
+        bool renderStatesChanged = refreshRenderStates(&scene.root, hlslpp::float4x4::identity(), true);
+        if (renderStatesChanged || rebuiltRenderLists) {
+            m_lights.clear();
+            for (Light* pLight : m_allLights) {
+                if (pLight->isEnabled() && pLight->getEntity()->isHierarchyEnabled()) {
+                    m_lights.push_back(pLight);
                 }
             }
         }
-    }
-
-    void SceneRenderer::draw(Scene& scene, const float aspect, float deltaTime) {
-        // We could do a more complex scene graph to optimise searching for entities but it doesn't harm performance enough to matter
 
         // Find the active camera
-        Entity* cameraEntity = scene.findEntityWithType(ComponentType::Camera);
-        if (!cameraEntity) {
-            return;
-        }
-        Camera* cameraComponent = (Camera*) cameraEntity->findComponent(ComponentType::Camera);
-        if (!cameraComponent) {
-            return;
+        Camera* cameraComponent = nullptr;
+        for (Camera* pCamera : m_cameras) {
+            if (pCamera->getEntity()->isHierarchyEnabled()) {
+                cameraComponent = pCamera;
+                break;
+            }
         }
-        if (!cameraEntity->enabled || !cameraComponent->enabled) {
+        if (!cameraComponent || !cameraComponent->isEnabled()) {
             // Can't draw if the camera is disabled
             return;
         }
         cameraComponent->setAspect(aspect); // Update aspect ratio
 
+        // Build the Hi-Z pyramid from an earlier frame's depth, if one is ready
+        m_occlusionCuller.beginFrame();
+        m_fontRenderer.beginFrame();
+        m_spriteBatcher.beginFrame();
+        m_uiProjection = makeUiProjection(engine::App::getInstance()->getWindow()->getWidth(), engine::App::getInstance()->getWindow()->getHeight());
+
         // forward rendering is simple:
         //   split scene by opaque and transparent meshes
         //   for each mesh, sort by draw order, then distance from camera
@@ -629,15 +1405,6 @@ namespace render {
         //   then draw the skybox (to take advantage of early-z discard)
         //   then draw transparent meshes, back to front
 
-        // clear draw lists
-        m_lights.clear();
-        m_forwardOpaqueList.clear();
-        m_forwardTransparentList.clear();
-        m_uiRenderList.clear();
-        // find lights and meshes
-        buildForwardRenderGraph(&scene.root, hlslpp::float4x4::identity());
-        buildUiRenderGraph(&scene.root);
-
         // sort draw graphs
         auto compareByDrawOrderFrontToBack = [cameraComponent](RenderListElement a, RenderListElement b) -> bool {
             uint32_t a_drawOrder = 0;
@@ -728,14 +1495,54 @@ namespace render {
         };
 
         // sort opaque front to back, transparent back to front for optimal rendering
-        std::sort(m_forwardOpaqueList.begin(), m_forwardOpaqueList.end(), compareByDrawOrderFrontToBack);
-        std::sort(m_forwardTransparentList.begin(), m_forwardTransparentList.end(), compareByDrawOrderBackToFront);
+        if (rebuiltRenderLists) {
+            std::sort(m_forwardOpaqueList.begin(), m_forwardOpaqueList.end(), compareByDrawOrderFrontToBack);
+            std::sort(m_forwardTransparentList.begin(), m_forwardTransparentList.end(), compareByDrawOrderBackToFront);
+        } else {
+            repairSortOrder(m_forwardOpaqueList, compareByDrawOrderFrontToBack);
+            repairSortOrder(m_forwardTransparentList, compareByDrawOrderBackToFront);
+        }
 
         // issue draw calls
-        m_pDevice->debugMarkerPush("Drawing scene...");
+        GPU_SCOPE(m_pDevice, "Scene");
+        bindSceneTarget();
+
+        // Decide whether the opaque pass is worth splitting into a depth pre-pass and a shading pass
+        switch (scene.renderingParams.depthPrepass) {
+        case DepthPrepassMode::Disabled:
+            m_depthPrepassActive = false;
+            break;
+        case DepthPrepassMode::Enabled:
+            m_depthPrepassActive = true;
+            break;
+        case DepthPrepassMode::Automatic:
+            m_estimatedDepthComplexity = estimateDepthComplexity(m_forwardOpaqueList, cameraComponent);
+            if (m_depthPrepassActive) {
+                m_depthPrepassActive = m_estimatedDepthComplexity > k_depthPrepassDisableComplexity;
+            } else {
+                m_depthPrepassActive = m_estimatedDepthComplexity > k_depthPrepassEnableComplexity;
+            }
+            break;
+        }
+
+        if (m_depthPrepassActive) {
+            drawDepthPrepass(m_forwardOpaqueList, cameraComponent);
+        }
+        {
+            GPU_SCOPE(m_pDevice, "Opaque");
+            m_shadingAgainstPrepass = m_depthPrepassActive;
+            drawRenderList(m_forwardOpaqueList, cameraComponent, scene.lightingParams.sunLight, m_opaque_BlendState);
+            m_shadingAgainstPrepass = false;
+            m_pDevice->setDepthOverride(false);
+        }
 
-        m_pDevice->bindBlendState(m_opaque_BlendState);
-        drawRenderList(m_forwardOpaqueList, cameraComponent, scene.lightingParams.sunLight, m_opaque_BlendState);
+        // The depth buffer now only holds opaque geometry, grab it for next frame's occlusion tests. The scene target is multisampled
+        // like the backbuffer, the culler resolves the viewport's depth into a single sample copy before reading it
+        m_occlusionCuller.captureDepth(
+            m_pSceneTarget,
+            m_sceneViewport.getWidth(),
+            m_sceneViewport.getHeight(),
+            hlslpp::mul(cameraComponent->getViewMatrix(), cameraComponent->getProjectionMatrix()));
 
         // Skybox is rendered after opaque materials and before transparent ones
         // this is to take advantage of an optimisation with opaque rendering.
@@ -749,15 +1556,22 @@ namespace render {
         // have already been written to.
         drawSkybox(scene, cameraComponent, scene.lightingParams.sunLight);
         
-        m_pDevice->bindBlendState(m_alphaBlend_BlendState);
-        drawRenderList(m_forwardTransparentList, cameraComponent, scene.lightingParams.sunLight, m_alphaBlend_BlendState);
+        // Order independent transparency first, sorted transparency is then blended on top of the composited result
+        drawWeightedBlendedTransparency(cameraComponent, scene.lightingParams.sunLight);
 
-        drawRenderList(m_uiRenderList, cameraComponent, scene.lightingParams.sunLight, m_alphaBlend_BlendState);
-        
-        m_pDevice->bindBlendState(m_opaque_BlendState);
+        {
+            GPU_SCOPE(m_pDevice, "Transparent");
+            drawRenderList(m_forwardTransparentList, cameraComponent, scene.lightingParams.sunLight, m_alphaBlend_BlendState);
+        }
+
+        resolveSceneTarget();
+        {
+            GPU_SCOPE(m_pDevice, "UI");
+            drawRenderList(m_uiRenderList, cameraComponent, scene.lightingParams.sunLight, m_alphaBlend_BlendState);
+        }
 
-        m_pDevice->debugMarkerPop();
 
+        m_fontRenderer.endFrame();
         m_elapsedTime += deltaTime;
     }
 }
\ No newline at end of file
@@ -5,81 +5,43 @@
 #include "engine/managers/asset_manager.hpp"
 #include "particle_system.hpp"
 #include "text_renderer.hpp"
+#include "sprite_batcher.hpp"
 #include "ui_components.hpp"
+#include "occlusion_culling.hpp"
+#include "mesh.hpp"
+#include "uniform_blocks.hpp"
+
+#include <unordered_map>
 
 namespace render {
 
     class Light;
 
-    constexpr uint32_t k_MAX_LIGHTS = 4;
-    constexpr uint32_t k_MAX_PARTICLES = 800;
-
-    struct GeometryCBuffer {
-        hlslpp::float4x4 model;
-        hlslpp::float4x4 view;
-        hlslpp::float4x4 projection;
-        hlslpp::float4 cameraPosTime;
-    };
-
-    struct MaterialCBuffer {
-        hlslpp::float3 ambient = { 0.2, 0.2, 0.2 };
-        hlslpp::float3 diffuse = { 1, 1, 1 };
-        hlslpp::float3 specular = { 1, 1, 1 };
-        hlslpp::float4 emissionColour_glintFactor = { 0, 0, 0, 0 };
-        float roughness = 1;
-        float metallic = 0;
-        float emissionIntensity = 1.0f;
-    };
-
-    struct LightRenderData {
-        // These 4 floats would be aligned into a float4, meaning a single light occupies 16 bytes
-        uint32_t type;
-        float intensity;
-        float innerRadius;
-        float outerRadius;
-
-        // Ignored for dir lights
-        hlslpp::float3 position;
-        hlslpp::float3 direction;
-
-        // RGB colour
-        hlslpp::float3 colour;
-    };
-
-    struct LightsCbuffer {
-        LightRenderData light[k_MAX_LIGHTS];
-    };
-
-    struct RenderParticleElement {
-        hlslpp::float3 position;
-        hlslpp::float3 velocity;
-        hlslpp::float4 colourBegin;
-        hlslpp::float4 colourEnd;
-
-        // packed as float4
-        float sizeBegin;
-        float sizeEnd;
-        float life;
-        float particleTextureCount;
-    };
+    // Uniform block binding slots, the same in every shader. See SceneRenderer::registerUniformBlocks
+    constexpr uint32_t k_uniformSlot_Geometry = 0;
+    constexpr uint32_t k_uniformSlot_Material = 1;
+    constexpr uint32_t k_uniformSlot_Lights = 2;
+    constexpr uint32_t k_uniformSlot_Particles = 3;
+    constexpr uint32_t k_uniformSlot_Upscale = 4;
 
-    struct ParticlesCBuffer {
-        RenderParticleElement particles[k_MAX_PARTICLES];
-    };
+    // Switch to LOD i + 1 once a mesh's bounding sphere covers less than this fraction of the screen's half height
+    constexpr float k_lodScreenCoverage[k_MAX_MESH_LODS - 1] = { 0.4f, 0.2f, 0.08f };
+    // How far past a threshold the coverage must move before changing LOD, stops meshes flickering between levels
+    constexpr float k_lodHysteresis = 0.15f;
 
-    struct UiCBuffer {
-        hlslpp::float4x4 model;
-        hlslpp::float4x4 view;
-        hlslpp::float4x4 projection;
-        hlslpp::float4 textureTint;
-        hlslpp::float4 sizePosition;
-        hlslpp::float4 screenSize;
-    };
+    // In DepthPrepassMode::Automatic the pre-pass is switched on once the estimated opaque depth complexity (average
+    // number of opaque surfaces covering a pixel) passes the first value, and back off once it drops under the second
+    constexpr float k_depthPrepassEnableComplexity = 2.0f;
+    constexpr float k_depthPrepassDisableComplexity = 1.5f;
 
     class SceneRenderer {
     public:
         void init(gpu::IDevice* pDevice, managers::AssetManager* pAssetManager);
         void draw(Scene& scene, const float aspect, float deltaTime);
+
+        inline HiZOcclusionCuller& getOcclusionCuller() { return m_occlusionCuller; }
+        inline bool isDepthPrepassActive() const { return m_depthPrepassActive; }
+        inline float getEstimatedDepthComplexity() const { return m_estimatedDepthComplexity; }
     private:
 
         struct RenderListElement {
@@ -88,43 +50,143 @@ namespace render {
                 MeshRenderer* pMeshRenderer;
                 ParticleSystem* pParticleSystem;
                 UIElement* pUiElement;
+                // Stands in for every element under a cached canvas
+                UICanvas* pUiCanvas;
             };
-            hlslpp::float4x4 parentMatrix;
+            // The same component, its entity holds the world state the element is drawn with
+            IComponent* pComponent;
+
+            // Inactive elements stay in the list but aren't drawn
+            inline bool isActive() const { return pComponent->isEnabled() && pComponent->getEntity()->isHierarchyEnabled(); }
+            inline const hlslpp::float4x4& getParentMatrix() const { return pComponent->getEntity()->getParentMatrix(); }
         };
 
-        void buildForwardRenderGraph(Entity* entity, hlslpp::float4x4 parentMatrix);
-        void buildUiRenderGraph(Entity* entity);
+        struct CachedUiCanvas {
+            // Every element under the canvas in draw order, with the state and clip space bounds they were last rendered with
+            std::vector<RenderListElement> elements;
+            std::vector<size_t> signatures;
+            std::vector<hlslpp::float4> bounds;
+            gpu::FramebufferHandle framebuffer;
+            // False until the whole canvas has been rendered once since it was (re)built or resized, with every shader compiled
+            bool valid = false;
+            // Cleared before a render list rebuild, canvases the rebuild didn't reach are dropped
+            bool seen = false;
+        };
+
+        // Collects every drawable, light and camera in the scene, regardless of whether they are enabled.
+        // UI elements under a cached canvas go into its element list instead of the UI render list
+        void buildRenderLists(Entity* entity, CachedUiCanvas* pCachedCanvas = nullptr);
+        // Recomputes the world state of every dirty entity and everything below it, top-down so each parent matrix is
+        // one multiply. Subtrees without changes aren't visited. Returns true if anything was recomputed
+        bool refreshRenderStates(Entity* entity, const hlslpp::float4x4& parentMatrix, bool parentEnabled, bool parentRecomputed = false);
+        // Which forward list a material belongs in, based on its draw order and transparency mode
+        std::vector<RenderListElement>& selectForwardRenderList(const Material& material);
         void drawRenderList(std::vector<RenderListElement>& drawables, Camera* cameraComponent, Light* sunLight, gpu::IBlendState* blendState);
+        // Binds the framebuffer the 3D scene renders into, offscreen at the dynamic resolution scale when it is enabled
+        void bindSceneTarget();
+        // Upscales the offscreen scene onto the backbuffer, UI is drawn at native resolution from here on
+        void resolveSceneTarget();
         void drawSkybox(Scene& scene, Camera* camera, Light* sunLight);
+        // Renders the sky into m_skyboxCubemap, one face at a time
+        void bakeSkybox(const Skybox& skybox, Light* sunLight);
+        // Hash of everything the baked sky depends on
+        size_t computeSkyboxSignature(const Skybox& skybox, Light* sunLight);
+        MeshLod selectMeshLod(MeshRenderer* pRenderer, const hlslpp::float4x4& model, Camera* cameraComponent);
+        bool isDepthPrepassEligible(MeshRenderer* pRenderer) const;
+        // Binds the cbuffer structs' blocks to their k_uniformSlot in every shader
+        void registerUniformBlocks();
+        // The smallest variant of the material's shader for its features and the bound lights, or the shader itself if it has none
+        gpu::IShader* fetchMaterialShader(const Material& material, uint32_t lightCount);
+        float estimateDepthComplexity(std::vector<RenderListElement>& drawables, Camera* cameraComponent);
+        void drawDepthPrepass(std::vector<RenderListElement>& drawables, Camera* cameraComponent);
+        void drawWeightedBlendedTransparency(Camera* cameraComponent, Light* sunLight);
+        // Re-renders the changed parts of a cached canvas, then composites it over the backbuffer
+        void drawCachedUiCanvas(CachedUiCanvas& canvas, Camera* cameraComponent, Light* sunLight, gpu::IBlendState* blendState);
+        // Union of the clip space bounds of every element that changed since the canvas was last rendered
+        hlslpp::float4 findCachedUiCanvasDirtyBounds(CachedUiCanvas& canvas);
+        hlslpp::float4 computeUiElementBounds(const UIElement* pElement, const hlslpp::float4x4& modelProjection);
 
         gpu::IDevice* m_pDevice = nullptr;
         managers::AssetManager* m_pAssetManager = nullptr;
 
         gpu::TextureSamplerHandle m_trillinearAniso16ClampSampler;
+        // Bilinear without mips, for render targets
+        gpu::TextureSamplerHandle m_linearClampSampler;
 
         gpu::BufferHandle m_geometryCbuffer;
         gpu::BufferHandle m_materialCbuffer;
         gpu::BufferHandle m_lightsCbuffer;
         gpu::BufferHandle m_particlesCbuffer;
-        gpu::BufferHandle m_UiCbuffer;
+        gpu::BufferHandle m_upscaleCbuffer;
 
         gpu::IShader* m_skyboxTexShader = nullptr;
         gpu::IShader* m_skyboxProceduralShader = nullptr;
-        gpu::IShader* m_uiShader = nullptr;
+        gpu::IShader* m_skyboxEquirectShader = nullptr;
+        gpu::IShader* m_skyboxCubemapShader = nullptr;
+        gpu::IShader* m_depthPrepassShader = nullptr;
+        gpu::IShader* m_oitCompositeShader = nullptr;
+        gpu::IShader* m_uiCanvasCompositeShader = nullptr;
+        gpu::IShader* m_sceneUpscaleShader = nullptr;
         Mesh m_skyboxSphere;
         Mesh m_particleQuad;
 
         gpu::BlendStateHandle m_opaque_BlendState;
         gpu::BlendStateHandle m_alphaBlend_BlendState;
-
+        gpu::BlendStateHandle m_oitAccumulate_BlendState;
+        gpu::BlendStateHandle m_uiCanvas_BlendState;
+        gpu::BlendStateHandle m_premultipliedAlpha_BlendState;
+
+        // Sky baked into a cube map, re-baked once m_skyboxSignature no longer matches the scene's sky
+        gpu::FramebufferHandle m_skyboxCubemap;
+        size_t m_skyboxSignature = 0;
+        // Baked while one of the bake shaders was still compiling, so it holds the error shader's output
+        bool m_skyboxBakeIncomplete = false;
+
+        // Dynamic resolution targets, sized for the largest scale so they only reallocate with the window. The scene renders
+        // into the bottom left corner of m_sceneFramebuffer, which is resolved into m_sceneResolveFramebuffer and upscaled
+        gpu::FramebufferHandle m_sceneFramebuffer;
+        gpu::FramebufferHandle m_sceneResolveFramebuffer;
+        // Where the 3D scene is drawn this frame. Either the backbuffer, or the bottom left corner of m_sceneFramebuffer
+        gpu::IFramebuffer* m_pSceneTarget = gpu::k_defaultFramebuffer;
+        uint32_t m_sceneTargetWidth = 0;
+        uint32_t m_sceneTargetHeight = 0;
+        gpu::Rect m_sceneViewport;
+
+        // Weighted blended OIT targets. Attachment 0 is accumulation (RGBA16F), attachment 1 the weight sum (R16F)
+        gpu::FramebufferHandle m_oitFramebuffer;
+
+        // Render lists persist across frames, they are only rebuilt when the scene or its hierarchy changes
+        Scene* m_cachedScene = nullptr;
+        uint64_t m_cachedHierarchyRevision = 0;
+        std::vector<Camera*> m_cameras;
+        std::vector<Light*> m_allLights;
         std::vector<Light*> m_lights;
+        // Material shader -> variant key (features, light count in the top byte) -> variant
+        std::unordered_map<gpu::IShader*, std::unordered_map<uint32_t, gpu::IShader*>> m_materialShaderVariants;
         std::vector<RenderListElement> m_forwardOpaqueList;
         std::vector<RenderListElement> m_forwardTransparentList;
+        // Transparent materials using TransparencyMode::WeightedBlended. Order doesn't matter, so this list is never sorted by depth
+        std::vector<RenderListElement> m_forwardWeightedBlendedList;
         std::vector<RenderListElement> m_uiRenderList;
+        std::unordered_map<UICanvas*, CachedUiCanvas> m_cachedUiCanvases;
+        // Scratch list of the cached canvas elements that need redrawing
+        std::vector<RenderListElement> m_dirtyUiElements;
+        hlslpp::float4x4 m_uiProjection = hlslpp::float4x4::identity();
 
         float m_elapsedTime = 0;
 
+        // Depth pre-pass state
+        bool m_depthPrepassActive = false;
+        // Set while drawing the opaque list after a pre-pass, eligible meshes then shade with an equal depth test
+        bool m_shadingAgainstPrepass = false;
+        // Set while drawing into the OIT targets, draws keep the OIT blend state and never write depth
+        bool m_drawingWeightedBlended = false;
+        float m_estimatedDepthComplexity = 0;
+
         FontRenderer m_fontRenderer;
         FontData m_fontData;
+        SpriteBatcher m_spriteBatcher;
+
+        HiZOcclusionCuller m_occlusionCuller;
     };
 }
\ No newline at end of file
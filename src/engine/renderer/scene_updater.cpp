@@ -20,11 +20,11 @@ namespace render {
     }
 
     void SceneUpdater::start(const std::shared_ptr<Entity> entity) {
-        if (entity->enabled) {
+        if (entity->isEnabled()) {
             for (const std::shared_ptr<IComponent> component : entity->components) {
                 if (component->getComponentType() == render::ComponentType::UserBehaviour) {
                     IBehaviour* pBehaviour = (IBehaviour*)component.get();
-                    if (pBehaviour->enabled) {
+                    if (pBehaviour->isEnabled()) {
                         pBehaviour->start();
                     }
                 }
@@ -33,7 +33,7 @@ namespace render {
             // Entity didn't have any components we wanted attached to itself, check children
             for (const std::shared_ptr<Entity> childEntity : entity->children) {
                 // may return null, if not null its what we're after anyway
-                if (childEntity->enabled) {
+                if (childEntity->isEnabled()) {
                     start(childEntity);
                 }
             }
@@ -41,11 +41,11 @@ namespace render {
     }
 
     void SceneUpdater::sleep(const std::shared_ptr<Entity> entity) {
-        if (entity->enabled) {
+        if (entity->isEnabled()) {
             for (const std::shared_ptr<IComponent> component : entity->components) {
                 if (component->getComponentType() == render::ComponentType::UserBehaviour) {
                     IBehaviour* pBehaviour = (IBehaviour*)component.get();
-                    if (pBehaviour->enabled) {
+                    if (pBehaviour->isEnabled()) {
                         pBehaviour->sleep();
                     }
                 }
@@ -54,7 +54,7 @@ namespace render {
             // Entity didn't have any components we wanted attached to itself, check children
             for (const std::shared_ptr<Entity> childEntity : entity->children) {
                 // may return null, if not null its what we're after anyway
-                if (childEntity->enabled) {
+                if (childEntity->isEnabled()) {
                     sleep(childEntity);
                 }
             }
@@ -62,11 +62,11 @@ namespace render {
     }
 
     void SceneUpdater::render(const std::shared_ptr<Entity> entity) {
-        if (entity->enabled) {
+        if (entity->isEnabled()) {
             for (const std::shared_ptr<IComponent> component : entity->components) {
                 if (component->getComponentType() == render::ComponentType::UserBehaviour) {
                     IBehaviour* pBehaviour = (IBehaviour*)component.get();
-                    if (pBehaviour->enabled) {
+                    if (pBehaviour->isEnabled()) {
                         pBehaviour->render();
                     }
                 }
@@ -75,7 +75,7 @@ namespace render {
             // Entity didn't have any components we wanted attached to itself, check children
             for (const std::shared_ptr<Entity> childEntity : entity->children) {
                 // may return null, if not null its what we're after anyway
-                if (childEntity->enabled) {
+                if (childEntity->isEnabled()) {
                     render(childEntity);
                 }
             }
@@ -83,11 +83,11 @@ namespace render {
     }
     
     void SceneUpdater::imgui(const std::shared_ptr<Entity> entity) {
-        if (entity->enabled) {
+        if (entity->isEnabled()) {
             for (const std::shared_ptr<IComponent> component : entity->components) {
                 if (component->getComponentType() == render::ComponentType::UserBehaviour) {
                     IBehaviour* pBehaviour = (IBehaviour*)component.get();
-                    if (pBehaviour->enabled) {
+                    if (pBehaviour->isEnabled()) {
                         pBehaviour->imgui();
                     }
                 }
@@ -96,7 +96,7 @@ namespace render {
             // Entity didn't have any components we wanted attached to itself, check children
             for (const std::shared_ptr<Entity> childEntity : entity->children) {
                 // may return null, if not null its what we're after anyway
-                if (childEntity->enabled) {
+                if (childEntity->isEnabled()) {
                     imgui(childEntity);
                 }
             }
@@ -104,32 +104,32 @@ namespace render {
     }
 
     void SceneUpdater::update(const std::shared_ptr<Entity> entity, const float deltaTime) {
-        if (entity->enabled) {
+        if (entity->isEnabled()) {
             for (const std::shared_ptr<IComponent> component : entity->components) {
                 if (component->getComponentType() == render::ComponentType::UserBehaviour) {
                     IBehaviour* pBehaviour = (IBehaviour*)component.get();
-                    if (pBehaviour->enabled) {
-                        if (pBehaviour->m_lastFrameEnabled != pBehaviour->enabled || entity->_lastFrameEnabled != entity->enabled) {
+                    if (pBehaviour->isEnabled()) {
+                        if (pBehaviour->m_lastFrameEnabled != pBehaviour->isEnabled() || entity->_lastFrameEnabled != entity->isEnabled()) {
                             pBehaviour->start();
                         }
                         pBehaviour->update(deltaTime);
-                        pBehaviour->m_lastFrameEnabled = pBehaviour->enabled;
+                        pBehaviour->m_lastFrameEnabled = pBehaviour->isEnabled();
                     }
                 }
                 if (component->getComponentType() == render::ComponentType::ParticleSystem) {
                     ParticleSystem* pParticleSystem = (ParticleSystem*)component.get();
-                    if (pParticleSystem->enabled) {
+                    if (pParticleSystem->isEnabled()) {
                         pParticleSystem->update(deltaTime);
                     }
                 }
             }
 
-            entity->_lastFrameEnabled = entity->enabled;
+            entity->_lastFrameEnabled = entity->isEnabled();
 
             // Entity didn't have any components we wanted attached to itself, check children
             for (const std::shared_ptr<Entity> childEntity : entity->children) {
                 // may return null, if not null its what we're after anyway
-                if (childEntity->enabled) {
+                if (childEntity->isEnabled()) {
                     update(childEntity, deltaTime);
                 }
             }
@@ -137,11 +137,11 @@ namespace render {
     }
 
     void SceneUpdater::physicsTick(const std::shared_ptr<Entity> entity, const float deltaTime, Scene::PhysicsParameters physicsParams) {
-        if (entity->enabled) {
+        if (entity->isEnabled()) {
             for (const std::shared_ptr<IComponent> component : entity->components) {
                 if (component->getComponentType() == render::ComponentType::Physics) {
                     physics::PhysicsComponent* pPhysicsComponent = (physics::PhysicsComponent*)component.get();
-                    if (pPhysicsComponent->enabled) {
+                    if (pPhysicsComponent->isEnabled()) {
                         if (B2_ID_EQUALS(pPhysicsComponent->m_physicsId, b2_nullBodyId)) {
                             // if internal physics stuff isn't setup, create it
                             
@@ -226,7 +226,7 @@ namespace render {
             // Entity didn't have any components we wanted attached to itself, check children
             for (const std::shared_ptr<Entity> childEntity : entity->children) {
                 // may return null, if not null its what we're after anyway
-                if (childEntity->enabled) {
+                if (childEntity->isEnabled()) {
                     physicsTick(childEntity, deltaTime, physicsParams);
                 }
             }
@@ -234,11 +234,11 @@ namespace render {
     }
 
     void SceneUpdater::physicsTickPost(const std::shared_ptr<Entity> entity, const float deltaTime, Scene::PhysicsParameters physicsParams) {
-        if (entity->enabled) {
+        if (entity->isEnabled()) {
             for (const std::shared_ptr<IComponent> component : entity->components) {
                 if (component->getComponentType() == render::ComponentType::Physics) {
                     physics::PhysicsComponent* pPhysicsComponent = (physics::PhysicsComponent*)component.get();
-                    if (pPhysicsComponent->enabled) {
+                    if (pPhysicsComponent->isEnabled()) {
                         
                         b2Vec2 newPos = b2Body_GetPosition(pPhysicsComponent->m_physicsId);
                         float newRot = b2Rot_GetAngle(b2Body_GetRotation(pPhysicsComponent->m_physicsId));
@@ -253,7 +253,7 @@ namespace render {
             // Entity didn't have any components we wanted attached to itself, check children
             for (const std::shared_ptr<Entity> childEntity : entity->children) {
                 // may return null, if not null its what we're after anyway
-                if (childEntity->enabled) {
+                if (childEntity->isEnabled()) {
                     physicsTickPost(childEntity, deltaTime, physicsParams);
                 }
             }
@@ -130,6 +130,10 @@ namespace render {
 
             // Skybox props
             ImGui::BeginGroupPanel("Skybox", ImVec2(groupWidth, 0));
+            // Changing any of these re-bakes the skybox cube map
+            Skybox& skybox = pScene->lightingParams.skybox;
+            ImGui::DragFloat3("Origin", skybox.proceduralOrigin.f32, 0.1f);
+            ImGui::DragFloat("Time", &skybox.proceduralTime, 1.0f);
 
             ImGui::EndGroupPanel();
 
@@ -137,7 +141,10 @@ namespace render {
             // is entity
             Entity* pEntity = (Entity*) (*pSelectedEntity);
             
-            ImGui::Checkbox("Enabled", &pEntity->enabled);
+            bool entityEnabled = pEntity->isEnabled();
+            if (ImGui::Checkbox("Enabled", &entityEnabled)) {
+                pEntity->setEnabled(entityEnabled);
+            }
 
             // Name
             char textBuffer[256] = {};
@@ -151,6 +158,9 @@ namespace render {
             markDirty |= ImGui::DragFloat4("Rotation", pEntity->transform.m_rotation.f32, 0.01f);
             markDirty |= ImGui::DragFloat3("Scale", pEntity->transform.m_scale.f32, 0.01f);
             pEntity->transform.m_isDirty = pEntity->transform.m_isDirty || markDirty;
+            if (markDirty) {
+                pEntity->markRenderStateDirty();
+            }
             ImGui::EndGroupPanel();
 
             // Draw components
@@ -205,7 +215,10 @@ namespace render {
                     ImGui::BeginGroupPanel("<UNKNOWN-TYPE>", ImVec2(groupWidth, 0));
                     break;
                 }
-                ImGui::Checkbox("Enabled", const_cast<bool*>(&component->enabled));
+                bool componentEnabled = component->isEnabled();
+                if (ImGui::Checkbox("Enabled", &componentEnabled)) {
+                    component->setEnabled(componentEnabled);
+                }
 
                 switch (componentType) {
                 case ComponentType::MeshRenderer:
@@ -218,6 +231,9 @@ namespace render {
                         ImGui::Text(fmt::format("Vertex Index buffer: {}", pMeshRenderer->mesh.indexBuffer->getDesc().debugName).c_str());
                     }
                     ImGui::Text(fmt::format("{} Triangles", pMeshRenderer->mesh.triangleCount).c_str());
+                    for (uint32_t lod = 1; lod < pMeshRenderer->mesh.lodCount; lod++) {
+                        ImGui::Text(fmt::format("    LOD {}: {} Triangles", lod, pMeshRenderer->mesh.lods[lod].triangleCount).c_str());
+                    }
                     ImGui::BeginGroupPanel(fmt::format("Material - {}", pMeshRenderer->material.name).c_str(), ImVec2(groupWidth - 2 * ImGui::GetStyle().ItemSpacing.x, 0));
 
                     {
@@ -225,7 +241,7 @@ namespace render {
                         ImGui::BeginGroupPanel("Graphics State", ImVec2(groupWidth - 4 * ImGui::GetStyle().ItemSpacing.x, 0));
                         ImGui::BeginDisabled();
 
-                        gpu::GraphicsState shaderState = pMeshRenderer->material.shader->getDesc().graphicsState;
+                        gpu::GraphicsState shaderState = pMeshRenderer->material.graphicsState;
 
                         const char* compareFuncNames[] = { "Never", "Less", "Equal", "LessOrEqual", "Greater", "NotEqual", "GreaterOrEqual", "Always" };
                         const char* faceCullModeNames[] = { "Back", "Front", "Both", "Never" };
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <hlsl++.h>
 #include "engine/gpu/idevice.hpp"
 
 namespace render {
@@ -13,6 +14,14 @@ namespace render {
     struct Skybox
     {
         SkyboxType type = SkyboxType::Procedural;
-        gpu::ITexture* m_skyTexture = nullptr; // skybox HDRI texture
+        gpu::ITexture* m_skyTexture = nullptr; // skybox HDRI texture, either a cube map or an equirectangular 2D texture
+
+        // Procedural skies and equirectangular HDRIs are rendered into a cube map with faces this big, and only
+        // re-rendered when the sun or one of the parameters here changes. Drawing the sky is then a single cube map fetch
+        uint32_t cubemapSize = 1024;
+        // Point and time the procedural sky is evaluated at when baking. The baked sky doesn't follow the camera or animate
+        // on its own, move these to change it
+        hlslpp::float3 proceduralOrigin = { 0.0f, 0.0f, 0.0f };
+        float proceduralTime = 0.0f;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,158 @@
+#include "sprite_batcher.hpp"
+#include "engine/core.hpp"
+#include "engine/log.hpp"
+#include "engine/app.hpp"
+
+#include <algorithm>
+
+namespace render {
+
+    // Sprites are drawn in submission order on top of whatever is already there
+    static constexpr gpu::GraphicsState k_spriteState = {
+        .depthState = gpu::CompareFunc::Always,
+        .depthWrite = false,
+        .depthTest = false,
+        .faceCullingMode = gpu::FaceCullMode::Never,
+    };
+
+    void SpriteBatcher::init(gpu::IDevice* pDevice, managers::AssetManager* pAssetManager) {
+        ASSERT(pDevice != nullptr);
+        ASSERT(pAssetManager != nullptr);
+        m_pDevice = pDevice;
+        m_pAssetManager = pAssetManager;
+
+        m_trillinearAniso16ClampSampler = m_pDevice->makeTextureSampler({ /* default (linear, wrap, 16x-aniso) */ });
+
+        m_uiShader = m_pAssetManager->fetchShader({
+            .vertShader = "ui_shader_vert.glsl",
+            .fragShader = "ui_shader_frag.glsl",
+            .debugName = "UIShader"
+        });
+
+        m_spriteInstanceBufferCapacity = k_spriteInstanceCapacity;
+        m_spriteInstanceBuffer = m_pDevice->makeBuffer({ .type = gpu::BufferType::VertexBuffer, .usage = gpu::Usage::Dynamic, .debugName = "SpriteBatcher_instanceBuffer" });
+        m_pDevice->writeBuffer(m_spriteInstanceBuffer, m_spriteInstanceBufferCapacity * sizeof(SpriteInstance), nullptr);
+
+        // Every attribute steps per instance, the quad corners come from gl_VertexID
+        gpu::VertexAttributeDesc vDesc[] = {
+            {.name = "ORIGIN_AXISX", .format = gpu::GpuFormat::RGBA8_TYPELESS, .bufferIndex = 0, .offset = offsetof(SpriteInstance, originAxisX), .elementStride = sizeof(SpriteInstance), .instanceStepRate = 1},
+            {.name = "AXISY", .format = gpu::GpuFormat::RG8_TYPELESS, .bufferIndex = 1, .offset = offsetof(SpriteInstance, axisY), .elementStride = sizeof(SpriteInstance), .instanceStepRate = 1},
+            {.name = "TEXCOORD0", .format = gpu::GpuFormat::RGBA16_UNORM, .bufferIndex = 2, .offset = offsetof(SpriteInstance, uvRect), .elementStride = sizeof(SpriteInstance), .instanceStepRate = 1},
+            {.name = "COLOR", .format = gpu::GpuFormat::RGBA8_TYPELESS, .bufferIndex = 3, .offset = offsetof(SpriteInstance, tint), .elementStride = sizeof(SpriteInstance), .instanceStepRate = 1},
+        };
+
+        m_pDevice->bindBuffer(m_spriteInstanceBuffer);
+        m_spriteInstanceLayout = m_pDevice->createInputLayout(vDesc, sizeof(vDesc) / sizeof(vDesc[0]));
+    }
+
+    void SpriteBatcher::beginFrame() {
+        m_projection = makeUiProjection(engine::App::getInstance()->getWindow()->getWidth(), engine::App::getInstance()->getWindow()->getHeight());
+        m_drawCallCount = 0;
+    }
+
+    void SpriteBatcher::submitSprite(const UIElement* pElement, const hlslpp::float4x4& model) {
+        ASSERT(pElement != nullptr);
+
+        // The quad is 2x2 units centred on the origin, scaled to sizeX x sizeY pixels and moved by the element's offset.
+        // Collapse that, the model and the window projection into a centre and two axes in clip space
+        hlslpp::float4x4 modelProjection = hlslpp::mul(model, m_projection);
+        hlslpp::float4 origin = hlslpp::mul(hlslpp::float4(pElement->posX, -pElement->posY, 0, 1), modelProjection); // flip offset y because OpenGL
+        hlslpp::float4 axisX = hlslpp::mul(hlslpp::float4(pElement->sizeX * 0.5f, 0, 0, 0), modelProjection);
+        hlslpp::float4 axisY = hlslpp::mul(hlslpp::float4(0, pElement->sizeY * 0.5f, 0, 0), modelProjection);
+
+        auto packUv = [](float value) -> uint16_t {
+            return static_cast<uint16_t>(std::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+        };
+
+        SpriteInstance instance = {
+            .originAxisX = { origin.x, origin.y, axisX.x, axisX.y },
+            .axisY = { axisY.x, axisY.y },
+            .uvRect = { packUv(pElement->uvRect.x), packUv(pElement->uvRect.y), packUv(pElement->uvRect.z), packUv(pElement->uvRect.w) },
+            .tint = { pElement->textureTint.x, pElement->textureTint.y, pElement->textureTint.z, pElement->textureTint.w },
+        };
+
+        hlslpp::float2 centre = hlslpp::float2(origin.xy);
+        hlslpp::float2 extent = hlslpp::abs(hlslpp::float2(axisX.xy)) + hlslpp::abs(hlslpp::float2(axisY.xy));
+        hlslpp::float4 bounds = hlslpp::float4(centre - extent, centre + extent);
+
+        gpu::ITexture* texture = pElement->texture ? pElement->texture : m_pAssetManager->fetchWhiteTexture();
+
+        // Walk back through the recent batches. The sprite can join one with the same texture as long as it doesn't
+        // overlap a batch in between, which would have to be drawn underneath it
+        uint32_t lookback = std::min(m_batchCount, k_spriteBatchLookback);
+        for (uint32_t i = 0; i < lookback; i++) {
+            SpriteBatch& batch = m_batches[m_batchCount - 1 - i];
+            if (batch.texture == texture) {
+                batch.instances.push_back(instance);
+                batch.bounds = hlslpp::float4(
+                    hlslpp::min(hlslpp::float2(batch.bounds.xy), hlslpp::float2(bounds.xy)),
+                    hlslpp::max(hlslpp::float2(batch.bounds.zw), hlslpp::float2(bounds.zw)));
+                m_pendingInstanceCount++;
+                return;
+            }
+            bool overlaps = (float)batch.bounds.x < (float)bounds.z && (float)bounds.x < (float)batch.bounds.z &&
+                (float)batch.bounds.y < (float)bounds.w && (float)bounds.y < (float)batch.bounds.w;
+            if (overlaps) {
+                break;
+            }
+        }
+
+        if (m_batchCount == m_batches.size()) {
+            m_batches.emplace_back();
+        }
+        SpriteBatch& batch = m_batches[m_batchCount++];
+        batch.texture = texture;
+        batch.instances.clear();
+        batch.instances.push_back(instance);
+        batch.bounds = bounds;
+        m_pendingInstanceCount++;
+    }
+
+    void SpriteBatcher::flush(gpu::IBlendState* blendState) {
+        if (m_pendingInstanceCount == 0) {
+            return;
+        }
+
+        if (m_pendingInstanceCount > m_spriteInstanceBufferCapacity) {
+            while (m_spriteInstanceBufferCapacity < m_pendingInstanceCount) {
+                m_spriteInstanceBufferCapacity *= 2;
+            }
+            LOG_INFO("[UI]: Growing sprite instance buffer to {} sprites", m_spriteInstanceBufferCapacity);
+            m_pDevice->writeBuffer(m_spriteInstanceBuffer, m_spriteInstanceBufferCapacity * sizeof(SpriteInstance), nullptr);
+        }
+
+        // Pack every batch back to back, then draw each one from its own range of the buffer
+        SpriteInstance* instanceView = nullptr;
+        m_pDevice->bindBuffer(m_spriteInstanceBuffer);
+        m_pDevice->mapBuffer(m_spriteInstanceBuffer, 0, m_pendingInstanceCount * sizeof(SpriteInstance), gpu::MapAccessFlags::Write | gpu::MapAccessFlags::InvalidateRange, reinterpret_cast<void**>(&instanceView));
+        if (instanceView != nullptr) {
+            for (uint32_t i = 0; i < m_batchCount; i++) {
+                const SpriteBatch& batch = m_batches[i];
+                memcpy(instanceView, batch.instances.data(), batch.instances.size() * sizeof(SpriteInstance));
+                instanceView += batch.instances.size();
+            }
+            m_pDevice->unmapBuffer(m_spriteInstanceBuffer);
+
+            gpu::IPipeline* pipeline = m_pAssetManager->fetchPipeline({
+                .shader = m_uiShader,
+                .inputLayout = m_spriteInstanceLayout,
+                .graphicsState = k_spriteState,
+                .blendState = blendState,
+            });
+            uint32_t firstInstance = 0;
+            for (uint32_t i = 0; i < m_batchCount; i++) {
+                const SpriteBatch& batch = m_batches[i];
+                m_pDevice->bindTexture(batch.texture, m_trillinearAniso16ClampSampler, 0);
+                m_pDevice->draw({
+                    .vertexBufer = m_spriteInstanceBuffer,
+                    .pipeline = pipeline,
+                    }, 2, 0, batch.instances.size(), firstInstance);
+                firstInstance += static_cast<uint32_t>(batch.instances.size());
+                m_drawCallCount++;
+            }
+        }
+
+        m_batchCount = 0;
+        m_pendingInstanceCount = 0;
+    }
+}
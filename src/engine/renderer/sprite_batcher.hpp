@@ -0,0 +1,71 @@
+#pragma once
+
+#include <inttypes.h>
+#include <hlsl++.h>
+#include <vector>
+#include "engine/gpu/idevice.hpp"
+#include "engine/managers/asset_manager.hpp"
+#include "ui_components.hpp"
+
+namespace render {
+
+    // Sprite instances the instance buffer starts with. It doubles whenever a flush needs more
+    constexpr uint32_t k_spriteInstanceCapacity = 256;
+    // How many batches back a sprite may be moved to join one using the same texture
+    constexpr uint32_t k_spriteBatchLookback = 8;
+
+    // Collects UI sprites into instanced draws, one per texture.
+    // A sprite may only join an earlier batch if it doesn't overlap anything queued after that batch, so the result
+    // is identical to drawing every sprite in submission order
+    class SpriteBatcher {
+    public:
+        void init(gpu::IDevice* pDevice, managers::AssetManager* pAssetManager);
+
+        // Caches the window projection used by every sprite this frame
+        void beginFrame();
+        // Queues a sprite. model is the element's full model matrix
+        void submitSprite(const UIElement* pElement, const hlslpp::float4x4& model);
+        // Draws every sprite submitted since the last flush, blended with blendState
+        void flush(gpu::IBlendState* blendState);
+
+        inline uint32_t getDrawCallCount() const { return m_drawCallCount; }
+
+    private:
+        // One quad per sprite, expanded from gl_VertexID in ui_shader_vert.glsl. 48 bytes
+        struct SpriteInstance {
+            // Clip space centre (xy) and half width axis (zw)
+            float originAxisX[4];
+            // Clip space half height axis
+            float axisY[2];
+            // left, bottom, right, top in the texture, normalised to [0, 65535]
+            uint16_t uvRect[4];
+            float tint[4];
+        };
+        static_assert(sizeof(SpriteInstance) == 48);
+
+        struct SpriteBatch {
+            gpu::ITexture* texture = nullptr;
+            std::vector<SpriteInstance> instances;
+            // Clip space bounds of every sprite in the batch, min xy then max xy
+            hlslpp::float4 bounds;
+        };
+
+        gpu::IDevice* m_pDevice = nullptr;
+        managers::AssetManager* m_pAssetManager = nullptr;
+
+        gpu::IShader* m_uiShader = nullptr;
+        gpu::TextureSamplerHandle m_trillinearAniso16ClampSampler;
+        gpu::InputLayoutHandle m_spriteInstanceLayout;
+        gpu::BufferHandle m_spriteInstanceBuffer;
+        uint32_t m_spriteInstanceBufferCapacity = 0;
+
+        hlslpp::float4x4 m_projection = hlslpp::float4x4::identity();
+
+        // Batches are kept between flushes so their instance vectors keep their allocations, only the first m_batchCount are live
+        std::vector<SpriteBatch> m_batches;
+        uint32_t m_batchCount = 0;
+        uint32_t m_pendingInstanceCount = 0;
+
+        uint32_t m_drawCallCount = 0;
+    };
+}
@@ -1,11 +1,18 @@
 #include "text_renderer.hpp"
 #include "engine/log.hpp"
 #include "engine/app.hpp"
-#include "engine/renderer/camera.hpp"
 #include <algorithm>
+#include <cfloat>
 
 namespace render {
 
+    // Text is drawn on top of whatever is already there
+    static constexpr gpu::GraphicsState k_textState = {
+        .depthWrite = false,
+        .depthTest = false,
+        .faceCullingMode = gpu::FaceCullMode::Never,
+    };
+
     FontRenderer::FontRenderer() {
         m_executableDir = engine::App::getInstance()->getAssetManager()->getExecutableDir();
     }
@@ -17,128 +24,71 @@ namespace render {
         m_trillinearAniso16ClampSampler = m_pDevice->makeTextureSampler({ /* default (linear, wrap, 16x-aniso) */ });
 
         m_textShader = engine::App::getInstance()->getAssetManager()->fetchShader({
-            .graphicsState = {
-                .depthWrite = false,
-                .depthTest = false,
-                .faceCullingMode = gpu::FaceCullMode::Never,
-            },
             .vertShader = "text_shader_vert.glsl",
             .fragShader = "text_shader_frag.glsl",
             .debugName = "TextShader",
             });
-        m_pDevice->setBufferBinding(m_textShader, "TextBuffer", 0);
 
-        // prepare text buffer for rendering
-        m_vertices.resize(3*5000);
-        m_textVertexBuffer = m_pDevice->makeBuffer({ .type = gpu::BufferType::VertexBuffer, .usage = gpu::Usage::Dynamic, .debugName = "FontRenderer_vertexBuffer" });
-        m_pDevice->writeBuffer(m_textVertexBuffer, m_vertices.size() * sizeof(TextVertex), m_vertices.data());
-        m_vertices.clear();
+        // Glyphs are streamed in every frame, a flush only writes the glyphs submitted since the previous one
+        m_glyphInstanceBufferCapacity = k_textGlyphCapacity;
+        m_glyphInstanceBuffer = m_pDevice->makeBuffer({ .type = gpu::BufferType::VertexBuffer, .usage = gpu::Usage::Dynamic, .debugName = "FontRenderer_glyphInstanceBuffer" });
+        m_pDevice->writeBuffer(m_glyphInstanceBuffer, m_glyphInstanceBufferCapacity * sizeof(GlyphInstance), nullptr);
 
+        // Every attribute steps per instance, the quad corners come from gl_VertexID
         gpu::VertexAttributeDesc vDesc[] = {
-            {.name = "POSITION", .format = gpu::GpuFormat::RG8_TYPELESS, .bufferIndex = 0, .offset = offsetof(TextVertex, pos), .elementStride = sizeof(TextVertex)},
-            {.name = "TEXCOORD0", .format = gpu::GpuFormat::RG8_TYPELESS, .bufferIndex = 1, .offset = offsetof(TextVertex, uv), .elementStride = sizeof(TextVertex)}
+            {.name = "ORIGIN_AXISX", .format = gpu::GpuFormat::RGBA8_TYPELESS, .bufferIndex = 0, .offset = offsetof(GlyphInstance, originAxisX), .elementStride = sizeof(GlyphInstance), .instanceStepRate = 1},
+            {.name = "AXISY_OUTLINE", .format = gpu::GpuFormat::RGB8_TYPELESS, .bufferIndex = 1, .offset = offsetof(GlyphInstance, axisYOutline), .elementStride = sizeof(GlyphInstance), .instanceStepRate = 1},
+            {.name = "TEXCOORD0", .format = gpu::GpuFormat::RGBA16_UNORM, .bufferIndex = 2, .offset = offsetof(GlyphInstance, uvRect), .elementStride = sizeof(GlyphInstance), .instanceStepRate = 1},
+            {.name = "COLOR0", .format = gpu::GpuFormat::RGBA16_UNORM, .bufferIndex = 3, .offset = offsetof(GlyphInstance, colourForeground), .elementStride = sizeof(GlyphInstance), .instanceStepRate = 1},
+            {.name = "COLOR1", .format = gpu::GpuFormat::RGBA16_UNORM, .bufferIndex = 4, .offset = offsetof(GlyphInstance, colourOutline), .elementStride = sizeof(GlyphInstance), .instanceStepRate = 1},
         };
 
-        m_textVertexLayout = m_pDevice->createInputLayout(vDesc, sizeof(vDesc) / sizeof(vDesc[0]));
-
-        m_textCBuffer = m_pDevice->makeBuffer({ .type = gpu::BufferType::ConstantBuffer, .usage = gpu::Usage::Dynamic, .debugName = "TextCBuffer" });
-        m_pDevice->writeBuffer(m_textCBuffer, sizeof(TextCBuffer), nullptr);
-    }
-
-
-    // to handle malformed csv
-    bool tryParseInt(const char* str, int line_number, uint32_t* result) {
-        char* endptr;
-        errno = 0;
-        *result = strtol(str, &endptr, 10); // base 10 string input
-        if (errno != 0 || *endptr != '\0') {
-            LOG_WARN("[Font]: Expected <int> on line {}, but got {}! Ignoring...", line_number, str);
-            return false;
-        }
-        return true;
+        m_pDevice->bindBuffer(m_glyphInstanceBuffer);
+        m_glyphInstanceLayout = m_pDevice->createInputLayout(vDesc, sizeof(vDesc) / sizeof(vDesc[0]));
     }
 
-    bool tryParseFloat(const char* str, int line_number, float* result) {
-        char* endptr;
-        errno = 0;
-        *result = (float) strtod(str, &endptr);
-        if (errno != 0 || *endptr != '\0') {
-            LOG_WARN("[Font]: Expected <double> on line {}, but got {}! Ignoring...", line_number, str);
-            return false;
-        }
-        return true;
-    }
 
     FontData FontRenderer::loadFont(const std::string& filePath, gpu::ITexture* texture) {
         ASSERT(texture != nullptr);
 
-        FontData fontData = {};
-        fontData.isValid = false;
-
-        FILE* file = fopen(fmt::format("{}/assets/{}", m_executableDir, filePath).c_str(), "r");
-        if (file == nullptr) {
+        // Cooked by tools/font_cooker. The file is mapped and its tables used in place, nothing gets parsed
+        std::shared_ptr<managers::MappedFile> file = std::make_shared<managers::MappedFile>();
+        if (!file->open(fmt::format("{}/assets/{}", m_executableDir, filePath))) {
             LOG_ERROR("[Font]: File {} could not be opened.", filePath);
             return {};
         }
 
-        // data format is GlyphInfo in order
-
-        char line[2048] = {};
-        int line_number = 0;
-
-        fontData.firstCodePoint = 0xFFFFFFFF;
-
-        while (fgets(line, sizeof(line), file) != nullptr) {
-            line_number++;
-
-            GlyphInfo glyphInfo = { 0 };
-            char* token = strtok(line, ",\n");
-            int index = 0;
-
-            while (token != nullptr) {
-                switch (index) {
-                case 0: if (!tryParseInt(token, line_number, &glyphInfo.unicodeCodePoint)) { token = nullptr; break; } break;
-                    case 1: if (!tryParseFloat(token, line_number, &glyphInfo.horizAdvanceEm)) { token = nullptr; break; } break;
-                    case 2: if (!tryParseFloat(token, line_number, &glyphInfo.quadBounds.x)) { token = nullptr; break; } break; // left
-                    case 3: if (!tryParseFloat(token, line_number, &glyphInfo.quadBounds.y)) { token = nullptr; break; } break; // bottom
-                    case 4: if (!tryParseFloat(token, line_number, &glyphInfo.quadBounds.z)) { token = nullptr; break; } break; // right
-                    case 5: if (!tryParseFloat(token, line_number, &glyphInfo.quadBounds.w)) { token = nullptr; break; } break; // top
-                    case 6: if (!tryParseFloat(token, line_number, &glyphInfo.pixelBounds.x)) { token = nullptr; break; } break; // left
-                    case 7: if (!tryParseFloat(token, line_number, &glyphInfo.pixelBounds.y)) { token = nullptr; break; } break; // bottom
-                    case 8: if (!tryParseFloat(token, line_number, &glyphInfo.pixelBounds.z)) { token = nullptr; break; } break; // right
-                    case 9: if (!tryParseFloat(token, line_number, &glyphInfo.pixelBounds.w)) { token = nullptr; break; } break; // top
-                }
-
-                token = strtok(nullptr, ",\n");
-                index++;
-            }
-
-            // only accept the parsed data if there were at least 10 entries in this line
-            if (index == 10) {
-                fontData.glyphs.emplace(glyphInfo.unicodeCodePoint, glyphInfo);
-                fontData.firstCodePoint = std::min(fontData.firstCodePoint, glyphInfo.unicodeCodePoint);
-            } else {
-                LOG_WARN("[Font]: Invalid line {}: {}", line_number, line);
-            }
+        const uint8_t* data = file->getData();
+        size_t size = file->getSize();
+        const FontFileHeader* header = reinterpret_cast<const FontFileHeader*>(data);
+        if (size < sizeof(FontFileHeader) || header->magic != k_fontFileMagic || header->version != k_fontFileVersion) {
+            LOG_ERROR("[Font]: File {} is not a cooked font (version {}). Re-run the font cooker.", filePath, k_fontFileVersion);
+            return {};
+        }
+        if (header->glyphTableOffset + size_t(header->glyphCount) * sizeof(GlyphInfo) > size ||
+            header->kerningTableOffset + size_t(header->kerningPairCount) * sizeof(KerningPair) > size) {
+            LOG_ERROR("[Font]: File {} is truncated.", filePath);
+            return {};
         }
 
+        FontData fontData = {};
+        fontData.glyphs = std::span<const GlyphInfo>(reinterpret_cast<const GlyphInfo*>(data + header->glyphTableOffset), header->glyphCount);
+        fontData.kerningPairs = std::span<const KerningPair>(reinterpret_cast<const KerningPair*>(data + header->kerningTableOffset), header->kerningPairCount);
+        fontData.firstCodePoint = header->firstCodePoint;
+        fontData.fontSize = header->emSize;
+        fontData.lineHeight = header->lineHeight;
         fontData.texture = texture;
+        fontData.file = std::move(file);
         fontData.isValid = true;
 
-        fclose(file);
-
         return fontData;
     }
 
-    void FontRenderer::drawText(const FontData& fontData, const TextDrawParams params, render::Entity* pEntity, render::Camera* pCameraComponent) {
-
-        ASSERT(pEntity != nullptr);
-        ASSERT(pCameraComponent != nullptr);
-
-        // construct vertex buffer of text to issue draw call with
+    void FontRenderer::layoutText(const FontData& fontData, const TextDrawParams& params, std::vector<GlyphQuad>& outGlyphs) const {
+        // construct glyph instances of text to issue draw call with
         auto textureDesc = fontData.texture->getDesc();
-        float texWidth = (float)textureDesc.width;
-        float texHeight = (float)textureDesc.height;
+        float invTexWidth = 1.0f / (float)textureDesc.width;
+        float invTexHeight = 1.0f / (float)textureDesc.height;
 
         float scale = fontData.fontSize * params.size;
 
@@ -146,81 +96,204 @@ namespace render {
         float advanceX = params.posX * scale;
         float advanceY = params.posY * scale;
 
-        for (int i = 0; i < params.text.length(); i++) {
-            const char c = params.text.at(i);
+        auto packUv = [](float value) -> uint16_t {
+            return static_cast<uint16_t>(std::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+        };
 
+        outGlyphs.clear();
+        outGlyphs.reserve(params.text.length());
+        uint32_t prevCodePoint = 0;
+        for (const char c : params.text) {
             // newline = move to initial pos + add line height
             if (c == '\n') {
                 advanceX = params.posX * scale;
-                advanceY += params.lineHeight * scale;
+                advanceY += params.lineHeight * fontData.lineHeight * scale;
+                prevCodePoint = 0;
                 continue;
             }
             if (c == 0) {
                 continue;
             }
 
-            const auto& currGlyph = fontData.glyphs.at(c);
-            hlslpp::float4 pixelBounds = currGlyph.pixelBounds;
-            hlslpp::float4 quadBounds = currGlyph.quadBounds * scale;
+            uint32_t codePoint = static_cast<unsigned char>(c);
+            const GlyphInfo* currGlyph = fontData.findGlyph(codePoint);
+            if (currGlyph == nullptr) {
+                continue;
+            }
+            if (prevCodePoint != 0 && !fontData.kerningPairs.empty()) {
+                advanceX += fontData.findKerning(prevCodePoint, codePoint) * scale;
+            }
+            prevCodePoint = codePoint;
+
+            hlslpp::float4 pixelBounds = hlslpp::float4(currGlyph->pixelBounds[0], currGlyph->pixelBounds[1], currGlyph->pixelBounds[2], currGlyph->pixelBounds[3]);
+            hlslpp::float4 quadBounds = hlslpp::float4(currGlyph->quadBounds[0], currGlyph->quadBounds[1], currGlyph->quadBounds[2], currGlyph->quadBounds[3]) * scale;
 
             quadBounds.x += advanceX;
             quadBounds.z += advanceX;
             quadBounds.y -= advanceY;
             quadBounds.w -= advanceY;
 
-            // build quad into VBO
-            m_vertices.insert(m_vertices.end(), {
-                {quadBounds.x, quadBounds.y, pixelBounds.x / texWidth, pixelBounds.y / texHeight},
-                {quadBounds.x, quadBounds.w, pixelBounds.x / texWidth, pixelBounds.w / texHeight},
-                {quadBounds.z, quadBounds.y, pixelBounds.z / texWidth, pixelBounds.y / texHeight},
+            // whitespace has no quad, only an advance
+            if ((float)quadBounds.x != (float)quadBounds.z && (float)quadBounds.y != (float)quadBounds.w) {
+                outGlyphs.push_back({
+                    .rect = { quadBounds.x, quadBounds.y, quadBounds.z, quadBounds.w },
+                    .uvRect = {
+                        packUv(pixelBounds.x * invTexWidth),
+                        packUv(pixelBounds.y * invTexHeight),
+                        packUv(pixelBounds.z * invTexWidth),
+                        packUv(pixelBounds.w * invTexHeight),
+                    },
+                    });
+            }
 
-                {quadBounds.z, quadBounds.y, pixelBounds.z / texWidth, pixelBounds.y / texHeight},
-                {quadBounds.x, quadBounds.w, pixelBounds.x / texWidth, pixelBounds.w / texHeight},
-                {quadBounds.z, quadBounds.w, pixelBounds.z / texWidth, pixelBounds.w / texHeight},
-            });
+            advanceX += currGlyph->horizAdvanceEm * scale;
+        }
+    }
+
+    void FontRenderer::beginFrame() {
+        m_projection = makeUiProjection(engine::App::getInstance()->getWindow()->getWidth(), engine::App::getInstance()->getWindow()->getHeight());
+        m_glyphInstanceCursor = 0;
+    }
+
+    void FontRenderer::submitText(const FontData& fontData, const TextDrawParams& params, const render::UIElement* pElement) {
+
+        ASSERT(pElement != nullptr);
+        if (!fontData.isValid) {
+            return;
+        }
 
-            advanceX += currGlyph.horizAdvanceEm * scale;
+        // Everything that changes the glyph quads. Colours, outline and transform are applied per instance, so they don't invalidate the layout
+        size_t layoutHash = std::hash<std::string_view>{}(params.text);
+        auto hashCombine = [&layoutHash](float value) {
+            layoutHash ^= std::hash<float>{}(value) + 0x9e3779b9 + (layoutHash << 6) + (layoutHash >> 2);
+        };
+        hashCombine(params.posX);
+        hashCombine(params.posY);
+        hashCombine(params.size);
+        hashCombine(params.lineHeight);
+        hashCombine(fontData.fontSize);
+
+        auto [iter, inserted] = m_textMeshes.try_emplace(pElement);
+        CachedTextMesh& mesh = iter->second;
+        mesh.lastDrawnFrame = m_frameIndex;
+        if (inserted || mesh.layoutHash != layoutHash) {
+            layoutText(fontData, params, mesh.glyphs);
+            mesh.layoutHash = layoutHash;
         }
 
-        // sometimes text may not print, so the vertex buffer would be empty, if so, don't bother rendering anything
-        if (m_vertices.size() == 0) {
+        // sometimes text may not print, so there would be no glyphs, if so, don't bother rendering anything
+        if (mesh.glyphs.empty()) {
             return;
         }
 
-        // upload to gpu
-        m_pDevice->writeBuffer(m_textVertexBuffer, m_vertices.size() * sizeof(TextVertex), m_vertices.data());
-
-        // bind texture to gpu
-        m_pDevice->bindTexture(fontData.texture, m_trillinearAniso16ClampSampler, 0);
-
-        // Set text cbuffer on bind slot 0
-        m_pDevice->setConstantBuffer(m_textCBuffer, 0);
-        TextCBuffer* textBufferView = nullptr;
-        m_pDevice->mapBuffer(m_textCBuffer, 0, sizeof(TextCBuffer), gpu::MapAccessFlags::Write | gpu::MapAccessFlags::InvalidateBuffer, reinterpret_cast<void**>(&textBufferView));
-        if (textBufferView != nullptr) {
-            textBufferView->model = pEntity->transform.getModel();
-            textBufferView->view = pCameraComponent->getViewMatrix();
-            textBufferView->projection = hlslpp::float4x4::orthographic(hlslpp::projection(hlslpp::frustum(
-                /* width */ engine::App::getInstance()->getWindow()->getWidth(),
-                /* height */ engine::App::getInstance()->getWindow()->getHeight(),
-                /* near_z */ 0.1f,
-                /* far_z */ 100.0f),
-                hlslpp::zclip::minus_one, hlslpp::zdirection::reverse, hlslpp::zplane::infinite));
-            textBufferView->colourForeground = params.colourForeground;
-            textBufferView->colourOutline = params.colourOutline;
-            textBufferView->outlineWidth = params.outlineWidth;
-
-            m_pDevice->unmapBuffer(m_textCBuffer);
+        // Collapse the element's model and the window projection into a 2D affine transform. UI elements never leave the XY plane
+        hlslpp::float4x4 modelProjection = hlslpp::mul(pElement->getEntity()->transform.getModel(), m_projection);
+        hlslpp::float4 origin = hlslpp::mul(hlslpp::float4(0, 0, 0, 1), modelProjection);
+        hlslpp::float4 axisX = hlslpp::mul(hlslpp::float4(1, 0, 0, 0), modelProjection);
+        hlslpp::float4 axisY = hlslpp::mul(hlslpp::float4(0, 1, 0, 0), modelProjection);
+        float originXY[2] = { origin.x, origin.y };
+        float axisXY[2] = { axisX.x, axisX.y };
+        float axisYXY[2] = { axisY.x, axisY.y };
+
+        auto packColour = [](const hlslpp::float4& colour, uint16_t outColour[4]) {
+            float values[4];
+            hlslpp::store(colour, values);
+            for (uint32_t i = 0; i < 4; i++) {
+                outColour[i] = static_cast<uint16_t>(std::clamp(values[i], 0.0f, 1.0f) * 65535.0f + 0.5f);
+            }
+        };
+        GlyphInstance instance = {};
+        packColour(params.colourForeground, instance.colourForeground);
+        packColour(params.colourOutline, instance.colourOutline);
+        instance.axisYOutline[2] = params.outlineWidth;
+
+        // Same centre and half axes encoding as the sprite batcher, so the glyphs need no per-element data on the GPU
+        for (const GlyphQuad& glyph : mesh.glyphs) {
+            float centreX = (glyph.rect[0] + glyph.rect[2]) * 0.5f;
+            float centreY = (glyph.rect[1] + glyph.rect[3]) * 0.5f;
+            float halfWidth = (glyph.rect[2] - glyph.rect[0]) * 0.5f;
+            float halfHeight = (glyph.rect[3] - glyph.rect[1]) * 0.5f;
+            instance.originAxisX[0] = originXY[0] + axisXY[0] * centreX + axisYXY[0] * centreY;
+            instance.originAxisX[1] = originXY[1] + axisXY[1] * centreX + axisYXY[1] * centreY;
+            instance.originAxisX[2] = axisXY[0] * halfWidth;
+            instance.originAxisX[3] = axisXY[1] * halfWidth;
+            instance.axisYOutline[0] = axisYXY[0] * halfHeight;
+            instance.axisYOutline[1] = axisYXY[1] * halfHeight;
+            memcpy(instance.uvRect, glyph.uvRect, sizeof(instance.uvRect));
+            m_pendingGlyphs.push_back(instance);
         }
+    }
 
-        uint32_t triCount = m_vertices.size() / 3;
+    void FontRenderer::flush(const FontData& fontData, gpu::IBlendState* blendState) {
+        if (m_pendingGlyphs.empty()) {
+            return;
+        }
 
-        m_pDevice->draw({
-            .vertexBufer = m_textVertexBuffer,
-            .shader = m_textShader,
-            .vertexLayout = m_textVertexLayout
-            }, triCount);
+        uint32_t glyphCount = static_cast<uint32_t>(m_pendingGlyphs.size());
+        if (m_glyphInstanceCursor + glyphCount > m_glyphInstanceBufferCapacity) {
+            // Reallocating gives the buffer new storage, so earlier draws this frame keep their glyphs and writing restarts at 0
+            while (m_glyphInstanceBufferCapacity < glyphCount) {
+                m_glyphInstanceBufferCapacity *= 2;
+            }
+            LOG_INFO("[Font]: Reallocating glyph instance buffer with {} glyphs", m_glyphInstanceBufferCapacity);
+            m_pDevice->writeBuffer(m_glyphInstanceBuffer, m_glyphInstanceBufferCapacity * sizeof(GlyphInstance), nullptr);
+            m_glyphInstanceCursor = 0;
+        }
+
+        GlyphInstance* glyphView = nullptr;
+        m_pDevice->bindBuffer(m_glyphInstanceBuffer);
+        m_pDevice->mapBuffer(m_glyphInstanceBuffer, m_glyphInstanceCursor * sizeof(GlyphInstance), glyphCount * sizeof(GlyphInstance), gpu::MapAccessFlags::Write | gpu::MapAccessFlags::InvalidateRange, reinterpret_cast<void**>(&glyphView));
+        if (glyphView != nullptr) {
+            memcpy(glyphView, m_pendingGlyphs.data(), glyphCount * sizeof(GlyphInstance));
+            m_pDevice->unmapBuffer(m_glyphInstanceBuffer);
+
+            // bind texture to gpu
+            m_pDevice->bindTexture(fontData.texture, m_trillinearAniso16ClampSampler, 0);
+
+            // Only the glyphs submitted since the last flush, 2 triangles per instance
+            m_pDevice->draw({
+                .vertexBufer = m_glyphInstanceBuffer,
+                .pipeline = engine::App::getInstance()->getAssetManager()->fetchPipeline({
+                    .shader = m_textShader,
+                    .inputLayout = m_glyphInstanceLayout,
+                    .graphicsState = k_textState,
+                    .blendState = blendState,
+                }),
+                }, 2, 0, glyphCount, m_glyphInstanceCursor);
+            m_glyphInstanceCursor += glyphCount;
+        }
 
-        m_vertices.clear();
+        m_pendingGlyphs.clear();
+    }
+
+    hlslpp::float4 FontRenderer::measureText(const FontData& fontData, const TextDrawParams& params) {
+        if (!fontData.isValid) {
+            return hlslpp::float4(0, 0, 0, 0);
+        }
+        layoutText(fontData, params, m_measureGlyphs);
+        if (m_measureGlyphs.empty()) {
+            return hlslpp::float4(0, 0, 0, 0);
+        }
+
+        float bounds[4] = { FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
+        for (const GlyphQuad& glyph : m_measureGlyphs) {
+            bounds[0] = std::min(bounds[0], std::min(glyph.rect[0], glyph.rect[2]));
+            bounds[1] = std::min(bounds[1], std::min(glyph.rect[1], glyph.rect[3]));
+            bounds[2] = std::max(bounds[2], std::max(glyph.rect[0], glyph.rect[2]));
+            bounds[3] = std::max(bounds[3], std::max(glyph.rect[1], glyph.rect[3]));
+        }
+        return hlslpp::float4(bounds[0], bounds[1], bounds[2], bounds[3]);
+    }
+
+    void FontRenderer::endFrame() {
+        // Elements that were disabled or destroyed stop drawing, drop their layouts once they've been gone a while
+        for (auto iter = m_textMeshes.begin(); iter != m_textMeshes.end();) {
+            if (m_frameIndex - iter->second.lastDrawnFrame > k_textMeshEvictionFrames) {
+                iter = m_textMeshes.erase(iter);
+            } else {
+                iter++;
+            }
+        }
+        m_frameIndex++;
     }
-}
\ No newline at end of file
+}
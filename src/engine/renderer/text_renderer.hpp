@@ -3,13 +3,26 @@
 #include "engine/core.hpp"
 #include "engine/gpu/idevice.hpp"
 #include "scene_graph.hpp"
-
+#include "ui_components.hpp"
+#include "font_format.hpp"
+#include "uniform_blocks.hpp"
+#include "engine/managers/mapped_file.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <span>
 #include <unordered_map>
+#include <string_view>
 
 namespace render {
 
     class FontRenderer;
 
+    // Glyph instances the instance buffer starts with. It doubles whenever a frame's text needs more
+    constexpr uint32_t k_textGlyphCapacity = 4096;
+    // A cached text layout that hasn't been drawn for this many frames is dropped
+    constexpr uint32_t k_textMeshEvictionFrames = 120;
+
     struct GlyphRect {
         double left;
         double right;
@@ -17,21 +30,44 @@ namespace render {
         double bottom;
     };
 
-    struct GlyphInfo {
-        uint32_t unicodeCodePoint;
-        float horizAdvanceEm;
-        hlslpp::float4 quadBounds; // quadBound
-        hlslpp::float4 pixelBounds; // pixelBound
-    };
     struct FontData {
         friend class FontRenderer;
 
-        std::unordered_map<uint32_t, GlyphInfo> glyphs;
+        // Both point straight into the mapped font file, see font_format.hpp
+        // Indexed by code point - firstCodePoint
+        std::span<const GlyphInfo> glyphs;
+        // Sorted by first then second code point
+        std::span<const KerningPair> kerningPairs;
+
+        // Returns null if the font has no glyph for this code point
+        inline const GlyphInfo* findGlyph(uint32_t codePoint) const {
+            if (codePoint < firstCodePoint || codePoint - firstCodePoint >= glyphs.size()) {
+                return nullptr;
+            }
+            const GlyphInfo& glyph = glyphs[codePoint - firstCodePoint];
+            return glyph.unicodeCodePoint == codePoint ? &glyph : nullptr;
+        }
+
+        // Extra advance between two consecutive glyphs in ems, 0 if the pair isn't kerned
+        inline float findKerning(uint32_t firstCodePoint, uint32_t secondCodePoint) const {
+            auto iter = std::lower_bound(kerningPairs.begin(), kerningPairs.end(), KerningPair{ firstCodePoint, secondCodePoint, 0.0f }, [](const KerningPair& a, const KerningPair& b) {
+                return a.firstCodePoint != b.firstCodePoint ? a.firstCodePoint < b.firstCodePoint : a.secondCodePoint < b.secondCodePoint;
+            });
+            if (iter != kerningPairs.end() && iter->firstCodePoint == firstCodePoint && iter->secondCodePoint == secondCodePoint) {
+                return iter->advanceEm;
+            }
+            return 0.0f;
+        }
     private:
         bool isValid = false;
         uint32_t firstCodePoint = 0;
-        float fontSize = 37.84375f; // Hardcoded, ik its bad but imagine adding a json parser
+        // Pixels per em the atlas was generated with
+        float fontSize = 0.0f;
+        // Distance between baselines in ems
+        float lineHeight = 1.0f;
         gpu::ITexture* texture = nullptr;
+        // Keeps glyphs and kerningPairs alive, FontData is copied around by value
+        std::shared_ptr<managers::MappedFile> file;
     };
 
     class FontRenderer {
@@ -47,37 +83,70 @@ namespace render {
             hlslpp::float4 colourOutline;
             float size = 1.0f;
             float lineHeight = 1.0f;
-            std::string text;
+            std::string_view text;
         };
 
         FontData loadFont(const std::string& filePath, gpu::ITexture* texture);
-        void drawText(const FontData& fontData, const TextDrawParams params, render::Entity* pEntity, render::Camera* pCameraComponent);
+
+        // Caches the window projection used by every text element this frame
+        void beginFrame();
+        // Queues a text element into the current batch. Glyphs are laid out once per element and kept on the CPU,
+        // they're only rebuilt when the text or layout changes
+        void submitText(const FontData& fontData, const TextDrawParams& params, const render::UIElement* pElement);
+        // Draws every glyph submitted since the last flush in a single instanced draw, blended with blendState
+        void flush(const FontData& fontData, gpu::IBlendState* blendState);
+        // Bounds of the laid out text in the element's space (left, bottom, right, top). Zero if nothing would be drawn
+        hlslpp::float4 measureText(const FontData& fontData, const TextDrawParams& params);
+        // Drops the cached layouts of text elements that stopped being drawn. Call once per frame after drawing
+        void endFrame();
 
     private:
 
-        struct TextVertex {
-            float pos[2];
-            float uv[2];
+        // A laid out glyph in the text element's space
+        struct GlyphQuad {
+            // left, bottom, right, top
+            float rect[4];
+            // left, bottom, right, top in the font atlas, normalised to [0, 65535]
+            uint16_t uvRect[4];
+        };
+
+        // One quad per glyph, already in clip space and expanded from gl_VertexID in text_shader_vert.glsl. 56 bytes
+        struct GlyphInstance {
+            // Clip space centre (xy) and half width axis (zw)
+            float originAxisX[4];
+            // Clip space half height axis (xy) and outline width (z)
+            float axisYOutline[4];
+            uint16_t uvRect[4];
+            // Normalised to [0, 65535]
+            uint16_t colourForeground[4];
+            uint16_t colourOutline[4];
+        };
+        static_assert(sizeof(GlyphInstance) == 56);
+
+        struct CachedTextMesh {
+            size_t layoutHash = 0;
+            uint64_t lastDrawnFrame = 0;
+            std::vector<GlyphQuad> glyphs;
         };
 
-        std::vector<TextVertex> m_vertices;
+        void layoutText(const FontData& fontData, const TextDrawParams& params, std::vector<GlyphQuad>& outGlyphs) const;
+
+        std::unordered_map<const render::UIElement*, CachedTextMesh> m_textMeshes;
+        uint64_t m_frameIndex = 0;
+
+        hlslpp::float4x4 m_projection = hlslpp::float4x4::identity();
+        // Glyphs submitted since the last flush
+        std::vector<GlyphInstance> m_pendingGlyphs;
+        std::vector<GlyphQuad> m_measureGlyphs;
 
         gpu::IDevice* m_pDevice = nullptr;
         gpu::IShader* m_textShader = nullptr;
         gpu::TextureSamplerHandle m_trillinearAniso16ClampSampler;
-        gpu::InputLayoutHandle m_textVertexLayout;
-        gpu::BufferHandle m_textVertexBuffer;
-
-        struct TextCBuffer {
-            hlslpp::float4x4 model;
-            hlslpp::float4x4 view;
-            hlslpp::float4x4 projection;
-            hlslpp::float4 colourForeground;
-            hlslpp::float4 colourOutline;
-            float outlineWidth;
-        };
-
-        gpu::BufferHandle m_textCBuffer;
+        gpu::InputLayoutHandle m_glyphInstanceLayout;
+        gpu::BufferHandle m_glyphInstanceBuffer;
+        uint32_t m_glyphInstanceBufferCapacity = 0;
+        // Each flush writes after the previous one, so a draw still in flight never has its glyphs overwritten
+        uint32_t m_glyphInstanceCursor = 0;
 
         std::string m_executableDir;
     };
@@ -4,6 +4,15 @@
 #include "engine/app.hpp"
 
 namespace render {
+    hlslpp::float4x4 makeUiProjection(uint32_t windowWidth, uint32_t windowHeight) {
+        return hlslpp::float4x4::orthographic(hlslpp::projection(hlslpp::frustum(
+            /* width */ windowWidth,
+            /* height */ windowHeight,
+            /* near_z */ 0.1f,
+            /* far_z */ 100.0f),
+            hlslpp::zclip::minus_one, hlslpp::zdirection::reverse, hlslpp::zplane::infinite));
+    }
+
     bool UIElement::isMouseOver() {
 
         hlslpp::float2 mousePos = engine::input::InputManager::getInstance()->mousePos();
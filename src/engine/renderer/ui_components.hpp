@@ -4,12 +4,19 @@
 
 namespace render {
 
+    // Orthographic projection from UI space (pixels, centred on the window) to clip space
+    hlslpp::float4x4 makeUiProjection(uint32_t windowWidth, uint32_t windowHeight);
+
     class UICanvas : public IComponent {
     public:
         UICanvas(Entity* parent) : IComponent(parent) {
             componentType = ::render::ComponentType::UICanvas;
         }
         ~UICanvas() = default;
+
+        // Render the elements under this canvas into an offscreen texture, composited with one quad. The texture
+        // is only redrawn where an element changed, worth it for UI that stays still most of the time
+        bool cacheRendering = false;
     private:
         // derived classes are forbidden from modifying componentType
         using IComponent::componentType;
@@ -43,6 +50,8 @@ namespace render {
         hlslpp::float4 outlineColour = hlslpp::float4(1, 1, 1, 0);
 
         hlslpp::float4 textureTint = hlslpp::float4(1, 1, 1, 1);
+        // left, bottom, right, top of the part of the texture to draw, lets sprites share an atlas and batch together
+        hlslpp::float4 uvRect = hlslpp::float4(0, 0, 1, 1);
 
         // for ui interactons like mouse click etc
         bool isMouseOver();
@@ -0,0 +1,70 @@
+#include "uniform_blocks.hpp"
+
+#include <algorithm>
+#include <fmt/format.h>
+
+namespace render {
+
+    namespace std140 {
+
+        struct UniformBlockType {
+            const char* glslName;
+            bool isBlock;
+            const FieldInfo* fields;
+            uint32_t fieldCount;
+        };
+
+        // In declaration order, so structs come before the blocks using them
+        #define RENDER_STD140_TYPE(CppName, GlslName) { TypeInfo<CppName>::glslName, TypeInfo<CppName>::isBlock, TypeInfo<CppName>::fields, TypeInfo<CppName>::fieldCount },
+        #define RENDER_STD140_IGNORE(...)
+        static constexpr UniformBlockType k_uniformBlockTypes[] = {
+            RENDER_UNIFORM_BLOCKS(RENDER_STD140_TYPE, RENDER_STD140_TYPE, RENDER_STD140_IGNORE, RENDER_STD140_IGNORE, RENDER_STD140_IGNORE)
+        };
+        #undef RENDER_STD140_TYPE
+        #undef RENDER_STD140_IGNORE
+
+        // Names the members the way glGetActiveUniformName reports them. Arrays only list their first two elements, which is
+        // enough to check the fields and the stride
+        static void addMembers(gpu::UniformBlockDesc& desc, const std::string& prefix, const FieldInfo* fields, uint32_t fieldCount, uint32_t baseOffset) {
+            for (uint32_t i = 0; i < fieldCount; i++) {
+                const FieldInfo& field = fields[i];
+                const uint32_t elementCount = std::min(field.arrayCount, 2U);
+                for (uint32_t element = 0; element < std::max(elementCount, 1U); element++) {
+                    std::string name = field.arrayCount > 0 ? fmt::format("{}{}[{}]", prefix, field.name, element) : prefix + field.name;
+                    const uint32_t offset = baseOffset + field.offset + element * field.size;
+                    if (field.fields != nullptr) {
+                        addMembers(desc, name + ".", field.fields, field.fieldCount, offset);
+                    } else {
+                        desc.members.push_back({ std::move(name), offset });
+                    }
+                }
+            }
+        }
+
+        gpu::UniformBlockDesc makeUniformBlockDesc(const char* name, const FieldInfo* fields, uint32_t fieldCount, size_t size, uint32_t bindIndex) {
+            gpu::UniformBlockDesc desc = { .name = name, .bindIndex = bindIndex, .size = (uint32_t)size };
+            addMembers(desc, "", fields, fieldCount, 0);
+            return desc;
+        }
+    }
+
+    const std::string& getUniformBlocksGlsl() {
+        static const std::string glsl = [] {
+            std::string text = "// Generated from RENDER_UNIFORM_BLOCKS in uniform_blocks.hpp\n";
+            for (const std140::UniformBlockType& type : std140::k_uniformBlockTypes) {
+                text += type.isBlock ? fmt::format("layout(std140) uniform {}\n{{\n", type.glslName) : fmt::format("struct {}\n{{\n", type.glslName);
+                for (uint32_t i = 0; i < type.fieldCount; i++) {
+                    const std140::FieldInfo& field = type.fields[i];
+                    if (field.arrayCount > 0) {
+                        text += fmt::format("    {} {}[{}];\n", field.glslType, field.name, field.arrayCount);
+                    } else {
+                        text += fmt::format("    {} {};\n", field.glslType, field.name);
+                    }
+                }
+                text += "};\n\n";
+            }
+            return text;
+        }();
+        return glsl;
+    }
+}
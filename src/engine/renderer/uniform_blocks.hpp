@@ -0,0 +1,222 @@
+#pragma once
+
+#include <inttypes.h>
+#include <cstddef>
+#include <string>
+#include <hlsl++.h>
+#include "engine/gpu/idevice.hpp"
+
+namespace render {
+
+    constexpr uint32_t k_MAX_LIGHTS = 4;
+    constexpr uint32_t k_MAX_PARTICLES = 800;
+
+    // Every uniform block shared between the C++ and the shaders, described once. It expands into the C++ structs below,
+    // compile time checks that they follow std140, and the GLSL declarations common.glsl pulls in (see getUniformBlocksGlsl).
+    // Fields are ordered so every vec3 is followed by a scalar that fills its 4th component, std140 would pad it otherwise.
+    // FIELD only takes the std140:: storage types, structs can be nested through ARRAY
+    #define RENDER_UNIFORM_BLOCKS(STRUCT, BLOCK, FIELD, ARRAY, END) \
+        BLOCK(GeometryCBuffer, GeometryBuffer) \
+            FIELD(float4x4, model) \
+            FIELD(float4x4, view) \
+            FIELD(float4x4, projection) \
+            FIELD(float3, cameraPos) \
+            FIELD(float, elapsedTime) \
+        END(GeometryCBuffer) \
+        BLOCK(MaterialCBuffer, MaterialBuffer) \
+            FIELD(float3, ambient) \
+            FIELD(float, roughness) \
+            FIELD(float3, diffuse) \
+            FIELD(float, metallic) \
+            FIELD(float3, specular) \
+            FIELD(float, emissionIntensity) \
+            FIELD(float3, emissionColour) \
+            FIELD(float, glintFactor) \
+        END(MaterialCBuffer) \
+        STRUCT(LightRenderData, LightData) \
+            /* Ignored for dir lights */ \
+            FIELD(float3, position) \
+            FIELD(uint, type) \
+            FIELD(float3, direction) \
+            FIELD(float, intensity) \
+            /* RGB colour */ \
+            FIELD(float3, colour) \
+            /* For spot lights (radians) */ \
+            FIELD(float, innerRadius) \
+            FIELD(float, outerRadius) \
+        END(LightRenderData) \
+        BLOCK(LightsCbuffer, LightsBuffer) \
+            ARRAY(LightRenderData, light, k_MAX_LIGHTS) \
+        END(LightsCbuffer) \
+        STRUCT(RenderParticleElement, ParticleData) \
+            FIELD(float3, position) \
+            FIELD(float, sizeBegin) \
+            FIELD(float4, colourBegin) \
+            FIELD(float4, colourEnd) \
+            FIELD(float, sizeEnd) \
+            FIELD(float, life) \
+            /* Per system, but these 4 bytes would be padding anyway */ \
+            FIELD(float, particleTextureCount) \
+        END(RenderParticleElement) \
+        BLOCK(ParticlesCBuffer, ParticleBuffer) \
+            ARRAY(RenderParticleElement, particles, k_MAX_PARTICLES) \
+        END(ParticlesCBuffer) \
+        BLOCK(UpscaleCBuffer, UpscaleBuffer) \
+            /* xy maps backbuffer pixels onto uvs of the rendered part of the scene target, zw clamps uvs half a texel inside it */ \
+            FIELD(float4, fragCoordScale_uvMax) \
+        END(UpscaleCBuffer)
+
+    namespace std140 {
+
+        using uint = uint32_t;
+
+        // hlslpp's types are SIMD registers, so its float3 is 16 bytes and a float declared after one lands on the next vec4.
+        // These hold just the floats, the fields using them are aligned by hand the way std140 would
+        struct float2 {
+            float values[2] = {};
+            float2() = default;
+            float2(const hlslpp::float2& v) { hlslpp::store(v, values); }
+        };
+
+        struct float3 {
+            float values[3] = {};
+            float3() = default;
+            float3(const hlslpp::float3& v) { hlslpp::store(v, values); }
+        };
+
+        struct float4 {
+            float values[4] = {};
+            float4() = default;
+            float4(const hlslpp::float4& v) { hlslpp::store(v, values); }
+        };
+
+        // Stored the way hlslpp keeps it in memory, which the shaders already expect
+        struct float4x4 {
+            float values[16] = {};
+            float4x4() = default;
+            float4x4(const hlslpp::float4x4& m) { hlslpp::store(m, values); }
+        };
+
+        struct FieldInfo {
+            const char* name;
+            const char* glslType;
+            uint32_t alignment;
+            // Of a single element
+            uint32_t size;
+            // 0 when the field isn't an array
+            uint32_t arrayCount;
+            // Where the C++ struct put it
+            uint32_t offset;
+            // Fields of a struct element, null for the storage types
+            const FieldInfo* fields;
+            uint32_t fieldCount;
+        };
+
+        // GLSL name and std140 base alignment of a field type. RENDER_UNIFORM_BLOCKS adds the fields of its structs and blocks
+        template<typename T>
+        struct TypeInfo;
+
+        #define RENDER_STD140_TYPE(Type, GlslType, Alignment) \
+            template<> struct TypeInfo<Type> { \
+                static constexpr const char* glslName = GlslType; \
+                static constexpr uint32_t alignment = Alignment; \
+                static constexpr const FieldInfo* fields = nullptr; \
+                static constexpr uint32_t fieldCount = 0; \
+            };
+        RENDER_STD140_TYPE(float, "float", 4)
+        RENDER_STD140_TYPE(uint, "uint", 4)
+        RENDER_STD140_TYPE(int32_t, "int", 4)
+        RENDER_STD140_TYPE(float2, "vec2", 8)
+        RENDER_STD140_TYPE(float3, "vec3", 16)
+        RENDER_STD140_TYPE(float4, "vec4", 16)
+        RENDER_STD140_TYPE(float4x4, "mat4", 16)
+        #undef RENDER_STD140_TYPE
+
+        constexpr uint32_t alignUp(uint32_t value, uint32_t alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        // Walks the fields with std140's rules and checks the C++ struct put each one at the same offset. Array elements
+        // and structs round up to a vec4, the C++ array stride has to as well
+        constexpr bool matchesStd140(const FieldInfo* fields, uint32_t fieldCount, size_t size) {
+            uint32_t offset = 0;
+            for (uint32_t i = 0; i < fieldCount; i++) {
+                const FieldInfo& field = fields[i];
+                const bool roundToVec4 = field.arrayCount > 0 || field.fields != nullptr;
+                offset = alignUp(offset, roundToVec4 ? alignUp(field.alignment, 16) : field.alignment);
+                if (field.offset != offset || (roundToVec4 && field.size % 16 != 0)) {
+                    return false;
+                }
+                offset += field.size * (field.arrayCount > 0 ? field.arrayCount : 1);
+            }
+            return alignUp(offset, 16) == size;
+        }
+
+        constexpr size_t getPaddingBytes(const FieldInfo* fields, uint32_t fieldCount, size_t size) {
+            size_t used = 0;
+            for (uint32_t i = 0; i < fieldCount; i++) {
+                used += fields[i].size * (fields[i].arrayCount > 0 ? fields[i].arrayCount : 1);
+            }
+            return size - used;
+        }
+
+        #define RENDER_STD140_STRUCT(CppName, GlslName) struct alignas(16) CppName {
+        #define RENDER_STD140_FIELD(Type, Name) alignas(TypeInfo<Type>::alignment) Type Name;
+        #define RENDER_STD140_ARRAY(Type, Name, Count) alignas(16) Type Name[Count];
+        #define RENDER_STD140_END(CppName) };
+        RENDER_UNIFORM_BLOCKS(RENDER_STD140_STRUCT, RENDER_STD140_STRUCT, RENDER_STD140_FIELD, RENDER_STD140_ARRAY, RENDER_STD140_END)
+        #undef RENDER_STD140_STRUCT
+        #undef RENDER_STD140_FIELD
+        #undef RENDER_STD140_ARRAY
+        #undef RENDER_STD140_END
+
+        #define RENDER_STD140_TYPE_INFO(CppName, GlslName, IsBlock) \
+            template<> struct TypeInfo<CppName> { \
+                using Owner = CppName; \
+                static constexpr const char* glslName = #GlslName; \
+                static constexpr uint32_t alignment = 16; \
+                static constexpr bool isBlock = IsBlock; \
+                static constexpr FieldInfo fields[] = {
+        #define RENDER_STD140_STRUCT(CppName, GlslName) RENDER_STD140_TYPE_INFO(CppName, GlslName, false)
+        #define RENDER_STD140_BLOCK(CppName, GlslName) RENDER_STD140_TYPE_INFO(CppName, GlslName, true)
+        #define RENDER_STD140_FIELD(Type, Name) \
+                    { #Name, TypeInfo<Type>::glslName, TypeInfo<Type>::alignment, sizeof(Type), 0, offsetof(Owner, Name), TypeInfo<Type>::fields, TypeInfo<Type>::fieldCount },
+        #define RENDER_STD140_ARRAY(Type, Name, Count) \
+                    { #Name, TypeInfo<Type>::glslName, TypeInfo<Type>::alignment, sizeof(Type), Count, offsetof(Owner, Name), TypeInfo<Type>::fields, TypeInfo<Type>::fieldCount },
+        #define RENDER_STD140_END(CppName) \
+                }; \
+                static constexpr uint32_t fieldCount = sizeof(fields) / sizeof(fields[0]); \
+            }; \
+            static_assert(matchesStd140(TypeInfo<CppName>::fields, TypeInfo<CppName>::fieldCount, sizeof(CppName)), \
+                #CppName " doesn't follow the std140 layout"); \
+            static_assert(getPaddingBytes(TypeInfo<CppName>::fields, TypeInfo<CppName>::fieldCount, sizeof(CppName)) < 16, \
+                #CppName " wastes a whole vec4 on padding, move a scalar after one of its vec3s");
+        RENDER_UNIFORM_BLOCKS(RENDER_STD140_STRUCT, RENDER_STD140_BLOCK, RENDER_STD140_FIELD, RENDER_STD140_ARRAY, RENDER_STD140_END)
+        #undef RENDER_STD140_TYPE_INFO
+        #undef RENDER_STD140_STRUCT
+        #undef RENDER_STD140_BLOCK
+        #undef RENDER_STD140_FIELD
+        #undef RENDER_STD140_ARRAY
+        #undef RENDER_STD140_END
+
+        gpu::UniformBlockDesc makeUniformBlockDesc(const char* name, const FieldInfo* fields, uint32_t fieldCount, size_t size, uint32_t bindIndex);
+    }
+
+    #define RENDER_STD140_USING(CppName, GlslName) using std140::CppName;
+    #define RENDER_STD140_IGNORE(...)
+    RENDER_UNIFORM_BLOCKS(RENDER_STD140_USING, RENDER_STD140_USING, RENDER_STD140_IGNORE, RENDER_STD140_IGNORE, RENDER_STD140_IGNORE)
+    #undef RENDER_STD140_USING
+    #undef RENDER_STD140_IGNORE
+
+    // Struct and block declarations for every entry of RENDER_UNIFORM_BLOCKS, injected where a shader has #inject
+    const std::string& getUniformBlocksGlsl();
+
+    // Name, size and member offsets of a block for IDevice::registerUniformBlock, so debug builds can check them against
+    // what the driver linked
+    template<typename T>
+    gpu::UniformBlockDesc getUniformBlockDesc(uint32_t bindIndex) {
+        using Info = std140::TypeInfo<T>;
+        static_assert(Info::isBlock, "Only uniform blocks can be registered, not the structs inside them");
+        return std140::makeUniformBlockDesc(Info::glslName, Info::fields, Info::fieldCount, sizeof(T), bindIndex);
+    }
+}
@@ -40,6 +40,12 @@ namespace engine {
 #endif
 
     void Window::createNativeWindow() {
+        if (m_desc.headless) {
+            // Headless windows don't count towards s_windowCount, GLFW is never initialised for them
+            LOG_INFO("Running headless, no window will be created");
+            return;
+        }
+
         if (s_windowCount == 0) {
             // Init GLFW
             glfwInit();
@@ -51,7 +57,7 @@ namespace engine {
             glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
             // Request 4x MSAA
-            glfwWindowHint(GLFW_SAMPLES, 4);
+            glfwWindowHint(GLFW_SAMPLES, gpu::k_BACKBUFFER_SAMPLES);
 #if _DEBUG
             glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true);
 #endif
@@ -75,7 +81,7 @@ namespace engine {
                 LOG_FATAL("Failed to initialise GLAD");
                 return;
             }
-            // Enable vsync
+            // Enable vsync, the frame pacer picks the final swap interval once the app starts
             glfwSwapInterval(1);
         }
 
@@ -175,6 +181,9 @@ namespace engine {
     }
 
     void Window::close() const {
+        if (m_desc.headless) {
+            return;
+        }
         glfwSetWindowShouldClose(reinterpret_cast<GLFWwindow*>(m_windowHandle), true);
         s_windowCount--;
         if (s_windowCount == 0) {
@@ -189,18 +198,64 @@ namespace engine {
 
     void Window::setTitle(std::string& title) {
         m_desc.title = title;
+        if (m_desc.headless) {
+            return;
+        }
         glfwSetWindowTitle(reinterpret_cast<GLFWwindow*>(m_windowHandle), title.c_str());
     }
 
     int Window::shouldCloseWindow() const {
+        if (m_desc.headless) {
+            // Nothing can close a headless window, the app has to stop itself
+            return false;
+        }
         return glfwWindowShouldClose(reinterpret_cast<GLFWwindow*>(m_windowHandle));
     }
 
     void Window::windowPresent() const {
+        if (m_desc.headless) {
+            return;
+        }
         glfwSwapBuffers(reinterpret_cast<GLFWwindow*>(m_windowHandle));
+    }
+
+    void Window::pollEvents() const {
+        if (m_desc.headless) {
+            return;
+        }
         glfwPollEvents();
     }
 
+    void Window::setSwapInterval(int32_t interval) const {
+        if (m_desc.headless) {
+            return;
+        }
+        glfwSwapInterval(interval);
+    }
+
+    bool Window::supportsAdaptiveVsync() const {
+        if (m_desc.headless) {
+            return false;
+        }
+        return glfwExtensionSupported("WGL_EXT_swap_control_tear") || glfwExtensionSupported("GLX_EXT_swap_control_tear");
+    }
+
+    double Window::getRefreshRate() const {
+        if (m_desc.headless) {
+            return 0.0;
+        }
+        GLFWmonitor* monitor = glfwGetWindowMonitor(reinterpret_cast<GLFWwindow*>(m_windowHandle));
+        if (monitor == nullptr) {
+            // Windowed, assume the primary monitor
+            monitor = glfwGetPrimaryMonitor();
+        }
+        if (monitor == nullptr) {
+            return 0.0;
+        }
+        const GLFWvidmode* mode = glfwGetVideoMode(monitor);
+        return mode != nullptr ? mode->refreshRate : 0.0;
+    }
+
 #if _DEBUG
 
     void APIENTRY glDebugOutput(
@@ -9,6 +9,9 @@ struct WindowDesc {
 	uint32_t width = 1820;
 	uint32_t height = 720;
 	std::string title = "OpenGL Engine";
+	// No native window or GL context is created. Input never arrives and presenting does nothing, for running on machines
+	// without a display. Pair with gpu::GraphicsApi::Null
+	bool headless = false;
 };
 
 struct GLFWwindow;
@@ -31,12 +34,21 @@ namespace engine {
 		inline const WindowHandle getHandle() const { return m_windowHandle; }
 
 		inline const WindowDesc getDesc() const { return m_desc; }
+		inline const bool isHeadless() const { return m_desc.headless; }
+
+		// 1 waits for vblank, 0 presents immediately, -1 waits for vblank unless the frame is late (needs adaptive vsync support)
+		void setSwapInterval(int32_t interval) const;
+		// Whether the driver supports a swap interval of -1
+		bool supportsAdaptiveVsync() const;
+		// Refresh rate of the monitor the window is on, 0 when unknown
+		double getRefreshRate() const;
 
 		inline static const uint32_t getWindowCount() { return s_windowCount; }
 
 	private:
 		int shouldCloseWindow() const;
 		void windowPresent() const;
+		void pollEvents() const;
 
 	private:
 		WindowHandle m_windowHandle;
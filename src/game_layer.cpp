@@ -53,9 +53,6 @@ GameLayer::GameLayer(gpu::DeviceManager* deviceManager, managers::AssetManager*
     m_testMesh = getAssetManager()->fetchMesh("test.obj");
 
     m_shader = getAssetManager()->fetchShader({
-        .graphicsState = {
-            // opaque rendering
-        },
         .vertShader = "vert.glsl",
         .fragShader = "frag.glsl",
         .debugName = "Simple"
@@ -140,8 +137,11 @@ void GameLayer::render(double deltaTime) {
     getDevice()->drawIndexed({
         .vertexBufer = m_testMesh.vertexBuffer,
         .indexBuffer = m_testMesh.indexBuffer,
-        .shader = m_shader,
-        .vertexLayout = m_testMesh.vertexLayout,
+        .pipeline = getAssetManager()->fetchPipeline({
+            // opaque rendering
+            .shader = m_shader,
+            .inputLayout = m_testMesh.vertexLayout,
+        }),
         }, m_testMesh.triangleCount);
 }
 
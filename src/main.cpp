@@ -1,4 +1,6 @@
 #include <stdio.h>
+#include <string.h>
+#include <ctype.h>
 
 #include "engine/app.hpp"
 #include "game_layer.hpp"
@@ -7,12 +9,48 @@
 int main (int argc, char *argv[]) {
 	srand(time(0));
 
+	// --headless [frames] runs the game on the null device without a window, uncapped, and quits after the given number of
+	// frames (600 by default). Used to measure the CPU cost of the renderer on CI
+	// --software [frames] runs headless like --headless, but renders every frame on the CPU through the software device
+	// --screenshot <path> writes the last frame rendered by --software to a PPM image
+	// --capture <path> records every device call into a capture for the CaptureReplay tool
+	bool headless = false;
+	bool softwareRendering = false;
+	uint32_t frameLimit = 0;
+	std::string capturePath;
+	std::string screenshotPath;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--headless") == 0 || strcmp(argv[i], "--software") == 0) {
+			headless = true;
+			softwareRendering = strcmp(argv[i], "--software") == 0;
+			frameLimit = 600;
+			if (i + 1 < argc && isdigit(argv[i + 1][0])) {
+				frameLimit = static_cast<uint32_t>(atoi(argv[++i]));
+			}
+		} else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+			capturePath = argv[++i];
+		} else if (strcmp(argv[i], "--screenshot") == 0 && i + 1 < argc) {
+			screenshotPath = argv[++i];
+		}
+	}
+
 	engine::App app({
 		.window = {
 			.width = 1920,
 			.height = 1080,
 			.title = "Breakanoid"
-		}
+		},
+		.maxFramerate = headless ? 0.0 : 60.0,
+		.dynamicResolution = {
+			.targetFrameTime = 1.0 / 60.0,
+			.minScale = 0.5f,
+			.maxScale = 1.0f,
+		},
+		.headless = headless,
+		.softwareRendering = softwareRendering,
+		.screenshotPath = screenshotPath,
+		.frameLimit = frameLimit,
+		.capturePath = capturePath,
 		});
 
 	// Use this to test the engine itself
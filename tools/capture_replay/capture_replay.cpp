@@ -0,0 +1,156 @@
+// Capture replay
+// Re-issues a device capture recorded with the game's --capture option against a backend, and times every frame.
+//
+// Usage: CaptureReplay <capture> [--backend gl|null] [--width <pixels>] [--height <pixels>] [--slowest <count>]
+//
+// The gl backend renders into a hidden window with vsync off, so frame times include the GPU throttling the CPU.
+// The null backend only measures the cost of validating and issuing the calls
+
+#include "engine/gpu/capture/capture_replayer.hpp"
+#include "engine/gpu/gl/gldevice.hpp"
+#include "engine/gpu/null/nulldevice.hpp"
+#include "engine/log.hpp"
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static GLFWwindow* createHiddenContext(uint32_t width, uint32_t height) {
+    if (!glfwInit()) {
+        return nullptr;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+    // Match the game's backbuffer
+    glfwWindowHint(GLFW_SAMPLES, 4);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window = glfwCreateWindow(width, height, "Capture replay", nullptr, nullptr);
+    if (window == nullptr) {
+        glfwTerminate();
+        return nullptr;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return nullptr;
+    }
+    glfwSwapInterval(0);
+    return window;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <capture> [--backend gl|null] [--width <pixels>] [--height <pixels>] [--slowest <count>]\n", argv[0]);
+        return 1;
+    }
+
+    std::string capturePath = argv[1];
+    std::string backend = "gl";
+    uint32_t width = 1920;
+    uint32_t height = 1080;
+    uint32_t slowestCount = 10;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--backend") == 0) {
+            backend = argv[i + 1];
+        } else if (strcmp(argv[i], "--width") == 0) {
+            width = static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10));
+        } else if (strcmp(argv[i], "--height") == 0) {
+            height = static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10));
+        } else if (strcmp(argv[i], "--slowest") == 0) {
+            slowestCount = static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10));
+        } else {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (backend != "gl" && backend != "null") {
+        fprintf(stderr, "Unknown backend %s, expected gl or null\n", backend.c_str());
+        return 1;
+    }
+
+    engine::log::init();
+
+    gpu::capture::CaptureReplayer replayer;
+    if (!replayer.load(capturePath)) {
+        fprintf(stderr, "Could not load %s\n", capturePath.c_str());
+        return 1;
+    }
+
+    GLFWwindow* window = nullptr;
+    gpu::DeviceHandle device;
+    if (backend == "gl") {
+        window = createHiddenContext(width, height);
+        if (window == nullptr) {
+            fprintf(stderr, "Could not create an OpenGL 3.3 context\n");
+            return 1;
+        }
+        device = gpu::DeviceHandle::Create(new gpu::gl::GlDevice());
+    } else {
+        device = gpu::DeviceHandle::Create(new gpu::null::NullDevice());
+    }
+    device->setViewport({ .left = 0, .right = width, .top = 0, .bottom = height });
+
+    bool complete = replayer.replay(device, [window]() {
+        if (window != nullptr) {
+            glfwSwapBuffers(window);
+        }
+    });
+
+    std::vector<gpu::capture::ReplayFrameTiming> frames = replayer.getFrameTimings();
+    if (frames.empty()) {
+        fprintf(stderr, "%s has no complete frames\n", capturePath.c_str());
+        return 1;
+    }
+
+    // The first frame also creates every resource loaded at startup, report it separately
+    const gpu::capture::ReplayFrameTiming firstFrame = frames[0];
+    std::vector<double> milliseconds;
+    double total = 0.0;
+    for (size_t i = 1; i < frames.size(); i++) {
+        milliseconds.push_back(frames[i].milliseconds);
+        total += frames[i].milliseconds;
+    }
+
+    printf("Replayed %zu frames of %s on the %s backend%s\n", frames.size(), capturePath.c_str(), backend.c_str(), complete ? "" : " (capture is corrupt, stopped early)");
+    printf("First frame: %.3f ms, %u commands\n", firstFrame.milliseconds, firstFrame.commandCount);
+    if (!milliseconds.empty()) {
+        std::sort(milliseconds.begin(), milliseconds.end());
+        auto percentile = [&](double fraction) {
+            return milliseconds[std::min(milliseconds.size() - 1, static_cast<size_t>(fraction * (milliseconds.size() - 1) + 0.5))];
+        };
+        printf("Frame time: %.3f ms average, %.3f ms p50, %.3f ms p95, %.3f ms p99, %.3f ms max\n",
+            total / milliseconds.size(), percentile(0.5), percentile(0.95), percentile(0.99), milliseconds.back());
+
+        // Spikes, to replay again under a profiler
+        std::sort(frames.begin() + 1, frames.end(), [](const gpu::capture::ReplayFrameTiming& a, const gpu::capture::ReplayFrameTiming& b) {
+            return a.milliseconds > b.milliseconds;
+        });
+        printf("Slowest frames:\n");
+        for (size_t i = 1; i < frames.size() && i <= slowestCount; i++) {
+            printf("    frame %u: %.3f ms, %u commands, %u draws\n", frames[i].frame, frames[i].milliseconds, frames[i].commandCount, frames[i].drawCount);
+        }
+    }
+
+    if (window != nullptr) {
+        // Release the GL objects while the context is still alive
+        device = gpu::DeviceHandle();
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
+    return complete ? 0 : 1;
+}
@@ -0,0 +1,378 @@
+// Font cooker
+// Converts an msdf-atlas-gen glyph layout into the binary font format loaded by FontRenderer::loadFont.
+//
+// Usage: FontCooker <layout.csv|layout.json> <output.fontbin> [--em-size <pixels>] [--line-height <ems>]
+//
+// JSON layouts carry the font metrics and kerning pairs. CSV layouts only have glyphs, so --em-size is required for them
+
+#include "engine/renderer/font_format.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace render;
+
+struct CookedFont {
+    float emSize = 0.0f;
+    float lineHeight = 1.0f;
+    float ascender = 0.0f;
+    float descender = 0.0f;
+    std::vector<GlyphInfo> glyphs;
+    std::vector<KerningPair> kerningPairs;
+};
+
+static bool readFile(const std::string& filePath, std::string& outContents) {
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::stringstream stream;
+    stream << file.rdbuf();
+    outContents = stream.str();
+    return true;
+}
+
+//
+// CSV: code point, advance, plane left, bottom, right, top, atlas left, bottom, right, top
+//
+
+static bool parseCsv(const std::string& contents, CookedFont& outFont) {
+    std::istringstream stream(contents);
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(stream, line)) {
+        lineNumber++;
+        if (line.empty() || line == "\r") {
+            continue;
+        }
+
+        float values[10] = {};
+        int index = 0;
+        const char* cursor = line.c_str();
+        while (index < 10 && *cursor != 0) {
+            char* end = nullptr;
+            values[index] = strtof(cursor, &end);
+            if (end == cursor) {
+                break;
+            }
+            index++;
+            cursor = end;
+            if (*cursor == ',') {
+                cursor++;
+            }
+        }
+        if (index != 10) {
+            fprintf(stderr, "Invalid line %d, expected 10 values: %s\n", lineNumber, line.c_str());
+            continue;
+        }
+
+        GlyphInfo glyph = {};
+        glyph.unicodeCodePoint = static_cast<uint32_t>(values[0]);
+        glyph.horizAdvanceEm = values[1];
+        memcpy(glyph.quadBounds, &values[2], sizeof(glyph.quadBounds));
+        memcpy(glyph.pixelBounds, &values[6], sizeof(glyph.pixelBounds));
+        outFont.glyphs.push_back(glyph);
+    }
+    return !outFont.glyphs.empty();
+}
+
+//
+// JSON, just enough of it to read msdf-atlas-gen's output
+//
+
+struct JsonValue {
+    enum class Type { Null, Bool, Number, String, Array, Object } type = Type::Null;
+    double number = 0;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::vector<std::pair<std::string, JsonValue>> object;
+
+    const JsonValue* find(const char* key) const {
+        for (const auto& [name, value] : object) {
+            if (name == key) {
+                return &value;
+            }
+        }
+        return nullptr;
+    }
+
+    double getNumber(const char* key, double fallback = 0) const {
+        const JsonValue* value = find(key);
+        return value != nullptr && value->type == Type::Number ? value->number : fallback;
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : m_text(text) {}
+
+    bool parse(JsonValue& outValue) {
+        return parseValue(outValue) && (skipWhitespace(), m_cursor == m_text.size());
+    }
+
+private:
+    void skipWhitespace() {
+        while (m_cursor < m_text.size() && isspace(static_cast<unsigned char>(m_text[m_cursor]))) {
+            m_cursor++;
+        }
+    }
+
+    bool consume(char c) {
+        skipWhitespace();
+        if (m_cursor < m_text.size() && m_text[m_cursor] == c) {
+            m_cursor++;
+            return true;
+        }
+        return false;
+    }
+
+    bool parseString(std::string& outString) {
+        if (!consume('"')) {
+            return false;
+        }
+        while (m_cursor < m_text.size() && m_text[m_cursor] != '"') {
+            char c = m_text[m_cursor++];
+            if (c == '\\' && m_cursor < m_text.size()) {
+                char escaped = m_text[m_cursor++];
+                switch (escaped) {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case 'u': c = '?'; m_cursor += 4; break; // Keys and values we care about are never escaped
+                default: c = escaped; break;
+                }
+            }
+            outString.push_back(c);
+        }
+        return consume('"');
+    }
+
+    bool parseValue(JsonValue& outValue) {
+        skipWhitespace();
+        if (m_cursor >= m_text.size()) {
+            return false;
+        }
+
+        char c = m_text[m_cursor];
+        if (c == '{') {
+            m_cursor++;
+            outValue.type = JsonValue::Type::Object;
+            if (consume('}')) {
+                return true;
+            }
+            do {
+                std::pair<std::string, JsonValue> member;
+                if (!parseString(member.first) || !consume(':') || !parseValue(member.second)) {
+                    return false;
+                }
+                outValue.object.push_back(std::move(member));
+            } while (consume(','));
+            return consume('}');
+        }
+        if (c == '[') {
+            m_cursor++;
+            outValue.type = JsonValue::Type::Array;
+            if (consume(']')) {
+                return true;
+            }
+            do {
+                outValue.array.emplace_back();
+                if (!parseValue(outValue.array.back())) {
+                    return false;
+                }
+            } while (consume(','));
+            return consume(']');
+        }
+        if (c == '"') {
+            outValue.type = JsonValue::Type::String;
+            return parseString(outValue.string);
+        }
+        if (m_text.compare(m_cursor, 4, "true") == 0 || m_text.compare(m_cursor, 5, "false") == 0) {
+            outValue.type = JsonValue::Type::Bool;
+            outValue.number = c == 't' ? 1 : 0;
+            m_cursor += c == 't' ? 4 : 5;
+            return true;
+        }
+        if (m_text.compare(m_cursor, 4, "null") == 0) {
+            m_cursor += 4;
+            return true;
+        }
+
+        const char* start = m_text.c_str() + m_cursor;
+        char* end = nullptr;
+        outValue.type = JsonValue::Type::Number;
+        outValue.number = strtod(start, &end);
+        if (end == start) {
+            return false;
+        }
+        m_cursor += end - start;
+        return true;
+    }
+
+    const std::string& m_text;
+    size_t m_cursor = 0;
+};
+
+static bool parseJson(const std::string& contents, CookedFont& outFont) {
+    JsonValue root;
+    if (!JsonParser(contents).parse(root) || root.type != JsonValue::Type::Object) {
+        fprintf(stderr, "Malformed JSON layout\n");
+        return false;
+    }
+
+    const JsonValue* atlas = root.find("atlas");
+    const JsonValue* metrics = root.find("metrics");
+    const JsonValue* glyphs = root.find("glyphs");
+    if (atlas == nullptr || metrics == nullptr || glyphs == nullptr || glyphs->type != JsonValue::Type::Array) {
+        fprintf(stderr, "JSON layout is missing atlas, metrics or glyphs\n");
+        return false;
+    }
+
+    // The runtime expects atlas bounds measured from the bottom of the texture
+    const JsonValue* yOrigin = atlas->find("yOrigin");
+    bool flipY = yOrigin != nullptr && yOrigin->string == "top";
+    float atlasHeight = static_cast<float>(atlas->getNumber("height"));
+
+    outFont.emSize = static_cast<float>(atlas->getNumber("size"));
+    outFont.lineHeight = static_cast<float>(metrics->getNumber("lineHeight", 1.0));
+    outFont.ascender = static_cast<float>(metrics->getNumber("ascender"));
+    outFont.descender = static_cast<float>(metrics->getNumber("descender"));
+
+    for (const JsonValue& glyphValue : glyphs->array) {
+        GlyphInfo glyph = {};
+        glyph.unicodeCodePoint = static_cast<uint32_t>(glyphValue.getNumber("unicode"));
+        glyph.horizAdvanceEm = static_cast<float>(glyphValue.getNumber("advance"));
+        if (const JsonValue* plane = glyphValue.find("planeBounds")) {
+            glyph.quadBounds[0] = static_cast<float>(plane->getNumber("left"));
+            glyph.quadBounds[1] = static_cast<float>(plane->getNumber("bottom"));
+            glyph.quadBounds[2] = static_cast<float>(plane->getNumber("right"));
+            glyph.quadBounds[3] = static_cast<float>(plane->getNumber("top"));
+        }
+        if (const JsonValue* atlasBounds = glyphValue.find("atlasBounds")) {
+            float bottom = static_cast<float>(atlasBounds->getNumber("bottom"));
+            float top = static_cast<float>(atlasBounds->getNumber("top"));
+            glyph.pixelBounds[0] = static_cast<float>(atlasBounds->getNumber("left"));
+            glyph.pixelBounds[1] = flipY ? atlasHeight - bottom : bottom;
+            glyph.pixelBounds[2] = static_cast<float>(atlasBounds->getNumber("right"));
+            glyph.pixelBounds[3] = flipY ? atlasHeight - top : top;
+        }
+        outFont.glyphs.push_back(glyph);
+    }
+
+    if (const JsonValue* kerning = root.find("kerning")) {
+        for (const JsonValue& pairValue : kerning->array) {
+            outFont.kerningPairs.push_back({
+                .firstCodePoint = static_cast<uint32_t>(pairValue.getNumber("unicode1")),
+                .secondCodePoint = static_cast<uint32_t>(pairValue.getNumber("unicode2")),
+                .advanceEm = static_cast<float>(pairValue.getNumber("advance")),
+                });
+        }
+    }
+    return !outFont.glyphs.empty();
+}
+
+//
+// Output
+//
+
+static bool writeFont(const std::string& filePath, CookedFont& font) {
+    uint32_t firstCodePoint = UINT32_MAX;
+    uint32_t lastCodePoint = 0;
+    for (const GlyphInfo& glyph : font.glyphs) {
+        firstCodePoint = std::min(firstCodePoint, glyph.unicodeCodePoint);
+        lastCodePoint = std::max(lastCodePoint, glyph.unicodeCodePoint);
+    }
+
+    // Flat table indexed from the first code point, gaps stay zeroed
+    std::vector<GlyphInfo> glyphTable(lastCodePoint - firstCodePoint + 1, GlyphInfo{});
+    for (const GlyphInfo& glyph : font.glyphs) {
+        glyphTable[glyph.unicodeCodePoint - firstCodePoint] = glyph;
+    }
+
+    // Sorted so the runtime can binary search it
+    std::sort(font.kerningPairs.begin(), font.kerningPairs.end(), [](const KerningPair& a, const KerningPair& b) {
+        return a.firstCodePoint != b.firstCodePoint ? a.firstCodePoint < b.firstCodePoint : a.secondCodePoint < b.secondCodePoint;
+    });
+
+    FontFileHeader header = {
+        .magic = k_fontFileMagic,
+        .version = k_fontFileVersion,
+        .emSize = font.emSize,
+        .lineHeight = font.lineHeight,
+        .ascender = font.ascender,
+        .descender = font.descender,
+        .firstCodePoint = firstCodePoint,
+        .glyphCount = static_cast<uint32_t>(glyphTable.size()),
+        .glyphTableOffset = sizeof(FontFileHeader),
+        .kerningPairCount = static_cast<uint32_t>(font.kerningPairs.size()),
+        .kerningTableOffset = static_cast<uint32_t>(sizeof(FontFileHeader) + glyphTable.size() * sizeof(GlyphInfo)),
+    };
+
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(glyphTable.data()), glyphTable.size() * sizeof(GlyphInfo));
+    file.write(reinterpret_cast<const char*>(font.kerningPairs.data()), font.kerningPairs.size() * sizeof(KerningPair));
+    return file.good();
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <layout.csv|layout.json> <output.fontbin> [--em-size <pixels>] [--line-height <ems>]\n", argv[0]);
+        return 1;
+    }
+
+    std::string inputPath = argv[1];
+    std::string outputPath = argv[2];
+    float emSizeOverride = 0.0f;
+    float lineHeightOverride = 0.0f;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--em-size") == 0) {
+            emSizeOverride = strtof(argv[i + 1], nullptr);
+        } else if (strcmp(argv[i], "--line-height") == 0) {
+            lineHeightOverride = strtof(argv[i + 1], nullptr);
+        } else {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    std::string contents;
+    if (!readFile(inputPath, contents)) {
+        fprintf(stderr, "Could not open %s\n", inputPath.c_str());
+        return 1;
+    }
+
+    CookedFont font;
+    bool isJson = inputPath.size() >= 5 && inputPath.compare(inputPath.size() - 5, 5, ".json") == 0;
+    if (!(isJson ? parseJson(contents, font) : parseCsv(contents, font))) {
+        fprintf(stderr, "No glyphs found in %s\n", inputPath.c_str());
+        return 1;
+    }
+
+    if (emSizeOverride > 0.0f) {
+        font.emSize = emSizeOverride;
+    }
+    if (lineHeightOverride > 0.0f) {
+        font.lineHeight = lineHeightOverride;
+    }
+    if (font.emSize <= 0.0f) {
+        fprintf(stderr, "%s has no em size, pass --em-size\n", inputPath.c_str());
+        return 1;
+    }
+
+    if (!writeFont(outputPath, font)) {
+        fprintf(stderr, "Could not write %s\n", outputPath.c_str());
+        return 1;
+    }
+    printf("Cooked %zu glyphs and %zu kerning pairs into %s\n", font.glyphs.size(), font.kerningPairs.size(), outputPath.c_str());
+    return 0;
+}